@@ -0,0 +1,337 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  muse-batch.cpp
+//    Convert songs and midi files without a gui, several
+//    at a time. Every file is handled by its own MusE
+//    process started in batch mode (muse -B), the song
+//    model is one global per process.
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QProcessEnvironment>
+#include <QRegExp>
+#include <QThread>
+
+#include <set>
+
+#include "muse-batch.h"
+
+//---------------------------------------------------------
+//   BatchRunner
+//---------------------------------------------------------
+
+BatchRunner::BatchRunner(const QString& program, const QStringList& museArgs,
+   const QStringList& inputs, const QString& outDir, const QString& format,
+   int jobs, int timeout, bool verbose)
+      {
+      _program  = program;
+      _museArgs = museArgs;
+      _inputs   = inputs;
+      _outDir   = outDir;
+      _format   = format;
+      _jobs     = jobs;
+      _timeout  = timeout;
+      _verbose  = verbose;
+      _next     = 0;
+      _failed   = 0;
+      _finished = false;
+      _busyTime = 0;
+      makeOutputNames();
+      connect(&_watchdog, SIGNAL(timeout()), SLOT(checkTimeouts()));
+      }
+
+//---------------------------------------------------------
+//   makeOutputNames
+//    Each output is named after its input. Inputs with the
+//     same name in different directories get -2, -3, ...
+//     appended, so that they don't overwrite each other.
+//---------------------------------------------------------
+
+void BatchRunner::makeOutputNames()
+      {
+      std::set<QString> used;
+      for (int i = 0; i < _inputs.size(); ++i) {
+            QFileInfo fi(_inputs[i]);
+            // Keep dots inside the name, drop .gz or .bz2 with the format.
+            QString base = fi.completeBaseName();
+            QString sfx  = fi.suffix().toLower();
+            if (sfx == "gz" || sfx == "bz2")
+                  base = QFileInfo(base).completeBaseName();
+            QString name = base + "." + _format;
+            for (int n = 2; used.find(name) != used.end(); ++n)
+                  name = QString("%1-%2.%3").arg(base).arg(n).arg(_format);
+            used.insert(name);
+            _outputs.append(QDir(_outDir).filePath(name));
+            }
+      }
+
+//---------------------------------------------------------
+//   start
+//---------------------------------------------------------
+
+void BatchRunner::start()
+      {
+      _totalTimer.start();
+      if (_timeout > 0)
+            _watchdog.start(1000);
+      for (int i = 0; i < _jobs; ++i)
+            startNext();
+      if (_running.empty())
+            done();
+      }
+
+//---------------------------------------------------------
+//   startNext
+//---------------------------------------------------------
+
+void BatchRunner::startNext()
+      {
+      while (_next < _inputs.size()) {
+            Job* job = new Job;
+            job->input    = _inputs[_next];
+            job->output   = _outputs[_next];
+            ++_next;
+            job->timedOut = false;
+            job->timer.start();
+
+            QFileInfo in(job->input);
+            if (!in.isReadable()) {
+                  job->log = "cannot read input file\n";
+                  report(job, false);
+                  continue;
+                  }
+            if (in.absoluteFilePath() == QFileInfo(job->output).absoluteFilePath()) {
+                  job->log = "output would overwrite the input file\n";
+                  report(job, false);
+                  continue;
+                  }
+
+            QProcess* p = new QProcess(this);
+            QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+            // No X session needed.
+            if (!env.contains("QT_QPA_PLATFORM"))
+                  env.insert("QT_QPA_PLATFORM", "offscreen");
+            p->setProcessEnvironment(env);
+            p->setProcessChannelMode(QProcess::MergedChannels);
+            connect(p, SIGNAL(finished(int, QProcess::ExitStatus)), SLOT(processFinished(int, QProcess::ExitStatus)));
+            connect(p, SIGNAL(error(QProcess::ProcessError)), SLOT(processError(QProcess::ProcessError)));
+            _running[p] = job;
+
+            QStringList args(_museArgs);
+            args << "-B" << job->output << in.absoluteFilePath();
+            p->start(_program, args);
+            return;
+            }
+      }
+
+//---------------------------------------------------------
+//   processFinished
+//---------------------------------------------------------
+
+void BatchRunner::processFinished(int exitCode, QProcess::ExitStatus status)
+      {
+      QProcess* p = static_cast<QProcess*>(sender());
+      std::map<QProcess*, Job*>::iterator i = _running.find(p);
+      if (i == _running.end())
+            return;
+      Job* job = i->second;
+      _running.erase(i);
+      job->log += p->readAll();
+      report(job, status == QProcess::NormalExit && exitCode == 0 && !job->timedOut);
+      p->deleteLater();
+
+      startNext();
+      if (_running.empty())
+            done();
+      }
+
+//---------------------------------------------------------
+//   processError
+//    Only a failed start is handled here, the other
+//     errors are followed by finished().
+//---------------------------------------------------------
+
+void BatchRunner::processError(QProcess::ProcessError error)
+      {
+      if (error != QProcess::FailedToStart)
+            return;
+      QProcess* p = static_cast<QProcess*>(sender());
+      std::map<QProcess*, Job*>::iterator i = _running.find(p);
+      if (i == _running.end())
+            return;
+      Job* job = i->second;
+      _running.erase(i);
+      job->log = QString("cannot start %1: %2\n").arg(_program).arg(p->errorString()).toLocal8Bit();
+      report(job, false);
+      p->deleteLater();
+
+      startNext();
+      if (_running.empty())
+            done();
+      }
+
+//---------------------------------------------------------
+//   checkTimeouts
+//    A worker stuck in a dialog nobody can see is killed.
+//---------------------------------------------------------
+
+void BatchRunner::checkTimeouts()
+      {
+      for (std::map<QProcess*, Job*>::iterator i = _running.begin(); i != _running.end(); ++i) {
+            Job* job = i->second;
+            if (!job->timedOut && job->timer.elapsed() > qint64(_timeout) * 1000) {
+                  job->timedOut = true;
+                  job->log += QString("timeout after %1 s, killed\n").arg(_timeout).toLocal8Bit();
+                  i->first->kill();
+                  }
+            }
+      }
+
+//---------------------------------------------------------
+//   report
+//    One line per file, with the worker output if it
+//     failed or -v was given.
+//---------------------------------------------------------
+
+void BatchRunner::report(Job* job, bool ok)
+      {
+      const qint64 ms = job->timer.elapsed();
+      _busyTime += ms;
+      if (!ok)
+            ++_failed;
+
+      QString detail;
+      QRegExp rx("MusE batch: load (\\d+) ms, write (\\d+) ms");
+      if (rx.indexIn(QString::fromLocal8Bit(job->log)) != -1)
+            detail = QString(" (load %1, write %2)").arg(rx.cap(1)).arg(rx.cap(2));
+
+      printf("%-6s %8lld ms%s  %s -> %s\n", ok ? "ok" : "FAILED", (long long)ms,
+         detail.toLocal8Bit().constData(), job->input.toLocal8Bit().constData(),
+         job->output.toLocal8Bit().constData());
+      if (!ok || _verbose) {
+            QList<QByteArray> lines = job->log.split('\n');
+            for (int i = 0; i < lines.size(); ++i) {
+                  if (!lines[i].isEmpty())
+                        printf("    | %s\n", lines[i].constData());
+                  }
+            }
+      fflush(stdout);
+      delete job;
+      }
+
+//---------------------------------------------------------
+//   done
+//---------------------------------------------------------
+
+void BatchRunner::done()
+      {
+      _watchdog.stop();
+      _finished = true;
+      printf("%d files, %d failed, %lld ms total, %lld ms of conversion work, %d jobs\n",
+         _inputs.size(), _failed, (long long)_totalTimer.elapsed(), (long long)_busyTime, _jobs);
+      QCoreApplication::exit(exitCode());
+      }
+
+//---------------------------------------------------------
+//   usage
+//---------------------------------------------------------
+
+static void usage(const char* prog, const char* txt)
+      {
+      fprintf(stderr, "%s: %s\n", prog, txt);
+      fprintf(stderr, "Usage: %s [flags] files...\n", prog);
+      fprintf(stderr, "   Convert MusE songs (*.med) and midi files (*.mid, *.kar) without a gui.\n");
+      fprintf(stderr, "   Flags:\n");
+      fprintf(stderr, "   -f fmt   Output format: mid, med, med.gz or med.bz2 (default mid)\n");
+      fprintf(stderr, "   -o dir   Output directory (default: current directory)\n");
+      fprintf(stderr, "   -j n     Convert n files at a time (default: number of cpus)\n");
+      fprintf(stderr, "   -t sec   Kill a conversion taking longer than sec seconds (default 300, 0: never)\n");
+      fprintf(stderr, "   -m prog  MusE executable (default: %s next to %s, else from PATH)\n", MUSE_EXEC_NAME, prog);
+      fprintf(stderr, "   -x flag  Pass flag on to MusE, for example -x -p to not load LADSPA plugins\n");
+      fprintf(stderr, "   -v       Show MusE output for every file\n");
+      fprintf(stderr, "   -h       This help\n");
+      }
+
+//---------------------------------------------------------
+//   main
+//---------------------------------------------------------
+
+int main(int argc, char* argv[])
+      {
+      QCoreApplication app(argc, argv);
+
+      QString format("mid");
+      QString outDir(".");
+      QString program;
+      QStringList museArgs;
+      int jobs    = QThread::idealThreadCount();
+      int timeout = 300;
+      bool verbose = false;
+
+      int c;
+      while ((c = getopt(argc, argv, "f:o:j:t:m:x:vh")) != EOF) {
+            switch (c) {
+                  case 'f': format  = QString(optarg); break;
+                  case 'o': outDir  = QString(optarg); break;
+                  case 'j': jobs    = atoi(optarg); break;
+                  case 't': timeout = atoi(optarg); break;
+                  case 'm': program = QString(optarg); break;
+                  case 'x': museArgs << QString(optarg); break;
+                  case 'v': verbose = true; break;
+                  case 'h': usage(argv[0], "help"); return 0;
+                  default:  usage(argv[0], "bad argument"); return 2;
+                  }
+            }
+      if (optind >= argc) {
+            usage(argv[0], "no files given");
+            return 2;
+            }
+      if (format != "mid" && format != "med" && format != "med.gz" && format != "med.bz2") {
+            usage(argv[0], "unknown output format");
+            return 2;
+            }
+      if (!QDir(outDir).exists() && !QDir().mkpath(outDir)) {
+            fprintf(stderr, "%s: cannot create %s\n", argv[0], outDir.toLocal8Bit().constData());
+            return 2;
+            }
+      if (jobs < 1)
+            jobs = 1;
+      if (program.isEmpty()) {
+            QFileInfo fi(QDir(QCoreApplication::applicationDirPath()).filePath(MUSE_EXEC_NAME));
+            program = fi.isExecutable() ? fi.absoluteFilePath() : QString(MUSE_EXEC_NAME);
+            }
+
+      QStringList inputs;
+      for (int i = optind; i < argc; ++i)
+            inputs << QString::fromLocal8Bit(argv[i]);
+
+      BatchRunner runner(program, museArgs, inputs, outDir, format, jobs, timeout, verbose);
+      runner.start();
+      // Nothing to wait for if no worker could be started.
+      if (runner.finished())
+            return runner.exitCode();
+      return app.exec();
+      }
@@ -0,0 +1,89 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  muse-batch.h
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#ifndef __MUSE_BATCH_H__
+#define __MUSE_BATCH_H__
+
+#include <QObject>
+#include <QProcess>
+#include <QElapsedTimer>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+#include <map>
+
+//---------------------------------------------------------
+//   BatchRunner
+//    Converts a list of files, each in its own headless
+//     MusE process (muse -B), up to 'jobs' at a time.
+//---------------------------------------------------------
+
+class BatchRunner : public QObject {
+      Q_OBJECT
+
+      struct Job {
+            QString input;
+            QString output;
+            QElapsedTimer timer;
+            QByteArray log;
+            bool timedOut;
+            };
+
+      QString _program;
+      QStringList _museArgs;
+      QStringList _inputs;
+      QStringList _outputs;   // One per input.
+      QString _outDir;
+      QString _format;
+      int _jobs;
+      int _timeout;           // seconds per file, 0: none
+      bool _verbose;
+
+      int _next;
+      int _failed;
+      bool _finished;
+      qint64 _busyTime;
+      QElapsedTimer _totalTimer;
+      QTimer _watchdog;
+      std::map<QProcess*, Job*> _running;
+
+      void makeOutputNames();
+      void startNext();
+      void report(Job*, bool ok);
+      void done();
+
+   private slots:
+      void processFinished(int, QProcess::ExitStatus);
+      void processError(QProcess::ProcessError);
+      void checkTimeouts();
+
+   public:
+      BatchRunner(const QString& program, const QStringList& museArgs,
+         const QStringList& inputs, const QString& outDir, const QString& format,
+         int jobs, int timeout, bool verbose);
+      void start();
+      bool finished() const { return _finished; }
+      int exitCode() const  { return _failed ? 1 : 0; }
+      };
+
+#endif
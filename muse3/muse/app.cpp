@@ -25,6 +25,7 @@
 #include <typeinfo>
 
 #include <QClipboard>
+#include <QFileDialog>
 #include <QMessageBox>
 #include <QShortcut>
 #include <QSignalMapper>
@@ -53,7 +54,11 @@
 #include "audio.h"
 #include "audiodev.h"
 #include "audioprefetch.h"
+#include "autosave.h"
+#include "deferredevents.h"
 #include "bigtime.h"
+#include "dspwindow.h"
+#include "xruntrace.h"
 #include "cliplist/cliplist.h"
 #include "conf.h"
 #include "config.h"
@@ -321,6 +326,9 @@ MusE::MusE() : QMainWindow()
       //routingPopupMenu      = 0;
       progress              = 0;
       saveIncrement         = 0;
+      xrunTraceWaits        = 0;
+      dirtySerial           = 0;
+      batchLoadError        = false;
       activeTopWin          = NULL;
       currentMenuSharingTopwin = NULL;
       waitingForTopwin      = NULL;
@@ -344,7 +352,11 @@ MusE::MusE() : QMainWindow()
 
       saveTimer = new QTimer(this);
       connect(saveTimer, SIGNAL(timeout()), this, SLOT(saveTimerSlot()));
-      saveTimer->start( 60 * 1000 ); // every minute
+      saveTimer->start( AUTOSAVE_TIMER_SECONDS * 1000 );
+
+      autoSaveWriter = new AutoSaveWriter(this);
+      connect(autoSaveWriter, SIGNAL(saved(const QString&, bool, const QString&, unsigned)),
+         SLOT(autoSaveDone(const QString&, bool, const QString&, unsigned)));
 
       //init cpuload stuff
       clock_gettime(CLOCK_REALTIME, &lastSysTime);
@@ -524,6 +536,8 @@ MusE::MusE() : QMainWindow()
       viewMarkerAction->setCheckable(true);
       viewArrangerAction = new QAction(tr("Arranger View"),  this);
       viewArrangerAction->setCheckable(true);
+      viewDspLoadAction = new QAction(tr("DSP Load"),  this);
+      viewDspLoadAction->setCheckable(true);
       fullscreenAction=new QAction(tr("Fullscreen"), this);
       fullscreenAction->setCheckable(true);
       fullscreenAction->setChecked(false);
@@ -548,6 +562,8 @@ MusE::MusE() : QMainWindow()
       audioBounce2TrackAction = new QAction(QIcon(*MusEGui::audio_bounce_to_trackIcon), tr("Bounce to Track"), this);
       audioBounce2FileAction = new QAction(QIcon(*MusEGui::audio_bounce_to_fileIcon), tr("Bounce to File"), this);
       audioRestartAction = new QAction(QIcon(*MusEGui::audio_restartaudioIcon), tr("Restart Audio"), this);
+      audioSaveXrunTraceAction = new QAction(tr("Save Xrun Trace..."), this);
+      audioSaveXrunTraceAction->setToolTip(tr("Save the timing of the audio cycles around the last xrun, as a Chrome trace file"));
 
       //-------- Automation Actions
       autoMixerAction = new QAction(QIcon(*MusEGui::automation_mixerIcon), tr("Mixer Automation"), this);
@@ -613,6 +629,7 @@ MusE::MusE() : QMainWindow()
       //-------- View connections
       connect(viewTransportAction, SIGNAL(toggled(bool)), SLOT(toggleTransport(bool)));
       connect(viewBigtimeAction, SIGNAL(toggled(bool)), SLOT(toggleBigTime(bool)));
+      connect(viewDspLoadAction, SIGNAL(toggled(bool)), SLOT(toggleDspLoad(bool)));
       connect(viewMixerAAction, SIGNAL(toggled(bool)),SLOT(toggleMixer1(bool)));
       connect(viewMixerBAction, SIGNAL(toggled(bool)), SLOT(toggleMixer2(bool)));
       connect(viewCliplistAction, SIGNAL(toggled(bool)), SLOT(startClipList(bool)));
@@ -647,6 +664,7 @@ MusE::MusE() : QMainWindow()
       connect(audioBounce2TrackAction, SIGNAL(triggered()), SLOT(bounceToTrack()));
       connect(audioBounce2FileAction, SIGNAL(triggered()), SLOT(bounceToFile()));
       connect(audioRestartAction, SIGNAL(triggered()), SLOT(seqRestart()));
+      connect(audioSaveXrunTraceAction, SIGNAL(triggered()), SLOT(saveXrunTrace()));
 
       //-------- Automation connections
       connect(autoMixerAction, SIGNAL(triggered()), SLOT(switchMixerAutomation()));
@@ -812,6 +830,7 @@ MusE::MusE() : QMainWindow()
       menuView->addAction(viewCliplistAction);
       menuView->addAction(viewMarkerAction);
       menuView->addAction(viewArrangerAction);
+      menuView->addAction(viewDspLoadAction);
       menuView->addSeparator();
       menuView->addAction(fullscreenAction);
 
@@ -853,6 +872,7 @@ MusE::MusE() : QMainWindow()
       menu_audio->addAction(audioBounce2FileAction);
       menu_audio->addSeparator();
       menu_audio->addAction(audioRestartAction);
+      menu_audio->addAction(audioSaveXrunTraceAction);
 
 
       //-------------------------------------------------------------
@@ -976,6 +996,7 @@ MusE::MusE() : QMainWindow()
 
       transport = new MusEGui::Transport(this, "transport");
       bigtime   = 0;
+      dspLoadWindow = 0;
 
       MusEGlobal::song->blockSignals(false);
 
@@ -1003,6 +1024,7 @@ void MusE::setHeartBeat()
 void MusE::setDirty()
       {
       MusEGlobal::song->dirty = true;
+      ++dirtySerial;
       setWindowTitle(projectTitle(project.absoluteFilePath()) + " <unsaved changes>");
       }
 
@@ -1061,6 +1083,58 @@ void MusE::loadDefaultSong(int argc, char** argv)
   loadProjectFile(name, useTemplate, loadConfig);
 }
 
+//---------------------------------------------------------
+//   fileError
+//    Report a failed project load or save. Nobody is
+//     there to answer a dialog in batch mode.
+//---------------------------------------------------------
+
+void MusE::fileError(const QString& s, const QString& title)
+      {
+      if (MusEGlobal::batchMode) {
+            fprintf(stderr, "MusE: %s\n", s.toLocal8Bit().constData());
+            batchLoadError = true;
+            }
+      else
+            QMessageBox::critical(this, title.isEmpty() ? QString("MusE") : title, s);
+      }
+
+//---------------------------------------------------------
+//   batchConvert
+//    Write the loaded song to name, as a project (*.med)
+//     or a standard midi file (*.mid, *.kar), judged by
+//     the suffix. Used by muse-batch, no dialogs.
+//    return true on success
+//---------------------------------------------------------
+
+bool MusE::batchConvert(const QString& name)
+      {
+      if (batchLoadError)
+            return false;
+      QFileInfo fi(name);
+      QString ex = fi.completeSuffix().toLower();
+      QString mex = ex.section('.', -1, -1);
+      if((mex == "gz") || (mex == "bz2"))
+        mex = ex.section('.', -2, -2);
+
+      if (mex == "med")
+            return save(name, false, false);
+      if (mex == "mid" || mex == "midi" || mex == "kar") {
+            bool popenFlag;
+            FILE* f = MusEGui::fileOpen(this, name, QString(".mid"), "w", popenFlag, true, false);
+            if (f == 0) {
+                  fprintf(stderr, "MusE: cannot open %s: %s\n", name.toLocal8Bit().constData(), strerror(errno));
+                  return false;
+                  }
+            bool rv = exportMidi(f);
+            if (popenFlag ? pclose(f) : fclose(f))
+                  rv = false;
+            return rv;
+            }
+      fprintf(stderr, "MusE: unknown file format: %s\n", name.toLocal8Bit().constData());
+      return false;
+      }
+
 //---------------------------------------------------------
 //   resetDevices
 //---------------------------------------------------------
@@ -1171,7 +1245,7 @@ void MusE::loadProjectFile(const QString& name, bool songTemplate, bool doReadMi
       // Prompt and send init sequences.
       MusEGlobal::audio->msgInitMidiDevices(false);
 
-      if (MusEGlobal::song->getSongInfo().length()>0 && MusEGlobal::song->showSongInfoOnStartup()) {
+      if (!MusEGlobal::batchMode && MusEGlobal::song->getSongInfo().length()>0 && MusEGlobal::song->showSongInfoOnStartup()) {
           startSongInfo(false);
         }
       }
@@ -1227,21 +1301,22 @@ void MusE::loadProjectFile1(const QString& name, bool songTemplate, bool doReadM
             FILE* f = MusEGui::fileOpen(this, fi.filePath(), QString(".med"), "r", popenFlag, true);
             if (f == 0) {
                   if (errno != ENOENT) {
-                        QMessageBox::critical(this, QString("MusE"),
-                           tr("File open error"));
+                        fileError(tr("File open error"));
                         setUntitledProject();
                         }
-                  else
+                  else {
+                        if (MusEGlobal::batchMode)
+                              fileError(tr("File not found: %1").arg(fi.filePath()));
                         setConfigDefaults();
+                        }
                   }
             else {
                   MusECore::Xml xml(f);
                   read(xml, doReadMidiPorts, songTemplate);
-                  bool fileError = ferror(f);
+                  bool readError = ferror(f);
                   popenFlag ? pclose(f) : fclose(f);
-                  if (fileError) {
-                        QMessageBox::critical(this, QString("MusE"),
-                           tr("File read error"));
+                  if (readError) {
+                        fileError(tr("File read error"));
                         setUntitledProject();
                         }
                   }
@@ -1252,8 +1327,7 @@ void MusE::loadProjectFile1(const QString& name, bool songTemplate, bool doReadM
                   setUntitledProject();
             }
       else {
-            QMessageBox::critical(this, QString("MusE"),
-               tr("Unknown File Format: %1").arg(ex));
+            fileError(tr("Unknown File Format: %1").arg(ex));
             setUntitledProject();
             }
       if (!songTemplate) {
@@ -1383,6 +1457,11 @@ void MusE::setUntitledProject()
 void MusE::setConfigDefaults()
       {
       MusECore::readConfiguration();    // used for reading midi files
+      if (MusEGlobal::batchMode) {
+            // The configuration just read must not bring the dialogs back.
+            MusEGlobal::config.warnInitPending = false;
+            MusEGlobal::config.warnOnFileVersions = false;
+            }
       MusEGlobal::song->dirty = false;
       }
 
@@ -1450,6 +1529,9 @@ bool MusE::save(const QString& name, bool overwriteWarn, bool writeTopwins)
       {
       QString backupCommand;
 
+      // Don't let a background autosave write the same file behind our back.
+      autoSaveWriter->waitIdle();
+
       QFile currentName(name);
       if (QFile::exists(name)) {
             currentName.copy(name+".backup");
@@ -1464,16 +1546,19 @@ bool MusE::save(const QString& name, bool overwriteWarn, bool writeTopwins)
 //            system(backupCommand.toLatin1().constData());
 
       bool popenFlag;
-      FILE* f = MusEGui::fileOpen(this, name, QString(".med"), "w", popenFlag, false, overwriteWarn);
-      if (f == 0)
+      // fileOpen reports errors in a dialog unless told not to.
+      FILE* f = MusEGui::fileOpen(this, name, QString(".med"), "w", popenFlag, MusEGlobal::batchMode, overwriteWarn);
+      if (f == 0) {
+            if (MusEGlobal::batchMode)
+                  fileError("Open File\n" + name + "\nfailed: " + QString(strerror(errno)));
             return false;
+            }
       MusECore::Xml xml(f);
       write(xml, writeTopwins);
       if (ferror(f)) {
             QString s = "Write File\n" + name + "\nfailed: "
                + QString(strerror(errno));
-            QMessageBox::critical(this,
-               tr("MusE: Write File failed"), s);
+            fileError(s, tr("MusE: Write File failed"));
             popenFlag? pclose(f) : fclose(f);
             unlink(name.toLatin1().constData());
             return false;
@@ -1541,20 +1626,23 @@ void MusE::closeEvent(QCloseEvent* event)
                   }
             }
 
-      QSettings settings("MusE", "MusE-qt");
-      settings.setValue("MusE/geometry", saveGeometry());
+      // Batch conversions run side by side, leave the user's settings alone.
+      if (!MusEGlobal::batchMode) {
+        QSettings settings("MusE", "MusE-qt");
+        settings.setValue("MusE/geometry", saveGeometry());
 
-      writeGlobalConfiguration();
+        writeGlobalConfiguration();
 
-      // save "Open Recent" list
-      QString prjPath(MusEGlobal::configPath);
-      prjPath += "/projects";
-      QFile f(prjPath);
-      f.open(QIODevice::WriteOnly | QIODevice::Text);
-      if (f.exists()) {
-        QTextStream out(&f);
-        for (int i = 0; i < projectRecentList.size(); ++i) {
-           out << projectRecentList[i] << "\n";
+        // save "Open Recent" list
+        QString prjPath(MusEGlobal::configPath);
+        prjPath += "/projects";
+        QFile f(prjPath);
+        f.open(QIODevice::WriteOnly | QIODevice::Text);
+        if (f.exists()) {
+          QTextStream out(&f);
+          for (int i = 0; i < projectRecentList.size(); ++i) {
+             out << projectRecentList[i] << "\n";
+          }
         }
       }
       if(MusEGlobal::debugMsg)
@@ -2634,6 +2722,52 @@ void MusE::configShortCutsSaveConfig()
       changeConfig(true);
       }
 
+//---------------------------------------------------------
+//   saveXrunTrace
+//    Write the audio cycle trace. If no xrun was captured yet,
+//     freeze the most recent cycles instead.
+//---------------------------------------------------------
+
+void MusE::saveXrunTrace()
+      {
+      audioSaveXrunTraceAction->setEnabled(false);
+      xrunTraceWaits = 0;
+      if (!MusEGlobal::xrunTrace.frozen())
+            MusEGlobal::xrunTrace.requestFreeze();
+      writeXrunTrace();
+      }
+
+//---------------------------------------------------------
+//   writeXrunTrace
+//    Give the audio thread a few cycles to notice the freeze
+//     request. Only a frozen ring is written, the audio thread
+//     may still be writing to any other.
+//---------------------------------------------------------
+
+void MusE::writeXrunTrace()
+      {
+      MusECore::XrunTrace& trace = MusEGlobal::xrunTrace;
+      if (!trace.frozen()) {
+            if (++xrunTraceWaits < 50) {
+                  QTimer::singleShot(10, this, SLOT(writeXrunTrace()));
+                  return;
+                  }
+            QMessageBox::warning(this, tr("MusE: Save Xrun Trace"),
+               tr("The trace was not frozen, the audio engine did not respond.\nIs it running?"));
+            trace.rearm();
+            audioSaveXrunTraceAction->setEnabled(true);
+            return;
+            }
+
+      QString fn = QFileDialog::getSaveFileName(this, tr("MusE: Save Xrun Trace"), QString("xrun-trace.json"),
+                                                tr("Chrome trace files (*.json)"));
+      if (!fn.isEmpty() && trace.write(fn))
+            QMessageBox::critical(this, tr("MusE: Save Xrun Trace"), tr("Cannot write file:\n%1").arg(fn));
+
+      trace.rearm();
+      audioSaveXrunTraceAction->setEnabled(true);
+      }
+
 //---------------------------------------------------------
 //   bounceToTrack
 //---------------------------------------------------------
@@ -3201,6 +3335,39 @@ void MusE::bigtimeClosed()
       viewBigtimeAction->setChecked(false);
       }
 
+//---------------------------------------------------------
+//   showDspLoad
+//---------------------------------------------------------
+
+void MusE::showDspLoad(bool on)
+      {
+      if (on && dspLoadWindow == 0) {
+            dspLoadWindow = new MusEGui::DspLoadWindow(this);
+            connect(dspLoadWindow, SIGNAL(closed()), SLOT(dspLoadClosed()));
+            }
+      if (dspLoadWindow)
+            dspLoadWindow->setVisible(on);
+      viewDspLoadAction->setChecked(on);
+      }
+
+//---------------------------------------------------------
+//   toggleDspLoad
+//---------------------------------------------------------
+
+void MusE::toggleDspLoad(bool checked)
+      {
+      showDspLoad(checked);
+      }
+
+//---------------------------------------------------------
+//   dspLoadClosed
+//---------------------------------------------------------
+
+void MusE::dspLoadClosed()
+      {
+      viewDspLoadAction->setChecked(false);
+      }
+
 
 //---------------------------------------------------------
 //   showMixer1
@@ -3847,13 +4014,11 @@ void MusE::saveTimerSlot()
         //printf("conditions not met, ignore %d %d\n", MusEGlobal::config.autoSave, MusEGlobal::song->dirty);
         return;
     }
-    saveIncrement++;
-    if (saveIncrement > 4) {
-        // printf("five minutes passed %d %d\n", MusEGlobal::config.autoSave, MusEGlobal::song->dirty);
+    saveIncrement += AUTOSAVE_TIMER_SECONDS;
+    if (saveIncrement >= MusEGlobal::config.autoSaveInterval) {
         // time to see if we are allowed to save, if so. Do
         if (MusEGlobal::audio->isPlaying() == false) {
-            printf("Performing autosave\n");
-            save(project.filePath(), false, writeTopwinState);
+            autoSave();
         } else
         {
             //printf("isPlaying, can't save\n");
@@ -3861,4 +4026,62 @@ void MusE::saveTimerSlot()
     }
 }
 
+//---------------------------------------------------------
+//   autoSave
+//    Serialise the song into memory, leaving the midi
+//     events to the AutoSaveWriter, which formats them,
+//     compresses and writes it all out. The song stays
+//     dirty until the write succeeded.
+//---------------------------------------------------------
+
+void MusE::autoSave()
+{
+    QString name = project.filePath();
+    QString zip;
+    QFileInfo info(name);
+    if (info.completeSuffix() == "")
+        name += QString(".med");
+    else if (info.suffix() == "gz")
+        zip = QString("gzip");
+    else if (info.suffix() == "bz2")
+        zip = QString("bzip2");
+
+    char* buf = 0;
+    size_t len = 0;
+    FILE* f = open_memstream(&buf, &len);
+    if (f == 0) {
+        printf("autosave: open_memstream failed: %s\n", strerror(errno));
+        return;
+    }
+    MusECore::DeferredEvents* events = new MusECore::DeferredEvents;
+    MusECore::Xml xml(f);
+    xml.setDeferredEvents(events);
+    write(xml, writeTopwinState);
+    fclose(f);
+    QByteArray data(buf, len);
+    free(buf);
+
+    if (MusEGlobal::debugMsg)
+        printf("Performing autosave of %s, %zu bytes without events\n", name.toLocal8Bit().constData(), len);
+    saveIncrement = 0;
+    autoSaveWriter->write(name, zip, data, events, dirtySerial);
+}
+
+//---------------------------------------------------------
+//   autoSaveDone
+//---------------------------------------------------------
+
+void MusE::autoSaveDone(const QString& path, bool ok, const QString& error, unsigned serial)
+{
+    if (ok) {
+        // Only if nothing changed since this save was serialised.
+        if (serial == dirtySerial && MusEGlobal::song->dirty) {
+            MusEGlobal::song->dirty = false;
+            setWindowTitle(projectTitle(project.absoluteFilePath()));
+        }
+        return;
+    }
+    fprintf(stderr, "autosave of %s failed: %s\n", path.toLocal8Bit().constData(), error.toLocal8Bit().constData());
+}
+
 } //namespace MusEGui
@@ -65,10 +65,12 @@ namespace MusEGui {
 class Appearance;
 class Arranger;
 class ArrangerView;
+class AutoSaveWriter;
 class AudioMixerApp;
 class AudioRecord;
 class BigTime;
 class ClipListEdit;
+class DspLoadWindow;
 class EditInstrument;
 class EditToolBar;
 class GlobalSettingsConfig;
@@ -92,6 +94,7 @@ class VisibleTracks;
 class RouteDialog;
 
 #define MENU_ADD_SYNTH_ID_BASE 0x8000
+#define AUTOSAVE_TIMER_SECONDS 10
 
 
 //---------------------------------------------------------
@@ -138,6 +141,7 @@ class MusE : public QMainWindow
    
       // View Menu actions
       QAction *viewTransportAction, *viewBigtimeAction, *viewMixerAAction, *viewMixerBAction, *viewCliplistAction, *viewMarkerAction, *viewArrangerAction;
+      QAction *viewDspLoadAction;
       QAction* fullscreenAction;
 
       // Midi Menu Actions
@@ -148,7 +152,7 @@ class MusE : public QMainWindow
 #endif
 
       // Audio Menu Actions
-      QAction *audioBounce2TrackAction, *audioBounce2FileAction, *audioRestartAction;
+      QAction *audioBounce2TrackAction, *audioBounce2FileAction, *audioRestartAction, *audioSaveXrunTraceAction;
 
       // Automation Menu Actions
       QAction *autoMixerAction, *autoSnapshotAction, *autoClearAction;
@@ -210,6 +214,7 @@ class MusE : public QMainWindow
       Arranger* _arranger;
       ToplevelList toplevels;
       ClipListEdit* clipListEdit;
+      DspLoadWindow* dspLoadWindow;
       MarkerView* markerView;
       ArrangerView* arrangerView;
       MidiTransformerDialog* midiTransformerDialog;
@@ -219,12 +224,13 @@ class MusE : public QMainWindow
       
       bool readMidi(FILE*);
       void read(MusECore::Xml& xml, bool doReadMidiPorts, bool isTemplate);
-      void processTrack(MusECore::MidiTrack* track);
 
       void write(MusECore::Xml& xml, bool writeTopwins) const;
       // If clear_all is false, it will not touch things like midi ports.
       bool clearSong(bool clear_all = true);
       bool save(const QString&, bool overwriteWarn, bool writeTopwins);
+      bool exportMidi(FILE*);
+      void fileError(const QString&, const QString& title = QString());
       void setUntitledProject();
       void setConfigDefaults();
 
@@ -247,7 +253,11 @@ class MusE : public QMainWindow
       QSignalMapper *followSignalMapper;
       QSignalMapper *windowsMapper;
       QTimer *saveTimer;
-      int saveIncrement;
+      int saveIncrement;             // Seconds since the last save.
+      AutoSaveWriter* autoSaveWriter;
+      bool batchLoadError;           // Loading failed in batch mode.
+      int xrunTraceWaits;            // Timer ticks spent waiting for the xrun trace to freeze.
+      unsigned dirtySerial;          // Counts setDirty() calls.
 
    signals:
       void configChanged();
@@ -255,6 +265,8 @@ class MusE : public QMainWindow
 
    private slots:
       void saveTimerSlot();
+      void autoSave();
+      void autoSaveDone(const QString& path, bool ok, const QString& error, unsigned serial);
       void loadProject();
       bool save();
       void configGlobalSettings();
@@ -275,6 +287,7 @@ class MusE : public QMainWindow
       void toggleMarker(bool);
       void toggleArranger(bool);
       void toggleBigTime(bool);
+      void toggleDspLoad(bool);
       void toggleMixer1(bool);
       void toggleMixer2(bool);
 
@@ -303,6 +316,8 @@ class MusE : public QMainWindow
       void hideMidiRhythmGenerator();
 #endif
       void bounceToTrack();
+      void saveXrunTrace();
+      void writeXrunTrace();
       void resetMidiDevices();
       void initMidiDevices();
       void localOff();
@@ -310,6 +325,7 @@ class MusE : public QMainWindow
       void takeAutomationSnapshot();
       void clearAutomation();
       void bigtimeClosed();
+      void dspLoadClosed();
       void mixer1Closed();
       void mixer2Closed();
       void markerClosed();
@@ -341,6 +357,7 @@ class MusE : public QMainWindow
       bool seqRestart();
       void loadTemplate();
       void showBigtime(bool);
+      void showDspLoad(bool);
       void showMixer1(bool);
       void showMixer2(bool);
       void startRouteDialog();
@@ -389,6 +406,7 @@ class MusE : public QMainWindow
    public:
       MusE();
       void loadDefaultSong(int argc, char** argv);
+      bool batchConvert(const QString& name);
       Arranger* arranger() const { return _arranger; }
       ArrangerView* getArrangerView() const { return arrangerView; }
       QRect configGeometryMain;
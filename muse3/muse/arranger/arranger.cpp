@@ -704,6 +704,12 @@ void Arranger::songChanged(MusECore::SongChangedFlags_t type)
           } 
         }
         
+        // Wave data edited. Rendered waveform tiles are stale.
+        if(type & SC_CLIP_MODIFIED)
+          canvas->clearWaveTiles();
+        if(type & (SC_EVENT_INSERTED | SC_EVENT_REMOVED | SC_EVENT_MODIFIED | SC_PART_MODIFIED | SC_DRUMMAP))
+          canvas->updateMidiThumbs(type & (SC_EVENT_INSERTED | SC_EVENT_REMOVED | SC_EVENT_MODIFIED | SC_PART_MODIFIED | SC_DRUMMAP));
+
         // Try these:
         if(type & (SC_PART_INSERTED | SC_PART_REMOVED | SC_PART_MODIFIED | 
                    SC_EVENT_INSERTED | SC_EVENT_REMOVED | SC_EVENT_MODIFIED |
@@ -0,0 +1,115 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  midithumbs.cpp
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#include "midithumbs.h"
+
+namespace MusEGui {
+
+//---------------------------------------------------------
+//   MidiThumbKey
+//---------------------------------------------------------
+
+bool MidiThumbKey::operator<(const MidiThumbKey& k) const
+      {
+      if (cloneSN != k.cloneSN)       return cloneSN < k.cloneSN;
+      if (lenTick != k.lenTick)       return lenTick < k.lenTick;
+      if (xmag != k.xmag)             return xmag < k.xmag;
+      if (height != k.height)         return height < k.height;
+      if (showType != k.showType)     return showType < k.showType;
+      if (showEvents != k.showEvents) return showEvents < k.showEvents;
+      if (eventColor != k.eventColor) return eventColor < k.eventColor;
+      if (brightness != k.brightness) return brightness < k.brightness;
+      if (trackType != k.trackType)   return trackType < k.trackType;
+      return drumMap < k.drumMap;
+      }
+
+//---------------------------------------------------------
+//   find
+//---------------------------------------------------------
+
+const QImage* MidiThumbCache::find(const MidiThumbKey& key)
+      {
+      std::map<MidiThumbKey, Thumb>::iterator i = _thumbs.find(key);
+      if (i == _thumbs.end())
+            return 0;
+      _lru.splice(_lru.begin(), _lru, i->second.lru);
+      return &i->second.image;
+      }
+
+//---------------------------------------------------------
+//   add
+//---------------------------------------------------------
+
+const QImage* MidiThumbCache::add(const MidiThumbKey& key, const QImage& image)
+      {
+      std::pair<std::map<MidiThumbKey, Thumb>::iterator, bool> ins = _thumbs.insert(std::make_pair(key, Thumb()));
+      Thumb& t = ins.first->second;
+      if (ins.second) {
+            _lru.push_front(key);
+            t.lru = _lru.begin();
+            }
+      else {
+            _bytes -= t.image.byteCount();
+            _lru.splice(_lru.begin(), _lru, t.lru);
+            }
+      t.image = image;
+      _bytes += t.image.byteCount();
+      evict();
+      // Never evicted, it is the most recently used.
+      return &t.image;
+      }
+
+//---------------------------------------------------------
+//   remove
+//---------------------------------------------------------
+
+void MidiThumbCache::remove(const std::set<int>& cloneSNs)
+      {
+      if (cloneSNs.empty())
+            return;
+      for (std::map<MidiThumbKey, Thumb>::iterator i = _thumbs.begin(); i != _thumbs.end(); ) {
+            if (cloneSNs.find(i->first.cloneSN) == cloneSNs.end()) {
+                  ++i;
+                  continue;
+                  }
+            _bytes -= i->second.image.byteCount();
+            _lru.erase(i->second.lru);
+            _thumbs.erase(i++);
+            }
+      }
+
+//---------------------------------------------------------
+//   evict
+//    Drop least recently used thumbnails until the cache fits.
+//---------------------------------------------------------
+
+void MidiThumbCache::evict()
+      {
+      while (_bytes > MIDI_THUMB_CACHE_BYTES && _thumbs.size() > 1) {
+            std::map<MidiThumbKey, Thumb>::iterator oldest = _thumbs.find(_lru.back());
+            _bytes -= oldest->second.image.byteCount();
+            _thumbs.erase(oldest);
+            _lru.pop_back();
+            }
+      }
+
+} // namespace MusEGui
@@ -0,0 +1,91 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  midithumbs.h
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#ifndef __MIDITHUMBS_H__
+#define __MIDITHUMBS_H__
+
+#include <list>
+#include <map>
+#include <set>
+
+#include <QImage>
+#include <QColor>
+
+#define MIDI_THUMB_MAX_WIDTH   4096                // Wider parts are drawn directly.
+#define MIDI_THUMB_CACHE_BYTES (32 * 1024 * 1024)  // Least recently used thumbnails are dropped above this.
+
+namespace MusEGui {
+
+//---------------------------------------------------------
+//   MidiThumbKey
+//    Clones carry the same events, so they share one
+//     thumbnail through their clone chain serial, as long
+//     as their tracks lay the notes out the same way.
+//---------------------------------------------------------
+
+struct MidiThumbKey {
+      int cloneSN;
+      unsigned lenTick;
+      int xmag;
+      int height;
+      int showType;           // MusEGlobal::config.canvasShowPartType
+      int showEvents;         // MusEGlobal::config.canvasShowPartEvent
+      QRgb eventColor;
+      int brightness;
+      int trackType;          // MusECore::Track::TrackType
+      const void* drumMap;    // Drum map of drum tracks, else 0.
+
+      bool operator<(const MidiThumbKey&) const;
+      };
+
+//---------------------------------------------------------
+//   MidiThumbCache
+//    Rendered midi part contents. Gui thread only.
+//---------------------------------------------------------
+
+class MidiThumbCache {
+      struct Thumb {
+            QImage image;
+            std::list<MidiThumbKey>::iterator lru;   // Position in _lru.
+            };
+
+      std::map<MidiThumbKey, Thumb> _thumbs;
+      std::list<MidiThumbKey> _lru;   // Most recently used first.
+      size_t _bytes;
+
+      void evict();
+
+   public:
+      MidiThumbCache() : _bytes(0) {}
+
+      const QImage* find(const MidiThumbKey&);
+      // Stores the image and returns the cached copy.
+      const QImage* add(const MidiThumbKey&, const QImage&);
+      void clear() { _thumbs.clear(); _lru.clear(); _bytes = 0; }
+      // Drop the thumbnails of the given clone chains.
+      void remove(const std::set<int>& cloneSNs);
+      };
+
+} // namespace MusEGui
+
+#endif
+
@@ -29,6 +29,8 @@
 #include <uuid/uuid.h>
 #include <math.h>
 #include <map>
+#include <set>
+#include <vector>
 #include <assert.h>
 
 #include <QClipboard>
@@ -52,6 +54,7 @@
 #include "icons.h"
 #include "event.h"
 #include "wave.h"
+#include "wavetiles.h"
 #include "audio.h"
 #include "shortcuts.h"
 #include "gconfig.h"
@@ -60,6 +63,7 @@
 #include "filedialog.h"
 #include "marker/marker.h"
 #include "menutitleitem.h"
+#include "midiedit/drummap.h"
 #include "mpevent.h"
 #include "midievent.h"
 #include "midi.h"
@@ -122,6 +126,8 @@ PartCanvas::PartCanvas(int* r, QWidget* parent, int sx, int sy)
       automation.currentCtrlValid = false;
       automation.controllerState = doNothing;
       automation.moveController = false;
+      _waveTiles = new WaveTileCache(this);
+      connect(_waveTiles, SIGNAL(tilesReady()), SLOT(redraw()));
       partsChanged();
       }
 
@@ -422,6 +428,42 @@ void PartCanvas::songIsClearing()
 {
   curItem=NULL;
   items.clearDelete();
+  _waveTiles->clear();
+  _midiThumbs.clear();
+}
+
+//---------------------------------------------------------
+//   clearWaveTiles
+//---------------------------------------------------------
+
+void PartCanvas::clearWaveTiles()
+{
+  _waveTiles->clear();
+}
+
+//---------------------------------------------------------
+//   updateMidiThumbs
+//    Drop the thumbnails of the clone chains the current
+//     song change touched. Only live parts are looked at,
+//     thumbnails of deleted parts age out of the cache.
+//---------------------------------------------------------
+
+void PartCanvas::updateMidiThumbs(MusECore::SongChangedFlags_t flags)
+{
+  const MusECore::SongChangeJournal& changes = MusEGlobal::song->songChanges();
+  std::set<int> stale;
+  MusECore::MidiTrackList* mtl = MusEGlobal::song->midis();
+  for (MusECore::ciMidiTrack it = mtl->begin(); it != mtl->end(); ++it)
+  {
+    const MusECore::PartList* pl = (*it)->cparts();
+    for (MusECore::ciPart ip = pl->begin(); ip != pl->end(); ++ip)
+    {
+      // No track given: a clone on another track may be the one that changed.
+      if (changes.touches(flags, 0, ip->second))
+        stale.insert(ip->second->clonemaster_sn());
+    }
+  }
+  _midiThumbs.remove(stale);
 }
 
 //---------------------------------------------------------
@@ -1886,32 +1928,116 @@ void PartCanvas::drawMoving(QPainter& p, const CItem* item, const QRect&)
 
 void PartCanvas::drawMidiPart(QPainter& p, const QRect& rect, MusECore::MidiPart* midipart, const QRect& r, int from, int to)
 {
-	drawMidiPart(p, rect, midipart->events(), midipart->track(), midipart, r, midipart->tick(), from, to);
+	if (!drawMidiThumb(p, midipart, r, from, to))
+		drawMidiPart(p, rect, midipart->events(), midipart->track(), midipart, r, midipart->tick(), from, to);
 }
 
-void PartCanvas::drawMidiPart(QPainter& p, const QRect&, const MusECore::EventList& events, MusECore::MidiTrack *mt, MusECore::MidiPart *pt, const QRect& r, int pTick, int from, int to)
+//---------------------------------------------------------
+//   NoteColumn
+//    Pitch range and note count of one summarised column.
+//---------------------------------------------------------
+
+struct NoteColumn {
+      int minY, maxY, count;
+      };
+
+//---------------------------------------------------------
+//   midiEventColor
+//    Returns the brightness used for controller colours.
+//---------------------------------------------------------
+
+static int midiEventColor(const MusECore::MidiPart* pt, QColor* eventColor)
 {
-  int color_brightness;
-  QColor eventColor;
-  
   if(pt) 
   {
     int part_r, part_g, part_b, brightness;
     MusEGlobal::config.partColors[pt->colorIndex()].getRgb(&part_r, &part_g, &part_b);
     brightness =  part_r*29 + part_g*59 + part_b*12;
     if (brightness >= 12000 && !pt->selected()) {
-      eventColor=MusEGlobal::config.partMidiDarkEventColor;
-      color_brightness=54; // 96;    // too bright: use dark color
-    }
-    else {
-      eventColor=MusEGlobal::config.partMidiLightEventColor;
-      color_brightness=200; //160;   // too dark: use lighter color
+      *eventColor=MusEGlobal::config.partMidiDarkEventColor;
+      return 54; // 96;    // too bright: use dark color
     }
+    *eventColor=MusEGlobal::config.partMidiLightEventColor;
+    return 200; //160;   // too dark: use lighter color
   }
-  else {
-    eventColor=QColor(80,80,80);
-    color_brightness=80;
+  *eventColor=QColor(80,80,80);
+  return 80;
+}
+
+//---------------------------------------------------------
+//   drawMidiThumb
+//    Blit the part contents from a cached image, rendering
+//     it first if needed. Returns false if the part has to
+//     be drawn directly.
+//---------------------------------------------------------
+
+bool PartCanvas::drawMidiThumb(QPainter& p, MusECore::MidiPart* part, const QRect& r, int from, int to)
+{
+  if (from > to)
+    return false;
+  MusECore::MidiTrack* mt = part->track();
+  const unsigned len = part->lenTick();
+  const int pTick = part->tick();
+  const int x0 = mapx(pTick);
+  const int w = mapx(pTick + len) - x0 + 1;
+  if (w <= 0 || w > MIDI_THUMB_MAX_WIDTH)
+    return false;
+  const int h = mt->height();
+  if (h <= 0)
+    return false;
+
+  QColor eventColor;
+  MidiThumbKey key;
+  key.cloneSN    = part->clonemaster_sn();
+  key.lenTick    = len;
+  key.xmag       = xmag;
+  key.height     = h;
+  key.showType   = MusEGlobal::config.canvasShowPartType;
+  key.showEvents = MusEGlobal::config.canvasShowPartEvent;
+  key.brightness = midiEventColor(part, &eventColor);
+  key.eventColor = eventColor.rgba();
+  key.trackType  = mt->type();
+  if (mt->type() == MusECore::Track::NEW_DRUM)
+    key.drumMap = mt->drummap();
+  else if (mt->type() == MusECore::Track::DRUM)
+    key.drumMap = MusEGlobal::drumMap;
+  else
+    key.drumMap = 0;
+
+  const QImage* img = _midiThumbs.find(key);
+  if (!img) {
+    QImage image(w, h, QImage::Format_ARGB32_Premultiplied);
+    image.fill(0);
+    QPainter ip(&image);
+    ip.scale(xmag < 0 ? 1.0 / double(-xmag) : double(xmag), 1.0);
+    // Far zoomed out, many events share a pixel column. Summarise those instead.
+    const int step = rmapxDev(1);
+    const bool summary = step > 1 && part->events().size() > (size_t)w;
+    drawMidiPart(ip, QRect(), part->events(), mt, part, QRect(0, 0, len, h), 0, 0, len, summary ? step : 0);
+    ip.end();
+    img = _midiThumbs.add(key, image);
   }
+
+  const int sx = mapx(pTick + from);
+  const int ex = mapx(pTick + to);
+  if (ex <= sx)
+    return true;
+  p.setWorldMatrixEnabled(false);
+  p.drawImage(QRect(sx, mapy(r.y()), ex - sx, rmapy(h)), *img, QRect(sx - x0, 0, ex - sx, h));
+  p.setWorldMatrixEnabled(true);
+  return true;
+}
+
+//---------------------------------------------------------
+//   drawMidiPart
+//    summaryStep - if not 0, notes are drawn as one pitch
+//                  range per summaryStep ticks
+//---------------------------------------------------------
+
+void PartCanvas::drawMidiPart(QPainter& p, const QRect&, const MusECore::EventList& events, MusECore::MidiTrack *mt, MusECore::MidiPart *pt, const QRect& r, int pTick, int from, int to, int summaryStep)
+{
+  QColor eventColor;
+  int color_brightness = midiEventColor(pt, &eventColor);
     
   if (MusEGlobal::config.canvasShowPartType & 2) {      // show events
             p.setPen(eventColor);
@@ -1919,6 +2045,7 @@ void PartCanvas::drawMidiPart(QPainter& p, const QRect&, const MusECore::EventLi
             if(from <= to)
             {
               MusECore::ciEvent ito(events.lower_bound(to));
+              int lastCol = -1;
 
               for (MusECore::ciEvent i = events.lower_bound(from); i != ito; ++i) {
                     MusECore::EventType type = i->second.type();
@@ -1936,6 +2063,14 @@ void PartCanvas::drawMidiPart(QPainter& p, const QRect&, const MusECore::EventLi
                       ) {
                           int t = i->first + pTick;
                           int th = mt->height();
+                          if(summaryStep)
+                          {
+                            // Events are sorted, one line per column is enough.
+                            const int col = int(i->first) / summaryStep;
+                            if(col == lastCol)
+                              continue;
+                            lastCol = col;
+                          }
                           if(t >= r.left() && t <= r.right())
                             p.drawLine(t, r.y()+2, t, r.y()+th-4);
                           }
@@ -2090,6 +2225,13 @@ void PartCanvas::drawMidiPart(QPainter& p, const QRect&, const MusECore::EventLi
         if (MusEGlobal::heavyDebugMsg) printf("DEBUG: arranger: cakewalk enabled, y-stretch disabled\n");
       }
 
+      std::vector<NoteColumn> columns;
+      if (summaryStep)
+      {
+        NoteColumn empty = { 0, 0, 0 };
+        columns.assign((to - from) / summaryStep + 1, empty);
+      }
+
       p.setPen(eventColor);
       for (MusECore::ciEvent i = events.begin(); i != ito; ++i) {
             int t  = i->first + pTick;
@@ -2112,9 +2254,41 @@ void PartCanvas::drawMidiPart(QPainter& p, const QRect&, const MusECore::EventLi
                   else
                     y = hoffset + r.y() + y_mapper[pitch]*th/(highest_pitch-lowest_pitch);
                   
-                  p.drawLine(t, y, te, y);
+                  if (summaryStep)
+                  {
+                    int c0 = (t - pTick - from) / summaryStep;
+                    int c1 = (te - pTick - from) / summaryStep;
+                    if (c0 < 0)
+                      c0 = 0;
+                    if (c1 >= (int)columns.size())
+                      c1 = columns.size() - 1;
+                    for (int c = c0; c <= c1; ++c)
+                    {
+                      NoteColumn& nc = columns[c];
+                      if (nc.count == 0 || y < nc.minY)
+                        nc.minY = y;
+                      if (nc.count == 0 || y > nc.maxY)
+                        nc.maxY = y;
+                      ++nc.count;
+                    }
+                  }
+                  else
+                    p.drawLine(t, y, te, y);
             }
       }
+
+      // Denser columns are drawn more opaque.
+      for (unsigned c = 0; c < columns.size(); ++c)
+      {
+        const NoteColumn& nc = columns[c];
+        if (nc.count == 0)
+          continue;
+        QColor color(eventColor);
+        color.setAlpha(nc.count >= 4 ? 255 : 128 + nc.count * 32);
+        p.setPen(color);
+        const int x = pTick + from + c * summaryStep;
+        p.drawLine(x, nc.minY, x, nc.maxY);
+      }
   }
 }
 
@@ -2131,9 +2305,66 @@ void PartCanvas::drawWaveSndFile(QPainter &p, MusECore::SndFileR &f, int sampleP
          return;
          }
 
+   int tickstep = rmapxDev(1);
+
+   // Files being written (recording, external edits) change under us, draw those directly.
+   if (tickstep > 0 && !f.isWritable()) {
+         int tick0 = MusEGlobal::tempomap.frame2tick(rootFrame + startFrame);
+         int eventx = mapx(tick0);
+         int evEnd = mapx(MusEGlobal::tempomap.frame2tick(rootFrame + startFrame + lengthFrames));
+         int sx = x1 > eventx ? x1 : eventx;
+         int ex = evEnd < x2 ? evEnd : x2;
+         if (sx >= ex)
+               return;
+
+         WaveTileKey key;
+         key.file      = f.operator->();
+         key.samplePos = samplePos;
+         key.frame     = rootFrame + startFrame;
+         key.lenFrames = lengthFrames;
+         key.tickStep  = tickstep;
+         key.height    = rectHeight;
+         key.tempoSN   = MusEGlobal::tempomap.tempoSN();
+         key.peakColor = MusEGlobal::config.partWaveColorPeak.rgba();
+         key.rmsColor  = MusEGlobal::config.partWaveColorRms.rgba();
+         key.drawing   = MusEGlobal::config.waveDrawing;
+
+         const int firstTile = (sx - eventx) / WAVE_TILE_WIDTH;
+         const int lastTile  = (ex - 1 - eventx) / WAVE_TILE_WIDTH;
+         for (int t = firstTile; t <= lastTile; ++t) {
+               key.tile = t;
+               const int tx = eventx + t * WAVE_TILE_WIDTH;
+               bool missing;
+               const QImage* img = _waveTiles->find(key, &missing);
+               if (missing) {
+                     // The last tile ends with the event.
+                     int cols = evEnd - tx;
+                     if (cols > WAVE_TILE_WIDTH)
+                           cols = WAVE_TILE_WIDTH;
+                     if (cols <= 0)
+                           continue;
+                     std::vector<int> pos(cols + 1);
+                     for (int c = 0; c <= cols; ++c)
+                           pos[c] = samplePos + MusEGlobal::tempomap.tick2frame(tick0 + (t * WAVE_TILE_WIDTH + c) * tickstep)
+                                    - rootFrame - startFrame;
+                     img = _waveTiles->add(key, f, pos);
+                     }
+               if (!img || img->isNull())
+                     continue;   // Still rendering, tilesReady() redraws.
+               const int from = sx > tx ? sx : tx;
+               int to = tx + img->width();
+               if (to > ex)
+                     to = ex;
+               if (from >= to)
+                     continue;
+               p.drawImage(QRect(from, startY, to - from, rectHeight), *img,
+                           QRect(from - tx, 0, to - from, rectHeight));
+               }
+         return;
+         }
+
    int xScale;
    int pos;
-   int tickstep = rmapxDev(1);
    int postick = MusEGlobal::tempomap.frame2tick(rootFrame + startFrame);
    int eventx = mapx(postick);
    int drawoffset;
@@ -32,6 +32,7 @@
 #include "song.h"
 #include "canvas.h"
 #include "trackautomationview.h"
+#include "midithumbs.h"
 
 class QDropEvent;
 class QMouseEvent;
@@ -51,6 +52,7 @@ class Xml;
 namespace MusEGui {
 
 class MidiEditor;
+class WaveTileCache;
 
 //---------------------------------------------------------
 //   NPart
@@ -104,6 +106,8 @@ class PartCanvas : public Canvas {
       QTime editingFinishedTime;
 
       AutomationObject automation;
+      WaveTileCache* _waveTiles;
+      MidiThumbCache _midiThumbs;
 
       virtual void keyPress(QKeyEvent*);
       virtual bool mousePress(QMouseEvent*);
@@ -145,7 +149,8 @@ class PartCanvas : public Canvas {
       MusECore::Undo pasteAt(const QString&, MusECore::Track*, unsigned int, bool clone = false, bool toTrack = true, int* finalPosPtr = NULL, std::set<MusECore::Track*>* affected_tracks = NULL);
       void drawWaveSndFile(QPainter &p, MusECore::SndFileR &f, int samplePos, unsigned rootFrame, unsigned startFrame, unsigned lengthFrames, int startY, int startX, int endX, int rectHeight);
       void drawWavePart(QPainter&, const QRect&, MusECore::WavePart*, const QRect&);
-      void drawMidiPart(QPainter&, const QRect& rect, const MusECore::EventList& events, MusECore::MidiTrack* mt, MusECore::MidiPart* pt, const QRect& r, int pTick, int from, int to);
+      void drawMidiPart(QPainter&, const QRect& rect, const MusECore::EventList& events, MusECore::MidiTrack* mt, MusECore::MidiPart* pt, const QRect& r, int pTick, int from, int to, int summaryStep = 0);
+      bool drawMidiThumb(QPainter&, MusECore::MidiPart*, const QRect& r, int from, int to);
 	  void drawMidiPart(QPainter&, const QRect& rect, MusECore::MidiPart* midipart, const QRect& r, int from, int to);
       MusECore::Track* y2Track(int) const;
       void drawAudioTrack(QPainter& p, const QRect& r, const QRect& bbox, MusECore::AudioTrack* track);
@@ -190,6 +195,8 @@ class PartCanvas : public Canvas {
       void partsChanged();
       void cmd(int);
       void songIsClearing();
+      void clearWaveTiles();
+      void updateMidiThumbs(MusECore::SongChangedFlags_t);
       
    public slots:
       void redirKeypress(QKeyEvent* e) { keyPress(e); }
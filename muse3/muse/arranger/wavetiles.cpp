@@ -0,0 +1,344 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  wavetiles.cpp
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#include <QPainter>
+
+#include "wavetiles.h"
+#include "gconfig.h"
+
+namespace MusEGui {
+
+//---------------------------------------------------------
+//   WaveTileKey
+//---------------------------------------------------------
+
+bool WaveTileKey::operator<(const WaveTileKey& k) const
+      {
+      if (file != k.file)           return file < k.file;
+      if (samplePos != k.samplePos) return samplePos < k.samplePos;
+      if (frame != k.frame)         return frame < k.frame;
+      if (lenFrames != k.lenFrames) return lenFrames < k.lenFrames;
+      if (tickStep != k.tickStep)   return tickStep < k.tickStep;
+      if (tile != k.tile)           return tile < k.tile;
+      if (height != k.height)       return height < k.height;
+      if (tempoSN != k.tempoSN)     return tempoSN < k.tempoSN;
+      if (peakColor != k.peakColor) return peakColor < k.peakColor;
+      if (rmsColor != k.rmsColor)   return rmsColor < k.rmsColor;
+      return drawing < k.drawing;
+      }
+
+//---------------------------------------------------------
+//   WaveTileCache
+//---------------------------------------------------------
+
+WaveTileCache::WaveTileCache(QObject* parent)
+   : QThread(parent)
+      {
+      _bytes          = 0;
+      _quit           = false;
+      _collectPending = false;
+      start(QThread::LowPriority);
+      }
+
+WaveTileCache::~WaveTileCache()
+      {
+      _mutex.lock();
+      _quit = true;
+      _wake.wakeAll();
+      _mutex.unlock();
+      wait();
+      for (std::list<Job*>::iterator i = _jobs.begin(); i != _jobs.end(); ++i)
+            delete *i;
+      }
+
+//---------------------------------------------------------
+//   run
+//    Worker thread. Renders queued jobs one at a time.
+//---------------------------------------------------------
+
+void WaveTileCache::run()
+      {
+      _mutex.lock();
+      for (;;) {
+            if (_quit)
+                  break;
+            Job* job = 0;
+            for (std::list<Job*>::iterator i = _jobs.begin(); i != _jobs.end(); ++i) {
+                  if (!(*i)->running && !(*i)->done) {
+                        job = *i;
+                        break;
+                        }
+                  }
+            if (!job) {
+                  _wake.wait(&_mutex);
+                  continue;
+                  }
+            job->running = true;
+            _mutex.unlock();
+
+            QImage image;
+            if (!job->cancelled) {
+                  // The job holds a reference, so the file can't go away. Only its peak cache can.
+                  MusECore::SndFile::cacheMutex.lock();
+                  MusECore::SndFile* sf = const_cast<MusECore::SndFile*>(job->key.file);
+                  if (sf->isOpen())
+                        render(&image, sf, job->key, job->pos);
+                  MusECore::SndFile::cacheMutex.unlock();
+                  }
+
+            _mutex.lock();
+            job->image   = image;
+            job->running = false;
+            job->done    = true;
+            if (!_collectPending) {
+                  _collectPending = true;
+                  QMetaObject::invokeMethod(this, "collect", Qt::QueuedConnection);
+                  }
+            }
+      _mutex.unlock();
+      }
+
+//---------------------------------------------------------
+//   collect
+//    Move finished tiles into the cache. Gui thread.
+//---------------------------------------------------------
+
+void WaveTileCache::collect()
+      {
+      bool ready = false;
+      _mutex.lock();
+      _collectPending = false;
+      for (std::list<Job*>::iterator i = _jobs.begin(); i != _jobs.end(); ) {
+            Job* job = *i;
+            if (!job->done) {
+                  ++i;
+                  continue;
+                  }
+            if (!job->cancelled) {
+                  std::map<WaveTileKey, Tile>::iterator it = _tiles.find(job->key);
+                  if (it != _tiles.end()) {
+                        it->second.image   = job->image;
+                        it->second.pending = false;
+                        _bytes += job->image.byteCount();
+                        ready = true;
+                        }
+                  }
+            delete job;
+            i = _jobs.erase(i);
+            }
+      _mutex.unlock();
+
+      if (ready) {
+            evict();
+            emit tilesReady();
+            }
+      }
+
+//---------------------------------------------------------
+//   evict
+//    Drop least recently used tiles until the cache fits.
+//    Pending tiles and keep are never dropped.
+//---------------------------------------------------------
+
+void WaveTileCache::evict(const WaveTileKey* keep)
+      {
+      std::list<WaveTileKey>::iterator i = _lru.end();
+      while (_bytes > WAVE_TILE_CACHE_BYTES && i != _lru.begin()) {
+            --i;
+            std::map<WaveTileKey, Tile>::iterator it = _tiles.find(*i);
+            if (it->second.pending || (keep && !(*keep < *i) && !(*i < *keep)))
+                  continue;
+            _bytes -= it->second.image.byteCount();
+            _tiles.erase(it);
+            i = _lru.erase(i);
+            }
+      }
+
+//---------------------------------------------------------
+//   find
+//---------------------------------------------------------
+
+const QImage* WaveTileCache::find(const WaveTileKey& key, bool* missing)
+      {
+      std::map<WaveTileKey, Tile>::iterator i = _tiles.find(key);
+      if (i == _tiles.end()) {
+            *missing = true;
+            return 0;
+            }
+      *missing = false;
+      _lru.splice(_lru.begin(), _lru, i->second.lru);
+      if (i->second.pending)
+            return 0;
+      return &i->second.image;
+      }
+
+//---------------------------------------------------------
+//   add
+//---------------------------------------------------------
+
+const QImage* WaveTileCache::add(const WaveTileKey& key, const MusECore::SndFileR& file, const std::vector<int>& pos)
+      {
+      bool background = true;
+      for (unsigned c = 0; c + 1 < pos.size(); ++c) {
+            if (pos[c + 1] - pos[c] < MusECore::cacheMag) {
+                  background = false;
+                  break;
+                  }
+            }
+
+      std::pair<std::map<WaveTileKey, Tile>::iterator, bool> ins = _tiles.insert(std::make_pair(key, Tile()));
+      Tile& t = ins.first->second;
+      if (ins.second) {
+            _lru.push_front(key);
+            t.lru = _lru.begin();
+            }
+      else {
+            _bytes -= t.image.byteCount();
+            t.image = QImage();
+            _lru.splice(_lru.begin(), _lru, t.lru);
+            }
+
+      if (!background) {
+            t.pending = false;
+            render(&t.image, const_cast<MusECore::SndFile*>(key.file), key, pos);
+            _bytes += t.image.byteCount();
+            evict(&key);
+            return &t.image;
+            }
+
+      t.pending = true;
+      Job* job = new Job;
+      job->key       = key;
+      job->file      = file;
+      job->pos       = pos;
+      job->running   = false;
+      job->done      = false;
+      job->cancelled = false;
+      _mutex.lock();
+      _jobs.push_back(job);
+      _wake.wakeOne();
+      _mutex.unlock();
+      return 0;
+      }
+
+//---------------------------------------------------------
+//   clear
+//    Forget all tiles, for example after the wave data
+//     changed. Tiles being rendered are thrown away.
+//---------------------------------------------------------
+
+void WaveTileCache::clear()
+      {
+      _tiles.clear();
+      _lru.clear();
+      _bytes = 0;
+      _mutex.lock();
+      for (std::list<Job*>::iterator i = _jobs.begin(); i != _jobs.end(); ) {
+            Job* job = *i;
+            if (job->running || job->done) {
+                  job->cancelled = true;   // collect deletes it.
+                  ++i;
+                  continue;
+                  }
+            delete job;
+            i = _jobs.erase(i);
+            }
+      _mutex.unlock();
+      }
+
+//---------------------------------------------------------
+//   render
+//    Same drawing as PartCanvas::drawWaveSndFile, one
+//     pixel column per entry in pos.
+//---------------------------------------------------------
+
+void WaveTileCache::render(QImage* image, MusECore::SndFile* f, const WaveTileKey& key, const std::vector<int>& pos)
+      {
+      const int cols = pos.size() - 1;
+      const int rectHeight = key.height;
+      const unsigned channels = f->channels();
+      if (cols <= 0 || rectHeight <= 0 || channels == 0) {
+            *image = QImage();
+            return;
+            }
+      *image = QImage(cols, rectHeight, QImage::Format_ARGB32_Premultiplied);
+      image->fill(0);
+
+      QPainter p(image);
+      const QColor peakColor(key.peakColor);
+      const QColor rmsColor(key.rmsColor);
+      const bool rmsPeak = key.drawing == MusEGlobal::WaveRmsPeak;
+      int h = rectHeight >> 1;
+
+      if (h < 20) {
+            //    combine multi channels into one waveform
+            int y = h;
+            int cc = rectHeight % 2 ? 0 : 1;
+            for (int i = 0; i < cols; i++) {
+                  MusECore::SampleV sa[channels];
+                  f->read(sa, pos[i + 1] - pos[i], pos[i], true, false);
+                  int peak = 0;
+                  int rms  = 0;
+                  for (unsigned k = 0; k < channels; ++k) {
+                        if (sa[k].peak > peak)
+                              peak = sa[k].peak;
+                        rms += sa[k].rms;
+                        }
+                  rms /= channels;
+                  peak = (peak * (rectHeight-2)) >> 9;
+                  rms  = (rms  * (rectHeight-2)) >> 9;
+                  p.setPen(peakColor);
+                  p.drawLine(i, y - peak - cc-1, i, y + peak+1);
+                  p.setPen(rmsColor);
+                  if (rmsPeak)
+                        p.drawLine(i, y - rms - cc, i, y + rms);
+                  else // WaveOutLine
+                        p.drawLine(i, y - peak - cc, i, y + peak);
+                  }
+            }
+      else {
+            //  multi channel display
+            int hm = rectHeight / (channels * 2);
+            int cc = rectHeight % (channels * 2) ? 0 : 1;
+            for (int i = 0; i < cols; i++) {
+                  int y  = hm;
+                  MusECore::SampleV sa[channels];
+                  f->read(sa, pos[i + 1] - pos[i], pos[i], true, false);
+                  for (unsigned k = 0; k < channels; ++k) {
+                        int peak = (sa[k].peak * (hm - 1)) >> 8;
+                        int rms  = (sa[k].rms  * (hm - 1)) >> 8;
+                        int outer = peak +1;
+                        int inner = peak;
+                        p.setPen(peakColor);
+                        p.drawLine(i, y - outer - cc , i, y + outer);
+                        p.setPen(rmsColor);
+                        if (rmsPeak)
+                              p.drawLine(i, y - rms - cc, i, y + rms);
+                        else // WaveOutLine
+                              p.drawLine(i, y - inner - cc, i, y + inner);
+                        y  += 2 * hm;
+                        }
+                  }
+            }
+      }
+
+} // namespace MusEGui
@@ -0,0 +1,132 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  wavetiles.h
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#ifndef __WAVETILES_H__
+#define __WAVETILES_H__
+
+#include <map>
+#include <list>
+#include <vector>
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QImage>
+#include <QColor>
+
+#include "wave.h"
+
+#define WAVE_TILE_WIDTH       256                 // Pixel columns per tile.
+#define WAVE_TILE_CACHE_BYTES (64 * 1024 * 1024)  // Least recently used tiles are dropped above this.
+
+namespace MusEGui {
+
+//---------------------------------------------------------
+//   WaveTileKey
+//    Everything a rendered tile depends on. Tiles are
+//     counted from the start of the wave event, so they
+//     don't depend on the scroll position.
+//---------------------------------------------------------
+
+struct WaveTileKey {
+      const MusECore::SndFile* file;
+      int samplePos;          // Event offset into the file.
+      unsigned frame;         // Absolute frame at which the event starts.
+      unsigned lenFrames;
+      int tickStep;           // Ticks per pixel column.
+      int tile;
+      int height;
+      int tempoSN;
+      QRgb peakColor;
+      QRgb rmsColor;
+      int drawing;            // MusEGlobal::WaveDrawing
+
+      bool operator<(const WaveTileKey&) const;
+      };
+
+//---------------------------------------------------------
+//   WaveTileCache
+//    Arranger waveform tiles, rendered once into images
+//     and blitted on paint. Tiles which only need the peak
+//     cache are rendered by a worker thread. Closer zoom
+//     levels read the sound file through its gui handle,
+//     which is not thread safe, so those are rendered on
+//     demand in the gui thread and cached all the same.
+//---------------------------------------------------------
+
+class WaveTileCache : public QThread {
+      Q_OBJECT
+
+      struct Tile {
+            QImage image;
+            std::list<WaveTileKey>::iterator lru;   // Position in _lru.
+            bool pending;     // Being rendered by the worker.
+            Tile() : pending(false) {}
+            };
+      struct Job {
+            WaveTileKey key;
+            MusECore::SndFileR file;   // Keeps the file alive. Only copied and destroyed in the gui thread.
+            std::vector<int> pos;
+            QImage image;
+            bool running;
+            bool done;
+            bool cancelled;
+            };
+
+      // Gui thread only:
+      std::map<WaveTileKey, Tile> _tiles;
+      std::list<WaveTileKey> _lru;   // Most recently used first.
+      size_t _bytes;
+
+      // Shared with the worker:
+      QMutex _mutex;
+      QWaitCondition _wake;
+      std::list<Job*> _jobs;
+      bool _quit;
+      bool _collectPending;
+
+      virtual void run();
+      void evict(const WaveTileKey* keep = 0);
+      static void render(QImage*, MusECore::SndFile*, const WaveTileKey&, const std::vector<int>& pos);
+
+   private slots:
+      void collect();
+
+   signals:
+      void tilesReady();
+
+   public:
+      WaveTileCache(QObject* parent = 0);
+      virtual ~WaveTileCache();
+
+      // Returns the tile, or 0 if it is missing or still being rendered.
+      const QImage* find(const WaveTileKey&, bool* missing);
+      // Render a missing tile. pos holds the file position of each pixel column
+      //  plus one past the last. Returns the tile if it could be rendered right away.
+      const QImage* add(const WaveTileKey&, const MusECore::SndFileR&, const std::vector<int>& pos);
+      void clear();
+      };
+
+} // namespace MusEGui
+
+#endif
+
@@ -44,6 +44,7 @@
 #include "gconfig.h"
 #include "pos.h"
 #include "ticksynth.h"
+#include "xruntrace.h"
 //#include "operations.h"
 #include "undo.h"
 
@@ -320,6 +321,21 @@ void Audio::shutdown()
       write(sigFd, "S", 1);
       }
 
+//---------------------------------------------------------
+//   CycleTraceEnd
+//    Closes the xrun trace record on every return path of
+//     Audio::process. Cycles running to the end have closed
+//     it already with their plugin and synth figures.
+//---------------------------------------------------------
+
+class CycleTraceEnd {
+   public:
+      ~CycleTraceEnd() {
+            if (MusEGlobal::xrunTrace.recording())
+                  MusEGlobal::xrunTrace.endCycle(0.0, 0.0, -1);
+            }
+      };
+
 //---------------------------------------------------------
 //   process
 //    process one audio buffer at position "_pos "
@@ -329,6 +345,9 @@ void Audio::shutdown()
 void Audio::process(unsigned frames)
       {
       if (!MusEGlobal::checkAudioDevice()) return;
+      MusEGlobal::dspLoadProfiler.startCycle();
+      MusEGlobal::xrunTrace.beginCycle(frames, _pos.frame(), m_Xruns);
+      CycleTraceEnd cycleTraceEnd;
       if (msg) {
             processMsg(msg);
             int sn = msg->serialNo;
@@ -339,6 +358,7 @@ void Audio::process(unsigned frames)
                      fromThreadFdw, strerror(errno));
                   }
             }
+      MusEGlobal::xrunTrace.markMsg();
 
       OutputList* ol = MusEGlobal::song->outputs();
       if (idle) {
@@ -519,6 +539,8 @@ void Audio::process(unsigned frames)
       process1(samplePos, offset, frames);
       for (iAudioOutput i = ol->begin(); i != ol->end(); ++i)
             (*i)->processWrite();
+      if (MusEGlobal::xrunTrace.recording())
+            traceCycleEnd();
       
 #ifdef _AUDIO_USE_TRUE_FRAME_
       _previousPos = _pos;
@@ -540,6 +562,7 @@ void Audio::process1(unsigned samplePos, unsigned offset, unsigned frames)
       if (MusEGlobal::midiSeqRunning) {
             processMidi();
             }
+      MusEGlobal::xrunTrace.markMidi();
       //
       // process not connected tracks
       // to animate meter display
@@ -590,9 +613,14 @@ void Audio::process1(unsigned samplePos, unsigned offset, unsigned frames)
         }
       }      
       
+      MusEGlobal::xrunTrace.markPrep();
+
       OutputList* ol = MusEGlobal::song->outputs();
       for (ciAudioOutput i = ol->begin(); i != ol->end(); ++i) 
+      {
         (*i)->process(samplePos, offset, frames);
+        MusEGlobal::xrunTrace.markOutput();
+      }
             
       // Were ANY tracks unprocessed as a result of processing all the AudioOutputs, above? 
       // Not just unconnected ones, as previously done, but ones whose output path ultimately leads nowhere.
@@ -620,6 +648,50 @@ void Audio::process1(unsigned samplePos, unsigned offset, unsigned frames)
       }      
     }
 
+//---------------------------------------------------------
+//   traceCycleEnd
+//    Gather the cycle's plugin and synth times and the
+//     prefetch fifo levels for the xrun trace.
+//---------------------------------------------------------
+
+void Audio::traceCycleEnd()
+      {
+      const DspLoadProfiler& prof = MusEGlobal::dspLoadProfiler;
+      const unsigned cycle = prof.cycle();
+      double plugin_time = 0.0;
+      double synth_time  = 0.0;
+      int prefetch_min   = -1;
+
+      TrackList* tl = MusEGlobal::song->tracks();
+      for(ciTrack it = tl->begin(); it != tl->end(); ++it)
+      {
+        if((*it)->isMidiTrack())
+          continue;
+        AudioTrack* track = (AudioTrack*)(*it);
+        Pipeline* pipe = track->efxPipe();
+        if(pipe)
+        {
+          for(ciPluginI ip = pipe->begin(); ip != pipe->end(); ++ip)
+          {
+            if(*ip && (*ip)->dspLoad().cycle == cycle)
+              plugin_time += (*ip)->dspLoad().time;
+          }
+        }
+        if(track->type() == Track::AUDIO_SOFTSYNTH)
+        {
+          if(track->sourceLoad().cycle == cycle)
+            synth_time += track->sourceLoad().time;
+        }
+        else if(track->type() == Track::WAVE)
+        {
+          const int cnt = static_cast<WaveTrack*>(track)->prefetchFifo()->getCount();
+          if(prefetch_min < 0 || cnt < prefetch_min)
+            prefetch_min = cnt;
+        }
+      }
+      MusEGlobal::xrunTrace.endCycle(plugin_time, synth_time, prefetch_min);
+      }
+
 //---------------------------------------------------------
 //   processMsg
 //---------------------------------------------------------
@@ -305,6 +305,7 @@ class Audio {
       void initDevices(bool force = true);
 
       void sendMsgToGui(char c);
+      void traceCycleEnd();
       bool bounce() const { return _bounce; }
 
       long getXruns() { return m_Xruns; }
@@ -578,6 +578,23 @@ void AudioTrack::clearEfxList()
       (*_efxPipe)[i] = 0;
 }
 
+//---------------------------------------------------------
+//   resetDspLoadPeaks
+//---------------------------------------------------------
+
+void AudioTrack::resetDspLoadPeaks()
+{
+  _trackLoad.resetPeak();
+  _sourceLoad.resetPeak();
+  if(_efxPipe)
+    for(int i = 0; i < PipelineDepth; i++)
+    {
+      PluginI* p = (*_efxPipe)[i];
+      if(p)
+        p->resetDspLoadPeak();
+    }
+}
+
 //---------------------------------------------------------
 //   newPart
 //---------------------------------------------------------
@@ -0,0 +1,192 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  autosave.cpp
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <QFile>
+
+#include "autosave.h"
+#include "deferredevents.h"
+
+namespace MusEGui {
+
+//---------------------------------------------------------
+//   AutoSaveWriter
+//---------------------------------------------------------
+
+AutoSaveWriter::AutoSaveWriter(QObject* parent)
+   : QThread(parent)
+      {
+      _quit    = false;
+      _busy    = false;
+      _pending = false;
+      _events  = 0;
+      _serial  = 0;
+      start(QThread::LowPriority);
+      }
+
+AutoSaveWriter::~AutoSaveWriter()
+      {
+      // Let a queued save finish, it may be the last one before quitting.
+      waitIdle();
+      _mutex.lock();
+      _quit = true;
+      _wake.wakeAll();
+      _mutex.unlock();
+      wait();
+      delete _events;
+      }
+
+//---------------------------------------------------------
+//   write
+//---------------------------------------------------------
+
+void AutoSaveWriter::write(const QString& path, const QString& zip, const QByteArray& data,
+                           MusECore::DeferredEvents* events, unsigned serial)
+      {
+      _mutex.lock();
+      _path    = path;
+      _zip     = zip;
+      _data    = data;
+      delete _events;
+      _events  = events;
+      _serial  = serial;
+      _pending = true;
+      _wake.wakeOne();
+      _mutex.unlock();
+      }
+
+//---------------------------------------------------------
+//   waitIdle
+//---------------------------------------------------------
+
+void AutoSaveWriter::waitIdle()
+      {
+      _mutex.lock();
+      while (_pending || _busy)
+            _idle.wait(&_mutex);
+      _mutex.unlock();
+      }
+
+//---------------------------------------------------------
+//   run
+//---------------------------------------------------------
+
+void AutoSaveWriter::run()
+      {
+      _mutex.lock();
+      for (;;) {
+            while (!_pending && !_quit)
+                  _wake.wait(&_mutex);
+            if (_quit)
+                  break;
+            const QString path = _path;
+            const QString zip  = _zip;
+            QByteArray data = _data;
+            MusECore::DeferredEvents* events = _events;
+            const unsigned serial = _serial;
+            _data.clear();
+            _events  = 0;
+            _pending = false;
+            _busy    = true;
+            _mutex.unlock();
+
+            bool ok = true;
+            QString error;
+            if (events) {
+                  data = events->merge(data);
+                  delete events;
+                  if (data.isEmpty()) {
+                        ok = false;
+                        error = QString("cannot format events");
+                        }
+                  }
+            if (ok && (path != _lastPath || data != _lastData || !QFile::exists(path))) {
+                  ok = writeFile(path, zip, data, &error);
+                  if (ok) {
+                        _lastPath = path;
+                        _lastData = data;
+                        }
+                  }
+            emit saved(path, ok, error, serial);
+
+            _mutex.lock();
+            _busy = false;
+            _idle.wakeAll();
+            }
+      _mutex.unlock();
+      }
+
+//---------------------------------------------------------
+//   writeFile
+//    Returns false on error.
+//---------------------------------------------------------
+
+bool AutoSaveWriter::writeFile(const QString& path, const QString& zip, const QByteArray& data, QString* error)
+      {
+      const QString tmp = path + ".autosave";
+      FILE* f;
+      if (zip.isEmpty())
+            f = fopen(tmp.toLocal8Bit().constData(), "w");
+      else
+            f = popen((zip + " > \"" + tmp + "\"").toLocal8Bit().constData(), "w");
+      if (f == 0) {
+            *error = QString(strerror(errno));
+            return false;
+            }
+      bool ok = fwrite(data.constData(), 1, data.size(), f) == size_t(data.size());
+      if (ok && fflush(f) != 0)
+            ok = false;
+      if (ok && zip.isEmpty() && fsync(fileno(f)) != 0)
+            ok = false;
+      if (!ok)
+            *error = QString(strerror(errno));
+      if (zip.isEmpty()) {
+            if (fclose(f) != 0 && ok) {
+                  *error = QString(strerror(errno));
+                  ok = false;
+                  }
+            }
+      else if (pclose(f) != 0 && ok) {
+            *error = zip + " failed";
+            ok = false;
+            }
+      if (!ok) {
+            unlink(tmp.toLocal8Bit().constData());
+            return false;
+            }
+
+      // Same backup as a manual save, then replace the song in one step.
+      if (QFile::exists(path))
+            QFile::copy(path, path + ".backup");
+      if (rename(tmp.toLocal8Bit().constData(), path.toLocal8Bit().constData()) != 0) {
+            *error = QString(strerror(errno));
+            unlink(tmp.toLocal8Bit().constData());
+            return false;
+            }
+      return true;
+      }
+
+} // namespace MusEGui
@@ -0,0 +1,92 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  autosave.h
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#ifndef __AUTOSAVE_H__
+#define __AUTOSAVE_H__
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QByteArray>
+#include <QString>
+
+namespace MusECore {
+class DeferredEvents;
+}
+
+namespace MusEGui {
+
+//---------------------------------------------------------
+//   AutoSaveWriter
+//    Writes a song to disk. The gui thread serialises
+//     everything but the midi events, which it only packs
+//     into a DeferredEvents snapshot. Formatting those,
+//     compression, the backup copy and the disk writes
+//     happen in this thread, so neither a big song nor a
+//     slow disk stalls the gui. The new file is written
+//     next to the old one and renamed over it, so an
+//     interrupted save never leaves a truncated song.
+//---------------------------------------------------------
+
+class AutoSaveWriter : public QThread {
+      Q_OBJECT
+
+      QMutex _mutex;
+      QWaitCondition _wake;
+      QWaitCondition _idle;
+      bool _quit;
+      bool _busy;
+      bool _pending;
+      QString _path;          // Pending job.
+      QString _zip;
+      QByteArray _data;
+      MusECore::DeferredEvents* _events;
+      unsigned _serial;
+
+      // Worker thread only:
+      QString _lastPath;
+      QByteArray _lastData;   // Last written contents, unchanged songs are not rewritten.
+
+      virtual void run();
+      bool writeFile(const QString& path, const QString& zip, const QByteArray& data, QString* error);
+
+   signals:
+      // serial is the one passed to write().
+      void saved(const QString& path, bool ok, const QString& error, unsigned serial);
+
+   public:
+      AutoSaveWriter(QObject* parent = 0);
+      virtual ~AutoSaveWriter();
+
+      // Queue a write. Replaces a queued write that has not started yet.
+      // zip is the compressor command ("gzip", "bzip2") or empty.
+      // Takes ownership of events, which may be 0.
+      void write(const QString& path, const QString& zip, const QByteArray& data,
+                 MusECore::DeferredEvents* events, unsigned serial);
+      // Block until nothing is queued or being written.
+      void waitIdle();
+      };
+
+} // namespace MusEGui
+
+#endif
+
@@ -718,8 +718,14 @@ void readConfiguration(Xml& xml, bool doReadMidiPortConfig, bool doReadGlobalCon
                               MusEGlobal::config.style = xml.parse1();
                         else if (tag == "autoSave")
                               MusEGlobal::config.autoSave = xml.parseInt();
+                        else if (tag == "autoSaveInterval")
+                              MusEGlobal::config.autoSaveInterval = xml.parseInt();
                         else if (tag == "scrollableSubMenus")
                               MusEGlobal::config.scrollableSubMenus = xml.parseInt();
+                        else if (tag == "compactEventEncoding")
+                              MusEGlobal::config.compactEventEncoding = xml.parseInt();
+                        else if (tag == "undoMemoryLimit")
+                              MusEGlobal::config.undoMemoryLimit = xml.parseInt();
                         else if (tag == "liveWaveUpdate")
                               MusEGlobal::config.liveWaveUpdate = xml.parseInt();
                         else if (tag == "styleSheetFile")
@@ -1035,6 +1041,8 @@ void readConfiguration(Xml& xml, bool doReadMidiPortConfig, bool doReadGlobalCon
                               MusEGlobal::config.guiDivision = xml.parseInt();
                         else if (tag == "rtcTicks")
                               MusEGlobal::config.rtcTicks = xml.parseInt();
+                        else if (tag == "alsaMidiLookahead")
+                              MusEGlobal::config.alsaMidiLookahead = xml.parseInt();
                         else if (tag == "midiSendInit")
                               MusEGlobal::config.midiSendInit = xml.parseInt();
                         else if (tag == "warnInitPending")
@@ -1422,6 +1430,7 @@ void MusE::writeGlobalConfiguration(int level, MusECore::Xml& xml) const
 
       xml.intTag(level, "division", MusEGlobal::config.division);
       xml.intTag(level, "rtcTicks", MusEGlobal::config.rtcTicks);
+      xml.intTag(level, "alsaMidiLookahead", MusEGlobal::config.alsaMidiLookahead);
       xml.intTag(level, "midiSendInit", MusEGlobal::config.midiSendInit);
       xml.intTag(level, "warnInitPending", MusEGlobal::config.warnInitPending);
       xml.intTag(level, "midiSendCtlDefaults", MusEGlobal::config.midiSendCtlDefaults);
@@ -1472,6 +1481,7 @@ void MusE::writeGlobalConfiguration(int level, MusECore::Xml& xml) const
       
       xml.strTag(level, "theme", MusEGlobal::config.style);
       xml.intTag(level, "autoSave", MusEGlobal::config.autoSave);
+      xml.intTag(level, "autoSaveInterval", MusEGlobal::config.autoSaveInterval);
       xml.strTag(level, "styleSheetFile", MusEGlobal::config.styleSheetFile);
       xml.strTag(level, "externalWavEditor", MusEGlobal::config.externalWavEditor);
       xml.intTag(level, "useOldStyleStopShortCut", MusEGlobal::config.useOldStyleStopShortCut);
@@ -1496,6 +1506,8 @@ void MusE::writeGlobalConfiguration(int level, MusECore::Xml& xml) const
       xml.intTag(level, "synthTracksVisible",  MusECore::SynthI::visible());
       xml.intTag(level, "trackHeight",  MusEGlobal::config.trackHeight);
       xml.intTag(level, "scrollableSubMenus", MusEGlobal::config.scrollableSubMenus);
+      xml.intTag(level, "compactEventEncoding", MusEGlobal::config.compactEventEncoding);
+      xml.intTag(level, "undoMemoryLimit", MusEGlobal::config.undoMemoryLimit);
       xml.intTag(level, "liveWaveUpdate", MusEGlobal::config.liveWaveUpdate);
       xml.intTag(level, "lv2UiBehavior", static_cast<int>(MusEGlobal::config.lv2UiBehavior));
 
@@ -1242,6 +1242,31 @@ void MPConfig::deviceSelectionChanged()
   }
 }
 
+//---------------------------------------------------------
+//   setInstStatsToolTip
+//    Append the output counters of a device to its tooltip.
+//---------------------------------------------------------
+
+void MPConfig::setInstStatsToolTip(QTableWidgetItem *item, const MusECore::MidiDevice* md)
+      {
+      const MusECore::MidiOutputStats& st = md->outputStats();
+      if(st.events == 0 && st.fifoOverflows == 0)
+            return;
+      item->setToolTip(item->toolTip() + "\n" +
+         tr("Output: %1 messages, %2 late, %3 dropped\n"
+            "Buffer full: %4 periods, fifo overflows: %5\n"
+            "Most events waiting for later periods: %6")
+         .arg(st.events).arg(st.late).arg(st.dropped)
+         .arg(st.bufferFull).arg(st.fifoOverflows).arg(st.maxQueued));
+      if(st.scheduled != 0)
+            item->setToolTip(item->toolTip() + "\n" + tr("Timestamped ahead: %1 messages").arg(st.scheduled));
+      if(st.late != 0 && MusEGlobal::sampleRate != 0)
+            item->setToolTip(item->toolTip() + "\n" +
+               tr("Lateness: average %1 ms, worst %2 ms")
+               .arg(st.totalLateness * 1000.0 / (double(st.late) * MusEGlobal::sampleRate), 0, 'f', 2)
+               .arg(double(st.maxLateness) * 1000.0 / MusEGlobal::sampleRate, 0, 'f', 2));
+      }
+
 //---------------------------------------------------------
 //   songChanged
 //---------------------------------------------------------
@@ -1463,6 +1488,8 @@ void MPConfig::songChanged(MusECore::SongChangedFlags_t flags)
             iitem = new QTableWidgetItem(md->deviceTypeString());
             iitem->setData(DeviceRole, QVariant::fromValue<void*>(md));
             iitem->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
+            setInstToolTip(iitem, INSTCOL_TYPE);
+            setInstStatsToolTip(iitem, md);
             addInstItem(row_cnt, INSTCOL_TYPE, iitem, instanceList);
 
 #ifdef _USE_EXTRA_INSTANCE_COLUMNS_
@@ -75,6 +75,7 @@ class MPConfig : public QDialog, Ui::SynthConfigBase {
       void setToolTip(QTableWidgetItem *item, int col);
       void setInstWhatsThis(QTableWidgetItem *item, int col);
       void setInstToolTip(QTableWidgetItem *item, int col);
+      void setInstStatsToolTip(QTableWidgetItem *item, const MusECore::MidiDevice* md);
       void addItem(int row, int col, QTableWidgetItem *item, QTableWidget *table);
       void addInstItem(int row, int col, QTableWidgetItem *item, QTableWidget *table);
 
@@ -490,7 +490,22 @@ void CtrlCanvas::songChanged(MusECore::SongChangedFlags_t type)
   if(!curPart)         
     return;
               
-  if(type & (SC_CONFIG | SC_DRUMMAP | SC_PART_MODIFIED | SC_EVENT_INSERTED | SC_EVENT_REMOVED | SC_EVENT_MODIFIED))   
+  // Event changes only matter if they were made in one of our parts.
+  bool events_changed = false;
+  if(type & (SC_EVENT_INSERTED | SC_EVENT_REMOVED | SC_EVENT_MODIFIED))
+  {
+    const MusECore::SongChangeJournal& changes = MusEGlobal::song->songChanges();
+    for(MusECore::ciPart p = editor->parts()->begin(); p != editor->parts()->end(); ++p)
+    {
+      if(changes.touches(SC_EVENT_INSERTED | SC_EVENT_REMOVED | SC_EVENT_MODIFIED, p->second->track(), p->second))
+      {
+        events_changed = true;
+        break;
+      }
+    }
+  }
+  
+  if((type & (SC_CONFIG | SC_DRUMMAP | SC_PART_MODIFIED)) || events_changed)   
     updateItems();
   else if(type & SC_SELECTION)
     updateSelections();               
@@ -444,7 +444,7 @@ void CtrlPanel::ctrlChanged(double val)
         MusECore::MidiPlayEvent ev(0, outport, chan, MusECore::ME_CONTROLLER, _dnum, ival);
         MusEGlobal::audio->msgPlayMidiEvent(&ev);
       }
-      MusEGlobal::song->update(SC_MIDI_CONTROLLER);
+      MusEGlobal::song->scheduleUpdate(SC_MIDI_CONTROLLER, _track, _dnum);
     }
 
 //---------------------------------------------------------
@@ -0,0 +1,65 @@
+//=============================================================================
+//  MusE
+//  Linux Music Editor
+//
+//  deferredevents.h
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//=============================================================================
+
+#ifndef __DEFERREDEVENTS_H__
+#define __DEFERREDEVENTS_H__
+
+#include <vector>
+
+#include <QByteArray>
+
+namespace MusECore {
+
+class Xml;
+class EventList;
+
+//---------------------------------------------------------
+//   DeferredEvents
+//    Splits writing a song in two. While set on an Xml,
+//     Part::write only packs each midi part's events into
+//     a compact snapshot and notes where they belong in
+//     the output. merge() then formats them into place.
+//     It touches no song data, so it may run in another
+//     thread while the song is edited.
+//---------------------------------------------------------
+
+class DeferredEvents {
+      struct Chunk {
+            long offset;            // Output position the events go to.
+            int level;
+            unsigned tick;          // Part position, added to <event> ticks.
+            bool compact;           // Write as one <events> chunk.
+            int count;
+            QByteArray data;        // Packed like a compact event chunk.
+            };
+      std::vector<Chunk> _chunks;
+
+   public:
+      void add(Xml&, int level, const EventList&, unsigned partTick, bool compact);
+      bool empty() const { return _chunks.empty(); }
+      // Insert the events into the output written with this set.
+      // Returns an empty array if that fails.
+      QByteArray merge(const QByteArray& skeleton) const;
+      };
+
+} // namespace MusECore
+
+#endif
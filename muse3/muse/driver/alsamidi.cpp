@@ -22,6 +22,7 @@
 //=========================================================
 
 #include <stdio.h>
+#include <errno.h>
 
 #include "alsamidi.h"
 #include "globals.h"
@@ -57,6 +58,9 @@ static int alsaSeqFdo = -1;
 snd_seq_t* alsaSeq = 0;
 static snd_seq_addr_t musePort;
 static snd_seq_addr_t announce_adr;
+// Queue used to timestamp output events, and whether the output buffer holds undrained events.
+static int alsaOutQueue = -1;
+static bool alsaOutPending = false;
 
 //---------------------------------------------------------
 //   createAlsaMidiDevice
@@ -104,6 +108,8 @@ MidiAlsaDevice::MidiAlsaDevice(const snd_seq_addr_t& a, const QString& n)
    : MidiDevice(n)
       {
       adr = a;
+      _batching = false;
+      _batchFrame = 0;
       init();
       }
 
@@ -598,16 +604,33 @@ bool MidiAlsaDevice::putMidiEvent(const MidiPlayEvent& e)
             fprintf(stderr, "MidiOut: Alsa: <%s>: ", name().toLatin1().constData());
             e.dump();
             }
+      
+      // Events played ahead of time are handed to the queue, which delivers them at their
+      //  exact time instead of at the next timer tick.
+      const bool batched = _batching && pthread_equal(pthread_self(), _batchThread);
+      if (batched && alsaOutQueue >= 0 && e.time() > _batchFrame) {
+            const unsigned d = e.time() - _batchFrame;
+            snd_seq_real_time_t rt;
+            rt.tv_sec  = d / MusEGlobal::sampleRate;
+            rt.tv_nsec = (unsigned)((unsigned long long)(d % MusEGlobal::sampleRate) * 1000000000ULL / MusEGlobal::sampleRate);
+            snd_seq_ev_schedule_real(&event, alsaOutQueue, 1, &rt);   // Relative to now.
+            if (!putAlsaEvent(&event, true)) {
+                  ++_outputStats.scheduled;
+                  return false;
+                  }
+            return true;
+            }
             
-      return putAlsaEvent(&event);
+      return putAlsaEvent(&event, batched);
       }
 
 //---------------------------------------------------------
 //   putEvent
 //    return false if event is delivered
+//    Buffered events are sent by alsaDrainOutput.
 //---------------------------------------------------------
 
-bool MidiAlsaDevice::putAlsaEvent(snd_seq_event_t* event)
+bool MidiAlsaDevice::putAlsaEvent(snd_seq_event_t* event, bool buffered)
       {
       if(!alsaSeq)
         return true;
@@ -618,11 +641,26 @@ bool MidiAlsaDevice::putAlsaEvent(snd_seq_event_t* event)
       fprintf(stderr, "MidiAlsaDevice::putEvent\n");  
 #endif
 
+      if (buffered) {
+            error = snd_seq_event_output(alsaSeq, event);
+            if (error < 0) {
+                  // Buffer and kernel pool full. Try again next tick.
+                  if (error != -EAGAIN && error != -ENOMEM)
+                        fprintf(stderr, "MidiAlsaDevice::%p putEvent(): midi write error: %s\n",
+                           this, snd_strerror(error));
+                  return true;
+                  }
+            alsaOutPending = true;
+            ++_outputStats.events;
+            return false;
+            }
+
       do {
             error   = snd_seq_event_output_direct(alsaSeq, event);
             int len = snd_seq_event_length(event);
             if (error == len) {
 //                  printf(".");fflush(stdout);
+                  ++_outputStats.events;
                   return false;
                   }
             if (error < 0) {
@@ -829,10 +867,18 @@ void MidiAlsaDevice::processMidi()
   
   unsigned curFrame = MusEGlobal::audio->curFrame();
   
-  // Play all events up to current frame.
+  // Play all events up to current frame, plus the lookahead if the queue can
+  //  timestamp them. They are buffered and sent in one go by alsaDrainOutput.
+  unsigned limit = ext_sync ? pos : curFrame;
+  if(!ext_sync && alsaOutQueue >= 0 && MusEGlobal::config.alsaMidiLookahead > 0)
+    limit += (unsigned)((long long)MusEGlobal::config.alsaMidiLookahead * MusEGlobal::sampleRate / 1000);
+  _batchThread = pthread_self();
+  _batchFrame = curFrame;
+  _batching = !ext_sync;
+  
   iMPEvent i = _playEvents.begin();            
   for (; i != _playEvents.end(); ++i) {
-        if (i->time() > (ext_sync ? pos : curFrame))  // p3.3.25  Check: Should be nextTickPos? p4.0.34
+        if (i->time() > limit)  // p3.3.25  Check: Should be nextTickPos? p4.0.34
           break; 
         if(mp){
           if (mp->sendEvent(*i, true))  // Force the event to be sent.
@@ -841,8 +887,59 @@ void MidiAlsaDevice::processMidi()
         else 
           if(putMidiEvent(*i))
             break;
+        // Timer granularity. Time zero means play immediately, that's never late.
+        if(_batching && i->time() != 0 && i->time() < curFrame)
+          _outputStats.addLateness(curFrame - i->time());
         }
+  _batching = false;
   _playEvents.erase(_playEvents.begin(), i);
+  
+  const int queued = _playEvents.size();
+  if(queued > _outputStats.maxQueued)
+    _outputStats.maxQueued = queued;
+}
+
+//---------------------------------------------------------
+//   removeScheduledOutput
+//    Take back events waiting in the queue for this device,
+//     except note offs, so that nothing scheduled ahead plays
+//     after a stop or seek.
+//---------------------------------------------------------
+
+void MidiAlsaDevice::removeScheduledOutput()
+{
+  if(!alsaSeq || alsaOutQueue < 0 || adr.client == SND_SEQ_ADDRESS_UNKNOWN || adr.port == SND_SEQ_ADDRESS_UNKNOWN)
+    return;
+  snd_seq_remove_events_t* rm;
+  // Allocated on stack, no need to call snd_seq_remove_events_free() later.
+  snd_seq_remove_events_alloca(&rm);
+  snd_seq_remove_events_set_queue(rm, alsaOutQueue);
+  snd_seq_remove_events_set_dest(rm, &adr);
+  snd_seq_remove_events_set_condition(rm, SND_SEQ_REMOVE_OUTPUT | SND_SEQ_REMOVE_DEST | SND_SEQ_REMOVE_IGNORE_OFF);
+  int error = snd_seq_remove_events(alsaSeq, rm);
+  if(error < 0)
+    fprintf(stderr, "MidiAlsaDevice::removeScheduledOutput: %s\n", snd_strerror(error));
+}
+
+//---------------------------------------------------------
+//   handleStop
+//---------------------------------------------------------
+
+void MidiAlsaDevice::handleStop()
+{
+  // Before the stuck notes are released, or queued notes would start after their note offs.
+  removeScheduledOutput();
+  MidiDevice::handleStop();
+}
+
+//---------------------------------------------------------
+//   handleSeek
+//---------------------------------------------------------
+
+void MidiAlsaDevice::handleSeek()
+{
+  removeScheduledOutput();
+  MidiDevice::handleSeek();
 }
 
 /*
@@ -1235,6 +1332,17 @@ bool initMidiAlsa()
       musePort.port   = port;
       musePort.client = snd_seq_client_id(alsaSeq);
 
+      // Output events played ahead of time are timestamped on this queue.
+      alsaOutQueue = snd_seq_alloc_named_queue(alsaSeq, "MusE Output");
+      if (alsaOutQueue < 0) {
+            fprintf(stderr, "Alsa: Could not allocate output queue, midi lookahead disabled: %s\n", snd_strerror(alsaOutQueue));
+            alsaOutQueue = -1;
+            }
+      else {
+            snd_seq_start_queue(alsaSeq, alsaOutQueue, NULL);
+            snd_seq_drain_output(alsaSeq);
+            }
+
       //-----------------------------------------
       //    subscribe to "Announce"
       //    this enables callbacks for any
@@ -1307,6 +1415,15 @@ void exitMidiAlsa()
         fprintf(stderr, "MusE: exitMidiAlsa: Error unsubscribing alsa midi Announce port %d:%d for reading: %s\n", announce_adr.client, announce_adr.port, snd_strerror(error));
     }   
     
+    if(alsaOutQueue >= 0)
+    {
+      error = snd_seq_free_queue(alsaSeq, alsaOutQueue);
+      if(error < 0) 
+        fprintf(stderr, "MusE: Could not free ALSA output queue: %s\n", snd_strerror(error));
+      alsaOutQueue = -1;
+    }
+    alsaOutPending = false;
+    
     error = snd_seq_delete_simple_port(alsaSeq, musePort.port);
     if(error < 0) 
       fprintf(stderr, "MusE: Could not delete ALSA simple port: %s\n", snd_strerror(error));
@@ -1629,6 +1746,23 @@ int alsaSelectWfd()
       return alsaSeqFdo;
       }
 
+//---------------------------------------------------------
+//   alsaDrainOutput
+//    Send all events buffered during this tick in one go.
+//    Called from ALSA midi sequencer thread only.
+//---------------------------------------------------------
+
+void alsaDrainOutput()
+      {
+      if (!alsaSeq || !alsaOutPending)
+            return;
+      int error = snd_seq_drain_output(alsaSeq);
+      // Anything the kernel could not take yet stays buffered for the next tick.
+      alsaOutPending = error != 0;
+      if (error < 0 && error != -EAGAIN)
+            fprintf(stderr, "alsaDrainOutput: %s\n", snd_strerror(error));
+      }
+
 //---------------------------------------------------------
 //   processInput
 //---------------------------------------------------------
@@ -25,6 +25,7 @@
 #define __ALSAMIDI_H__
 
 #include <config.h>
+#include <pthread.h>
 #include <alsa/asoundlib.h>
 
 #include "mpevent.h"
@@ -52,8 +53,15 @@ class MidiAlsaDevice : public MidiDevice {
       virtual int selectRfd()      { return -1; }
       virtual int selectWfd();
 
-      bool putAlsaEvent(snd_seq_event_t*);
+      // Set while processMidi plays events from the sequencer thread. Only those
+      //  are buffered and timestamped, events from other threads still go out directly.
+      bool _batching;
+      pthread_t _batchThread;
+      unsigned _batchFrame;
+      
+      bool putAlsaEvent(snd_seq_event_t*, bool buffered = false);
       virtual bool putMidiEvent(const MidiPlayEvent&);
+      void removeScheduledOutput();
 
    public:
       MidiAlsaDevice(const snd_seq_addr_t&, const QString& name);
@@ -75,8 +83,8 @@ class MidiAlsaDevice : public MidiDevice {
       //virtual bool addStuckNote(const MidiPlayEvent& ev) { return !stuckNotesFifo.put(ev); }
       // Play all events up to current frame.
       virtual void processMidi();
-      //virtual void handleStop();
-      //virtual void handleSeek();
+      virtual void handleStop();
+      virtual void handleSeek();
 
       virtual void setAddressClient(int client) { adr.client = client; }
       virtual void setAddressPort(int port) { adr.port = port; }
@@ -87,6 +95,7 @@ extern void exitMidiAlsa();
 extern int alsaSelectRfd();
 extern int alsaSelectWfd();
 extern void alsaProcessMidiInput();
+extern void alsaDrainOutput();
 extern void alsaScanMidiPorts();
 extern void setAlsaClientName(const char*);
 
@@ -68,6 +68,8 @@ MidiJackDevice::MidiJackDevice(const QString& n)
 {
   _in_client_jackport  = NULL;
   _out_client_jackport = NULL;
+  _outBuf = 0;
+  _outFrame = 0;
   init();
 }
 
@@ -734,7 +736,10 @@ bool MidiJackDevice::putEvent(const MidiPlayEvent& ev)
       
   bool rv = eventFifo.put(ev);
   if(rv)
+  {
+    ++_outputStats.fifoOverflows;
     printf("MidiJackDevice::putEvent: port overflow\n");
+  }
   
   return rv;
 }
@@ -753,22 +758,28 @@ bool MidiJackDevice::queueEvent(const MidiPlayEvent& e)
       //if(port >= JACK_MIDI_CHANNELS)
       //  return false;
         
-      if(!_writeEnable || !_out_client_jackport)   
+      if(!_writeEnable || !_out_client_jackport || !_outBuf)   
         return false;
-      void* pb = jack_port_get_buffer(_out_client_jackport, MusEGlobal::segmentSize);  
+      void* pb = _outBuf;
     
       //unsigned frameCounter = ->frameTime();
       int frameOffset = MusEGlobal::audio->getFrameOffset();
       unsigned pos = MusEGlobal::audio->pos().frame();
       int ft = e.time() - frameOffset - pos;
       
-      if (ft < 0)
+      if (ft < 0) {
+            _outputStats.addLateness(-ft);
             ft = 0;
+            }
       if (ft >= (int)MusEGlobal::segmentSize) {
-            printf("MidiJackDevice::queueEvent: Event time:%d out of range. offset:%d ft:%d (seg=%d)\n", e.time(), frameOffset, ft, MusEGlobal::segmentSize);
-            if (ft > (int)MusEGlobal::segmentSize)
-                  ft = MusEGlobal::segmentSize - 1;
+            // processMidi holds back events of later periods, so this should not happen.
+            if(MusEGlobal::debugMsg)
+              printf("MidiJackDevice::queueEvent: Event time:%d out of range. offset:%d ft:%d (seg=%d)\n", e.time(), frameOffset, ft, MusEGlobal::segmentSize);
+            ft = MusEGlobal::segmentSize - 1;
             }
+      // Jack refuses messages earlier than the last one. Better a little late than lost.
+      if (ft < _outFrame)
+            ft = _outFrame;
       
       #ifdef JACK_MIDI_DEBUG
       printf("MidiJackDevice::queueEvent pos:%d fo:%d ft:%d time:%d type:%d ch:%d A:%d B:%d\n", pos, frameOffset, ft, e.time(), e.type(), e.channel(), e.dataA(), e.dataB());
@@ -831,6 +842,10 @@ bool MidiJackDevice::queueEvent(const MidiPlayEvent& e)
                   int len = e.len();
                   unsigned char* p = jack_midi_event_reserve(pb, ft, len+2);
                   if (p == 0) {
+                        // Only part of the buffer was left. Try again in an empty one next period.
+                        if (jack_midi_get_event_count(pb) != 0)
+                              return false;
+                        ++_outputStats.dropped;
                         fprintf(stderr, "MidiJackDevice::queueEvent ME_SYSEX: buffer overflow, sysex too big, event lost\n");
                         
                         //return false;
@@ -891,6 +906,8 @@ bool MidiJackDevice::queueEvent(const MidiPlayEvent& e)
                   return true;   // Absorb the event. Don't want it hanging around in the list. 
             }
             
+            _outFrame = ft;
+            ++_outputStats.events;
             return true;
 }
       
@@ -1272,11 +1289,12 @@ void MidiJackDevice::processMidi()
   //if(_port == -1)
   //  return;
     
-  void* port_buf = 0;
+  _outBuf = 0;
+  _outFrame = 0;
   if(_out_client_jackport && _writeEnable)  
   {
-    port_buf = jack_port_get_buffer(_out_client_jackport, MusEGlobal::segmentSize);
-    jack_midi_clear_buffer(port_buf);
+    _outBuf = jack_port_get_buffer(_out_client_jackport, MusEGlobal::segmentSize);
+    jack_midi_clear_buffer(_outBuf);
   }  
   
   int port = midiPort();
@@ -1406,35 +1424,82 @@ void MidiJackDevice::processMidi()
   }
   */
   
-  while(!eventFifo.isEmpty())
-  {
-    MidiPlayEvent e(eventFifo.peek()); 
-    //printf("MidiJackDevice::processMidi FIFO event time:%d type:%d ch:%d A:%d B:%d\n", e.time(), e.type(), e.channel(), e.dataA(), e.dataB()); 
-    // Try to process only until full, keep rest for next cycle. If no out client port or no write enable, eat up events.  p4.0.15 
-    if(port_buf && !processEvent(e))  
-      return;            // Give up. The Jack buffer is full. Nothing left to do.  
-    eventFifo.remove();  // Successfully processed event. Remove it from FIFO.
-  }
-  
-  //if(!(stop || (seek && is_playing)))
-  //  processStuckNotes();  
-  
-  if(_playEvents.empty())
-    return;
+  // Merge the gui fifo and the scheduled play events into the buffer in one
+  //  pass, in time order. Events due in later periods stay where they are,
+  //  so the sequencer may schedule further ahead than one period.
+  // If there is no out client port or no write enable, due events are eaten up.
+  const bool ext_sync = MusEGlobal::extSyncFlag.value();
+  const unsigned cycle_start = MusEGlobal::audio->getFrameOffset() + MusEGlobal::audio->pos().frame();
+  const unsigned cycle_end = cycle_start + MusEGlobal::segmentSize;
   
   iMPEvent i = _playEvents.begin();     
-  for(; i != _playEvents.end(); ++i) 
+  bool fifo_held = false;
+  bool play_held = false;
+  while(true)
   {
-    //printf("MidiJackDevice::processMidi playEvent time:%d type:%d ch:%d A:%d B:%d\n", i->time(), i->type(), i->channel(), i->dataA(), i->dataB()); 
+    const bool have_fifo = !fifo_held && !eventFifo.isEmpty();
+    const bool have_play = !play_held && i != _playEvents.end();
+    if(!have_fifo && !have_play)
+      break;
+    
+    const unsigned fifo_frame = have_fifo ? eventFrame(eventFifo.peek(), cycle_start, ext_sync) : 0;
+    const unsigned play_frame = have_play ? eventFrame(*i, cycle_start, ext_sync) : 0;
+    const bool use_fifo = have_fifo && (!have_play || fifo_frame <= play_frame);
+    const MidiPlayEvent& e = use_fifo ? eventFifo.peek() : *i;
+    
+    if(!ext_sync && (use_fifo ? fifo_frame : play_frame) >= cycle_end)
+    {
+      // Not due yet. The play events are sorted, so the rest of them are not due either.
+      if(use_fifo)
+        fifo_held = true;
+      else
+        play_held = true;
+      continue;
+    }
+    
     // Update hardware state so knobs and boxes are updated. Optimize to avoid re-setting existing values.   
-    if(mp && !mp->sendHwCtrlState(*i, true)) // Force the event to be sent.
+    if(!use_fifo && mp && !mp->sendHwCtrlState(e, true)) // Force the event to be sent.
+    {
+      ++i;
       continue;
-  
-    // Try to process only until full, keep rest for next cycle. If no out client port or no write enable, eat up events.  p4.0.15 
-    if(port_buf && !processEvent(*i)) 
-      break;
+    }
+    
+    if(_outBuf)
+    {
+      // Don't start an event which might not fit completely. Keep it and the rest for next cycle. 
+      if((jack_midi_max_event_size(_outBuf) < JACK_MIDI_OUT_EVENT_GUARD && jack_midi_get_event_count(_outBuf) != 0) || 
+         !processEvent(e))
+      {
+        ++_outputStats.bufferFull;
+        break;
+      }
+    }
+    
+    if(use_fifo)
+      eventFifo.remove();  // Successfully processed event. Remove it from FIFO.
+    else
+      ++i;
   }
   _playEvents.erase(_playEvents.begin(), i);
+  
+  const int queued = _playEvents.size() + eventFifo.getSize();
+  if(queued > _outputStats.maxQueued)
+    _outputStats.maxQueued = queued;
+}
+
+//---------------------------------------------------------
+//    eventFrame
+//    Absolute frame at which an event is due.
+//    Events marked for immediate playback (time zero), and all events
+//     with external sync (their times are ticks), are due at the start
+//     of the current period.
+//---------------------------------------------------------
+
+unsigned MidiJackDevice::eventFrame(const MidiPlayEvent& e, unsigned cycleStart, bool extSync) const
+{
+  if(extSync || e.time() == 0)
+    return cycleStart;
+  return e.time();
 }
 
 /*
@@ -47,6 +47,11 @@ class Xml;
 // Jack doesn't seem to like manipulation of non-local ports buffers.
 //#define JACK_MIDI_USE_MULTIPLE_CLIENT_PORTS
 
+// An event is only started when at least this many bytes are free in the output buffer,
+//  so that controllers expanding to several messages (RPN, NRPN, bank + program) are
+//  never split across periods and partly sent twice.
+#define JACK_MIDI_OUT_EVENT_GUARD 96
+
 //---------------------------------------------------------
 //   MidiJackDevice
 //---------------------------------------------------------
@@ -57,6 +62,11 @@ class MidiJackDevice : public MidiDevice {
       jack_port_t* _in_client_jackport;
       jack_port_t* _out_client_jackport;
       
+      // Output buffer of the current period, and frame offset of the last message
+      //  written to it. Jack requires messages in non-decreasing time order.
+      void* _outBuf;
+      int _outFrame;
+      
       //RouteList _routes;
       
       virtual QString open();
@@ -66,6 +76,7 @@ class MidiJackDevice : public MidiDevice {
       bool processEvent(const MidiPlayEvent&);
       // Port is not midi port, it is the port(s) created for MusE.
       bool queueEvent(const MidiPlayEvent&);
+      unsigned eventFrame(const MidiPlayEvent&, unsigned cycleStart, bool extSync) const;
       
       virtual bool putMidiEvent(const MidiPlayEvent&);
       //bool sendEvent(const MidiPlayEvent&);
@@ -0,0 +1,143 @@
+//=============================================================================
+//  MusE
+//  Linux Music Editor
+//
+//  dspload.cpp
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//=============================================================================
+
+#include "dspload.h"
+#include "globals.h"
+
+namespace MusEGlobal {
+MusECore::DspLoadProfiler dspLoadProfiler;
+}
+
+namespace MusECore {
+
+//---------------------------------------------------------
+//   DspLoadProfiler
+//---------------------------------------------------------
+
+DspLoadProfiler::DspLoadProfiler()
+      {
+      _depth    = 0;
+      _overflow = 0;
+      _mark     = 0.0;
+      _cycle    = 0;
+      }
+
+//---------------------------------------------------------
+//   charge
+//    Add time to a load, rolling its figures over first
+//     if this is the first charge in a new cycle.
+//---------------------------------------------------------
+
+void DspLoadProfiler::charge(DspLoad* l, double t)
+      {
+      if(l->cycle != _cycle) {
+            l->lastTime = (l->cycle + 1 == _cycle) ? l->time : 0.0;
+            l->time     = 0.0;
+            l->cycle    = _cycle;
+            }
+      l->time += t;
+      if(l->time > l->peakTime)
+            l->peakTime = l->time;
+      }
+
+//---------------------------------------------------------
+//   begin
+//    Pause the enclosing section and start timing l.
+//---------------------------------------------------------
+
+void DspLoadProfiler::begin(DspLoad* l)
+      {
+      if(_overflow || _depth >= DSP_LOAD_MAX_DEPTH) {
+            ++_overflow;
+            return;
+            }
+      const double t = now();
+      if(_depth > 0)
+            charge(_stack[_depth - 1], t - _mark);
+      else
+            charge(l, 0.0);  // Roll over even if nothing gets charged later.
+      _stack[_depth++] = l;
+      _mark = t;
+      }
+
+//---------------------------------------------------------
+//   end
+//    Charge the innermost section and resume the enclosing one.
+//---------------------------------------------------------
+
+void DspLoadProfiler::end()
+      {
+      if(_overflow) {
+            --_overflow;
+            return;
+            }
+      if(_depth == 0)
+            return;
+      const double t = now();
+      charge(_stack[--_depth], t - _mark);
+      _mark = t;
+      }
+
+//---------------------------------------------------------
+//   lastTime
+//    Seconds used by l in the last complete cycle.
+//---------------------------------------------------------
+
+double DspLoadProfiler::lastTime(const DspLoad& l) const
+      {
+      const unsigned c = _cycle;
+      if(l.cycle == c)
+            return l.lastTime;
+      if(l.cycle + 1 == c)
+            return l.time;
+      return 0.0;
+      }
+
+//---------------------------------------------------------
+//   load
+//---------------------------------------------------------
+
+double DspLoadProfiler::load(double time) const
+      {
+      if(MusEGlobal::sampleRate == 0 || MusEGlobal::segmentSize == 0)
+            return 0.0;
+      return time * 100.0 * (double)MusEGlobal::sampleRate / (double)MusEGlobal::segmentSize;
+      }
+
+//---------------------------------------------------------
+//   lastLoad
+//---------------------------------------------------------
+
+double DspLoadProfiler::lastLoad(const DspLoad& l) const
+      {
+      return load(lastTime(l));
+      }
+
+//---------------------------------------------------------
+//   peakLoad
+//---------------------------------------------------------
+
+double DspLoadProfiler::peakLoad(const DspLoad& l) const
+      {
+      return load(l.peakTime);
+      }
+
+} // namespace MusECore
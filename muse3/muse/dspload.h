@@ -0,0 +1,108 @@
+//=============================================================================
+//  MusE
+//  Linux Music Editor
+//
+//  dspload.h
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//=============================================================================
+
+#ifndef __DSPLOAD_H__
+#define __DSPLOAD_H__
+
+#include <time.h>
+
+#define DSP_LOAD_MAX_DEPTH 64
+
+namespace MusECore {
+
+//---------------------------------------------------------
+//   DspLoad
+//    Processing time used by one track, synth or plugin.
+//    Written by the audio thread only. The gui just reads
+//     the values, a slightly stale figure does no harm.
+//---------------------------------------------------------
+
+struct DspLoad {
+      unsigned cycle;     // Process cycle in which 'time' was last accumulated.
+      double time;        // Seconds accumulated during 'cycle'.
+      double lastTime;    // Seconds used in the cycle before 'cycle', if any.
+      double peakTime;    // Worst single cycle since last reset.
+
+      DspLoad() { cycle = 0; time = lastTime = peakTime = 0.0; }
+      void resetPeak() { peakTime = 0.0; }
+      };
+
+//---------------------------------------------------------
+//   DspLoadProfiler
+//    Exclusive (self) time accounting for the audio thread.
+//    Timed sections may nest, for example a track pulling
+//     its input tracks, or plugins inside a track. The time
+//     spent in a nested section is charged to the nested
+//     object only, never to its parent as well.
+//---------------------------------------------------------
+
+class DspLoadProfiler {
+      DspLoad* _stack[DSP_LOAD_MAX_DEPTH];
+      int _depth;
+      int _overflow;
+      double _mark;
+      volatile unsigned _cycle;
+
+      void charge(DspLoad* l, double t);
+
+   public:
+      DspLoadProfiler();
+
+      // Monotonic time in seconds with nanosecond resolution. Realtime safe.
+      static double now() {
+            struct timespec t;
+            clock_gettime(CLOCK_MONOTONIC, &t);
+            return (double)t.tv_sec + (double)t.tv_nsec / 1000000000.0;
+            }
+
+      // Audio thread:
+      void startCycle()       { ++_cycle; _depth = 0; _overflow = 0; }
+      void begin(DspLoad* l);
+      void end();
+
+      // Gui thread:
+      unsigned cycle() const  { return _cycle; }
+      double lastTime(const DspLoad& l) const;
+      double load(double time) const;            // Seconds in percent of one period.
+      double lastLoad(const DspLoad& l) const;   // In percent of one period.
+      double peakLoad(const DspLoad& l) const;   // In percent of one period.
+      };
+
+//---------------------------------------------------------
+//   DspLoadScope
+//    Times a block of code.
+//---------------------------------------------------------
+
+class DspLoadScope {
+      DspLoadProfiler* _p;
+   public:
+      DspLoadScope(DspLoadProfiler* p, DspLoad* l) : _p(p) { _p->begin(l); }
+      ~DspLoadScope() { _p->end(); }
+      };
+
+} // namespace MusECore
+
+namespace MusEGlobal {
+extern MusECore::DspLoadProfiler dspLoadProfiler;
+}
+
+#endif
+
@@ -79,6 +79,11 @@ iEvent EventList::add(Event event)
         return insert(std::pair<const unsigned, Event> (event.frame(), event));          
 
       unsigned key = event.tick();
+      // Events mostly arrive in time order, for example when a song is loaded.
+      // Appending at the end then needs no search.
+      if(empty() || key > rbegin()->first || (key == rbegin()->first && event.type() == Note))
+        return insert(end(), std::pair<const unsigned, Event> (key, event));
+
       if(event.type() == Note)      // Place notes after controllers.
       {
         iEvent i = upper_bound(key);
@@ -270,6 +270,17 @@ void MusE::exportMidi()
          tr("MusE: Export Midi"));
       if (fp == 0)
             return;
+      exportMidi(fp);
+      }
+
+//---------------------------------------------------------
+//   exportMidi
+//    Write the song as a standard midi file to fp.
+//    return true on success
+//---------------------------------------------------------
+
+bool MusE::exportMidi(FILE* fp)
+      {
       MusECore::MidiFile mf(fp);
 
       MusECore::TrackList* tl = MusEGlobal::song->tracks();       // Changed to full track list so user can rearrange tracks.
@@ -531,8 +542,7 @@ void MusE::exportMidi()
       mf.setDivision(MusEGlobal::config.midiDivision);
       // Takes ownership of mtl and its contents.
       mf.setTrackList(mtl, i);
-      mf.write();
-
+      return !mf.write();
       }
 
 } // namespace MusEGui
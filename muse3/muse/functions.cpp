@@ -67,6 +67,89 @@ namespace MusECore {
 
 bool read_eventlist_and_part(Xml& xml, EventList* el, int* part_id);
 
+// Parts with fewer edits than this still get one operation per event. Below it,
+// copying the part's whole event list costs more than it saves.
+#define BULK_EDIT_MIN_EVENTS 64
+
+//---------------------------------------------------------
+//   EventEdits
+//    Collects event modifications and deletions per part.
+//    Parts with many edits get a single ModifyEventList
+//     operation, so large edits don't flood the undo list
+//     and the realtime stage with one operation per note.
+//---------------------------------------------------------
+
+class EventEdits {
+      struct Edit {
+            Event oldEvent;
+            Event newEvent;   // Empty: delete oldEvent.
+            };
+      std::map<const Part*, std::vector<Edit> > _edits;
+
+      std::vector<Edit>& edits(const Part* part);
+
+   public:
+      void modify(const Event& newEvent, const Event& oldEvent, const Part* part);
+      void remove(const Event& event, const Part* part);
+      void flush(Undo& operations);
+      };
+
+std::vector<EventEdits::Edit>& EventEdits::edits(const Part* part)
+{
+	// Clones share their events, collect them under one part.
+	for (std::map<const Part*, std::vector<Edit> >::iterator it = _edits.begin(); it != _edits.end(); it++)
+		if (it->first->isCloneOf(part))
+			return it->second;
+	return _edits[part];
+}
+
+void EventEdits::modify(const Event& newEvent, const Event& oldEvent, const Part* part)
+{
+	Edit e;
+	e.oldEvent = oldEvent;
+	e.newEvent = newEvent;
+	edits(part).push_back(e);
+}
+
+void EventEdits::remove(const Event& event, const Part* part)
+{
+	Edit e;
+	e.oldEvent = event;
+	edits(part).push_back(e);
+}
+
+void EventEdits::flush(Undo& operations)
+{
+	for (std::map<const Part*, std::vector<Edit> >::iterator it = _edits.begin(); it != _edits.end(); it++)
+	{
+		const Part* part = it->first;
+		const std::vector<Edit>& v = it->second;
+		
+		if (v.size() < BULK_EDIT_MIN_EVENTS)
+		{
+			for (std::vector<Edit>::const_iterator e = v.begin(); e != v.end(); e++)
+				if (e->newEvent.empty())
+					operations.push_back(UndoOp(UndoOp::DeleteEvent, e->oldEvent, part, false, false));
+				else
+					operations.push_back(UndoOp(UndoOp::ModifyEvent, e->newEvent, e->oldEvent, part, false, false));
+			continue;
+		}
+		
+		EventList* erase = new EventList();
+		EventList* add = new EventList();
+		for (std::vector<Edit>::const_iterator e = v.begin(); e != v.end(); e++)
+		{
+			if (erase->findWithId(e->oldEvent) != erase->end())
+				continue; // Same event seen through a clone part.
+			erase->add(e->oldEvent);
+			if (!e->newEvent.empty())
+				add->add(e->newEvent);
+		}
+		operations.push_back(UndoOp(UndoOp::ModifyEventList, part, erase, add, false, false));
+	}
+	_edits.clear();
+}
+
 // -----------------------
 
 
@@ -443,6 +526,7 @@ bool modify_velocity(const set<const Part*>& parts, int range, int rate, int off
 {
 	map<const Event*, const Part*> events = get_events(parts, range);
 	Undo operations;
+	EventEdits edits;
 	
 	if ( (!events.empty()) && ((rate!=100) || (offset!=0)) )
 	{
@@ -465,10 +549,11 @@ bool modify_velocity(const set<const Part*>& parts, int range, int rate, int off
 			{
 				Event newEvent = event.clone();
 				newEvent.setVelo(velo);
-				operations.push_back(UndoOp(UndoOp::ModifyEvent, newEvent, event, part, false, false));
+				edits.modify(newEvent, event, part);
 			}
 		}
 		
+		edits.flush(operations);
 		return MusEGlobal::song->applyOperationGroup(operations);
 	}
 	else
@@ -479,6 +564,7 @@ bool modify_off_velocity(const set<const Part*>& parts, int range, int rate, int
 {
 	map<const Event*, const Part*> events = get_events(parts, range);
 	Undo operations;
+	EventEdits edits;
 	
 	if ( (!events.empty()) && ((rate!=100) || (offset!=0)) )
 	{
@@ -501,10 +587,11 @@ bool modify_off_velocity(const set<const Part*>& parts, int range, int rate, int
 			{
 				Event newEvent = event.clone();
 				newEvent.setVeloOff(velo);
-				operations.push_back(UndoOp(UndoOp::ModifyEvent, newEvent, event, part, false, false));
+				edits.modify(newEvent, event, part);
 			}
 		}
 
+		edits.flush(operations);
 		return MusEGlobal::song->applyOperationGroup(operations);
 	}
 	else
@@ -515,6 +602,7 @@ bool modify_notelen(const set<const Part*>& parts, int range, int rate, int offs
 {
 	map<const Event*, const Part*> events = get_events(parts, range);
 	Undo operations;
+	EventEdits edits;
 	map<const Part*, int> partlen;
 	
 	if ( (!events.empty()) && ((rate!=100) || (offset!=0)) )
@@ -539,10 +627,12 @@ bool modify_notelen(const set<const Part*>& parts, int range, int rate, int offs
 			{
 				Event newEvent = event.clone();
 				newEvent.setLenTick(len);
-				operations.push_back(UndoOp(UndoOp::ModifyEvent, newEvent, event, part, false, false));
+				edits.modify(newEvent, event, part);
 			}
 		}
 		
+		edits.flush(operations);
+		
 		for (map<const Part*, int>::iterator it=partlen.begin(); it!=partlen.end(); it++)
 			schedule_resize_all_same_len_clone_parts(it->first, it->second, operations);
 
@@ -583,6 +673,7 @@ bool quantize_notes(const set<const Part*>& parts, int range, int raster, bool q
 {
 	map<const Event*, const Part*> events = get_events(parts, range);
 	Undo operations;
+	EventEdits edits;
 	
 	if (!events.empty())
 	{
@@ -615,10 +706,11 @@ bool quantize_notes(const set<const Part*>& parts, int range, int raster, bool q
 				Event newEvent = event.clone();
 				newEvent.setTick(begin_tick - part->tick());
 				newEvent.setLenTick(len);
-				operations.push_back(UndoOp(UndoOp::ModifyEvent, newEvent, event, part, false, false));
+				edits.modify(newEvent, event, part);
 			}
 		}
 		
+		edits.flush(operations);
 		return MusEGlobal::song->applyOperationGroup(operations);
 	}
 	else
@@ -629,6 +721,7 @@ bool erase_notes(const set<const Part*>& parts, int range, int velo_threshold, b
 {
 	map<const Event*, const Part*> events = get_events(parts, range);
 	Undo operations;
+	EventEdits edits;
 	
 	if (!events.empty())
 	{
@@ -640,9 +733,10 @@ bool erase_notes(const set<const Part*>& parts, int range, int velo_threshold, b
 			if ( (!velo_thres_used && !len_thres_used) ||
 			     (velo_thres_used && event.velo() < velo_threshold) ||
 			     (len_thres_used && int(event.lenTick()) < len_threshold) )
-				operations.push_back(UndoOp(UndoOp::DeleteEvent, event, part, false, false));
+				edits.remove(event, part);
 		}
 		
+		edits.flush(operations);
 		return MusEGlobal::song->applyOperationGroup(operations);
 	}
 	else
@@ -653,6 +747,7 @@ bool transpose_notes(const set<const Part*>& parts, int range, signed int halfto
 {
 	map<const Event*, const Part*> events = get_events(parts, range);
 	Undo operations;
+	EventEdits edits;
 	
 	if ( (!events.empty()) && (halftonesteps!=0) )
 	{
@@ -666,9 +761,10 @@ bool transpose_notes(const set<const Part*>& parts, int range, signed int halfto
 			if (pitch > 127) pitch=127;
 			if (pitch < 0) pitch=0;
 			newEvent.setPitch(pitch);
-			operations.push_back(UndoOp(UndoOp::ModifyEvent, newEvent, event, part, false, false));
+			edits.modify(newEvent, event, part);
 		}
 		
+		edits.flush(operations);
 		return MusEGlobal::song->applyOperationGroup(operations);
 	}
 	else
@@ -679,6 +775,7 @@ bool crescendo(const set<const Part*>& parts, int range, int start_val, int end_
 {
 	map<const Event*, const Part*> events = get_events(parts, range);
 	Undo operations;
+	EventEdits edits;
 	
 	int from=MusEGlobal::song->lpos();
 	int to=MusEGlobal::song->rpos();
@@ -704,9 +801,10 @@ bool crescendo(const set<const Part*>& parts, int range, int start_val, int end_
 			if (velo > 127) velo=127;
 			if (velo <= 0) velo=1;
 			newEvent.setVelo(velo);
-			operations.push_back(UndoOp(UndoOp::ModifyEvent, newEvent, event, part, false, false));
+			edits.modify(newEvent, event, part);
 		}
 		
+		edits.flush(operations);
 		return MusEGlobal::song->applyOperationGroup(operations);
 	}
 	else
@@ -717,6 +815,7 @@ bool move_notes(const set<const Part*>& parts, int range, signed int ticks)
 {
 	map<const Event*, const Part*> events = get_events(parts, range);
 	Undo operations;
+	EventEdits edits;
 	map<const Part*, int> partlen;
 	
 	if ( (!events.empty()) && (ticks!=0) )
@@ -747,11 +846,13 @@ bool move_notes(const set<const Part*>& parts, int range, signed int ticks)
 			}
 			
 			if (del==false)
-				operations.push_back(UndoOp(UndoOp::ModifyEvent, newEvent, event, part, false, false));
+				edits.modify(newEvent, event, part);
 			else
-				operations.push_back(UndoOp(UndoOp::DeleteEvent, event, part, false, false));
+				edits.remove(event, part);
 		}
 		
+		edits.flush(operations);
+		
 		for (map<const Part*, int>::iterator it=partlen.begin(); it!=partlen.end(); it++)
 			schedule_resize_all_same_len_clone_parts(it->first, it->second, operations);
 		
@@ -766,6 +867,7 @@ bool delete_overlaps(const set<const Part*>& parts, int range)
 {
 	map<const Event*, const Part*> events = get_events(parts, range);
 	Undo operations;
+	EventEdits edits;
 	
 	set<const Event*> deleted_events;
 	
@@ -796,7 +898,7 @@ bool delete_overlaps(const set<const Part*>& parts, int range)
 
 						if (new_len==0)
 						{
-							operations.push_back(UndoOp(UndoOp::DeleteEvent, event1, part1, false, false));
+							edits.remove(event1, part1);
 							deleted_events.insert(&event1);
 						}
 						else
@@ -804,13 +906,14 @@ bool delete_overlaps(const set<const Part*>& parts, int range)
 							Event new_event1 = event1.clone();
 							new_event1.setLenTick(new_len);
 							
-							operations.push_back(UndoOp(UndoOp::ModifyEvent, new_event1, event1, part1, false, false));
+							edits.modify(new_event1, event1, part1);
 						}
 					}
 				}
 			}
 		}
 		
+		edits.flush(operations);
 		return MusEGlobal::song->applyOperationGroup(operations);
 	}
 	else
@@ -821,6 +924,7 @@ bool legato(const set<const Part*>& parts, int range, int min_len, bool dont_sho
 {
 	map<const Event*, const Part*> events = get_events(parts, range);
 	Undo operations;
+	EventEdits edits;
 	
 	if (min_len<=0) min_len=1;
 	
@@ -857,10 +961,11 @@ bool legato(const set<const Part*>& parts, int range, int min_len, bool dont_sho
 				Event new_event1 = event1.clone();
 				new_event1.setLenTick(len);
 				
-				operations.push_back(UndoOp(UndoOp::ModifyEvent, new_event1, event1, part1, false, false));
+				edits.modify(new_event1, event1, part1);
 			}
 		}
 		
+		edits.flush(operations);
 		return MusEGlobal::song->applyOperationGroup(operations);
 	}
 	else
@@ -877,53 +982,27 @@ void copy_notes(const set<const Part*>& parts, int range)
 		QApplication::clipboard()->setMimeData(drag, QClipboard::Clipboard);
 }
 
-unsigned get_groupedevents_len(const QString& pt)
+unsigned get_groupedevents_len(const GroupedEventLists& lists)
 {
 	unsigned maxlen=0;
 	
-	QByteArray pt_= pt.toLatin1();
-	Xml xml(pt_.constData());
-	for (;;) 
+	for (GroupedEventLists::const_iterator it = lists.begin(); it != lists.end(); it++)
 	{
-		Xml::Token token = xml.parse();
-		const QString& tag = xml.s1();
-		switch (token) 
-		{
-			case Xml::Error:
-			case Xml::End:
-				return maxlen;
-				
-			case Xml::TagStart:
-				if (tag == "eventlist")
-				{
-					EventList el;
-					int part_id;
-					if (read_eventlist_and_part(xml, &el, &part_id))
-					{
-						unsigned len = el.rbegin()->first;
-						if (len > maxlen) maxlen=len;
-					}
-				}
-				else
-					xml.unknown("get_clipboard_len");
-				break;
-				
-			case Xml::Attribut:
-			case Xml::TagEnd:
-			default:
-				break;
-		}
+		if (it->second.empty())
+			continue;
+		unsigned len = it->second.rbegin()->first;
+		if (len > maxlen) maxlen=len;
 	}
 	
-	return maxlen; // see also the return statement above!
+	return maxlen;
 }
 
 unsigned get_clipboard_len()
 {
-	QString tmp="x-muse-groupedeventlists"; // QClipboard::text() expects a QString&, not a QString :(
-	QString s = QApplication::clipboard()->text(tmp, QClipboard::Clipboard);  // TODO CHECK Tim.
+	GroupedEventLists storage;
+	const GroupedEventLists* lists = mimedata_to_groupedevents(QApplication::clipboard()->mimeData(QClipboard::Clipboard), &storage);
 	
-	return get_groupedevents_len(s);
+	return lists ? get_groupedevents_len(*lists) : 0;
 }
 
 bool paste_notes(const Part* paste_into_part)
@@ -945,9 +1024,7 @@ bool paste_notes(const Part* paste_into_part)
 
 void paste_notes(int max_distance, bool always_new_part, bool never_new_part, const Part* paste_into_part, int amount, int raster)
 {
-	QString tmp="x-muse-groupedeventlists"; // QClipboard::text() expects a QString&, not a QString :(
-	QString s = QApplication::clipboard()->text(tmp, QClipboard::Clipboard);  // TODO CHECK Tim.
-	paste_at(s, MusEGlobal::song->cpos(), max_distance, always_new_part, never_new_part, paste_into_part, amount, raster);
+	paste_at(QApplication::clipboard()->mimeData(QClipboard::Clipboard), MusEGlobal::song->cpos(), max_distance, always_new_part, never_new_part, paste_into_part, amount, raster);
 }
 
 // if nothing is selected/relevant, this function returns NULL
@@ -965,33 +1042,77 @@ QMimeData* selected_events_to_mime(const set<const Part*>& parts, int range)
         return NULL;
 
     //---------------------------------------------------
-    //    write events as XML into tmp file
+    //    copy events, the xml is written on demand
     //---------------------------------------------------
 
-    FILE* tmp = tmpfile();
-    if (tmp == 0)
-    {
-        fprintf(stderr, "EventCanvas::getTextDrag() fopen failed: %s\n", strerror(errno));
-        return 0;
-    }
-
-    Xml xml(tmp);
-    int level = 0;
+    GroupedEventListsMimeData* mimeData = new GroupedEventListsMimeData();
 
     for (set<const Part*>::iterator part=parts.begin(); part!=parts.end(); part++)
     {
-        xml.tag(level++, "eventlist part_id=\"%d\"", (*part)->sn());
+        mimeData->lists().push_back(std::make_pair((*part)->sn(), EventList()));
+        EventList& el = mimeData->lists().back().second;
         for (ciEvent ev=(*part)->events().begin(); ev!=(*part)->events().end(); ev++)
             if (is_relevant(ev->second, *part, range))
-                ev->second.write(level, xml, -start_tick);
-        xml.etag(--level, "eventlist");
+            {
+                // A private copy. Later edits to the song must not show up in the clipboard.
+                Event e = ev->second.clone();
+                e.setTick(e.tick() - start_tick);
+                el.add(e);
+            }
     }
 
-    QMimeData *mimeData =  file_to_mimedata(tmp, "text/x-muse-groupedeventlists" );
-    fclose(tmp);
     return mimeData;
 }
 
+//---------------------------------------------------
+//    GroupedEventListsMimeData
+//---------------------------------------------------
+
+bool GroupedEventListsMimeData::hasFormat(const QString& mimeType) const
+{
+    return mimeType == "text/x-muse-groupedeventlists" || QMimeData::hasFormat(mimeType);
+}
+
+QStringList GroupedEventListsMimeData::formats() const
+{
+    QStringList l = QMimeData::formats();
+    l.prepend("text/x-muse-groupedeventlists");
+    return l;
+}
+
+QVariant GroupedEventListsMimeData::retrieveData(const QString& mimeType, QVariant::Type type) const
+{
+    if (mimeType != "text/x-muse-groupedeventlists")
+        return QMimeData::retrieveData(mimeType, type);
+
+    if (!_xmlValid)
+    {
+        char* buf = 0;
+        size_t len = 0;
+        FILE* tmp = open_memstream(&buf, &len);
+        if (tmp == 0)
+        {
+            fprintf(stderr, "GroupedEventListsMimeData::retrieveData() open_memstream failed: %s\n", strerror(errno));
+            return QVariant();
+        }
+
+        Xml xml(tmp);
+        int level = 0;
+        for (GroupedEventLists::const_iterator it = _lists.begin(); it != _lists.end(); it++)
+        {
+            xml.tag(level++, "eventlist part_id=\"%d\"", it->first);
+            for (ciEvent ev = it->second.begin(); ev != it->second.end(); ev++)
+                ev->second.write(level, xml, Pos(0, true));
+            xml.etag(--level, "eventlist");
+        }
+        fclose(tmp);
+        _xml = QByteArray(buf, len);
+        free(buf);
+        _xmlValid = true;
+    }
+    return QVariant(_xml);
+}
+
 // if nothing is selected/relevant, this function returns NULL
 QMimeData* parts_to_mime(const set<const Part*>& parts)
 {
@@ -1102,12 +1223,8 @@ bool read_eventlist_and_part(Xml& xml, EventList* el, int* part_id) // true on s
 	}
 }
 
-void paste_at(const QString& pt, int pos, int max_distance, bool always_new_part, bool never_new_part, const Part* paste_into_part, int amount, int raster)
+bool read_groupedevents(const QString& pt, GroupedEventLists* lists) // true on success, false on failure
 {
-	Undo operations;
-	map<const Part*, unsigned> expand_map;
-	map<const Part*, set<const Part*> > new_part_map;
-	
 	QByteArray pt_= pt.toLatin1();
 	Xml xml(pt_.constData());
 	for (;;) 
@@ -1118,94 +1235,20 @@ void paste_at(const QString& pt, int pos, int max_distance, bool always_new_part
 		{
 			case Xml::Error:
 			case Xml::End:
-				goto out_of_paste_at_for;
+				return !lists->empty();
 				
 			case Xml::TagStart:
 				if (tag == "eventlist")
 				{
-					EventList el;
-					int part_id;
-		
-					if (read_eventlist_and_part(xml, &el, &part_id))
-					{
-						const Part* dest_part;
-						Track* dest_track;
-						const Part* old_dest_part;
-						
-						if (paste_into_part == NULL)
-							dest_part = partFromSerialNumber(part_id);
-						else
-							dest_part=paste_into_part;
-						
-						if (dest_part == NULL)
-						{
-							printf("ERROR: destination part wasn't found. ignoring these events\n");
-						}
-						else
-						{
-							dest_track=dest_part->track();
-							old_dest_part=dest_part;
-							unsigned first_paste_tick = el.begin()->first + pos;
-							bool create_new_part = ( (dest_part->tick() > first_paste_tick) ||   // dest_part begins too late
-									 ( ( (dest_part->endTick() + max_distance < first_paste_tick) || // dest_part is too far away
-										                  always_new_part ) && !never_new_part ) );    // respect function arguments
-							
-							for (int i=0;i<amount;i++)
-							{
-								unsigned curr_pos = pos + i*raster;
-								first_paste_tick = el.begin()->first + curr_pos;
-								
-								if (create_new_part)
-								{
-									Part* newpart = dest_track->newPart();
-									newpart->setTick(AL::sigmap.raster1(first_paste_tick, config.division));
-
-									new_part_map[old_dest_part].insert(dest_part);
-									operations.push_back(UndoOp(UndoOp::AddPart, dest_part));
-									dest_part = newpart;
-								}
-								
-								for (iEvent i = el.begin(); i != el.end(); ++i)
-								{
-									Event e = i->second.clone();
-									int tick = e.tick() + curr_pos - dest_part->tick();
-									if (tick<0)
-									{
-										printf("ERROR: trying to add event before current part! ignoring this event\n");
-										continue;
-									}
-
-									e.setTick(tick);
-									e.setSelected(true);  // No need to select clones, AddEvent operation below will take care of that.
-									
-									if (e.endTick() > dest_part->lenTick()) // event exceeds part?
-									{
-										if (dest_part->hasHiddenEvents()) // auto-expanding is forbidden?
-										{
-											if (e.tick() < dest_part->lenTick())
-												e.setLenTick(dest_part->lenTick() - e.tick()); // clip
-											else
-												e.setLenTick(0); // don't insert that note at all
-										}
-										else
-										{
-											if (e.endTick() > expand_map[dest_part])
-												expand_map[dest_part]=e.endTick();
-										}
-									}
-									
-									if (e.lenTick() != 0) operations.push_back(UndoOp(UndoOp::AddEvent,e, dest_part, false, false));
-								}
-							}
-						}
-					}
-					else
+					lists->push_back(std::make_pair(-1, EventList()));
+					if (!read_eventlist_and_part(xml, &lists->back().second, &lists->back().first))
 					{
 						printf("ERROR: reading eventlist from clipboard failed. ignoring this one...\n");
+						lists->pop_back();
 					}
 				}
 				else
-					xml.unknown("paste_at");
+					xml.unknown("read_groupedevents");
 				break;
 				
 			case Xml::Attribut:
@@ -1214,8 +1257,125 @@ void paste_at(const QString& pt, int pos, int max_distance, bool always_new_part
 				break;
 		}
 	}
+}
+
+// Returns the copied events in md, either straight from our own clipboard
+// object or parsed into storage. NULL if md holds no events.
+const GroupedEventLists* mimedata_to_groupedevents(const QMimeData* md, GroupedEventLists* storage)
+{
+	if (md == NULL)
+		return NULL;
 	
-	out_of_paste_at_for:
+	const GroupedEventListsMimeData* gmd = dynamic_cast<const GroupedEventListsMimeData*>(md);
+	if (gmd)
+		return &gmd->lists();
+	
+	if (!md->hasFormat("text/x-muse-groupedeventlists"))
+		return NULL;
+	if (!read_groupedevents(QString(md->data("text/x-muse-groupedeventlists")), storage))
+		return NULL;
+	return storage;
+}
+
+void paste_at(const QString& pt, int pos, int max_distance, bool always_new_part, bool never_new_part, const Part* paste_into_part, int amount, int raster)
+{
+	GroupedEventLists lists;
+	read_groupedevents(pt, &lists);
+	paste_at(lists, pos, max_distance, always_new_part, never_new_part, paste_into_part, amount, raster);
+}
+
+void paste_at(const QMimeData* md, int pos, int max_distance, bool always_new_part, bool never_new_part, const Part* paste_into_part, int amount, int raster)
+{
+	GroupedEventLists storage;
+	const GroupedEventLists* lists = mimedata_to_groupedevents(md, &storage);
+	if (lists)
+		paste_at(*lists, pos, max_distance, always_new_part, never_new_part, paste_into_part, amount, raster);
+}
+
+void paste_at(const GroupedEventLists& lists, int pos, int max_distance, bool always_new_part, bool never_new_part, const Part* paste_into_part, int amount, int raster)
+{
+	Undo operations;
+	map<const Part*, unsigned> expand_map;
+	map<const Part*, set<const Part*> > new_part_map;
+	
+	for (GroupedEventLists::const_iterator it = lists.begin(); it != lists.end(); it++)
+	{
+		const EventList& el = it->second;
+		int part_id = it->first;
+		if (el.empty())
+			continue;
+		
+		const Part* dest_part;
+		Track* dest_track;
+		const Part* old_dest_part;
+		
+		if (paste_into_part == NULL)
+			dest_part = partFromSerialNumber(part_id);
+		else
+			dest_part=paste_into_part;
+		
+		if (dest_part == NULL)
+		{
+			printf("ERROR: destination part wasn't found. ignoring these events\n");
+		}
+		else
+		{
+			dest_track=dest_part->track();
+			old_dest_part=dest_part;
+			unsigned first_paste_tick = el.begin()->first + pos;
+			bool create_new_part = ( (dest_part->tick() > first_paste_tick) ||   // dest_part begins too late
+					 ( ( (dest_part->endTick() + max_distance < first_paste_tick) || // dest_part is too far away
+						                  always_new_part ) && !never_new_part ) );    // respect function arguments
+			
+			for (int i=0;i<amount;i++)
+			{
+				unsigned curr_pos = pos + i*raster;
+				first_paste_tick = el.begin()->first + curr_pos;
+				
+				if (create_new_part)
+				{
+					Part* newpart = dest_track->newPart();
+					newpart->setTick(AL::sigmap.raster1(first_paste_tick, config.division));
+
+					new_part_map[old_dest_part].insert(dest_part);
+					operations.push_back(UndoOp(UndoOp::AddPart, dest_part));
+					dest_part = newpart;
+				}
+				
+				for (ciEvent i = el.begin(); i != el.end(); ++i)
+				{
+					Event e = i->second.clone();
+					int tick = e.tick() + curr_pos - dest_part->tick();
+					if (tick<0)
+					{
+						printf("ERROR: trying to add event before current part! ignoring this event\n");
+						continue;
+					}
+
+					e.setTick(tick);
+					e.setSelected(true);  // No need to select clones, AddEvent operation below will take care of that.
+					
+					if (e.endTick() > dest_part->lenTick()) // event exceeds part?
+					{
+						if (dest_part->hasHiddenEvents()) // auto-expanding is forbidden?
+						{
+							if (e.tick() < dest_part->lenTick())
+								e.setLenTick(dest_part->lenTick() - e.tick()); // clip
+							else
+								e.setLenTick(0); // don't insert that note at all
+						}
+						else
+						{
+							if (e.endTick() > expand_map[dest_part])
+								expand_map[dest_part]=e.endTick();
+						}
+					}
+					
+					if (e.lenTick() != 0) operations.push_back(UndoOp(UndoOp::AddEvent,e, dest_part, false, false));
+				}
+			}
+		}
+	}
 	
 	for (map<const Part*, unsigned>::iterator it = expand_map.begin(); it!=expand_map.end(); it++)
 		if (it->second != it->first->lenTick())
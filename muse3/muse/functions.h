@@ -24,12 +24,15 @@
 #define __FUNCTIONS_H__
 
 #include <set>
+#include <list>
+#include <utility>
 #include "part.h"
 #include "dialogs.h"
 #include <QWidget>
+#include <QMimeData>
+#include <QStringList>
 
 class QString;
-class QMimeData;
 
 #define FUNCTION_RANGE_ONLY_SELECTED 1
 #define FUNCTION_RANGE_ONLY_BETWEEN_MARKERS 2
@@ -39,6 +42,34 @@ class QMimeData;
 namespace MusECore {
 class Undo;
 
+// Copied events, one list per source part serial number.
+// Ticks are relative to the first copied event.
+typedef std::list<std::pair<int, EventList> > GroupedEventLists;
+
+//---------------------------------------------------------
+//   GroupedEventListsMimeData
+//    Clipboard and drag contents of copied events, kept
+//     in process. The text/x-muse-groupedeventlists xml
+//     is only written if somebody asks for it, for example
+//     another MusE instance.
+//---------------------------------------------------------
+
+class GroupedEventListsMimeData : public QMimeData {
+      GroupedEventLists _lists;
+      mutable QByteArray _xml;
+      mutable bool _xmlValid;
+
+   protected:
+      virtual QVariant retrieveData(const QString& mimeType, QVariant::Type type) const;
+
+   public:
+      GroupedEventListsMimeData() : _xmlValid(false) {}
+      GroupedEventLists& lists()             { return _lists; }
+      const GroupedEventLists& lists() const { return _lists; }
+      virtual bool hasFormat(const QString& mimeType) const;
+      virtual QStringList formats() const;
+      };
+
 std::set<const Part*> partlist_to_set(PartList* pl);
 std::set<const Part*> part_to_set(const Part* p);
 std::map<const Event*, const Part*> get_events(const std::set<const Part*>& parts, int range);
@@ -92,6 +123,8 @@ QMimeData* parts_to_mime(const std::set<const Part*>& parts);
 
 
 void paste_at(const QString& pt, int pos, int max_distance=3072, bool always_new_part=false, bool never_new_part=false, const Part* paste_into_part=NULL, int amount=1, int raster=3072);
+void paste_at(const QMimeData* md, int pos, int max_distance=3072, bool always_new_part=false, bool never_new_part=false, const Part* paste_into_part=NULL, int amount=1, int raster=3072);
+void paste_at(const GroupedEventLists& lists, int pos, int max_distance=3072, bool always_new_part=false, bool never_new_part=false, const Part* paste_into_part=NULL, int amount=1, int raster=3072);
 
 //functions for selections
 void select_all(const std::set<const Part*>& parts);
@@ -115,6 +148,8 @@ bool delete_selected_parts();
 
 // internal
 QMimeData* file_to_mimedata(FILE *datafile, QString mimeType);
+bool read_groupedevents(const QString& pt, GroupedEventLists* lists);
+const GroupedEventLists* mimedata_to_groupedevents(const QMimeData* md, GroupedEventLists* storage);
 
 } // namespace MusECore
 
@@ -163,6 +163,7 @@ GlobalConfigValues config = {
       WaveOutLine,                  // waveDrawing
       384,                          // division;
       1024,                         // rtcTicks
+      5,                            // alsaMidiLookahead
       true,                         // midiSendInit Send instrument initialization sequences
       true,                         // warnInitPending Warn instrument initialization sequences pending
       false,                        // midiSendCtlDefaults Send instrument controller defaults at position 0 if none in song
@@ -252,7 +253,10 @@ GlobalConfigValues config = {
       20,                           // trackHeight
       true,                         // borderlessMouse
       false,                        // autoSave
+      300,                          // autoSaveInterval
       false,                        // scrollableSubMenus
+      false,                        // compactEventEncoding
+      512,                          // undoMemoryLimit
       true,                         // liveWaveUpdate
       true,                         // warnOnFileVersions Warn if file version different than current
       MusEGlobal::CONF_LV2_UI_USE_FIRST, //lv2UiBehavior
@@ -173,6 +173,7 @@ struct GlobalConfigValues {
 
       int division;
       int rtcTicks;
+      int alsaMidiLookahead;     // ALSA midi output scheduled ahead by the sequencer queue, in milliseconds. 0: Off.
       bool midiSendInit;         // Send instrument initialization sequences
       bool warnInitPending;      // Warn instrument initialization sequences pending
       bool midiSendCtlDefaults;  // Send instrument controller defaults at position 0 if none in song
@@ -253,7 +254,10 @@ struct GlobalConfigValues {
       int trackHeight;
       bool borderlessMouse;
       bool autoSave;
+      int autoSaveInterval;  // Seconds between autosaves.
       bool scrollableSubMenus;
+      bool compactEventEncoding; // Save midi part events as a packed binary chunk instead of xml elements.
+      int undoMemoryLimit;   // Megabytes of undo history to keep, 0 = unlimited.
       bool liveWaveUpdate;   //live update wave tracks while recording
       bool warnOnFileVersions; // Warn if file version different than current
       CONF_LV2_UI_BEHAVIOR lv2UiBehavior;
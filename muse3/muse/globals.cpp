@@ -120,6 +120,7 @@ bool useLASH = true;
 bool useAlsaWithJack = false;
 bool noAutoStartJack = false;
 bool populateMidiPortsOnStart = true;
+bool batchMode = false;             // Converting a file from the command line, no gui shown.
 
 const char* midi_file_pattern[] = {
       QT_TRANSLATE_NOOP("file_patterns", "Midi/Kar (*.mid *.MID *.kar *.KAR *.mid.gz *.mid.bz2)"),
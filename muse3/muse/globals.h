@@ -96,6 +96,7 @@ extern bool loadLV2;
 extern bool useAlsaWithJack;
 extern bool noAutoStartJack;
 extern bool populateMidiPortsOnStart;
+extern bool batchMode;
 
 extern bool realTimeScheduling;
 extern int realTimePriority;
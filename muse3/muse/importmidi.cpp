@@ -27,6 +27,7 @@
 
 #include <set>
 #include <utility>
+#include <vector>
 
 #include <QMessageBox>
 
@@ -51,6 +52,7 @@
 
 using std::set;
 using std::pair;
+using std::vector;
 
 
 namespace MusEGui {
@@ -116,7 +118,7 @@ bool MusE::importMidi(const QString name, bool merge)
             s += name;
             s += tr("\nfailed: ");
             s += mf.error();
-            QMessageBox::critical(this, QString("MusE"), s);
+            fileError(s);
             return rv;
             }
             
@@ -258,75 +260,69 @@ bool MusE::importMidi(const QString name, bool merge)
 
             bool first = true;
             
-            // vastly changed by flo: replaced that silly loop
-            // with that already_processed-set-check.
-            // this makes stuff really fast :)
+            // Split the events by port and channel in one pass, one list per
+            //  target track, instead of letting buildMidiEventList scan the
+            //  whole track again for each of them.
+            MusECore::MidiFileTrackSplit split;
+            (*t)->split(&split);
             
-            MusECore::iMPEvent ev;
-            set< pair<int,int> > already_processed;
-            for (ev = el.begin(); ev != el.end(); ++ev)
+            for (vector<MusECore::MidiFileTarget>::const_iterator it = split.targets.begin(); it != split.targets.end(); ++it)
             {
-              if (ev->type() != MusECore::ME_SYSEX && ev->type() != MusECore::ME_META)
-              {
-                int channel=ev->channel();
-                int port=ev->port();
-                
-                if (already_processed.find(pair<int,int>(channel, port)) == already_processed.end())
+                int channel=it->first;
+                int port=it->second;
+                MusECore::MPEventList& tel = split.events[*it];
+
+                MusECore::MidiTrack* track = new MusECore::MidiTrack();
+                if ((*t)->_isDrumTrack)
                 {
-                        already_processed.insert(pair<int,int>(channel, port));
-                        
-                        MusECore::MidiTrack* track = new MusECore::MidiTrack();
-                        if ((*t)->_isDrumTrack)
-                        {
-                           if (MusEGlobal::config.importMidiNewStyleDrum)
-                              track->setType(MusECore::Track::NEW_DRUM);
-                           else
-                              track->setType(MusECore::Track::DRUM);
-                        }
-                              
-                        track->setOutChannel(channel);
-                        track->setOutPort(port);
-
-                        MusECore::MidiPort* mport = &MusEGlobal::midiPorts[port];
-                        buildMidiEventList(&track->events, el, track, division, first, false); // Don't do loops.
-                        first = false;
-
-                        // Comment Added by T356.
-                        // Hmm. buildMidiEventList already takes care of this. 
-                        // But it seems to work. How? Must test. 
-                        //if (channel == 9 && instr->midiType() != MT_UNKNOWN) {
-                        MusECore::ciMidiFilePort imp = usedPortMap->find(port);
-                        if(imp != usedPortMap->end() && imp->second._isStandardDrums && channel == 9) { // A bit HACKISH, see above
-                           if (MusEGlobal::config.importMidiNewStyleDrum)
-                              track->setType(MusECore::Track::NEW_DRUM);
-                           else
-                           {
-                              track->setType(MusECore::Track::DRUM);
-                              // remap drum pitch with drumOutmap (was: Inmap. flo93 thought this was wrong)
-                              for (MusECore::iEvent i = track->events.begin(); i != track->events.end(); ++i) {
-                                    MusECore::Event ev  = i->second;
-                                    if (ev.isNote()) {
-                                          int pitch = MusEGlobal::drumOutmap[ev.pitch()];
-                                          ev.setPitch(pitch);
-                                          }
-                                    else
-                                    if(ev.type() == MusECore::Controller)
-                                    {
-                                      int ctl = ev.dataA();
-                                      MusECore::MidiController *mc = mport->drumController(ctl);
-                                      if(mc)
-                                        ev.setA((ctl & ~0xff) | MusEGlobal::drumOutmap[ctl & 0x7f]);
-                                    }
-                              }
-                           }
-                        }
-                              
-                        processTrack(track);
-                        
-                        MusEGlobal::song->insertTrack0(track, -1);
+                   if (MusEGlobal::config.importMidiNewStyleDrum)
+                      track->setType(MusECore::Track::NEW_DRUM);
+                   else
+                      track->setType(MusECore::Track::DRUM);
+                }
+                      
+                track->setOutChannel(channel);
+                track->setOutPort(port);
+
+                MusECore::MidiPort* mport = &MusEGlobal::midiPorts[port];
+                buildMidiEventList(&track->events, tel, track, division, first, false); // Don't do loops.
+                first = false;
+
+                // Comment Added by T356.
+                // Hmm. buildMidiEventList already takes care of this. 
+                // But it seems to work. How? Must test. 
+                //if (channel == 9 && instr->midiType() != MT_UNKNOWN) {
+                MusECore::ciMidiFilePort imp = usedPortMap->find(port);
+                if(imp != usedPortMap->end() && imp->second._isStandardDrums && channel == 9) { // A bit HACKISH, see above
+                   if (MusEGlobal::config.importMidiNewStyleDrum)
+                      track->setType(MusECore::Track::NEW_DRUM);
+                   else
+                   {
+                      track->setType(MusECore::Track::DRUM);
+                      // remap drum pitch with drumOutmap (was: Inmap. flo93 thought this was wrong)
+                      for (MusECore::iEvent i = track->events.begin(); i != track->events.end(); ++i) {
+                            MusECore::Event ev  = i->second;
+                            if (ev.isNote()) {
+                                  int pitch = MusEGlobal::drumOutmap[ev.pitch()];
+                                  ev.setPitch(pitch);
+                                  }
+                            else
+                            if(ev.type() == MusECore::Controller)
+                            {
+                              int ctl = ev.dataA();
+                              MusECore::MidiController *mc = mport->drumController(ctl);
+                              if(mc)
+                                ev.setA((ctl & ~0xff) | MusEGlobal::drumOutmap[ctl & 0x7f]);
+                            }
+                      }
+                   }
                 }
-              }
-						}
+                      
+                MusECore::buildMidiParts(track, MusEGlobal::config.importMidiSplitParts);
+                
+                MusEGlobal::song->insertTrack0(track, -1);
+                tel.clear();
+            }
 						
             if (first) {
                   //
@@ -337,7 +333,7 @@ bool MusE::importMidi(const QString name, bool merge)
                   track->setOutChannel(0);
                   track->setOutPort(0);
                   buildMidiEventList(&track->events, el, track, division, true, false); // Do SysexMeta. Don't do loops.
-                  processTrack(track);
+                  MusECore::buildMidiParts(track, MusEGlobal::config.importMidiSplitParts);
                   MusEGlobal::song->insertTrack0(track, -1);
                   }
             }
@@ -372,134 +368,6 @@ bool MusE::importMidi(const QString name, bool merge)
       return false;
       }
 
-//---------------------------------------------------------
-//   processTrack
-//    divide events into parts
-//---------------------------------------------------------
-
-void MusE::processTrack(MusECore::MidiTrack* track)
-      {
-      MusECore::EventList& tevents = track->events;
-      if (tevents.empty())
-            return;
-
-      //---------------------------------------------------
-      //    Parts ermitteln
-      //    die Midi-Spuren werden in Parts aufgebrochen;
-      //    ein neuer Part wird bei einer LÃ¯Â¿Â½cke von einem
-      //    Takt gebildet; die LÃ¯Â¿Â½nge wird jeweils auf
-      //    Takte aufgerundet und aligned
-      //---------------------------------------------------
-
-      MusECore::PartList* pl = track->parts();
-
-      int lastTick = 0;
-      for (MusECore::ciEvent i = tevents.begin(); i != tevents.end(); ++i) {
-            const MusECore::Event& event = i->second;
-            int epos = event.tick() + event.lenTick();
-            if (epos > lastTick)
-                  lastTick = epos;
-            }
-
-      QString partname = track->name();
-      int len = MusEGlobal::song->roundUpBar(lastTick+1);
-
-      // p3.3.27
-      if(MusEGlobal::config.importMidiSplitParts)
-      {
-        
-        int bar2, beat;
-        unsigned tick;
-        AL::sigmap.tickValues(len, &bar2, &beat, &tick);
-        
-        int lastOff = 0;
-        int st = -1;      // start tick current part
-        int x1 = 0;       // start tick current measure
-        int x2 = 0;       // end tick current measure
-  
-        for (int bar = 0; bar < bar2; ++bar, x1 = x2) {
-              x2 = AL::sigmap.bar2tick(bar+1, 0, 0);
-              if (lastOff > x2) {        
-                    continue;
-                    }
-              MusECore::iEvent i1 = tevents.lower_bound(x1);
-              MusECore::iEvent i2 = tevents.lower_bound(x2);
-  
-              if (i1 == i2) {   // empty?
-                    if (st != -1) {
-                          MusECore::MidiPart* part = new MusECore::MidiPart(track);
-                          part->setTick(st);
-                          part->setLenTick((lastOff > x1 ? x2 : x1) - st);
-                          part->setName(partname);
-                          pl->add(part);
-                          st = -1;
-                          }
-                    }
-              else {
-                    if (st == -1)
-                          st = x1;    // begin new  part
-                    //HACK:
-                    //lastOff:
-                    for (MusECore::ciEvent i = i1; i != i2; ++i) {
-                          const MusECore::Event& event = i->second;
-                          if (event.type() == MusECore::Note) {
-                                int off = event.tick() + event.lenTick();
-                                if (off > lastOff)
-                                      lastOff = off;
-                                }
-                          }
-                    }
-              }
-        if (st != -1) {
-              MusECore::MidiPart* part = new MusECore::MidiPart(track);
-              part->setTick(st);
-              part->setLenTick(x2-st);
-              part->setName(partname);
-              pl->add(part);
-              }
-      }
-      else
-      {
-        // Just one long part...
-        MusECore::MidiPart* part = new MusECore::MidiPart(track);
-        part->setTick(0);
-        part->setLenTick(len);
-        part->setName(partname);
-        pl->add(part);
-      }
-
-      //-------------------------------------------------------------
-      //    assign events to parts
-      //-------------------------------------------------------------
-
-      for (MusECore::iPart p = pl->begin(); p != pl->end(); ++p) {
-            MusECore::MidiPart* part = (MusECore::MidiPart*)(p->second);
-            int stick = part->tick();
-            int etick = part->tick() + part->lenTick();
-            MusECore::iEvent r1 = tevents.lower_bound(stick);
-            MusECore::iEvent r2 = tevents.lower_bound(etick);
-            int startTick = part->tick();
-
-            for (MusECore::iEvent i = r1; i != r2; ++i) {
-                  MusECore::Event& ev = i->second;
-                  int ntick = ev.tick() - startTick;
-                  ev.setTick(ntick);
-                  part->addEvent(ev);
-                  }
-            tevents.erase(r1, r2);
-            }
-
-      if (tevents.size())
-            printf("-----------events left: %zd\n", tevents.size());
-      for (MusECore::ciEvent i = tevents.begin(); i != tevents.end(); ++i) {
-            printf("%d===\n", i->first);
-            i->second.dump();
-            }
-      // all events should be processed:
-      if (!tevents.empty())
-        printf("THIS SHOULD NEVER HAPPEN: not all events processed at the end of MusE::processTrack()!\n");
-      }
-
 //---------------------------------------------------------
 //   importController
 //---------------------------------------------------------
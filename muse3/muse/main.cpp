@@ -23,6 +23,7 @@
 
 #include <QApplication>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
 #include <QFileInfoList>
@@ -100,6 +101,7 @@ extern lash_client_t * lash_client;
 }
 
 static QString locale_override;
+static QString batch_output;
 
 //---------------------------------------------------------
 //   getCapabilities
@@ -255,6 +257,8 @@ static void usage(const char* prog, const char* txt)
       fprintf(stderr, "   -P  n    Set audio driver real time priority to n\n");
       fprintf(stderr, "                        (Dummy only, default 40. Else fixed by Jack.)\n");
       fprintf(stderr, "   -Y  n    Force midi real time priority to n (default: audio driver prio -1)\n");
+      fprintf(stderr, "   -B  file Batch mode: convert midifile to file (*.med, *.mid) and exit, implies -a\n");
+      fprintf(stderr, "                        (no windows shown, settings not saved; see muse-batch)\n");
       fprintf(stderr, "\n");
       fprintf(stderr, "   -p       Don't load LADSPA plugins\n");
 #ifdef VST_SUPPORT
@@ -397,7 +401,7 @@ int main(int argc, char* argv[])
       QString appStyleObjName = app.style()->objectName();
       MusEGui::Appearance::getSetDefaultStyle(&appStyleObjName);   // NOTE: May need alternate method, above.
       
-      QString optstr("aJFAhvdDumMsP:Y:l:py");
+      QString optstr("aJFAhvdDumMsP:Y:B:l:py");
 #ifdef VST_SUPPORT
       optstr += QString("V");
 #endif
@@ -454,6 +458,12 @@ int main(int argc, char* argv[])
                   case 'u': MusEGlobal::unityWorkaround = true; break;
                   case 'P': MusEGlobal::realTimePriority = atoi(optarg); break;
                   case 'Y': MusEGlobal::midiRTPrioOverride = atoi(optarg); break;
+                  case 'B':
+                        batch_output = QString(optarg);
+                        MusEGlobal::batchMode = true;
+                        MusEGlobal::populateMidiPortsOnStart = false;
+                        noAudio = true;
+                        break;
                   case 'p': MusEGlobal::loadPlugins = false; break;
                   case 'V': MusEGlobal::loadVST = false; break;
                   case 'N': MusEGlobal::loadNativeVST = false; break;
@@ -478,6 +488,21 @@ int main(int argc, char* argv[])
       argc -= optind;
       ++argc;
         
+      if (MusEGlobal::batchMode) {
+            if (argc < 2) {
+                  usage(argv[0], "batch mode needs a file to convert");
+#ifdef HAVE_LASH
+                  if(lash_args) lash_args_destroy(lash_args); 
+#endif
+                  return -1;
+                  }
+            // Nobody is there to answer these.
+            MusEGlobal::config.warnInitPending = false;
+            MusEGlobal::config.warnOnFileVersions = false;
+            MusEGlobal::config.showSplashScreen = false;
+            MusEGlobal::useLASH = false;
+            }
+
       MusEGlobal::ruid = getuid();
       MusEGlobal::euid = geteuid();
       MusEGlobal::undoSetuid();
@@ -699,8 +724,10 @@ int main(int argc, char* argv[])
       // created (in initMidiDevices), otherwise random crashes can occur within Jack <= 1.9.8. Fixed in Jack 1.9.9.  Tim.
       MusECore::initMidiDevices();    
       // Wait until things have settled. One second seems OK so far.
-      for(int t = 0; t < 100; ++t)   
-        usleep(10000);
+      // Not needed without Jack, batch mode always uses the dummy driver.
+      if (!MusEGlobal::batchMode)
+        for(int t = 0; t < 100; ++t)   
+          usleep(10000);
       // Now it is safe to call registerClient.
       MusEGlobal::audioDevice->registerClient();
       
@@ -754,12 +781,13 @@ int main(int argc, char* argv[])
       }
 #endif /* HAVE_LASH */
 
-      if (!MusEGlobal::debugMode) {
+      if (!MusEGlobal::debugMode && !MusEGlobal::batchMode) {
             if (mlockall(MCL_CURRENT | MCL_FUTURE))
                   perror("WARNING: Cannot lock memory:");
             }
 
-      MusEGlobal::muse->show();
+      if (!MusEGlobal::batchMode)
+            MusEGlobal::muse->show();
       MusEGlobal::muse->seqStart();  
 
       //--------------------------------------------------
@@ -778,11 +806,25 @@ int main(int argc, char* argv[])
       //--------------------------------------------------
       // Load the default song.                            
       //--------------------------------------------------
+      QElapsedTimer loadTimer;
+      loadTimer.start();
       MusEGlobal::muse->loadDefaultSong(argc, &argv[optind]);    
-
-      QTimer::singleShot(100, MusEGlobal::muse, SLOT(showDidYouKnowDialog()));
-      
-      int rv = app.exec();
+      const qint64 loadTime = loadTimer.elapsed();
+
+      int rv;
+      if (MusEGlobal::batchMode) {
+            QElapsedTimer timer;
+            timer.start();
+            rv = MusEGlobal::muse->batchConvert(batch_output) ? 0 : 1;
+            // Parsed by muse-batch.
+            printf("MusE batch: load %lld ms, write %lld ms\n", (long long)loadTime, (long long)timer.elapsed());
+            MusEGlobal::song->dirty = false;
+            MusEGlobal::muse->close();
+            }
+      else {
+            QTimer::singleShot(100, MusEGlobal::muse, SLOT(showDidYouKnowDialog()));
+            rv = app.exec();
+            }
       if(MusEGlobal::debugMsg) 
         printf("app.exec() returned:%d\nDeleting main MusE object\n", rv);
 
@@ -580,8 +580,9 @@ void buildMidiEventList(EventList* del, const MPEventList& el, MidiTrack* track,
                             //while k has to be a NOTE OFF. but in case something changes:
                             printf("ERROR: THIS SHOULD NEVER HAPPEN: k==i in midi.cpp:buildMidiEventList()\n");
                           else
+                            // Erasing k leaves i valid. Don't start over from the
+                            //  beginning, the notes before i all have their length.
                             mel.erase(k);
-                            i = mel.begin();
                           continue;
                           }
                     }
@@ -606,6 +607,134 @@ void buildMidiEventList(EventList* del, const MPEventList& el, MidiTrack* track,
             }
       }
 
+//---------------------------------------------------------
+//   buildMidiParts
+//    divide the events of an imported track into parts
+//---------------------------------------------------------
+
+void buildMidiParts(MidiTrack* track, bool splitParts)
+      {
+      EventList& tevents = track->events;
+      if (tevents.empty())
+            return;
+
+      //---------------------------------------------------
+      //    Parts ermitteln
+      //    die Midi-Spuren werden in Parts aufgebrochen;
+      //    ein neuer Part wird bei einer LÃ¯Â¿Â½cke von einem
+      //    Takt gebildet; die LÃ¯Â¿Â½nge wird jeweils auf
+      //    Takte aufgerundet und aligned
+      //---------------------------------------------------
+
+      PartList* pl = track->parts();
+
+      int lastTick = 0;
+      for (ciEvent i = tevents.begin(); i != tevents.end(); ++i) {
+            const Event& event = i->second;
+            int epos = event.tick() + event.lenTick();
+            if (epos > lastTick)
+                  lastTick = epos;
+            }
+
+      QString partname = track->name();
+      int len = MusEGlobal::song->roundUpBar(lastTick+1);
+
+      // p3.3.27
+      if(splitParts)
+      {
+        
+        int bar2, beat;
+        unsigned tick;
+        AL::sigmap.tickValues(len, &bar2, &beat, &tick);
+        
+        int lastOff = 0;
+        int st = -1;      // start tick current part
+        int x1 = 0;       // start tick current measure
+        int x2 = 0;       // end tick current measure
+  
+        for (int bar = 0; bar < bar2; ++bar, x1 = x2) {
+              x2 = AL::sigmap.bar2tick(bar+1, 0, 0);
+              if (lastOff > x2) {        
+                    continue;
+                    }
+              iEvent i1 = tevents.lower_bound(x1);
+              iEvent i2 = tevents.lower_bound(x2);
+  
+              if (i1 == i2) {   // empty?
+                    if (st != -1) {
+                          MidiPart* part = new MidiPart(track);
+                          part->setTick(st);
+                          part->setLenTick((lastOff > x1 ? x2 : x1) - st);
+                          part->setName(partname);
+                          pl->add(part);
+                          st = -1;
+                          }
+                    }
+              else {
+                    if (st == -1)
+                          st = x1;    // begin new  part
+                    //HACK:
+                    //lastOff:
+                    for (ciEvent i = i1; i != i2; ++i) {
+                          const Event& event = i->second;
+                          if (event.type() == Note) {
+                                int off = event.tick() + event.lenTick();
+                                if (off > lastOff)
+                                      lastOff = off;
+                                }
+                          }
+                    }
+              }
+        if (st != -1) {
+              MidiPart* part = new MidiPart(track);
+              part->setTick(st);
+              part->setLenTick(x2-st);
+              part->setName(partname);
+              pl->add(part);
+              }
+      }
+      else
+      {
+        // Just one long part...
+        MidiPart* part = new MidiPart(track);
+        part->setTick(0);
+        part->setLenTick(len);
+        part->setName(partname);
+        pl->add(part);
+      }
+
+      //-------------------------------------------------------------
+      //    assign events to parts
+      //-------------------------------------------------------------
+
+      for (iPart p = pl->begin(); p != pl->end(); ++p) {
+            MidiPart* part = (MidiPart*)(p->second);
+            int stick = part->tick();
+            int etick = part->tick() + part->lenTick();
+            iEvent r1 = tevents.lower_bound(stick);
+            iEvent r2 = tevents.lower_bound(etick);
+            int startTick = part->tick();
+
+            for (iEvent i = r1; i != r2; ++i) {
+                  Event& ev = i->second;
+                  int ntick = ev.tick() - startTick;
+                  ev.setTick(ntick);
+                  part->addEvent(ev);
+                  }
+            tevents.erase(r1, r2);
+            }
+
+      if (tevents.size())
+            printf("-----------events left: %zd\n", tevents.size());
+      for (ciEvent i = tevents.begin(); i != tevents.end(); ++i) {
+            printf("%d===\n", i->first);
+            i->second.dump();
+            }
+      // all events should be processed:
+      if (!tevents.empty())
+        printf("THIS SHOULD NEVER HAPPEN: not all events processed at the end of buildMidiParts()!\n");
+      }
+
 } // namespace MusECore
 
 namespace MusECore {
@@ -134,6 +134,7 @@ QString midiMetaName(int);
 struct MPEventList;
 class MidiTrack;
 extern void buildMidiEventList(EventList* mel, const MPEventList& el, MidiTrack* track, int division, bool addSysexMeta, bool doLoops);
+extern void buildMidiParts(MidiTrack* track, bool splitParts);
 
 } // namespace MusECore
 
@@ -39,6 +39,29 @@ namespace MusECore {
 class Xml;
 class PendingOperationList;
 
+//---------------------------------------------------------
+//   MidiOutputStats
+//    Output counters of a device, written by the thread
+//     which delivers its events. The gui only reads them.
+//---------------------------------------------------------
+
+struct MidiOutputStats {
+      unsigned long events;         // Messages handed to the driver.
+      unsigned long late;           // Messages due before the period they went out in.
+      unsigned long bufferFull;     // Periods cut short because the driver buffer was full.
+      unsigned long dropped;        // Messages lost, for example oversized sysex.
+      unsigned long fifoOverflows;  // Events lost because the gui fifo was full.
+      int maxQueued;                // Most events held back for later periods.
+      unsigned long scheduled;      // Messages timestamped ahead for the driver to deliver.
+      int maxLateness;              // Worst lateness of a late message, in frames.
+      double totalLateness;         // Sum of the lateness of all late messages, in frames.
+
+      MidiOutputStats() { reset(); }
+      void reset() { events = late = bufferFull = dropped = fifoOverflows = scheduled = 0; 
+                     maxQueued = maxLateness = 0; totalLateness = 0.0; }
+      void addLateness(int frames) { ++late; totalLateness += frames; if(frames > maxLateness) maxLateness = frames; }
+      };
+
 //---------------------------------------------------------
 //   MidiDevice
 //---------------------------------------------------------
@@ -66,6 +89,8 @@ class MidiDevice {
       MidiFifo eventFifo;  
       // Recording fifos. To speed up processing, one per channel plus one special system 'channel' for channel-less events like sysex.
       MidiRecFifo _recordFifo[MIDI_CHANNELS + 1];   
+      
+      MidiOutputStats _outputStats;
 
       volatile bool stopPending;         
       volatile bool seekPending;
@@ -164,6 +189,9 @@ class MidiDevice {
       bool sysexReadingChunks() { return _sysexReadingChunks; }
       void setSysexReadingChunks(bool v) { _sysexReadingChunks = v; }
       bool sendNullRPNParams(unsigned time, int port, int chan, bool);
+      
+      const MidiOutputStats& outputStats() const    { return _outputStats; }
+      void resetOutputStats()                       { _outputStats.reset(); }
       };
 
 //---------------------------------------------------------
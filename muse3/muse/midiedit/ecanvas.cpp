@@ -63,6 +63,7 @@ EventCanvas::EventCanvas(MidiEditor* pr, QWidget* parent, int sx,
       _midiin     = false;
       _playEvents = true;
       _setCurPartIfOnlyOneEventIsSelected = true;
+      _appliedChangeSerial = 0;
       curVelo     = 70;
       playedPitch = -1;
       playedPitchChannel = -1;
@@ -165,7 +166,19 @@ void EventCanvas::songChanged(MusECore::SongChangedFlags_t flags)
       if(flags == SC_MIDI_CONTROLLER)
         return;
     
-      if (flags & ~(SC_SELECTION | SC_PART_SELECTION | SC_TRACK_SELECTION)) {
+      // Only events were added or removed? Then patch the items of just those events
+      //  instead of rebuilding all of them.
+      bool patched = false;
+      const MusECore::EventChangeLog* changes = MusEGlobal::song->eventChanges();
+      if (changes && MusEGlobal::song->songChangedSerial() != _appliedChangeSerial) {
+            _appliedChangeSerial = MusEGlobal::song->songChangedSerial();
+            if ((flags & (SC_EVENT_INSERTED | SC_EVENT_REMOVED | SC_EVENT_MODIFIED)) &&
+               !(flags & ~(SC_EVENT_INSERTED | SC_EVENT_REMOVED | SC_EVENT_MODIFIED |
+                           SC_SELECTION | SC_PART_SELECTION | SC_TRACK_SELECTION | SC_MIDI_CONTROLLER)))
+                  patched = applyEventChanges(changes);
+            }
+
+      if (!patched && (flags & ~(SC_SELECTION | SC_PART_SELECTION | SC_TRACK_SELECTION))) {
             // TODO FIXME: don't we actually only want SC_PART_*, and maybe SC_TRACK_DELETED?
             //             (same in waveview.cpp)
             bool curItemNeedsRestore=false;
@@ -219,28 +232,27 @@ void EventCanvas::songChanged(MusECore::SongChangedFlags_t flags)
       MusECore::Event event;
       MusECore::MidiPart* part   = 0;
       int x            = 0;
-      CItem*   nevent  = 0;
 
-      int n  = 0;       // count selections
-      for (iCItem k = items.begin(); k != items.end(); ++k) {
-            MusECore::Event ev = k->second->event();
-            
-            if (ev.selected()) {
-                  ++n;
-                  if (!nevent) {
-                        nevent   =  k->second;
-                        curVelo = ev.velo();
-                        }
+      // Patched items keep the selection list up to date, unless the selection changed.
+      const bool incremental = patched && !(flags & SC_SELECTION);
+      if (!incremental) {
+            _selected.clear();
+            for (iCItem k = items.begin(); k != items.end(); ++k) {
+                  if (k->second->event().selected())
+                        noteSelected(k->first, k->second);
                   }
             }
+      const int n = _selected.size();       // count selections
       start_tick = MusEGlobal::song->roundDownBar(start_tick);
       end_tick   = MusEGlobal::song->roundUpBar(end_tick);
 
       if (n >= 1)    
       {
-            x     = nevent->x();
-            event = nevent->event();
-            part  = (MusECore::MidiPart*)nevent->part();
+            const SelectedItem& first = _selected.begin()->second;
+            x     = first.x;
+            event = first.event;
+            part  = first.part;
+            curVelo = event.velo();
             if (_setCurPartIfOnlyOneEventIsSelected && n == 1 && curPart != part) {
                   curPart = part;
                   curPartId = curPart->sn();
@@ -258,7 +270,216 @@ void EventCanvas::songChanged(MusECore::SongChangedFlags_t flags)
       
       if (curPart == 0)
             curPart = (MusECore::MidiPart*)(editor->parts()->begin()->second);
-      redraw();
+      if (!incremental)
+            redraw();
+      else if (!_changedRect.isEmpty())
+            redraw(map(_changedRect).adjusted(-2, -2, 2, 2));
+      }
+
+//---------------------------------------------------------
+//   noteSelected
+//    Add an item of a selected event, keyed as in items,
+//     to the selection list.
+//---------------------------------------------------------
+
+void EventCanvas::noteSelected(int key, const CItem* item)
+      {
+      SelectedItem s;
+      s.x     = item->x();
+      s.event = item->event();
+      s.part  = (MusECore::MidiPart*)item->part();
+      _selected.insert(std::make_pair(key, s));
+      }
+
+//---------------------------------------------------------
+//   itemAdded
+//    Account for an item applyEventChanges added.
+//---------------------------------------------------------
+
+void EventCanvas::itemAdded(CItem* item)
+      {
+      _changedRect |= item->bbox();
+      if (item->event().selected())
+            noteSelected(item->bbox().x(), item);
+      }
+
+//---------------------------------------------------------
+//   forgetSelected
+//    Remove an item's event from the selection list.
+//---------------------------------------------------------
+
+void EventCanvas::forgetSelected(int key, const CItem* item)
+      {
+      std::pair<std::multimap<int, SelectedItem>::iterator, std::multimap<int, SelectedItem>::iterator> r = _selected.equal_range(key);
+      for (std::multimap<int, SelectedItem>::iterator i = r.first; i != r.second; ++i) {
+            if (i->second.part == item->part() && i->second.event == item->event()) {
+                  _selected.erase(i);
+                  return;
+                  }
+            }
+      // Keyed elsewhere meanwhile (items being dragged).
+      for (std::multimap<int, SelectedItem>::iterator i = _selected.begin(); i != _selected.end(); ++i) {
+            if (i->second.part == item->part() && i->second.event == item->event()) {
+                  _selected.erase(i);
+                  return;
+                  }
+            }
+      }
+
+//---------------------------------------------------------
+//   removeItem
+//    Remove and delete the item showing event e of part.
+//    Unless searchAll is set, only the item keyed by the
+//     event's position and the current item are checked.
+//    Returns true if it was the current item.
+//---------------------------------------------------------
+
+bool EventCanvas::removeItem(const MusECore::Part* part, const MusECore::Event& e, bool searchAll)
+      {
+      iCItem found = items.end();
+      std::pair<iCItem, iCItem> r = items.equal_range(e.tick() + part->tick());
+      for (iCItem i = r.first; i != r.second; ++i) {
+            if (i->second->part() == part && i->second->event() == e) {
+                  found = i;
+                  break;
+                  }
+            }
+      // The current item is keyed where it was drawn (a new note, drum items).
+      if (found == items.end() && curItem && curItem->part() == part && curItem->event() == e) {
+            r = items.equal_range(curItem->bbox().x());
+            for (iCItem i = r.first; i != r.second; ++i) {
+                  if (i->second == curItem) {
+                        found = i;
+                        break;
+                        }
+                  }
+            }
+      // The item may be keyed elsewhere (items being dragged).
+      if (found == items.end() && searchAll) {
+            for (iCItem i = items.begin(); i != items.end(); ++i) {
+                  if (i->second->part() == part && i->second->event() == e) {
+                        found = i;
+                        break;
+                        }
+                  }
+            }
+      if (found == items.end())
+            return false;
+
+      CItem* item = found->second;
+      _changedRect |= item->bbox();
+      if (item->event().selected())
+            forgetSelected(found->first, item);
+      items.erase(found);
+      for (iCItem i = moving.begin(); i != moving.end(); ++i) {
+            if (i->second == item) {
+                  moving.erase(i);
+                  break;
+                  }
+            }
+      const bool wasCurrent = (item == curItem);
+      if (wasCurrent)
+            curItem = NULL;
+      delete item;
+      return wasCurrent;
+      }
+
+//---------------------------------------------------------
+//   removePartItems
+//---------------------------------------------------------
+
+void EventCanvas::removePartItems(const MusECore::Part* part)
+      {
+      for (iCItem i = items.begin(); i != items.end(); ) {
+            CItem* item = i->second;
+            if (item->part() != part) {
+                  ++i;
+                  continue;
+                  }
+            _changedRect |= item->bbox();
+            if (item->event().selected())
+                  forgetSelected(i->first, item);
+            items.erase(i++);
+            for (iCItem k = moving.begin(); k != moving.end(); ++k) {
+                  if (k->second == item) {
+                        moving.erase(k);
+                        break;
+                        }
+                  }
+            if (item == curItem)
+                  curItem = NULL;
+            delete item;
+            }
+      }
+
+//---------------------------------------------------------
+//   applyEventChanges
+//    Bring the items up to date from the song's event change
+//     log. Returns false if a full rebuild is cheaper.
+//---------------------------------------------------------
+
+bool EventCanvas::applyEventChanges(const MusECore::EventChangeLog* changes)
+      {
+      if (changes->empty() || changes->size() > items.size())
+            return false;
+
+      _changedRect = QRect();
+
+      for (MusECore::ciEventChange ic = changes->begin(); ic != changes->end(); ++ic) {
+            // Only parts shown here.
+            MusECore::Part* part = 0;
+            for (MusECore::ciPart p = editor->parts()->begin(); p != editor->parts()->end(); ++p) {
+                  if (p->second == ic->part) {
+                        part = p->second;
+                        break;
+                        }
+                  }
+            if (!part)
+                  continue;
+
+            switch (ic->type) {
+                  case MusECore::EventChange::Removed:
+                        removeItem(part, ic->event);
+                        break;
+                  case MusECore::EventChange::Added:
+                        {
+                        // A new note keeps the event of the item that was drawn for it,
+                        //  which is the current item. Other added events have no item
+                        //  yet, don't search all items for them.
+                        const bool wasCurrent = removeItem(part, ic->event, false);
+                        const MusECore::Event& e = ic->event;
+                        if (e.isNote() && e.tick() <= part->lenTick()) {
+                              CItem* item = addItem(part, e);
+                              if (item)
+                                    itemAdded(item);
+                              if (wasCurrent)
+                                    curItem = item;
+                              }
+                        }
+                        break;
+                  case MusECore::EventChange::ListReplaced:
+                        removePartItems(part);
+                        for (MusECore::ciEvent i = part->events().begin(); i != part->events().end(); ++i) {
+                              const MusECore::Event& e = i->second;
+                              if (e.tick() > part->lenTick())
+                                    break;
+                              if (e.isNote()) {
+                                    CItem* item = addItem(part, e);
+                                    if (item)
+                                          itemAdded(item);
+                                    }
+                              }
+                        break;
+                  }
+            }
+
+      // A temporary item whose event did not make it into the part (forbidden new note).
+      if (curItem) {
+            const MusECore::EventList& el = curItem->part()->events();
+            if (el.findWithId(curItem->event()) == el.end())
+                  removeItem(curItem->part(), curItem->event());
+            }
+      return true;
       }
 
 //---------------------------------------------------------
@@ -433,7 +654,6 @@ void EventCanvas::keyPress(QKeyEvent* event)
 
 void EventCanvas::viewDropEvent(QDropEvent* event)
       {
-      QString text;
       if (event->source() == this) {
             printf("local DROP\n");      
             //event->acceptProposedAction();     
@@ -441,12 +661,10 @@ void EventCanvas::viewDropEvent(QDropEvent* event)
             return;
             }
       if (event->mimeData()->hasFormat("text/x-muse-groupedeventlists")) {
-            text = QString(event->mimeData()->data("text/x-muse-groupedeventlists"));
-      
             int x = editor->rasterVal(event->pos().x());
             if (x < 0)
                   x = 0;
-            paste_at(text,x,3072,false,false,curPart);
+            paste_at(event->mimeData(),x,3072,false,false,curPart);
             //event->accept();  // TODO
             }
       else {
@@ -477,6 +695,9 @@ void EventCanvas::endMoveItems(const QPoint& pos, DragType dragtype, int dir, bo
       
       
       MusECore::Undo operations = moveCanvasItems(moving, dp, dx, dragtype, rasterize);
+      // Items which stay (copied events) must not be drawn as moving any more.
+      for (iCItem i = moving.begin(); i != moving.end(); ++i)
+            i->second->setMoving(false);
       if (operations.empty())
         songChanged(SC_EVENT_MODIFIED); //this is a hack to force the canvas to repopulate
       	                                //itself. otherwise, if a moving operation was forbidden,
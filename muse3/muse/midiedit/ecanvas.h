@@ -40,6 +40,7 @@ namespace MusECore {
 class MidiPart;
 class MidiTrack;
 class Part;
+class EventChangeLog;
 
 struct PartToChange
 {
@@ -78,7 +79,24 @@ class EventCanvas : public Canvas {
       bool _steprec;
       bool _midiin;
       bool _setCurPartIfOnlyOneEventIsSelected;
-
+      unsigned _appliedChangeSerial;   // Song::songChangedSerial() of the last patch.
+
+      // The items of selected events, keyed like in items. Rebuilt when the
+      //  selection changed, else kept up to date by applyEventChanges.
+      struct SelectedItem {
+            int x;
+            MusECore::Event event;
+            MusECore::MidiPart* part;
+            };
+      std::multimap<int, SelectedItem> _selected;
+      QRect _changedRect;              // Items patched by applyEventChanges, virtual coordinates.
+
+      void noteSelected(int key, const CItem*);
+      void forgetSelected(int key, const CItem*);
+      void itemAdded(CItem*);
+      bool removeItem(const MusECore::Part*, const MusECore::Event&, bool searchAll = true);
+      void removePartItems(const MusECore::Part*);
+      bool applyEventChanges(const MusECore::EventChangeLog*);
       void updateSelection();
       virtual CItem* addItem(MusECore::Part*, const MusECore::Event&) = 0;
       virtual QPoint raster(const QPoint&) const;
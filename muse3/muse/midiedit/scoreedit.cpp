@@ -1566,10 +1566,20 @@ void ScoreCanvas::song_changed(MusECore::SongChangedFlags_t flags)
 	             SC_EVENT_INSERTED | SC_EVENT_MODIFIED | SC_EVENT_REMOVED |
 	             SC_SIG  | SC_KEY) )
 	{
-		calc_pos_add_list();
-		
-		for (list<staff_t>::iterator it=staves.begin(); it!=staves.end(); it++)
-			it->recalculate();
+		if (flags & (SC_SIG | SC_KEY))
+		{
+			calc_pos_add_list(); // only depends on time signatures and keys
+			
+			for (list<staff_t>::iterator it=staves.begin(); it!=staves.end(); it++)
+				it->recalculate();
+		}
+		else
+		{
+			// only the notes changed. staves and measures without
+			// changed notes keep their layout.
+			for (list<staff_t>::iterator it=staves.begin(); it!=staves.end(); it++)
+				it->recalculate_changed();
+		}
 			
 		recalc_staff_pos();
 		
@@ -1864,6 +1874,110 @@ void staff_t::create_appropriate_eventlist()
 }
 
 
+// true if both events would be laid out the same
+static bool same_flo_event(const FloEvent& a, const FloEvent& b)
+{
+	if (a.type==FloEvent::NOTE_ON)
+		return (a.tick==b.tick) && (a.vel==b.vel) && (a.len==b.len) &&
+		       (a.source_part==b.source_part) && (a.source_event==b.source_event);
+	else
+		return (a.len==b.len) && (a.num==b.num) && (a.denom==b.denom) && (a.key==b.key);
+}
+
+// widens [from, to] to cover a changed event. anything else than
+// a note makes all measures dirty.
+static void mark_changed(const pair<unsigned, FloEvent>& ev, unsigned& from, unsigned& to, bool& all)
+{
+	if (ev.second.type!=FloEvent::NOTE_ON)
+	{
+		all=true;
+		return;
+	}
+	if (ev.first < from) from=ev.first;
+	if (ev.first + ev.second.len > to) to=ev.first + ev.second.len;
+}
+
+/* lays out only the measures whose notes differ from those
+ * the current itemlist was created from (see laid_out).
+ * everything which doesn't only depend on the notes (clef, key,
+ * time signatures) must use recalculate() instead
+ */
+void staff_t::recalculate_changed()
+{
+	if (itemlist.empty() || laid_out.empty())
+	{
+		recalculate();
+		return;
+	}
+	
+	create_appropriate_eventlist();
+	
+	// find the changed notes
+	floComp comp;
+	unsigned from=UINT_MAX, to=0;
+	bool all=false;
+	ScoreEventList::iterator a=laid_out.begin(), b=eventlist.begin();
+	while (!all && (a!=laid_out.end() || b!=eventlist.end()))
+	{
+		if (b==eventlist.end() || (a!=laid_out.end() && comp(*a,*b)))
+			mark_changed(*a++, from, to, all);
+		else if (a==laid_out.end() || comp(*b,*a))
+			mark_changed(*b++, from, to, all);
+		else
+		{
+			if (!same_flo_event(a->second, b->second))
+			{
+				mark_changed(*a, from, to, all);
+				mark_changed(*b, from, to, all);
+			}
+			a++;
+			b++;
+		}
+	}
+	
+	laid_out=eventlist;
+	
+	if (from > to) // nothing changed, the layout is still valid.
+		return;
+	
+	// widen to whole measures: from the bar before from up to the bar at or after to.
+	unsigned bar_from=0;
+	bool found=false;
+	ScoreEventList::iterator it=eventlist.upper_bound(pair<unsigned, FloEvent>(from, FloEvent(from,0,0,0,FloEvent::BAR)));
+	while (it!=eventlist.begin())
+	{
+		it--;
+		if (it->second.type==FloEvent::BAR)
+		{
+			bar_from=it->first;
+			found=true;
+			break;
+		}
+	}
+	
+	unsigned bar_to=UINT_MAX;
+	for (it=eventlist.lower_bound(pair<unsigned, FloEvent>(to, FloEvent(to,0,0,0,FloEvent::BAR))); it!=eventlist.end(); it++)
+		if (it->second.type==FloEvent::BAR)
+		{
+			bar_to=it->first;
+			break;
+		}
+	
+	if (all || !found || bar_from==0)
+	{
+		create_itemlist();
+		process_itemlist();
+	}
+	else
+	{
+		if (heavyDebugMsg) cout << "laying out measures from tick "<<bar_from<<" to "<<bar_to<<" again" << endl;
+		create_itemlist(bar_from, bar_to);
+		process_itemlist(bar_from, bar_to);
+	}
+	calc_item_pos();
+}
+
+
 bool is_sharp_key(MusECore::key_enum t)
 {
 	return ((t>=MusECore::KEY_SHARP_BEGIN) && (t<=MusECore::KEY_SHARP_END));
@@ -2263,17 +2377,32 @@ void ScoreCanvas::draw_accidentials(QPainter& p, int x, int y_offset, const list
 	}
 }
 
-void staff_t::create_itemlist()
+void staff_t::create_itemlist(unsigned from, unsigned to)
 {
 	MusECore::key_enum tmp_key=MusECore::KEY_C;
 	int lastevent=0;
 	int next_measure=-1;
 	int last_measure=-1;
 	vector<int> emphasize_list=create_emphasize_list(4,4); //actually unneccessary, for safety
+	ScoreEventList::iterator begin_it=eventlist.begin();
 
-	itemlist.clear();
+	if (from==0)
+		itemlist.clear();
+	else
+	{
+		// start at the bar at from, in the state a full run would be in there.
+		// last_measure stays -1, so the measure before isn't closed again.
+		int z, n;
+		AL::sigmap.timesig(from-1, z, n);
+		emphasize_list=create_emphasize_list(z, n);
+		tmp_key=MusEGlobal::keymap.keyAtTick(from-1);
+		
+		erase_items(from, to);
+		insert_crossing_notes(from);
+		begin_it=eventlist.lower_bound(pair<unsigned, FloEvent>(from, FloEvent(from,0,0,0,FloEvent::BAR)));
+	}
 
-	for (ScoreEventList::iterator it=eventlist.begin(); it!=eventlist.end(); it++)
+	for (ScoreEventList::iterator it=begin_it; it!=eventlist.end(); it++)
 	{
 		int t, pitch, len, velo, actual_tick;
 		FloEvent::typeEnum type;
@@ -2324,6 +2453,9 @@ void staff_t::create_itemlist()
 					}
 				}
 			}
+			
+			if (unsigned(t)>=to) //the measures after to are still laid out
+				break;
 						
 			lastevent=t;
 			last_measure=t;
@@ -2422,14 +2554,78 @@ void staff_t::create_itemlist()
 	}	
 }
 
-void staff_t::process_itemlist()
+// removes the items of the measures from..to. the ends of notes and rests
+// at from belong to the measure before, those at to to the last removed one.
+void staff_t::erase_items(unsigned from, unsigned to)
+{
+	ScoreItemList::iterator it2=itemlist.lower_bound(from);
+	
+	if (it2!=itemlist.end() && it2->first==from)
+	{
+		set<FloItem, floComp>& items=it2->second;
+		for (set<FloItem, floComp>::iterator it=items.begin(); it!=items.end();)
+			if ((it->type!=FloItem::NOTE_END) && (it->type!=FloItem::REST_END))
+				items.erase(it++);
+			else
+				it++;
+		it2++;
+	}
+	
+	while (it2!=itemlist.end() && it2->first<to)
+		itemlist.erase(it2++);
+	
+	if (it2!=itemlist.end() && it2->first==to)
+	{
+		set<FloItem, floComp>& items=it2->second;
+		for (set<FloItem, floComp>::iterator it=items.begin(); it!=items.end();)
+			if ((it->type==FloItem::NOTE_END) || (it->type==FloItem::REST_END))
+				items.erase(it++);
+			else
+				it++;
+	}
+}
+
+// a full create_itemlist() run splits notes at each bar and puts the
+// remainder back into the eventlist. do that for the notes sounding at tick.
+void staff_t::insert_crossing_notes(unsigned tick)
+{
+	ScoreEventList::iterator end_it=eventlist.lower_bound(pair<unsigned, FloEvent>(tick, FloEvent(tick,0,0,0,FloEvent::BAR)));
+	
+	for (ScoreEventList::iterator it=eventlist.begin(); it!=end_it; it++)
+		if ((it->second.type==FloEvent::NOTE_ON) && (it->first < tick) && (it->first + it->second.len > tick))
+		{
+			int actual_tick=it->second.tick;
+			eventlist.insert(pair<unsigned, FloEvent>(tick, FloEvent(actual_tick,it->second.pitch, it->second.vel,it->first + it->second.len - tick,FloEvent::NOTE_ON, it->second.source_part, it->second.source_event)));
+		}
+}
+
+void staff_t::process_itemlist(unsigned from, unsigned to)
 {
 	map<int,int> occupied;
 	int last_measure=0;
 	vector<int> emphasize_list=create_emphasize_list(4,4); //unneccessary, only for safety
+	ScoreItemList::iterator begin_it=itemlist.begin();
+	ScoreItemList::iterator end_it=itemlist.end();
+
+	if (from!=0)
+	{
+		int z, n;
+		AL::sigmap.timesig(from-1, z, n);
+		emphasize_list=create_emphasize_list(z, n);
+		
+		begin_it=itemlist.lower_bound(from);
+		end_it=itemlist.lower_bound(to); // there's a bar at to, so this stays the end
+		
+		// notes never cross a bar, so only those ending at from are
+		// still occupying their lines there
+		if (begin_it!=itemlist.end() && begin_it->first==from)
+			for (set<FloItem, floComp>::iterator it=begin_it->second.begin(); it!=begin_it->second.end(); it++)
+				if ((it->type==FloItem::NOTE_END) || (it->type==FloItem::REST_END))
+					occupied[it->pos.height]++;
+	}
 
 	//iterate through all times with items
-	for (ScoreItemList::iterator it2=itemlist.begin(); it2!=itemlist.end(); it2++)
+	for (ScoreItemList::iterator it2=begin_it; it2!=end_it; it2++)
 	{
 		set<FloItem, floComp>& curr_items=it2->second;
 		
@@ -2908,6 +3104,11 @@ void staff_t::calc_item_pos()
 	max_y_coord=0;
 	min_y_coord=0;
 	
+	//items may be left over from an earlier layout, whose tie may be gone
+	for (ScoreItemList::iterator it2=itemlist.begin(); it2!=itemlist.end(); it2++)
+		for (set<FloItem, floComp>::iterator it=it2->second.begin(); it!=it2->second.end();it++)
+			it->is_tie_dest=false;
+	
 	for (ScoreItemList::iterator it2=itemlist.begin(); it2!=itemlist.end(); it2++)
 	{
 		for (set<FloItem, floComp>::iterator it=it2->second.begin(); it!=it2->second.end();it++)
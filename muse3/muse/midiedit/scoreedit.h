@@ -550,6 +550,7 @@ struct staff_t
 	set<int> part_indices;
 	ScoreEventList eventlist;
 	ScoreItemList itemlist;
+	ScoreEventList laid_out; // the eventlist itemlist was created from
 	
 	int y_top;
 	int y_draw;
@@ -564,20 +565,27 @@ struct staff_t
 	ScoreCanvas* parent;
 	
 	void create_appropriate_eventlist();
-	void create_itemlist();
-	void process_itemlist();
+	// from and to are bar ticks. from=0 lays out the whole staff,
+	// otherwise only the measures from from up to to are replaced.
+	void create_itemlist(unsigned from=0, unsigned to=UINT_MAX);
+	void process_itemlist(unsigned from=0, unsigned to=UINT_MAX);
 	void calc_item_pos();
+	void erase_items(unsigned from, unsigned to);
+	void insert_crossing_notes(unsigned tick);
 	
 	void apply_lasso(QRect rect, set<const MusECore::Event*>& already_processed);
 	
 	void recalculate()
 	{
 		create_appropriate_eventlist();
+		laid_out=eventlist;
 		create_itemlist();
 		process_itemlist();
 		calc_item_pos();
 	}
 	
+	void recalculate_changed();
+	
 	staff_t(ScoreCanvas* parent_)
 	{
 		type=NORMAL;
@@ -139,13 +139,25 @@ void MidiEventBase::dump(int n) const
 
 void MidiEventBase::write(int level, Xml& xml, const Pos& offset, bool /*forcePath*/) const
       {
-      xml.nput(level++, "<event tick=\"%d\"", tick() + offset.tick());
-      switch (type()) {
+      writeXml(level, xml, tick() + offset.tick(), type(), lenTick(), a, b, c, edata.data, edata.dataLen);
+      }
+
+//---------------------------------------------------------
+//   MidiEventBase::writeXml
+//    Touches no event, so deferred song writes can use it
+//     outside the gui thread.
+//---------------------------------------------------------
+
+void MidiEventBase::writeXml(int level, Xml& xml, unsigned tick, int type, unsigned len,
+                             int a, int b, int c, const unsigned char* data, int dataLen)
+      {
+      xml.nput(level++, "<event tick=\"%d\"", tick);
+      switch (type) {
             case Note:
-                  xml.nput(" len=\"%d\"", lenTick());
+                  xml.nput(" len=\"%d\"", len);
                   break;
             default:
-                  xml.nput(" type=\"%d\"", type());
+                  xml.nput(" type=\"%d\"", type);
                   break;
             }
       
@@ -157,11 +169,11 @@ void MidiEventBase::write(int level, Xml& xml, const Pos& offset, bool /*forcePa
       if (c)
             xml.nput(" c=\"%d\"", c);
       
-      if (edata.dataLen) {
-            xml.nput(" datalen=\"%d\">\n", edata.dataLen);
+      if (dataLen) {
+            xml.nput(" datalen=\"%d\">\n", dataLen);
             xml.nput(level, "");
-            for (int i = 0; i < edata.dataLen; ++i)
-                  xml.nput("%02x ", edata.data[i] & 0xff);
+            for (int i = 0; i < dataLen; ++i)
+                  xml.nput("%02x ", data[i] & 0xff);
             xml.nput("\n");
             xml.tag(level, "/event");
             }
@@ -84,6 +84,9 @@ class MidiEventBase : public EventBase {
       virtual void dump(int n = 0) const;
       virtual void read(Xml&);
       virtual void write(int, Xml&, const Pos& offset, bool forcePath = false) const;
+      // The <event> tag written by write(), from plain values.
+      static void writeXml(int level, Xml&, unsigned tick, int type, unsigned len,
+                           int a, int b, int c, const unsigned char* data, int dataLen);
       virtual EventBase* mid(unsigned, unsigned) const;
       };
 
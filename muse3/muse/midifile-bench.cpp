@@ -0,0 +1,335 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  midifile-bench.cpp
+//    Generate a big multi-track standard midi file, then time
+//    reading it with MidiFile and splitting the tracks into
+//    MusE tracks and parts the way importMidi does.
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <QCoreApplication>
+
+#include "song.h"
+#include "track.h"
+#include "part.h"
+#include "midi.h"
+#include "midifile.h"
+#include "mpevent.h"
+#include "globals.h"
+
+//---------------------------------------------------------
+//   SmfEvent
+//    a channel event of a generated track
+//---------------------------------------------------------
+
+struct SmfEvent {
+      unsigned tick;
+      int seq;          // keeps note offs ahead of note ons at the same tick
+      unsigned char data[3];
+      int len;
+      };
+
+static bool smfEventLess(const SmfEvent& a, const SmfEvent& b)
+      {
+      if (a.tick != b.tick)
+            return a.tick < b.tick;
+      return a.seq < b.seq;
+      }
+
+static void putLong(std::vector<unsigned char>& b, unsigned v)
+      {
+      b.push_back(v >> 24);
+      b.push_back(v >> 16);
+      b.push_back(v >> 8);
+      b.push_back(v);
+      }
+
+static void putVl(std::vector<unsigned char>& b, unsigned v)
+      {
+      unsigned char buf[5];
+      int n = 0;
+      buf[n++] = v & 0x7f;
+      while (v >>= 7)
+            buf[n++] = (v & 0x7f) | 0x80;
+      while (n)
+            b.push_back(buf[--n]);
+      }
+
+static void putMeta(std::vector<unsigned char>& b, int type, const unsigned char* data, int len)
+      {
+      putVl(b, 0);
+      b.push_back(0xff);
+      b.push_back(type);
+      putVl(b, len);
+      b.insert(b.end(), data, data + len);
+      }
+
+static void putTrack(std::vector<unsigned char>& smf, const std::vector<unsigned char>& track)
+      {
+      smf.push_back('M'); smf.push_back('T'); smf.push_back('r'); smf.push_back('k');
+      putLong(smf, track.size());
+      smf.insert(smf.end(), track.begin(), track.end());
+      }
+
+//---------------------------------------------------------
+//   generateSmf
+//    Format 1: a tempo track, then 'tracks' tracks each playing
+//     on two channels. Every step has a three note chord of a
+//     beat, steps are half a beat apart so notes overlap, with
+//     a controller and a pitch bend every eighth step.
+//     Returns the number of channel events written.
+//---------------------------------------------------------
+
+static long generateSmf(std::vector<unsigned char>& smf, int tracks, int steps, int division)
+      {
+      long events = 0;
+      smf.clear();
+      smf.push_back('M'); smf.push_back('T'); smf.push_back('h'); smf.push_back('d');
+      putLong(smf, 6);
+      smf.push_back(0); smf.push_back(1);
+      smf.push_back((tracks + 1) >> 8); smf.push_back(tracks + 1);
+      smf.push_back(division >> 8); smf.push_back(division);
+
+      std::vector<unsigned char> tb;
+      const unsigned char tempo[3]   = { 0x07, 0xa1, 0x20 };   // 500000 us/quarter
+      const unsigned char timesig[4] = { 4, 2, 24, 8 };
+      const unsigned char eot[1]     = { 0 };
+      putMeta(tb, 0x51, tempo, 3);
+      putMeta(tb, 0x58, timesig, 4);
+      putMeta(tb, 0x2f, eot, 0);
+      putTrack(smf, tb);
+
+      std::vector<SmfEvent> el;
+      for (int t = 0; t < tracks; ++t) {
+            el.clear();
+            int seq = 0;
+            for (int s = 0; s < steps; ++s) {
+                  const int ch   = (2 * t + (s & 1)) & 15;
+                  const unsigned tick = s * (division / 2);
+                  for (int k = 0; k < 3; ++k) {
+                        const int pitch = 36 + (s * 7 + k * 4 + t) % 60;
+                        SmfEvent on  = { tick, seq++, { (unsigned char)(0x90 | ch), (unsigned char)pitch, 100 }, 3 };
+                        // seq -1: ends before anything starts at that tick
+                        SmfEvent off = { tick + division, -1, { (unsigned char)(0x80 | ch), (unsigned char)pitch, 0 }, 3 };
+                        el.push_back(on);
+                        el.push_back(off);
+                        }
+                  if ((s & 7) == 0) {
+                        SmfEvent ctl  = { tick, seq++, { (unsigned char)(0xb0 | ch), 7, (unsigned char)((s / 8) % 128) }, 3 };
+                        SmfEvent bend = { tick, seq++, { (unsigned char)(0xe0 | ch), 0, (unsigned char)(64 + (s / 8) % 32) }, 3 };
+                        el.push_back(ctl);
+                        el.push_back(bend);
+                        }
+                  }
+            std::stable_sort(el.begin(), el.end(), smfEventLess);
+
+            tb.clear();
+            char name[32];
+            snprintf(name, sizeof(name), "Track %d", t + 1);
+            putMeta(tb, 0x03, (const unsigned char*)name, strlen(name));
+            unsigned last = 0;
+            for (std::vector<SmfEvent>::const_iterator i = el.begin(); i != el.end(); ++i) {
+                  putVl(tb, i->tick - last);
+                  last = i->tick;
+                  tb.insert(tb.end(), i->data, i->data + i->len);
+                  }
+            putMeta(tb, 0x2f, eot, 0);
+            putTrack(smf, tb);
+            events += el.size();
+            }
+      return events;
+      }
+
+//---------------------------------------------------------
+//   now
+//---------------------------------------------------------
+
+static double now()
+      {
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return ts.tv_sec + ts.tv_nsec * 1e-9;
+      }
+
+//---------------------------------------------------------
+//   splitTracks
+//    What importMidi does with the tracks of a midi file,
+//     less the port, instrument and drum map setup.
+//---------------------------------------------------------
+
+static void splitTracks(MusECore::MidiFile& mf, bool splitParts, std::vector<MusECore::MidiTrack*>& tracks)
+      {
+      MusECore::MidiFileTrackList* etl = mf.trackList();
+      for (MusECore::iMidiFileTrack t = etl->begin(); t != etl->end(); ++t) {
+            const MusECore::MPEventList& el = (*t)->events;
+            if (el.empty())
+                  continue;
+            bool first = true;
+            MusECore::MidiFileTrackSplit split;
+            (*t)->split(&split);
+            for (std::vector<MusECore::MidiFileTarget>::const_iterator it = split.targets.begin(); it != split.targets.end(); ++it) {
+                  MusECore::MidiTrack* track = new MusECore::MidiTrack();
+                  track->setOutChannel(it->first);
+                  track->setOutPort(it->second);
+                  MusECore::MPEventList& tel = split.events[*it];
+                  MusECore::buildMidiEventList(&track->events, tel, track, mf.division(), first, false);
+                  first = false;
+                  MusECore::buildMidiParts(track, splitParts);
+                  tracks.push_back(track);
+                  tel.clear();
+                  }
+            if (first) {
+                  MusECore::MidiTrack* track = new MusECore::MidiTrack();
+                  track->setOutChannel(0);
+                  track->setOutPort(0);
+                  MusECore::buildMidiEventList(&track->events, el, track, mf.division(), true, false);
+                  MusECore::buildMidiParts(track, splitParts);
+                  tracks.push_back(track);
+                  }
+            }
+      }
+
+//---------------------------------------------------------
+//   usage
+//---------------------------------------------------------
+
+static void usage(const char* name)
+      {
+      fprintf(stderr,
+         "usage: %s [-t tracks] [-n steps] [-r runs] [-p] [-o file]\n"
+         "   -t  tracks in the generated file (default 16)\n"
+         "   -n  steps per track, 3 notes each (default 8000)\n"
+         "   -r  runs, the best time is printed (default 5)\n"
+         "   -p  one part per track instead of splitting into parts\n"
+         "   -o  write the file here and keep it, default is a temporary file\n",
+         name);
+      }
+
+//---------------------------------------------------------
+//   main
+//---------------------------------------------------------
+
+int main(int argc, char* argv[])
+      {
+      QCoreApplication app(argc, argv);
+
+      int ntracks = 16;
+      int steps   = 8000;
+      int runs    = 5;
+      bool splitParts = true;
+      const char* out = 0;
+      for (int i = 1; i < argc; ++i) {
+            if (!strcmp(argv[i], "-t") && i + 1 < argc)
+                  ntracks = atoi(argv[++i]);
+            else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+                  steps = atoi(argv[++i]);
+            else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+                  runs = atoi(argv[++i]);
+            else if (!strcmp(argv[i], "-p"))
+                  splitParts = false;
+            else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+                  out = argv[++i];
+            else {
+                  usage(argv[0]);
+                  return 1;
+                  }
+            }
+      if (ntracks <= 0 || ntracks > 0xfffe || steps <= 0 || runs <= 0) {
+            usage(argv[0]);
+            return 1;
+            }
+
+      std::vector<unsigned char> smf;
+      const long nevents = generateSmf(smf, ntracks, steps, 384);
+
+      char tmpPath[] = "/tmp/midifile-benchXXXXXX";
+      const char* path = out;
+      FILE* fp;
+      if (out)
+            fp = fopen(out, "w");
+      else {
+            int fd = mkstemp(tmpPath);
+            fp = fd < 0 ? 0 : fdopen(fd, "w");
+            path = tmpPath;
+            }
+      if (fp == 0 || fwrite(&smf[0], 1, smf.size(), fp) != smf.size()) {
+            fprintf(stderr, "midifile-bench: can't write %s\n", path);
+            return 1;
+            }
+      fclose(fp);
+
+      MusEGlobal::song = new MusECore::Song("bench");
+
+      printf("%d tracks, %ld channel events, %zu bytes\n", ntracks, nevents, smf.size());
+      double readBest = 0.0, splitBest = 0.0;
+      size_t ntracksOut = 0, nparts = 0;
+      int rv = 0;
+      for (int r = 0; r < runs; ++r) {
+            fp = fopen(path, "r");
+            if (fp == 0) {
+                  fprintf(stderr, "midifile-bench: can't read %s\n", path);
+                  rv = 1;
+                  break;
+                  }
+            double start = now();
+            MusECore::MidiFile mf(fp);
+            bool err = mf.read();
+            double tRead = now() - start;
+            fclose(fp);
+            if (err) {
+                  fprintf(stderr, "midifile-bench: reading %s failed: %s\n", path, mf.error().toLocal8Bit().constData());
+                  rv = 1;
+                  break;
+                  }
+
+            std::vector<MusECore::MidiTrack*> tracks;
+            start = now();
+            splitTracks(mf, splitParts, tracks);
+            double tSplit = now() - start;
+
+            ntracksOut = tracks.size();
+            nparts = 0;
+            for (std::vector<MusECore::MidiTrack*>::iterator i = tracks.begin(); i != tracks.end(); ++i) {
+                  nparts += (*i)->parts()->size();
+                  delete *i;
+                  }
+            if (r == 0 || tRead < readBest)
+                  readBest = tRead;
+            if (r == 0 || tSplit < splitBest)
+                  splitBest = tSplit;
+            printf("run %d: read %8.3f ms  split %8.3f ms\n", r + 1, tRead * 1000.0, tSplit * 1000.0);
+            }
+      if (rv == 0)
+            printf("best:  read %8.3f ms  split %8.3f ms  (%zu tracks, %zu parts)\n",
+               readBest * 1000.0, splitBest * 1000.0, ntracksOut, nparts);
+
+      if (out == 0)
+            unlink(tmpPath);
+      delete MusEGlobal::song;
+      return rv;
+      }
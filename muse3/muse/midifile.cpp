@@ -23,6 +23,13 @@
 //=========================================================
 
 #include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <vector>
+
+#include <QThread>
+#include <QAtomicInt>
 
 #include "song.h"
 #include "midi.h"
@@ -37,6 +44,9 @@
 #include "mpevent.h"
 #include "gconfig.h"
 
+// Files with less track data are parsed in the calling thread.
+#define MIDIFILE_PARALLEL_BYTES (256 * 1024)
+
 namespace MusECore {
 
 const char* errString[] = {
@@ -77,7 +87,7 @@ MidiFile::MidiFile(FILE* f)
       {
       fp        = f;
       curPos    = 0;
-      lastMtype = MT_UNKNOWN;
+      status    = -1;
       _error    = MF_NO_ERROR;
       _tracks   = new MidiFileTrackList;
       _usedPortMap = new MidiFilePortMap;
@@ -113,15 +123,42 @@ void MidiFile::setTrackList(MidiFileTrackList* tr, int n)
 
 bool MidiFile::read(void* p, size_t len)
       {
+      if (curPos + len > (size_t)_data.size()) {
+            curPos = _data.size();
+            _error = MF_EOF;
+            return true;
+            }
+      memcpy(p, _data.constData() + curPos, len);
+      curPos += len;
+      return false;
+      }
+
+//---------------------------------------------------------
+//   fill
+//    Read the whole file into memory, it is parsed from
+//     there. Return true on error.
+//---------------------------------------------------------
+
+bool MidiFile::fill()
+      {
+      int chunk = 256 * 1024;
+      struct stat st;
+      if (fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode)) {
+            const long pos = ftell(fp);
+            if (pos >= 0 && st.st_size > pos && st.st_size - pos < 0x7fff0000)
+                  chunk = st.st_size - pos + 1;   // One more, to see the end in the first read.
+            }
+      int size = 0;
       for (;;) {
-            curPos += len;
-            size_t rv = fread(p, 1, len, fp);
-            if (rv == len)
-                  return false;
-            if (feof(fp)) {
-                  _error = MF_EOF;
-                  return true;
-                  }
+            _data.resize(size + chunk);
+            const size_t n = fread(_data.data() + size, 1, chunk, fp);
+            size += n;
+            if (n < (size_t)chunk)
+                  break;
+            }
+      _data.resize(size);
+      curPos = 0;
+      if (ferror(fp)) {
             _error = MF_READ;
             return true;
             }
@@ -195,28 +232,13 @@ int MidiFile::readLong()
 
 bool MidiFile::skip(size_t len)
       {
-      char tmp[len];
-      return read(tmp, len);
-      }
-
-/*---------------------------------------------------------
- *    getvl
- *    Read variable-length number (7 bits per byte, MSB first)
- *---------------------------------------------------------*/
-
-int MidiFile::getvl()
-      {
-      int l = 0;
-      for (int i = 0; i < 16; i++) {
-            uchar c;
-            if (read(&c, 1))
-                  return -1;
-            l += (c & 0x7f);
-            if (!(c & 0x80))
-                  return l;
-            l <<= 7;
+      if (curPos + len > (size_t)_data.size()) {
+            curPos = _data.size();
+            _error = MF_EOF;
+            return true;
             }
-      return -1;
+      curPos += len;
+      return false;
       }
 
 /*---------------------------------------------------------
@@ -242,33 +264,108 @@ void MidiFile::putvl(unsigned val)
       }
 
 //---------------------------------------------------------
-//   readTrack
+//   MidiFilePortChange
+//    Port, channel and device metas seen while parsing a
+//     track, applied in file order by MidiFile::readTrack.
+//---------------------------------------------------------
+
+struct MidiFilePortChange {
+      std::size_t index;      // Applies before the index'th accepted event.
+      int port;               // -1: none
+      int channel;            // -1: none
+      MType mtype;
+      QString instrName;
+      QString deviceName;
+      };
+
+//---------------------------------------------------------
+//   MidiFileTrackReader
+//    Parses one MTrk chunk out of the file buffer. Uses no
+//     shared state, so the tracks of a file can be parsed
+//     in parallel.
+//---------------------------------------------------------
+
+struct MidiFileTrackReader {
+      const unsigned char* data;
+      std::size_t pos;
+      std::size_t end;
+      int error;
+      bool failed;            // Bad event, the file is rejected.
+      int status, sstatus, click;
+      int lastport, lastchannel;
+      MType lastMtype;
+      QString lastInstrName;
+      QString lastDeviceName;
+      MidiFileTrack* track;
+      std::vector<MidiPlayEvent> events;
+      std::vector<MidiFilePortChange> changes;
+
+      MidiFileTrackReader(const unsigned char* d, std::size_t p, std::size_t e) {
+            data   = d;
+            pos    = p;
+            end    = e;
+            error  = MF_NO_ERROR;
+            failed = false;
+            track  = new MidiFileTrack;
+            }
+      bool read(void* p, size_t len);
+      int getvl();
+      int readEvent(MidiPlayEvent*);
+      void parse();
+      };
+
+//---------------------------------------------------------
+//   read
 //    return true on error
 //---------------------------------------------------------
 
-bool MidiFile::readTrack(MidiFileTrack* t)
+inline bool MidiFileTrackReader::read(void* p, size_t len)
       {
-      MPEventList* el = &(t->events);
-      char tmp[4];
-      if (read(tmp, 4))
-            return true;
-      if (memcmp(tmp, "MTrk", 4)) {
-            _error = MF_MTRK;
+      if (pos + len > end) {
+            pos   = end;
+            error = MF_EOF;
             return true;
             }
-      int len    = readLong();       // len
-      if(len <= 0)
-        return false;
-      
-      int endPos = curPos + len;
-      status     = -1;
-      sstatus    = -1;     // running status, not reset scanning meta or sysex
-      click      = 0;
+      memcpy(p, data + pos, len);
+      pos += len;
+      return false;
+      }
 
-      int port    = 0;
-      int channel = 0;
-      
-      for (;;) {
+/*---------------------------------------------------------
+ *    getvl
+ *    Read variable-length number (7 bits per byte, MSB first)
+ *---------------------------------------------------------*/
+
+int MidiFileTrackReader::getvl()
+      {
+      int l = 0;
+      for (int i = 0; i < 16; i++) {
+            if (pos >= end) {
+                  error = MF_EOF;
+                  return -1;
+                  }
+            const uchar c = data[pos++];
+            l += (c & 0x7f);
+            if (!(c & 0x80))
+                  return l;
+            l <<= 7;
+            }
+      return -1;
+      }
+
+//---------------------------------------------------------
+//   parse
+//---------------------------------------------------------
+
+void MidiFileTrackReader::parse()
+      {
+      status  = -1;
+      sstatus = -1;     // running status, not reset scanning meta or sysex
+      click   = 0;
+      // A running status event takes at least two bytes.
+      events.reserve((end - pos) / 3);
+
+      for (bool first = true; pos < end; first = false) {
             MidiPlayEvent event;
             lastport    = -1;
             lastchannel = -1;
@@ -276,105 +373,248 @@ bool MidiFile::readTrack(MidiFileTrack* t)
             lastInstrName.clear();
             lastDeviceName.clear();
 
-            int rv = readEvent(&event, t);
-            if (lastport != -1) {
-                  port = lastport;
-                  if (port >= MIDI_PORTS) {
-                        printf("port %d >= %d, reset to 0\n", port, MIDI_PORTS);
-                        port = 0;
-                        }
-                  }
-            if (lastchannel != -1) {
-                  channel = lastchannel;
-                  if (channel >= MIDI_CHANNELS) {
-                        printf("channel %d >= %d, reset to 0\n", port, MIDI_CHANNELS);
-                        channel = 0;
-                        }
+            int rv = readEvent(&event);
+            if (first || lastport != -1 || lastchannel != -1 || lastMtype != MT_UNKNOWN
+               || !lastInstrName.isEmpty() || !lastDeviceName.isEmpty()) {
+                  MidiFilePortChange c;
+                  c.index      = events.size();
+                  c.port       = lastport;
+                  c.channel    = lastchannel;
+                  c.mtype      = lastMtype;
+                  c.instrName  = lastInstrName;
+                  c.deviceName = lastDeviceName;
+                  changes.push_back(c);
                   }
-                
-            if(!lastDeviceName.isEmpty())
-            {
-              iMidiFilePort iup = _usedPortMap->begin();
-              for( ; iup != _usedPortMap->end(); ++iup)
-              {
-                if(iup->second._subst4DevName == lastDeviceName)
-                {
-                  port = iup->first;
+            if (rv == 0)
                   break;
-                }
-              }
-              if(iup == _usedPortMap->end())
-              {
-                MidiDevice* md = MusEGlobal::midiDevices.find(lastDeviceName);
-                if(md)
-                {
-                  int pn = md->midiPort();
-                  if(pn != -1)
-                    port = pn;
-                  else
-                  {
-                    for(int i = 0; i < MIDI_PORTS; ++i)
-                    {
-                      iMidiFilePort ip = _usedPortMap->find(i);
-                      MidiPort* mp = &MusEGlobal::midiPorts[i];
-                      if(!mp->device() && (ip == _usedPortMap->end() || ip->second._subst4DevName.isEmpty()))
-                      {
-                        //mp->setMidiDevice(); // No, done in importMidi
-                        //msgSetMidiDevice(
-                        port = i;
+            else if (rv == -1)
+                  continue;
+            else if (rv == -2) {        // error
+                  failed = true;
+                  break;
+                  }
+            events.push_back(event);
+            }
+      if (pos != end)
+            printf("MidiFile::readTrack(): TRACKLEN does not fit, %d bytes left\n", int(end - pos));
+      }
+
+//---------------------------------------------------------
+//   MidiFileTrackParser
+//    Worker thread, parses tracks until none are left.
+//---------------------------------------------------------
+
+class MidiFileTrackParser : public QThread {
+      std::vector<MidiFileTrackReader*>* _readers;
+      QAtomicInt* _next;
+
+   public:
+      MidiFileTrackParser(std::vector<MidiFileTrackReader*>* r, QAtomicInt* next)
+         : _readers(r), _next(next) {}
+      virtual void run() {
+            for (;;) {
+                  const int i = _next->fetchAndAddRelaxed(1);
+                  if (i >= (int)_readers->size())
                         break;
-                      }
-                    }
+                  (*_readers)[i]->parse();
                   }
-                }
-              }
             }
-            
-            iMidiFilePort iup = _usedPortMap->find(port);
-            if(iup == _usedPortMap->end())
-            {
-              MidiFilePort up;
-              if(lastMtype != MT_UNKNOWN)
-                up._midiType = lastMtype;
-              if(!lastInstrName.isEmpty())
-                up._instrName = lastInstrName;
-              if(!lastDeviceName.isEmpty())
-                up._subst4DevName = lastDeviceName;
-              _usedPortMap->insert(std::pair<int, MidiFilePort>(port, up));
+      };
+
+//---------------------------------------------------------
+//   readTracks
+//    Locate n MTrk chunks, parse them, in parallel if the
+//     file is big enough, and collect them in file order.
+//    return true on error
+//---------------------------------------------------------
+
+bool MidiFile::readTracks(int n)
+      {
+      std::vector<MidiFileTrackReader*> readers;
+      int chunkError = MF_NO_ERROR;
+      std::size_t bytes = 0;
+      for (int i = 0; i < n; ++i) {
+            char tmp[4];
+            if (read(tmp, 4)) {
+                  chunkError = _error;
+                  break;
+                  }
+            if (memcmp(tmp, "MTrk", 4)) {
+                  chunkError = MF_MTRK;
+                  break;
+                  }
+            int len = readLong();       // len
+            std::size_t end = curPos;
+            if (len > 0) {
+                  end = std::min((std::size_t)curPos + len, (std::size_t)_data.size());
+                  bytes += end - curPos;
+                  }
+            readers.push_back(new MidiFileTrackReader((const unsigned char*)_data.constData(), curPos, end));
+            curPos = end;
             }
+
+      // Threads only pay off for big files.
+      int nthreads = std::min(QThread::idealThreadCount(), (int)readers.size());
+      if (bytes < MIDIFILE_PARALLEL_BYTES)
+            nthreads = 1;
+      if (nthreads > 1) {
+            QAtomicInt next(0);
+            std::vector<MidiFileTrackParser*> parsers;
+            for (int i = 0; i < nthreads; ++i) {
+                  parsers.push_back(new MidiFileTrackParser(&readers, &next));
+                  parsers.back()->start();
+                  }
+            for (int i = 0; i < nthreads; ++i) {
+                  parsers[i]->wait();
+                  delete parsers[i];
+                  }
+            }
+      else {
+            for (std::size_t i = 0; i < readers.size(); ++i)
+                  readers[i]->parse();
+            }
+
+      bool rv = false;
+      for (std::size_t i = 0; i < readers.size(); ++i) {
+            MidiFileTrackReader* r = readers[i];
+            if (!rv) {
+                  if (readTrack(r->track, r)) {
+                        rv = true;
+                        delete r->track;
+                        }
+                  else
+                        _tracks->push_back(r->track);
+                  }
             else
-            {
-              if(lastMtype != MT_UNKNOWN)
-                iup->second._midiType = lastMtype;
-              if(!lastInstrName.isEmpty())
-                iup->second._instrName = lastInstrName;
-              if(!lastDeviceName.isEmpty())
-                iup->second._subst4DevName = lastDeviceName;
+                  delete r->track;
+            delete r;
             }
-            
-            if (rv == 0)
+      if (!rv && chunkError != MF_NO_ERROR) {
+            _error = chunkError;
+            rv = true;
+            }
+      return rv;
+      }
+
+//---------------------------------------------------------
+//   readTrack
+//    Assign ports and channels to the events parsed by r
+//     and add them to t. Must run in file order, device
+//     names are resolved against ports used by earlier
+//     tracks.
+//    return true on error
+//---------------------------------------------------------
+
+bool MidiFile::readTrack(MidiFileTrack* t, MidiFileTrackReader* r)
+      {
+      if (r->error != MF_NO_ERROR)
+            _error = r->error;
+      // An empty chunk was not parsed.
+      if (r->changes.empty())
+            return false;
+
+      MPEventList* el = &(t->events);
+      int port    = 0;
+      int channel = 0;
+      std::vector<MidiFilePortChange>::const_iterator ic = r->changes.begin();
+      for (std::size_t i = 0; ; ++i) {
+            for ( ; ic != r->changes.end() && ic->index <= i; ++ic)
+                  applyPortChange(*ic, &port, &channel);
+            if (i >= r->events.size())
                   break;
-            else if (rv == -1)
-                  continue;
-            else if (rv == -2)          // error
-                  return true;
 
+            MidiPlayEvent& event = r->events[i];
             event.setPort(port);
             if (event.type() == ME_SYSEX || event.type() == ME_META)
                   event.setChannel(channel);
             else
                   channel = event.channel();
-            el->add(event);
+            // Events of a track come in time order, append.
+            el->insert(el->end(), event);
             }
-      
-      int end = curPos;
-      if (end != endPos) {
-            printf("MidiFile::readTrack(): TRACKLEN does not fit %d+%d != %d, %d too much\n",
-               endPos-len, len, end, endPos-end);
-            if (end < endPos)
-                  skip(endPos - end);
+      return r->failed;
+      }
+
+//---------------------------------------------------------
+//   applyPortChange
+//---------------------------------------------------------
+
+void MidiFile::applyPortChange(const MidiFilePortChange& c, int* portp, int* channelp)
+      {
+      int port = *portp;
+      if (c.port != -1) {
+            port = c.port;
+            if (port >= MIDI_PORTS) {
+                  printf("port %d >= %d, reset to 0\n", port, MIDI_PORTS);
+                  port = 0;
+                  }
             }
-      return false;
+      if (c.channel != -1) {
+            *channelp = c.channel;
+            if (*channelp >= MIDI_CHANNELS) {
+                  printf("channel %d >= %d, reset to 0\n", port, MIDI_CHANNELS);
+                  *channelp = 0;
+                  }
+            }
+          
+      if(!c.deviceName.isEmpty())
+      {
+        iMidiFilePort iup = _usedPortMap->begin();
+        for( ; iup != _usedPortMap->end(); ++iup)
+        {
+          if(iup->second._subst4DevName == c.deviceName)
+          {
+            port = iup->first;
+            break;
+          }
+        }
+        if(iup == _usedPortMap->end())
+        {
+          MidiDevice* md = MusEGlobal::midiDevices.find(c.deviceName);
+          if(md)
+          {
+            int pn = md->midiPort();
+            if(pn != -1)
+              port = pn;
+            else
+            {
+              for(int i = 0; i < MIDI_PORTS; ++i)
+              {
+                iMidiFilePort ip = _usedPortMap->find(i);
+                MidiPort* mp = &MusEGlobal::midiPorts[i];
+                if(!mp->device() && (ip == _usedPortMap->end() || ip->second._subst4DevName.isEmpty()))
+                {
+                  port = i;
+                  break;
+                }
+              }
+            }
+          }
+        }
+      }
+      
+      iMidiFilePort iup = _usedPortMap->find(port);
+      if(iup == _usedPortMap->end())
+      {
+        MidiFilePort up;
+        if(c.mtype != MT_UNKNOWN)
+          up._midiType = c.mtype;
+        if(!c.instrName.isEmpty())
+          up._instrName = c.instrName;
+        if(!c.deviceName.isEmpty())
+          up._subst4DevName = c.deviceName;
+        _usedPortMap->insert(std::pair<int, MidiFilePort>(port, up));
+      }
+      else
+      {
+        if(c.mtype != MT_UNKNOWN)
+          iup->second._midiType = c.mtype;
+        if(!c.instrName.isEmpty())
+          iup->second._instrName = c.instrName;
+        if(!c.deviceName.isEmpty())
+          iup->second._subst4DevName = c.deviceName;
+      }
+      *portp = port;
       }
 
 //---------------------------------------------------------
@@ -385,7 +625,7 @@ bool MidiFile::readTrack(MidiFileTrack* t)
 //          -2    Error
 //---------------------------------------------------------
 
-int MidiFile::readEvent(MidiPlayEvent* event, MidiFileTrack* t)
+int MidiFileTrackReader::readEvent(MidiPlayEvent* event)
       {
       uchar me, type, a, b;
 
@@ -476,7 +716,7 @@ int MidiFile::readEvent(MidiPlayEvent* event, MidiFileTrack* t)
                                           // 5 - DRUM 4
                                           printf("xg set part mode channel %d to %d\n", buffer[4]+1, buffer[6]);
                                           if (buffer[6] != 0)
-                                                t->_isDrumTrack = true;
+                                                track->_isDrumTrack = true;
                                           }
                                     break;
                               case 0x20:
@@ -773,9 +1013,11 @@ bool MidiFile::write()
 bool MidiFile::read()
       {
       _error = MF_NO_ERROR;
-      int i;
       char tmp[4];
 
+      if (fill())
+            return true;
+
       if (read(tmp, 4))
             return true;
       int len = readLong();
@@ -794,36 +1036,13 @@ bool MidiFile::read()
 
       switch (format) {
             case 0:
-                  {
-                  MidiFileTrack* t = new MidiFileTrack;
-                  if (readTrack(t))
-                  {
-                    delete t;
-                    return true;
-                  }
-                  else
-                    _tracks->push_back(t);
-                  }
-                  break;
+                  return readTracks(1);
             case 1:
-                  for (i = 0; i < ntracks; ++i)
-                  {
-                    MidiFileTrack* t = new MidiFileTrack;
-                    if (readTrack(t))
-                    {
-                      delete t;
-                      return true;
-                    }
-                    else
-                      _tracks->push_back(t);
-                  }
-                  break;
+                  return readTracks(ntracks);
             default:
                   _error = MF_FORMAT;
                   return true;
             }
-            
-      return false;
       }
 
 void MidiFileTrackList::clearDelete()
@@ -835,5 +1054,42 @@ void MidiFileTrackList::clearDelete()
   }
   clear();
 }
-      
+
+//---------------------------------------------------------
+//   split
+//    Sort the events by channel and port in one pass.
+//    SYSEX and META events go with the first target.
+//---------------------------------------------------------
+
+void MidiFileTrack::split(MidiFileTrackSplit* split) const
+      {
+      MPEventList* first_events = 0;
+      std::vector<MidiPlayEvent> sysex_meta;   // Those before the first channel event.
+      for (ciMPEvent ev = events.begin(); ev != events.end(); ++ev)
+      {
+        if (ev->type() == ME_SYSEX || ev->type() == ME_META)
+        {
+          if (first_events)
+            first_events->insert(first_events->end(), *ev);
+          else
+            sysex_meta.push_back(*ev);
+          continue;
+        }
+        const MidiFileTarget key(ev->channel(), ev->port());
+        std::map<MidiFileTarget, MPEventList>::iterator it = split->events.find(key);
+        if (it == split->events.end())
+        {
+          it = split->events.insert(std::pair<MidiFileTarget, MPEventList>(key, MPEventList())).first;
+          split->targets.push_back(key);
+          if (!first_events)
+          {
+            first_events = &it->second;
+            for (std::vector<MidiPlayEvent>::const_iterator i = sysex_meta.begin(); i != sysex_meta.end(); ++i)
+              first_events->insert(first_events->end(), *i);
+          }
+        }
+        it->second.insert(it->second.end(), *ev);
+      }
+      }
+
 } // namespace MusECore
@@ -26,9 +26,13 @@
 #define __MIDIFILE_H__
 
 #include <QString>
+#include <QByteArray>
 
 #include <stdio.h>
 #include <list>
+#include <map>
+#include <utility>
+#include <vector>
 
 #include "globaldefs.h"
 #include "mpevent.h"
@@ -38,6 +42,8 @@ namespace MusECore {
 struct MPEventList;
 class MidiPlayEvent;
 class MidiInstrument;
+struct MidiFileTrackReader;
+struct MidiFilePortChange;
 
 //---------------------------------------------------------
 //   MidiFileTrack
@@ -63,12 +69,26 @@ typedef MidiFilePortMap::const_iterator ciMidiFilePort;
 //   MidiFileTrack
 //---------------------------------------------------------
 
+//---------------------------------------------------------
+//   MidiFileTrackSplit
+//    events of a MidiFileTrack sorted by the channel and port
+//    they play on, one list per track they are imported into
+//---------------------------------------------------------
+
+typedef std::pair<int, int> MidiFileTarget;   // channel, port
+
+struct MidiFileTrackSplit {
+      std::vector<MidiFileTarget> targets;            // in order of appearance
+      std::map<MidiFileTarget, MPEventList> events;
+      };
+
 struct MidiFileTrack {
       MPEventList events;
       bool _isDrumTrack;
       MidiFileTrack() {
             _isDrumTrack = false;
             }
+      void split(MidiFileTrackSplit*) const;
       };
 
 class MidiFileTrackList : public std::list<MidiFileTrack*>
@@ -91,18 +111,14 @@ class MidiFile {
       //MType _mtype;
       MidiFileTrackList* _tracks;
 
-      int status, click;
-      int sstatus;
-      int lastport, lastchannel;
-      MType lastMtype;
-      //QString lastMtypeInstrument;
-      QString lastInstrName;
-      QString lastDeviceName;
+      int status;       // running status when writing
       //MidiInstrument* def_instr;
       MidiFilePortMap* _usedPortMap;
       FILE* fp;
-      int curPos;
+      QByteArray _data; // whole file when reading
+      size_t curPos;
 
+      bool fill();
       bool read(void*, size_t);
       bool write(const void*, size_t);
       void put(unsigned char c) { write(&c, 1); }
@@ -111,13 +127,13 @@ class MidiFile {
       bool writeShort(int);
       int readLong();
       bool writeLong(int);
-      int getvl();
       void putvl(unsigned);
 
-      bool readTrack(MidiFileTrack*);
+      bool readTracks(int n);
+      bool readTrack(MidiFileTrack*, MidiFileTrackReader*);
+      void applyPortChange(const MidiFilePortChange&, int* port, int* channel);
       bool writeTrack(const MidiFileTrack*);
 
-      int readEvent(MidiPlayEvent*, MidiFileTrack*);
       void writeEvent(const MidiPlayEvent*);
 
    public:
@@ -535,6 +535,7 @@ void MidiSeq::processTimerTick()
       for (iMidiDevice id = MusEGlobal::midiDevices.begin(); id != MusEGlobal::midiDevices.end(); ++id)
             if((*id)->deviceType() == MidiDevice::ALSA_MIDI)
               (*id)->processMidi();
+      alsaDrainOutput();
       }
 
 //---------------------------------------------------------
@@ -848,9 +848,12 @@ void AudioMixerApp::songChanged(MusECore::SongChangedFlags_t flags)
   if (action != UPDATE_ALL)
   {
 
+    // Only strips whose track the changes are about.
+    const MusECore::SongChangeJournal& changes = MusEGlobal::song->songChanges();
     StripList::iterator si = stripList.begin();
     for (; si != stripList.end(); ++si) {
-          (*si)->songChanged(flags);
+          if (changes.touches(flags, (*si)->getTrack()))
+                (*si)->songChanged(flags);
           }
   }
 }
@@ -61,6 +61,7 @@
 //#include "route.h"
 #include "doublelabel.h"
 #include "rack.h"
+#include "plugin.h"
 #include "node.h"
 #include "amixer.h"
 #include "icons.h"
@@ -119,6 +120,11 @@ QSize AudioStrip::sizeHint () const
 
 void AudioStrip::heartBeat()
 {
+   // Nothing to show while hidden or scrolled out of view. The next
+   //  beat after the strip shows again brings everything up to date.
+   if(!isVisible() || visibleRegion().isEmpty())
+     return;
+
 // REMOVE Tim. Trackinfo. Removed.
 //    double clipperVal = 0.0f;
    const int tch = track->channels();
@@ -142,12 +148,51 @@ void AudioStrip::heartBeat()
 //    _clipperLabel->setVal(clipperVal);
    updateVolume();
    updatePan();
+   updateDspLoad();
 
 // REMOVE Tim. Trackinfo. Removed.
 //    _clipperLabel->setClipper(track->isClipped());
 
 }
 
+//---------------------------------------------------------
+//   updateDspLoad
+//    Show the processing load of the track, its data source
+//     and its effect rack in the last audio period.
+//---------------------------------------------------------
+
+void AudioStrip::updateDspLoad()
+{
+   MusECore::AudioTrack* t = static_cast<MusECore::AudioTrack*>(track);
+   const MusECore::DspLoadProfiler& prof = MusEGlobal::dspLoadProfiler;
+
+   const double track_load  = prof.lastLoad(t->trackLoad());
+   const double source_load = prof.lastLoad(t->sourceLoad());
+   double rack_load = 0.0;
+   double peak = prof.peakLoad(t->trackLoad()) + prof.peakLoad(t->sourceLoad());
+   MusECore::Pipeline* pipe = t->efxPipe();
+   if(pipe)
+   {
+      for(MusECore::ciPluginI ip = pipe->begin(); ip != pipe->end(); ++ip)
+      {
+         if(*ip)
+         {
+            rack_load += prof.lastLoad((*ip)->dspLoad());
+            peak      += prof.peakLoad((*ip)->dspLoad());
+         }
+      }
+   }
+
+   const double load = track_load + source_load + rack_load;
+   _dspLoadLabel->setText(tr("DSP %1%").arg(load, 0, 'f', 1));
+   // The worst cases of the parts may come from different periods.
+   _dspLoadLabel->setToolTip(tr("DSP load in the last period\nTrack: %1%\nSource: %2%\nEffect rack: %3%\nSum of worst cases: %4%")
+                             .arg(track_load, 0, 'f', 1)
+                             .arg(source_load, 0, 'f', 1)
+                             .arg(rack_load, 0, 'f', 1)
+                             .arg(peak, 0, 'f', 1));
+}
+
 // REMOVE Tim. Trackinfo. Changed.      
 // //---------------------------------------------------------
 // //   configChanged
@@ -1574,6 +1619,11 @@ AudioStrip::AudioStrip(QWidget* parent, MusECore::AudioTrack* at, bool hasHandle
       rack->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Minimum);
       grid->addWidget(rack, _curGridRow++, 0, 1, 2);
 
+      _dspLoadLabel = new QLabel(this);
+      _dspLoadLabel->setAlignment(Qt::AlignCenter);
+      _dspLoadLabel->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Minimum);
+      grid->addWidget(_dspLoadLabel, _curGridRow++, 0, 1, 2);
+
       //---------------------------------------------------
       //    mono/stereo  pre/post
       //---------------------------------------------------
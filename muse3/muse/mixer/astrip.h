@@ -96,6 +96,7 @@ class AudioStrip : public Strip {
 //       ClipperLabel *_clipperLabel;
       ClipperLabel* _clipperLabel[MAX_CHANNELS];
       QHBoxLayout* _clipperLayout;
+      QLabel* _dspLoadLabel;
 
       //QToolButton* iR;
       //QToolButton* oR;
@@ -109,6 +110,7 @@ class AudioStrip : public Strip {
       CompactSlider* addController(ControllerType, int, const QString& label);
       
       void updateOffState();
+      void updateDspLoad();
       void updateVolume();
       void updatePan();
       void updateChannels();
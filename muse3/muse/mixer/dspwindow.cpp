@@ -0,0 +1,194 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  dspwindow.cpp
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#include <QCloseEvent>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QTimer>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+#include "dspwindow.h"
+#include "globals.h"
+#include "song.h"
+#include "track.h"
+#include "plugin.h"
+#include "dspload.h"
+
+namespace MusEGui {
+
+//---------------------------------------------------------
+//   DspLoadWindow
+//---------------------------------------------------------
+
+DspLoadWindow::DspLoadWindow(QWidget* parent)
+   : QWidget(parent, Qt::Window)
+      {
+      setWindowTitle(tr("MusE: DSP Load"));
+
+      _list = new QTreeWidget(this);
+      _list->setColumnCount(7);
+      QStringList cols;
+      cols << tr("Name") << tr("Type") << tr("Track") << tr("Load %") << tr("Worst %")
+           << tr("Slices") << tr("Bookkeeping %");
+      _list->setHeaderLabels(cols);
+      _list->headerItem()->setToolTip(COL_PEAK, tr("Worst single period since the last reset. For a track, the worst periods "
+                                                    "of the track itself and of its source added up, they may differ."));
+      _list->headerItem()->setToolTip(COL_SLICES, tr("Plugin runs in the last period. Automation and control changes split a period."));
+      _list->headerItem()->setToolTip(COL_BOOKKEEP, tr("Plugin time spent outside its runs, sampled every few periods"));
+      _list->setRootIsDecorated(false);
+      _list->setAllColumnsShowFocus(true);
+      _list->setSortingEnabled(true);
+      _list->sortByColumn(COL_LOAD, Qt::DescendingOrder);
+      _list->header()->setStretchLastSection(false);
+      _list->header()->setSectionResizeMode(COL_NAME, QHeaderView::Stretch);
+
+      QPushButton* resetButton = new QPushButton(tr("Reset worst case"), this);
+      resetButton->setToolTip(tr("Forget the worst case periods seen so far"));
+      connect(resetButton, SIGNAL(clicked()), SLOT(resetPeaks()));
+
+      QHBoxLayout* buttons = new QHBoxLayout;
+      buttons->addStretch();
+      buttons->addWidget(resetButton);
+
+      QVBoxLayout* layout = new QVBoxLayout;
+      layout->addWidget(_list);
+      layout->addLayout(buttons);
+      setLayout(layout);
+
+      _timer = new QTimer(this);
+      connect(_timer, SIGNAL(timeout()), SLOT(refresh()));
+      _timer->start(500);
+
+      resize(680, 360);
+      refresh();
+      }
+
+//---------------------------------------------------------
+//   closeEvent
+//---------------------------------------------------------
+
+void DspLoadWindow::closeEvent(QCloseEvent* ev)
+      {
+      emit closed();
+      QWidget::closeEvent(ev);
+      }
+
+//---------------------------------------------------------
+//   updateRow
+//    Update the row of a track or plugin in place, so that
+//     the selection and scroll position stay. Rows still
+//     in stale are reused, new ones are created.
+//---------------------------------------------------------
+
+void DspLoadWindow::updateRow(ItemMap& stale, const void* key, const QString& name, const QString& type,
+                              const QString& track, double load, double peak,
+                              const MusECore::PluginIApplyStats* stats)
+      {
+      QTreeWidgetItem* item = stale.take(key);
+      if(!item)
+            item = new QTreeWidgetItem(_list);
+      _items.insert(key, item);
+      item->setText(COL_NAME, name);
+      item->setText(COL_TYPE, type);
+      item->setText(COL_TRACK, track);
+      // Numbers, not strings, so that the columns sort numerically.
+      item->setData(COL_LOAD, Qt::DisplayRole, qRound(load * 10.0) / 10.0);
+      item->setData(COL_PEAK, Qt::DisplayRole, qRound(peak * 10.0) / 10.0);
+      item->setTextAlignment(COL_LOAD, Qt::AlignRight);
+      item->setTextAlignment(COL_PEAK, Qt::AlignRight);
+      if(!stats)
+      {
+            // A track may get the address of a deleted plugin.
+            item->setData(COL_SLICES, Qt::DisplayRole, QVariant());
+            item->setData(COL_BOOKKEEP, Qt::DisplayRole, QVariant());
+            item->setToolTip(COL_SLICES, QString());
+            item->setToolTip(COL_BOOKKEEP, QString());
+            return;
+      }
+      const MusECore::DspLoadProfiler& prof = MusEGlobal::dspLoadProfiler;
+      item->setData(COL_SLICES, Qt::DisplayRole, (qulonglong)stats->slices);
+      item->setData(COL_BOOKKEEP, Qt::DisplayRole, qRound(prof.load(stats->bookkeepTime) * 100.0) / 100.0);
+      item->setToolTip(COL_SLICES, tr("Most: %1").arg(stats->maxSlices));
+      item->setToolTip(COL_BOOKKEEP, tr("Worst: %1 %").arg(prof.load(stats->maxBookkeepTime), 0, 'f', 2));
+      item->setTextAlignment(COL_SLICES, Qt::AlignRight);
+      item->setTextAlignment(COL_BOOKKEEP, Qt::AlignRight);
+      }
+
+//---------------------------------------------------------
+//   refresh
+//---------------------------------------------------------
+
+void DspLoadWindow::refresh()
+      {
+      if(!isVisible())
+            return;
+
+      const MusECore::DspLoadProfiler& prof = MusEGlobal::dspLoadProfiler;
+
+      _list->setUpdatesEnabled(false);
+      ItemMap stale = _items;
+      _items.clear();
+      MusECore::TrackList* tl = MusEGlobal::song->tracks();
+      for(MusECore::ciTrack it = tl->begin(); it != tl->end(); ++it)
+      {
+            if((*it)->isMidiTrack())
+                  continue;
+            MusECore::AudioTrack* t = static_cast<MusECore::AudioTrack*>(*it);
+            const QString type = t->type() == MusECore::Track::AUDIO_SOFTSYNTH ? tr("Synth") : tr("Track");
+            updateRow(stale, t, t->name(), type, t->name(),
+                      prof.lastLoad(t->trackLoad()) + prof.lastLoad(t->sourceLoad()),
+                      prof.peakLoad(t->trackLoad()) + prof.peakLoad(t->sourceLoad()));
+
+            MusECore::Pipeline* pipe = t->efxPipe();
+            if(!pipe)
+                  continue;
+            for(MusECore::ciPluginI ip = pipe->begin(); ip != pipe->end(); ++ip)
+            {
+                  if(!*ip)
+                        continue;
+                  updateRow(stale, *ip, (*ip)->name(), tr("Plugin"), t->name(),
+                            prof.lastLoad((*ip)->dspLoad()), prof.peakLoad((*ip)->dspLoad()), &(*ip)->applyStats());
+            }
+      }
+      // Rows of removed tracks and plugins.
+      qDeleteAll(stale);
+      _list->setUpdatesEnabled(true);
+      }
+
+//---------------------------------------------------------
+//   resetPeaks
+//---------------------------------------------------------
+
+void DspLoadWindow::resetPeaks()
+      {
+      MusECore::TrackList* tl = MusEGlobal::song->tracks();
+      for(MusECore::ciTrack it = tl->begin(); it != tl->end(); ++it)
+      {
+            if(!(*it)->isMidiTrack())
+                  static_cast<MusECore::AudioTrack*>(*it)->resetDspLoadPeaks();
+      }
+      refresh();
+      }
+
+} // namespace MusEGui
@@ -0,0 +1,79 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  dspwindow.h
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#ifndef __DSPWINDOW_H__
+#define __DSPWINDOW_H__
+
+#include <QHash>
+#include <QWidget>
+
+class QCloseEvent;
+class QTimer;
+class QTreeWidget;
+class QTreeWidgetItem;
+
+namespace MusECore {
+struct PluginIApplyStats;
+}
+
+namespace MusEGui {
+
+//---------------------------------------------------------
+//   DspLoadWindow
+//    Sortable list of the tracks, synths and rack plugins
+//     using the most processing time. For plugins it also
+//     shows how many runs apply() split the last period
+//     into, and the time spent around those runs.
+//---------------------------------------------------------
+
+class DspLoadWindow : public QWidget {
+      Q_OBJECT
+
+      enum Columns { COL_NAME = 0, COL_TYPE, COL_TRACK, COL_LOAD, COL_PEAK, COL_SLICES, COL_BOOKKEEP };
+
+      typedef QHash<const void*, QTreeWidgetItem*> ItemMap;
+
+      QTreeWidget* _list;
+      QTimer* _timer;
+      ItemMap _items;   // Rows by the track or plugin they show.
+
+      void updateRow(ItemMap& stale, const void* key, const QString& name, const QString& type,
+                     const QString& track, double load, double peak,
+                     const MusECore::PluginIApplyStats* stats = 0);
+
+   protected:
+      virtual void closeEvent(QCloseEvent*);
+
+   private slots:
+      void refresh();
+      void resetPeaks();
+
+   signals:
+      void closed();
+
+   public:
+      DspLoadWindow(QWidget* parent);
+      };
+
+} // namespace MusEGui
+
+#endif
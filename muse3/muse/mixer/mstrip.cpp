@@ -1693,26 +1693,31 @@ void MidiStrip::offToggled(bool val)
 
 void MidiStrip::heartBeat()
       {
-      inHeartBeat = true;
-      
-      // Try to avoid calling MidiInstrument::getPatchName too often.
-      if(++_heartBeatCounter >= 10)
-        _heartBeatCounter = 0;
-      
       int act = track->activity();
       double dact = double(act) * (slider->value() / 127.0);
       
       if((int)dact > track->lastActivity())
         track->setLastActivity((int)dact);
       
-      if(meter[0]) 
-        //meter[0]->setVal(int(double(act) * (slider->value() / 127.0)), 0, false);  
-        meter[0]->setVal(dact, track->lastActivity(), false);  
-      
       // Gives reasonable decay with gui update set to 20/sec.
+      // Keep decaying while hidden, the track's activity is not only shown here.
       if(act)
         track->setActivity((int)((double)act * 0.8));
       
+      // Nothing to show while hidden or scrolled out of view.
+      if(!isVisible() || visibleRegion().isEmpty())
+        return;
+      
+      inHeartBeat = true;
+      
+      // Try to avoid calling MidiInstrument::getPatchName too often.
+      if(++_heartBeatCounter >= 10)
+        _heartBeatCounter = 0;
+      
+      if(meter[0]) 
+        //meter[0]->setVal(int(double(act) * (slider->value() / 127.0)), 0, false);  
+        meter[0]->setVal(dact, track->lastActivity(), false);  
+      
       Strip::heartBeat();
       updateControls();
             
@@ -2473,7 +2478,7 @@ void MidiStrip::ctrlChanged(double v, bool off, int num)
         MusECore::MidiPlayEvent ev(tick, port, chan, MusECore::ME_CONTROLLER, num, val);
         MusEGlobal::audio->msgPlayMidiEvent(&ev);
       }  
-      MusEGlobal::song->update(SC_MIDI_CONTROLLER);
+      MusEGlobal::song->scheduleUpdate(SC_MIDI_CONTROLLER, track, num);
     }
 
 void MidiStrip::propertyChanged(double v, bool /*off*/, int num)
@@ -1764,6 +1764,10 @@ void AudioTrack::copyData(unsigned pos, int dstStartChan, int dstChannels, int s
   {
     // First time here during this process cycle. 
     
+    // Charge the work done from here on to this track. Input tracks pulled
+    //  by getData and the plugins in the rack are charged to themselves.
+    DspLoadScope dsp_scope(&MusEGlobal::dspLoadProfiler, &_trackLoad);
+
     _haveData = false;  // Reset.
     _processed = true;  // Set this now.
 
@@ -88,6 +88,7 @@ int PendingOperationItem::getIndex() const
     case PendingOperationItem::ModifySongLength:
     case PendingOperationItem::AddMidiCtrlValList:
     case PendingOperationItem::ModifyAudioCtrlValList:
+    case PendingOperationItem::ModifyEventList:
     case PendingOperationItem::SetGlobalTempo:
     case PendingOperationItem::AddRoute:
     case PendingOperationItem::DeleteRoute:
@@ -819,6 +820,16 @@ SongChangedFlags_t PendingOperationItem::executeRTStage()
       flags |= SC_EVENT_REMOVED;
     break;
     
+    case ModifyEventList:
+#ifdef _PENDING_OPS_DEBUG_
+      fprintf(stderr, "PendingOperationItem::executeRTStage ModifyEventList: part:%p old size:%zd new size:%zd\n", 
+              _part, _part->events().size(), _event_list->size());
+#endif      
+      // Constant time. The original events are left in _event_list for deletion in the non-RT stage.
+      _part->nonconst_events().swap(*_event_list);
+      flags |= SC_EVENT_INSERTED | SC_EVENT_REMOVED | SC_EVENT_MODIFIED;
+    break;
+    
     
     case AddMidiCtrlValList:
 #ifdef _PENDING_OPS_DEBUG_
@@ -1072,6 +1083,12 @@ SongChangedFlags_t PendingOperationItem::executeNonRTStage()
         delete _aud_ctrl_list;
     break;
     
+    case ModifyEventList:
+      // At this point _event_list holds the original events that were replaced. Delete it now.
+      if(_event_list)
+        delete _event_list;
+    break;
+    
     default:
     break;
   }
@@ -1975,5 +1992,178 @@ iPendingOperation PendingOperationList::findAllocationOp(const PendingOperationI
 }
 
 
+//---------------------------------------------------------
+//   add
+//---------------------------------------------------------
+
+void EventChangeLog::add(const PendingOperationList& ops)
+{
+  for(PendingOperationList::const_iterator ip = ops.begin(); ip != ops.end(); ++ip)
+  {
+    switch(ip->_type)
+    {
+      case PendingOperationItem::AddEvent:
+        push_back(EventChange(EventChange::Added, ip->_part, ip->_ev));
+      break;
+      case PendingOperationItem::DeleteEvent:
+        push_back(EventChange(EventChange::Removed, ip->_part, ip->_ev));
+      break;
+      case PendingOperationItem::ModifyEventList:
+        push_back(EventChange(EventChange::ListReplaced, ip->_part));
+      break;
+      default:
+      break;
+    }
+  }
+}
+
+//---------------------------------------------------------
+//   SongChangeJournal
+//---------------------------------------------------------
+
+void SongChangeJournal::add(const SongChange& c)
+{
+  push_back(c);
+  _flags |= c.flags;
+}
+
+void SongChangeJournal::add(const PendingOperationList& ops)
+{
+  for(PendingOperationList::const_iterator ip = ops.begin(); ip != ops.end(); ++ip)
+  {
+    switch(ip->_type)
+    {
+      case PendingOperationItem::ModifyTrackName:
+        add(SongChange(SC_TRACK_MODIFIED, ip->_track));
+      break;
+      case PendingOperationItem::SetTrackRecord:
+        add(SongChange(SC_RECFLAG, ip->_track));
+      break;
+      case PendingOperationItem::SetTrackMute:
+        add(SongChange(SC_MUTE, ip->_track));
+      break;
+      case PendingOperationItem::SetTrackSolo:
+        add(SongChange(SC_SOLO, ip->_track));
+      break;
+
+      case PendingOperationItem::AddPart:
+        add(SongChange(SC_PART_INSERTED, ip->_part->track(), ip->_part));
+      break;
+      case PendingOperationItem::DeletePart:
+        add(SongChange(SC_PART_REMOVED, ip->_iPart->second->track(), ip->_iPart->second));
+      break;
+      case PendingOperationItem::MovePart:
+        add(SongChange(SC_PART_MODIFIED | SC_PART_REMOVED, ip->_part->track(), ip->_part));
+        if(ip->_track && ip->_track != ip->_part->track())
+          add(SongChange(SC_PART_MODIFIED | SC_PART_INSERTED, ip->_track, ip->_part));
+      break;
+      case PendingOperationItem::ModifyPartLength:
+      case PendingOperationItem::ModifyPartName:
+        add(SongChange(SC_PART_MODIFIED, ip->_part->track(), ip->_part));
+      break;
+
+      case PendingOperationItem::AddEvent:
+      case PendingOperationItem::DeleteEvent:
+      {
+        const unsigned pos = ip->_part->posValue() + ip->_ev.posValue();
+        add(SongChange(ip->_type == PendingOperationItem::AddEvent ? SC_EVENT_INSERTED : SC_EVENT_REMOVED,
+                       ip->_part->track(), ip->_part, -1, pos, pos + ip->_ev.lenValue()));
+      }
+      break;
+      case PendingOperationItem::ModifyEventList:
+        add(SongChange(SC_EVENT_INSERTED | SC_EVENT_REMOVED | SC_EVENT_MODIFIED, ip->_part->track(), ip->_part));
+      break;
+
+      case PendingOperationItem::AddMidiCtrlVal:
+        add(SongChange(SC_MIDI_CONTROLLER, ip->_part ? ip->_part->track() : 0, ip->_part,
+                       ip->_mcvl->num(), ip->_intA, ip->_intA));
+      break;
+      case PendingOperationItem::DeleteMidiCtrlVal:
+      case PendingOperationItem::ModifyMidiCtrlVal:
+      {
+        const Part* part = ip->_imcv->second.part;
+        add(SongChange(SC_MIDI_CONTROLLER, part ? part->track() : 0, part,
+                       ip->_mcvl->num(), ip->_imcv->first, ip->_imcv->first));
+      }
+      break;
+      case PendingOperationItem::AddMidiCtrlValList:
+        add(SongChange(SC_MIDI_CONTROLLER_ADD, 0, 0, ip->_intB));
+      break;
+
+      // Controller lists don't know their track. Any track, but only this controller.
+      case PendingOperationItem::AddAudioCtrlVal:
+        add(SongChange(SC_AUDIO_CONTROLLER, 0, 0, ip->_aud_ctrl_list->id(), ip->_frame, ip->_frame));
+      break;
+      case PendingOperationItem::DeleteAudioCtrlVal:
+      case PendingOperationItem::ModifyAudioCtrlVal:
+        add(SongChange(SC_AUDIO_CONTROLLER, 0, 0, ip->_aud_ctrl_list->id(), ip->_iCtrl->first, ip->_iCtrl->first));
+      break;
+      case PendingOperationItem::ModifyAudioCtrlValList:
+        add(SongChange(SC_AUDIO_CONTROLLER_LIST, 0, 0, ip->_iCtrlList->first));
+      break;
+
+      case PendingOperationItem::AddTempo:
+      case PendingOperationItem::DeleteTempo:
+      case PendingOperationItem::ModifyTempo:
+      case PendingOperationItem::SetGlobalTempo:
+        add(SongChange(SC_TEMPO));
+      break;
+      case PendingOperationItem::AddSig:
+      case PendingOperationItem::DeleteSig:
+      case PendingOperationItem::ModifySig:
+        add(SongChange(SC_SIG));
+      break;
+      case PendingOperationItem::AddKey:
+      case PendingOperationItem::DeleteKey:
+      case PendingOperationItem::ModifyKey:
+        add(SongChange(SC_KEY));
+      break;
+
+      case PendingOperationItem::Uninitialized:
+      break;
+
+      // Tracks, routes, devices, song length etc. may affect anything.
+      default:
+        add(SongChange(SC_EVERYTHING));
+      break;
+    }
+  }
+}
+
+void SongChangeJournal::cover(SongChangedFlags_t flags)
+{
+  if(flags & ~_flags)
+    add(SongChange(flags & ~_flags));
+}
+
+bool SongChangeJournal::touches(SongChangedFlags_t mask, const Track* track, const Part* part,
+                                int ctrl, unsigned from, unsigned to) const
+{
+  for(ciSongChange ic = begin(); ic != end(); ++ic)
+  {
+    if(!(ic->flags & mask))
+      continue;
+    if(track && ic->track && ic->track != track)
+      continue;
+    if(ctrl != -1 && ic->ctrl != -1 && ic->ctrl != ctrl)
+      continue;
+    if(ic->to < from || ic->from > to)
+      continue;
+    if(!part || !ic->part)
+      return true;
+    // Clones share their events. Only the given part is dereferenced,
+    //  the journal's part may be gone by now.
+    const Part* p = part;
+    do
+    {
+      if(p == ic->part)
+        return true;
+      p = p->nextClone();
+    }
+    while(p != part);
+  }
+  return false;
+}
+
 } // namespace MusECore
   
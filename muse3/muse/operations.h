@@ -25,6 +25,8 @@
 
 #include <list> 
 #include <map> 
+#include <vector> 
+#include <climits>
 
 #include "type_defs.h"
 #include "event.h"
@@ -54,7 +56,7 @@ struct PendingOperationItem
                               AddTrack,          DeleteTrack, MoveTrack,                    ModifyTrackName,
                               SetTrackRecord,    SetTrackMute, SetTrackSolo,
                               AddPart,           DeletePart,  MovePart, ModifyPartLength,   ModifyPartName,
-                              AddEvent,          DeleteEvent,
+                              AddEvent,          DeleteEvent,           ModifyEventList,
                               AddMidiCtrlVal,    DeleteMidiCtrlVal,     ModifyMidiCtrlVal,  AddMidiCtrlValList,
                               AddAudioCtrlVal,   DeleteAudioCtrlVal,    ModifyAudioCtrlVal, ModifyAudioCtrlValList,
                               AddTempo,          DeleteTempo,           ModifyTempo,        SetGlobalTempo, 
@@ -86,6 +88,7 @@ struct PendingOperationItem
     MidiDeviceList* _midi_device_list;
     MidiInstrumentList* _midi_instrument_list;
     AuxSendValueList* _aux_send_value_list;
+    EventList* _event_list;
     RouteList* _route_list;       
   };
             
@@ -223,6 +226,11 @@ struct PendingOperationItem
   PendingOperationItem(Part* part, const iEvent& iev, PendingOperationType type = DeleteEvent)
     { _type = type; _part = part; _iev = iev; _ev = iev->second; }
 
+  // NOTE: el is the complete new event list of the part. It is swapped with the part's list in RT stage 2,
+  //        then holds the old events until it is deleted in non-RT stage 3.
+  PendingOperationItem(Part* part, EventList* el, PendingOperationType type = ModifyEventList)
+    { _type = type; _part = part; _event_list = el; }
+
 
   PendingOperationItem(MidiCtrlValListList* mcvll, MidiCtrlValList* mcvl, int channel, int control_num, PendingOperationType type = AddMidiCtrlValList)
     { _type = type; _mcvll = mcvll; _mcvl = mcvl; _intA = channel; _intB = control_num; }
@@ -343,6 +351,70 @@ typedef std::multimap<int, iPendingOperation, std::less<int> >::iterator iPendin
 typedef std::multimap<int, iPendingOperation, std::less<int> >::reverse_iterator riPendingOperationSorted;
 typedef std::pair <iPendingOperationSorted, iPendingOperationSorted> iPendingOperationSortedRange;
 
+//---------------------------------------------------------
+//   EventChangeLog
+//    Events added to or removed from parts, and parts whose
+//     whole event list was swapped, in the order they were
+//     executed. Lets editors patch their items instead of
+//     rebuilding them all.
+//---------------------------------------------------------
+
+struct EventChange {
+      enum Type { Added, Removed, ListReplaced };
+      Type type;
+      const Part* part;
+      Event event;      // Not used by ListReplaced.
+      EventChange(Type t, const Part* p, const Event& e = Event()) : type(t), part(p), event(e) { }
+      };
+
+class EventChangeLog : public std::vector<EventChange> {
+   public:
+      // Append the event changes made by an executed operation list.
+      void add(const PendingOperationList&);
+      };
+
+typedef EventChangeLog::const_iterator ciEventChange;
+
+//---------------------------------------------------------
+//   SongChangeJournal
+//    What a songChanged signal is about: for each change,
+//     the flags it raised and how far it reaches. A null
+//     track or part, ctrl -1 or the full position range
+//     means any. Positions are in the part's time domain
+//     (ticks or frames).
+//---------------------------------------------------------
+
+struct SongChange {
+      SongChangedFlags_t flags;
+      const Track* track;
+      const Part* part;
+      int ctrl;
+      unsigned from, to;
+      SongChange(SongChangedFlags_t f, const Track* t = 0, const Part* p = 0, int c = -1,
+                 unsigned fr = 0, unsigned tt = UINT_MAX)
+        : flags(f), track(t), part(p), ctrl(c), from(fr), to(tt) { }
+      };
+
+class SongChangeJournal : public std::vector<SongChange> {
+      SongChangedFlags_t _flags;
+
+   public:
+      SongChangeJournal() : _flags(0) { }
+      // Append the changes made by an operation list, before it is executed.
+      void add(const PendingOperationList&);
+      void add(const SongChange&);
+      // Add a global change for any of the flags no entry accounts for yet.
+      void cover(SongChangedFlags_t flags);
+      void clear() { std::vector<SongChange>::clear(); _flags = 0; }
+      SongChangedFlags_t flags() const { return _flags; }
+      // Whether any change with one of the mask flags may affect the given
+      //  track, part (or one of its clones), controller and position range.
+      bool touches(SongChangedFlags_t mask, const Track* track = 0, const Part* part = 0,
+                   int ctrl = -1, unsigned from = 0, unsigned to = UINT_MAX) const;
+      };
+
+typedef SongChangeJournal::const_iterator ciSongChange;
+
 } // namespace MusECore
 
 #endif
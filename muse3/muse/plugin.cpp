@@ -1652,6 +1652,7 @@ void Pipeline::apply(unsigned pos, unsigned long ports, unsigned long nframes, f
 
             if(p)
             {
+              DspLoadScope dsp_scope(&MusEGlobal::dspLoadProfiler, p->dspLoadPtr());
               if (p->on())
               {
                 if (p->inPlaceCapable())
@@ -1811,6 +1812,10 @@ void PluginI::init()
       controlsOutDummy  = 0;
       controlPorts      = 0;
       controlOutPorts   = 0;
+      _activeCtrls      = 0;
+      _activeCtrlCount  = 0;
+      _ctrlIsActive     = 0;
+      _ctrlLists        = 0;
       _audioInSilenceBuf = 0;
       _audioOutDummyBuf  = 0;
       //_gui              = 0;
@@ -1853,6 +1858,12 @@ PluginI::~PluginI()
             delete[] controlsOut;
       if (controls)
             delete[] controls;
+      if (_ctrlLists)
+            delete[] _ctrlLists;
+      if (_ctrlIsActive)
+            delete[] _ctrlIsActive;
+      if (_activeCtrls)
+            delete[] _activeCtrls;
       if (handle)
             delete[] handle;
       }
@@ -2149,6 +2160,15 @@ bool PluginI::initPluginInstance(Plugin* plug, int c)
       controls    = new Port[controlPorts];
       controlsOut = new Port[controlOutPorts];
       controlsOutDummy = new Port[controlOutPorts];
+      _activeCtrls  = new unsigned long[controlPorts];
+      _ctrlIsActive = new bool[controlPorts];
+      _ctrlLists    = new CtrlList*[controlPorts];
+      _activeCtrlCount = 0;
+      for(unsigned long k = 0; k < controlPorts; ++k)
+      {
+        _ctrlIsActive[k] = false;
+        _ctrlLists[k] = 0;
+      }
       
       unsigned long curPort = 0;
       unsigned long curOutPort = 0;
@@ -2721,8 +2741,14 @@ QString PluginI::titlePrefix() const
 void PluginI::apply(unsigned pos, unsigned long n, unsigned long ports, float** bufIn, float** bufOut)
 {
   const unsigned long syncFrame = MusEGlobal::audio->curSyncFrame();
+  const unsigned long end_frame = pos + n;
   unsigned long sample = 0;
 
+  // The bookkeeping time is only sampled, see PluginIApplyStats.
+  const bool timed = (_applyStats.periods++ % PLUGINI_STATS_SAMPLE_PERIODS) == 0;
+  const double start_time = timed ? DspLoadProfiler::now() : 0.0;
+  double run_time = 0.0;
+
   // Must make this detectable for dssi vst effects.
   const bool usefixedrate = _plugin->_isDssiVst;
 
@@ -2762,29 +2788,46 @@ void PluginI::apply(unsigned pos, unsigned long n, unsigned long ports, float**
     //  from there, but this section determines where the next highest maximum frame
     //  absolutely needs to be for smooth playback of the controller value stream...
     //
+    // The first slice refreshes every port and collects the ones which can change
+    //  later in this period: interpolating ramps, ramps ending inside the period and
+    //  ports hit by the control FIFO. Only those are revisited in further slices.
+    //
     if(ports != 0)    // Don't bother if not 'running'.
     {
       ciCtrlList icl = icl_first;
-      for(unsigned long k = 0; k < controlPorts; ++k)
+      if(cur_slice == 0)
+        _activeCtrlCount = 0;
+      const unsigned long nctrls = (cur_slice == 0) ? controlPorts : _activeCtrlCount;
+      for(unsigned long ai = 0; ai < nctrls; ++ai)
       {
-        CtrlList* cl = (cll && _id != -1 && icl != cll->end()) ? icl->second : NULL;
+        const unsigned long k = (cur_slice == 0) ? ai : _activeCtrls[ai];
+        CtrlList* cl;
+        if(cur_slice == 0)
+        {
+          // Controller lists are sorted by id. If the IDs don't match just let k catch up with icl.
+          cl = NULL;
+          if(cll && _id != -1 && icl != cll->end() && (unsigned long)icl->second->id() == genACnum(_id, k))
+          {
+            cl = icl->second;
+            ++icl;
+          }
+          _ctrlLists[k] = cl;
+          _ctrlIsActive[k] = false;
+        }
+        else
+          cl = _ctrlLists[k];
+
         CtrlInterpolate& ci = controls[k].interp;
         // Always refresh the interpolate struct at first, since things may have changed.
         // Or if the frame is outside of the interpolate range - and eStop is not true.  // FIXME TODO: Be sure these comparisons are correct.
         if(cur_slice == 0 || (!ci.eStop && MusEGlobal::audio->isPlaying() &&
             (slice_frame < (unsigned long)ci.sFrame || (ci.eFrame != -1 && slice_frame >= (unsigned long)ci.eFrame)) ) )
         {
-          if(cl && _id != -1 && (unsigned long)cl->id() == genACnum(_id, k))
-          {
+          if(cl)
             cl->getInterpolation(slice_frame, no_auto || !controls[k].enCtrl, &ci);
-            if(icl != cll->end())
-              ++icl;
-          }
           else
           {
             // No matching controller, or end. Just copy the current value into the interpolator.
-            // Keep the current icl iterator, because since they are sorted by frames,
-            //  if the IDs didn't match it means we can just let k catch up with icl.
             ci.sFrame   = 0;
             ci.eFrame   = -1;
             ci.sVal     = controls[k].val;
@@ -2804,8 +2847,6 @@ void PluginI::apply(unsigned pos, unsigned long n, unsigned long ports, float**
             ci.doInterp = false;
             ci.eStop    = false;
           }
-          if(cl && cll && icl != cll->end())
-            ++icl;
         }
 
         if(!usefixedrate && MusEGlobal::audio->isPlaying())
@@ -2845,10 +2886,26 @@ void PluginI::apply(unsigned pos, unsigned long n, unsigned long ports, float**
 
         controls[k].tmpVal = controls[k].val;  // Special for plugins: Deal with tmpVal.
 
+        if(cur_slice == 0 && (ci.doInterp || ci.eStop || (ci.eFrame != -1 && (unsigned long)ci.eFrame < end_frame)))
+          markCtrlActive(k);
+
 #ifdef PLUGIN_DEBUGIN_PROCESS
         printf("PluginI::apply k:%lu sample:%lu frame:%lu nextFrame:%d nsamp:%lu \n", k, sample, frame, ci.eFrame, nsamp);
 #endif
       }
+
+      // The untouched ports hold a steady value for the rest of this period.
+      // Each of them would limit the run just like an endless value does, so do that once for all of them.
+      if(cur_slice != 0 && _activeCtrlCount < controlPorts && !usefixedrate && MusEGlobal::audio->isPlaying())
+      {
+        unsigned long samps = nsamp;
+        if(samps > min_per)
+          samps &= ~min_per_mask;
+        else
+          samps = min_per;
+        if(samps < nsamp)
+          nsamp = samps;
+      }
     }
 
 #ifdef PLUGIN_DEBUGIN_PROCESS
@@ -2909,6 +2966,8 @@ void PluginI::apply(unsigned pos, unsigned long n, unsigned long ports, float**
         ci->eFrame = frame;
         ci->eVal   = v.value;
         ci->eStop  = true;
+        // The port must be revisited in the next slice.
+        markCtrlActive(v.idx);
       }
 
       // Need to update the automation value, otherwise it overwrites later with the last automation value.
@@ -2944,8 +3003,11 @@ void PluginI::apply(unsigned pos, unsigned long n, unsigned long ports, float**
       {
         connect(ports, sample, bufIn, bufOut);
 
+        const double run_start = timed ? DspLoadProfiler::now() : 0.0;
         for(int i = 0; i < instances; ++i)
           _plugin->apply(handle[i], nsamp);
+        if(timed)
+          run_time += DspLoadProfiler::now() - run_start;
       }
 
       sample += nsamp;
@@ -2953,6 +3015,16 @@ void PluginI::apply(unsigned pos, unsigned long n, unsigned long ports, float**
 
     ++cur_slice; // Slice is done. Moving on to any next slice now...
   }
+
+  _applyStats.slices = cur_slice;
+  if(_applyStats.slices > _applyStats.maxSlices)
+    _applyStats.maxSlices = _applyStats.slices;
+  if(timed)
+  {
+    _applyStats.bookkeepTime = DspLoadProfiler::now() - start_time - run_time;
+    if(_applyStats.bookkeepTime > _applyStats.maxBookkeepTime)
+      _applyStats.maxBookkeepTime = _applyStats.bookkeepTime;
+  }
 }
 
 //---------------------------------------------------------
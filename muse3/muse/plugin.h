@@ -44,6 +44,7 @@
 #include "globaldefs.h"
 #include "ctrl.h"
 #include "controlfifo.h"
+#include "dspload.h"
 
 #include "config.h"
 
@@ -261,6 +262,28 @@ struct Port {
       CtrlInterpolate interp;
       };
 
+//---------------------------------------------------------
+//   PluginIApplyStats
+//    Bookkeeping figures of PluginI::apply(), written by
+//     the audio thread. Slices are counted in every period.
+//     The bookkeeping time, all of apply() except the
+//     plugin's own run(), is only measured in one period
+//     out of PLUGINI_STATS_SAMPLE_PERIODS.
+//---------------------------------------------------------
+
+#define PLUGINI_STATS_SAMPLE_PERIODS 16
+
+struct PluginIApplyStats {
+      unsigned long periods;        // apply() calls so far.
+      unsigned long slices;         // Run slices in the last period.
+      unsigned long maxSlices;      // Highest slice count since last reset.
+      double bookkeepTime;          // Seconds spent outside run() in the last sampled period.
+      double maxBookkeepTime;       // Highest sampled bookkeeping time since last reset.
+
+      PluginIApplyStats() { periods = slices = 0; bookkeepTime = 0.0; resetPeaks(); }
+      void resetPeaks() { maxSlices = 0; maxBookkeepTime = 0.0; }
+      };
+
 //---------------------------------------------------------
 //   PluginIBase
 //---------------------------------------------------------
@@ -353,6 +376,22 @@ class PluginI : public PluginIBase {
       unsigned long controlPorts;
       unsigned long controlOutPorts;
 
+      // Change tracking for apply(). Only the ports listed in _activeCtrls
+      //  are revisited after the first run slice of a period.
+      unsigned long* _activeCtrls;
+      unsigned long _activeCtrlCount;
+      bool* _ctrlIsActive;
+      CtrlList** _ctrlLists;         // Cached automation list per port, or NULL.
+      PluginIApplyStats _applyStats;
+      DspLoad _dspLoad;
+
+      inline void markCtrlActive(unsigned long k) {
+            if(!_ctrlIsActive[k]) {
+                  _ctrlIsActive[k] = true;
+                  _activeCtrls[_activeCtrlCount++] = k;
+                  }
+            }
+
       float *_audioInSilenceBuf; // Just all zeros all the time, so we don't have to clear for silence.
       float *_audioOutDummyBuf;  // A place to connect unused outputs.
       
@@ -387,6 +426,10 @@ class PluginI : public PluginIBase {
       void setChannels(int);
       void connect(unsigned long ports, unsigned long offset, float** src, float** dst);
       void apply(unsigned pos, unsigned long n, unsigned long ports, float** bufIn, float** bufOut);
+      const PluginIApplyStats& applyStats() const { return _applyStats; }
+      const DspLoad& dspLoad() const              { return _dspLoad; }
+      DspLoad* dspLoadPtr()                       { return &_dspLoad; }
+      void resetDspLoadPeak()                     { _dspLoad.resetPeak(); _applyStats.resetPeaks(); }
 
       void enableController(unsigned long i, bool v = true)   { controls[i].enCtrl = v; }
       bool controllerEnabled(unsigned long i) const           { return controls[i].enCtrl; }
@@ -495,6 +495,8 @@ void Audio::msgExecutePendingOperations(PendingOperationList& operations, bool d
         AudioMsg msg;
         msg.id = SEQM_EXECUTE_PENDING_OPERATIONS;
         msg.pendingOps=&operations;
+        if(doUpdate)
+          MusEGlobal::song->journalChanges(operations);
         sendMsg(&msg);
         operations.executeNonRTStage();
         const SongChangedFlags_t flags = operations.flags() | extraFlags;
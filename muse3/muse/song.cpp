@@ -100,6 +100,10 @@ Song::Song(const char* name)
       bounceTrack = NULL;
       bounceOutput = NULL;
       showSongInfo=true;
+      _eventChangesPublished = false;
+      _songChangedLevel = 0;
+      _songChangedSerial = 0;
+      _scheduledFlags = 0;
       clearDrumMap(); // One-time only early init
       clear(false);
       }
@@ -612,6 +616,74 @@ void Song::deleteEventOperation(const Event& event, Part* part, bool do_port_ctr
   while(p != part);
 }
 
+//---------------------------------------------------------
+//   modifyEventListOperation
+//    Removes the events in eraseEvents and adds the ones in
+//     addEvents, in part and all its clones. The new event
+//     lists are built here, the realtime stage only swaps
+//     them in.
+//---------------------------------------------------------
+
+void Song::modifyEventListOperation(const EventList* eraseEvents, const EventList* addEvents, Part* part, bool do_port_ctrls, bool do_clone_port_ctrls)
+{
+  Part* p = part;
+  do
+  {
+    // Keep building on a list already scheduled for this part, if any.
+    EventList* new_list = 0;
+    for(iPendingOperation ip = pendingOperations.begin(); ip != pendingOperations.end(); ++ip)
+    {
+      if(ip->_type == PendingOperationItem::ModifyEventList && ip->_part == p)
+      {
+        new_list = ip->_event_list;
+        break;
+      }
+    }
+    const bool is_new = (new_list == 0);
+    if(is_new)
+      new_list = new EventList(p->events());
+    
+    const bool do_ctrls = do_port_ctrls && (do_clone_port_ctrls || (!do_clone_port_ctrls && p == part));
+    
+    if(eraseEvents)
+    {
+      for(ciEvent ie = eraseEvents->begin(); ie != eraseEvents->end(); ++ie)
+      {
+        iEvent ine = new_list->findWithId(ie->second);
+        if(ine == new_list->end())
+          continue;
+        if(do_ctrls)
+          removePortCtrlEvents(ine->second, p, p->track(), pendingOperations);  // Port controller values.
+        new_list->erase(ine);
+      }
+    }
+    
+    if(addEvents)
+    {
+      for(ciEvent ie = addEvents->begin(); ie != addEvents->end(); ++ie)
+      {
+        // Clone parts get their own copy with the same id, as in addEventOperation.
+        Event ev = (p == part) ? ie->second : ie->second.clone();
+        if(new_list->findWithId(ev) != new_list->end())
+          continue;
+        SndFileR f = ev.sndFile();
+        // Ensure that wave event sndfile file handle is opened.
+        if(!f.isNull() && !f.isOpen())
+          f.openRead();
+        new_list->add(ev);
+        if(do_ctrls)
+          addPortCtrlEvents(ev, p, p->tick(), p->lenTick(), p->track(), pendingOperations);  // Port controller values.
+      }
+    }
+    
+    if(is_new)
+      pendingOperations.add(PendingOperationItem(p, new_list, PendingOperationItem::ModifyEventList));
+    
+    p = p->nextClone();
+  }
+  while(p != part);
+}
+
 //---------------------------------------------------------
 //   selectEvent
 //---------------------------------------------------------
@@ -1124,7 +1196,7 @@ void Song::setMasterFlag(bool val)
       _masterFlag = val;
       if (MusEGlobal::tempomap.setMasterFlag(cpos(), val))
       {
-        emit songChanged(SC_MASTER);
+        emitSongChanged(SC_MASTER);
       }      
     }
 
@@ -1320,10 +1392,45 @@ void Song::update(MusECore::SongChangedFlags_t flags, bool allowRecursion)
             return;
             }
       ++level;
-      emit songChanged(flags);
+      emitSongChanged(flags);
       --level;
       }
 
+//---------------------------------------------------------
+//   emitSongChanged
+//---------------------------------------------------------
+
+void Song::emitSongChanged(MusECore::SongChangedFlags_t flags, bool eventChangesPublished)
+      {
+      if (_songChangedLevel == 0) {
+            ++_songChangedSerial;
+            // Scheduled updates go out with any songChanged.
+            flags |= _scheduledFlags;
+            _scheduledFlags = 0;
+            }
+      _songChanges.cover(flags);
+      const bool published = _eventChangesPublished;
+      _eventChangesPublished = eventChangesPublished;
+      ++_songChangedLevel;
+      emit songChanged(flags);
+      --_songChangedLevel;
+      _eventChangesPublished = published;
+      if (_songChangedLevel == 0) {
+            _eventChanges.clear();
+            _songChanges.clear();
+            }
+      }
+
+//---------------------------------------------------------
+//   scheduleUpdate
+//---------------------------------------------------------
+
+void Song::scheduleUpdate(MusECore::SongChangedFlags_t flags, const Track* track, int ctrl)
+      {
+      _songChanges.add(SongChange(flags, track, 0, ctrl));
+      _scheduledFlags |= flags;
+      }
+
 //---------------------------------------------------------
 //   updatePos
 //---------------------------------------------------------
@@ -1689,6 +1796,10 @@ void Song::beat()
         }
       }
       
+      // Send the updates scheduled since the last beat.
+      if (_scheduledFlags)
+            update(0);
+      
       // Update synth native guis at the heartbeat rate.
       for(ciSynthI is = _synthIs.begin(); is != _synthIs.end(); ++is)
         (*is)->guiHeartBeat();
@@ -1824,7 +1935,7 @@ void Song::endMsgCmd()
             
             MusEGlobal::redoAction->setEnabled(false);
             setUndoRedoText();
-            emit songChanged(updateFlags);
+            emitSongChanged(updateFlags, true);
             }
       }
 
@@ -1854,7 +1965,7 @@ void Song::undo()
       MusEGlobal::undoAction->setEnabled(!undoList->empty());
       setUndoRedoText();
 
-      emit songChanged(updateFlags);
+      emitSongChanged(updateFlags, true);
       emit sigDirty();
 }
 
@@ -1884,7 +1995,7 @@ void Song::redo()
       MusEGlobal::redoAction->setEnabled(!redoList->empty());
       setUndoRedoText();
 
-      emit songChanged(updateFlags);
+      emitSongChanged(updateFlags, true);
       emit sigDirty();
 }
 
@@ -2049,7 +2160,7 @@ void Song::clear(bool signal, bool clear_all)
       if (signal) {
             emit loopChanged(false);
             recordChanged(false);
-            emit songChanged(-1);  
+            emitSongChanged(-1);  
             }
       }
 
@@ -158,6 +158,14 @@ class Song : public QObject {
       UndoList* redoList;
       // New items created in GUI thread awaiting addition in audio thread.
       PendingOperationList pendingOperations;
+      // Event changes made by operations, until the next songChanged is sent.
+      EventChangeLog _eventChanges;
+      bool _eventChangesPublished;
+      int _songChangedLevel;
+      unsigned _songChangedSerial;
+      // What the next songChanged is about, and flags held back by scheduleUpdate().
+      SongChangeJournal _songChanges;
+      MusECore::SongChangedFlags_t _scheduledFlags;
       
       Pos pos[3];
       Pos _vcpos;               // virtual CPOS (locate in progress)
@@ -190,6 +198,11 @@ class Song : public QObject {
       bool addEventOperation(const Event&, Part*, bool do_port_ctrls = true, bool do_clone_port_ctrls = true);
       void changeEventOperation(const Event&, const Event&, Part*, bool do_port_ctrls = true, bool do_clone_port_ctrls = true);
       void deleteEventOperation(const Event&, Part*, bool do_port_ctrls = true, bool do_clone_port_ctrls = true);
+      void modifyEventListOperation(const EventList* eraseEvents, const EventList* addEvents, Part*, bool do_port_ctrls = true, bool do_clone_port_ctrls = true);
+      
+      // Emit songChanged. If eventChangesPublished, receivers may patch their views
+      //  from eventChanges(). The change log is cleared afterwards.
+      void emitSongChanged(MusECore::SongChangedFlags_t flags, bool eventChangesPublished = false);
       
    public:
       Song(const char* name = 0);
@@ -422,6 +435,19 @@ public:
       // use allowRecursion with care! this could lock up muse if you 
       //  aren't sure that your recursion will be finite!
       void update(MusECore::SongChangedFlags_t flags = -1, bool allowRecursion=false); 
+      // While songChanged is being sent for executed operations, the event changes they
+      //  made, in order. Otherwise null: anything may have changed.
+      const EventChangeLog* eventChanges() const { return _eventChangesPublished ? &_eventChanges : 0; }
+      // Counts outermost songChanged signals, to tell whether eventChanges() was seen already.
+      unsigned songChangedSerial() const { return _songChangedSerial; }
+      // While songChanged is being sent, which tracks, parts, controllers and ranges the flags
+      //  are about. Receivers may skip whatever they don't display.
+      const SongChangeJournal& songChanges() const { return _songChanges; }
+      // Journal operations executed outside of the undo system, before they are executed.
+      void journalChanges(const PendingOperationList& ops) { _songChanges.add(ops); }
+      // Like update(), but coalesced: the flags are sent with the next songChanged,
+      //  at the latest on the next heartbeat. For frequent changes like controller knobs.
+      void scheduleUpdate(MusECore::SongChangedFlags_t flags, const Track* track = 0, int ctrl = -1);
       void beat();
 
       void undo();
@@ -21,6 +21,8 @@
 //
 //=========================================================
 
+#include <stdio.h>
+#include <stdlib.h>
 #include <uuid/uuid.h>
 #include <QProgressDialog>
 #include <QMessageBox>
@@ -36,6 +38,7 @@
 #include "pianoroll.h"
 #include "scoreedit.h"
 #include "globals.h"
+#include "gconfig.h"
 #include "xml.h"
 #include "drummap.h"
 #include "event.h"
@@ -50,6 +53,8 @@
 #include "conf.h"
 #include "driver/jackmidi.h"
 #include "keyevent.h"
+#include "midievent.h"
+#include "deferredevents.h"
 
 namespace MusEGlobal {
 MusECore::CloneList cloneList;
@@ -125,6 +130,258 @@ void Scale::read(Xml& xml)
             }
       }
 
+//---------------------------------------------------------
+//   Compact event chunk
+//    Midi part events packed as, per event:
+//      tick delta to the previous event  (signed varint)
+//      type                              (varint)
+//      length, Note only                 (varint)
+//      a, b, c                           (signed varints)
+//      data length and data bytes        (varint, bytes)
+//    Varints are 7 bits per byte, low bits first. Signed
+//     values are zigzag encoded. The chunk is stored base64
+//     encoded as the text of an <events count="n"> element.
+//---------------------------------------------------------
+
+static void putVarint(QByteArray& ba, unsigned v)
+      {
+      while (v >= 0x80) {
+            ba.append(char((v & 0x7f) | 0x80));
+            v >>= 7;
+            }
+      ba.append(char(v));
+      }
+
+static void putSigned(QByteArray& ba, int v)
+      {
+      putVarint(ba, (unsigned(v) << 1) ^ unsigned(v >> 31));
+      }
+
+static bool getVarint(const unsigned char** p, const unsigned char* end, unsigned* v)
+      {
+      unsigned val = 0;
+      for (int shift = 0; shift < 35; shift += 7) {
+            if (*p >= end)
+                  return false;
+            const unsigned char b = *(*p)++;
+            val |= unsigned(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                  *v = val;
+                  return true;
+                  }
+            }
+      return false;
+      }
+
+static bool getSigned(const unsigned char** p, const unsigned char* end, int* v)
+      {
+      unsigned u;
+      if (!getVarint(p, end, &u))
+            return false;
+      *v = int(u >> 1) ^ -int(u & 1);
+      return true;
+      }
+
+//---------------------------------------------------------
+//   PackedEvent
+//    One event unpacked from a compact chunk. data points
+//     into the chunk.
+//---------------------------------------------------------
+
+struct PackedEvent {
+      unsigned tick;
+      unsigned type;
+      unsigned len;
+      int a, b, c;
+      unsigned dataLen;
+      const unsigned char* data;
+      };
+
+//---------------------------------------------------------
+//   unpackEvent
+//    Reads the next event, ev->tick must hold the previous
+//     event's tick. Returns false on corrupt data.
+//---------------------------------------------------------
+
+static bool unpackEvent(const unsigned char** p, const unsigned char* end, PackedEvent* ev)
+      {
+      int delta;
+      ev->len = 0;
+      if (!getSigned(p, end, &delta) || !getVarint(p, end, &ev->type)
+         || (ev->type != Note && ev->type != Controller && ev->type != Sysex && ev->type != Meta)
+         || (ev->type == Note && !getVarint(p, end, &ev->len))
+         || !getSigned(p, end, &ev->a) || !getSigned(p, end, &ev->b) || !getSigned(p, end, &ev->c)
+         || !getVarint(p, end, &ev->dataLen) || ev->dataLen > unsigned(end - *p))
+            return false;
+      ev->tick += delta;
+      ev->data  = *p;
+      *p       += ev->dataLen;
+      return true;
+      }
+
+//---------------------------------------------------------
+//   packEvents
+//---------------------------------------------------------
+
+static QByteArray packEvents(const EventList& el)
+      {
+      QByteArray ba;
+      ba.reserve(el.size() * 8);
+      unsigned last = 0;
+      for (ciEvent i = el.begin(); i != el.end(); ++i) {
+            const Event& e = i->second;
+            putSigned(ba, int(e.tick() - last));
+            last = e.tick();
+            putVarint(ba, e.type());
+            if (e.type() == Note)
+                  putVarint(ba, e.lenTick());
+            putSigned(ba, e.dataA());
+            putSigned(ba, e.dataB());
+            putSigned(ba, e.dataC());
+            putVarint(ba, e.dataLen());
+            if (e.dataLen())
+                  ba.append((const char*)e.data(), e.dataLen());
+            }
+      return ba;
+      }
+
+//---------------------------------------------------------
+//   writeEventChunk
+//---------------------------------------------------------
+
+static void writeEventChunk(int level, Xml& xml, int count, const QByteArray& ba)
+      {
+      xml.nput(level, "<events count=\"%d\">", count);
+      xml.nput("%s", ba.toBase64().constData());
+      xml.put("</events>");
+      }
+
+static void writeEventChunk(int level, Xml& xml, const EventList& el)
+      {
+      writeEventChunk(level, xml, int(el.size()), packEvents(el));
+      }
+
+//---------------------------------------------------------
+//   DeferredEvents::add
+//---------------------------------------------------------
+
+void DeferredEvents::add(Xml& xml, int level, const EventList& el, unsigned partTick, bool compact)
+      {
+      Chunk c;
+      c.offset  = xml.tell();
+      c.level   = level;
+      c.tick    = partTick;
+      c.compact = compact;
+      c.count   = el.size();
+      _chunks.push_back(c);
+      _chunks.back().data = packEvents(el);
+      }
+
+//---------------------------------------------------------
+//   DeferredEvents::merge
+//---------------------------------------------------------
+
+QByteArray DeferredEvents::merge(const QByteArray& skeleton) const
+      {
+      char* buf = 0;
+      size_t len = 0;
+      FILE* f = open_memstream(&buf, &len);
+      if (f == 0)
+            return QByteArray();
+      Xml xml(f);
+      long pos = 0;
+      bool ok = true;
+      for (std::vector<Chunk>::const_iterator i = _chunks.begin(); i != _chunks.end(); ++i) {
+            if (i->offset < pos || i->offset > skeleton.size()) {
+                  ok = false;
+                  break;
+                  }
+            fwrite(skeleton.constData() + pos, 1, i->offset - pos, f);
+            pos = i->offset;
+            if (i->compact) {
+                  writeEventChunk(i->level, xml, i->count, i->data);
+                  continue;
+                  }
+            const unsigned char* p   = (const unsigned char*)i->data.constData();
+            const unsigned char* end = p + i->data.size();
+            PackedEvent ev;
+            ev.tick = 0;
+            while (p < end && unpackEvent(&p, end, &ev))
+                  MidiEventBase::writeXml(i->level, xml, ev.tick + i->tick, ev.type, ev.len,
+                                          ev.a, ev.b, ev.c, ev.dataLen ? ev.data : 0, ev.dataLen);
+            }
+      if (ok)
+            fwrite(skeleton.constData() + pos, 1, skeleton.size() - pos, f);
+      fclose(f);
+      QByteArray out;
+      if (ok)
+            out = QByteArray(buf, len);
+      free(buf);
+      return out;
+      }
+
+//---------------------------------------------------------
+//   readEventChunk
+//    Events are relative to the part, unlike <event> tags.
+//---------------------------------------------------------
+
+static void readEventChunk(Xml& xml, Part* part)
+      {
+      int count = -1;
+      QByteArray ba;
+      for (;;) {
+            Xml::Token token = xml.parse();
+            const QString& tag = xml.s1();
+            switch (token) {
+                  case Xml::Error:
+                  case Xml::End:
+                        return;
+                  case Xml::TagStart:
+                        xml.unknown("events");
+                        break;
+                  case Xml::Attribut:
+                        if (tag == "count")
+                              count = xml.s2().toInt();
+                        break;
+                  case Xml::Text:
+                        ba = QByteArray::fromBase64(tag.toLatin1());
+                        break;
+                  case Xml::TagEnd:
+                        if (tag == "events") {
+                              const unsigned char* p   = (const unsigned char*)ba.constData();
+                              const unsigned char* end = p + ba.size();
+                              PackedEvent ev;
+                              ev.tick = 0;
+                              int n = 0;
+                              while (p < end) {
+                                    if (!unpackEvent(&p, end, &ev)) {
+                                          printf("readEventChunk: corrupt event data in part %s after %d events\n",
+                                             part->name().toLatin1().constData(), n);
+                                          break;
+                                          }
+                                    Event e(EventType(ev.type));
+                                    e.setTick(ev.tick);
+                                    if (ev.type == Note)
+                                          e.setLenTick(ev.len);
+                                    e.setA(ev.a);
+                                    e.setB(ev.b);
+                                    e.setC(ev.c);
+                                    if (ev.dataLen)
+                                          e.setData(ev.data, ev.dataLen);
+                                    part->addEvent(e);
+                                    ++n;
+                                    }
+                              if (count != -1 && n != count)
+                                    printf("readEventChunk: part %s: expected %d events, read %d\n",
+                                       part->name().toLatin1().constData(), count, n);
+                              return;
+                              }
+                  default:
+                        break;
+                  }
+            }
+      }
+
 //---------------------------------------------------------
 //   Part::readFromXml
 //---------------------------------------------------------
@@ -317,6 +574,13 @@ Part* Part::readFromXml(Xml& xml, Track* track, bool doClone, bool toTrack)
                               else // ...Otherwise a clone was created, so we don't need the events.
                                 xml.skip(tag);
                         }
+                        else if (tag == "events")
+                        {
+                              if(!clone && track->isMidiTrack())
+                                readEventChunk(xml, npart);
+                              else
+                                xml.skip(tag);
+                        }
                         else
                               xml.unknown("readXmlPart");
                         break;
@@ -442,8 +706,14 @@ void Part::write(int level, Xml& xml, bool isCopy, bool forceWavePaths) const
       if (_mute)
             xml.intTag(level, "mute", _mute);
       if (dumpEvents) {
-            for (ciEvent e = events().begin(); e != events().end(); ++e)
-                  e->second.write(level, xml, *this, forceWavePaths);
+            if (!wave && xml.deferredEvents())
+                  xml.deferredEvents()->add(xml, level, events(), tick(),
+                                            MusEGlobal::config.compactEventEncoding && !events().empty());
+            else if (!wave && MusEGlobal::config.compactEventEncoding && !events().empty())
+                  writeEventChunk(level, xml, events());
+            else
+                  for (ciEvent e = events().begin(); e != events().end(); ++e)
+                        e->second.write(level, xml, *this, forceWavePaths);
             }
       xml.etag(level, "part");
       }
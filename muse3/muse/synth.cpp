@@ -255,7 +255,7 @@ Synth::Synth(const QFileInfo& fi, QString label, QString descr, QString maker, Q
 //   instantiate
 //---------------------------------------------------------
 
-void* MessSynth::instantiate(const QString& instanceName)
+void* MessSynth::instantiate(const QString& instanceName, int initLen, const unsigned char* initData)
       {
       ++_instances;
 
@@ -292,7 +292,12 @@ void* MessSynth::instantiate(const QString& instanceName)
             MusEGlobal::undoSetuid();
             return 0;
             }
-      Mess* mess = _descr->instantiate(MusEGlobal::sampleRate, MusEGlobal::muse, &MusEGlobal::museProject, instanceName.toLatin1().constData());
+      Mess* mess;
+      if (initLen > 0 && _descr->majorMessVersion == 1 && _descr->minorMessVersion >= 2 && _descr->instantiateWithInitData)
+            mess = _descr->instantiateWithInitData(MusEGlobal::sampleRate, MusEGlobal::muse, &MusEGlobal::museProject,
+               instanceName.toLatin1().constData(), initLen, initData);
+      else
+            mess = _descr->instantiate(MusEGlobal::sampleRate, MusEGlobal::muse, &MusEGlobal::museProject, instanceName.toLatin1().constData());
       MusEGlobal::undoSetuid();
       return mess;
       }
@@ -460,7 +465,19 @@ void SynthI::currentProg(unsigned long *prog, unsigned long *bankL, unsigned lon
 
 bool MessSynthIF::init(Synth* s, SynthI* si)
       {
-      _mess = (Mess*)((MessSynth*)s)->instantiate(si->name());
+      // A restored instance hands its saved state to the synth up front,
+      //  the first sysex of the midi state is what getInitData() gave.
+      int initLen = 0;
+      const unsigned char* initData = 0;
+      EventList* iel = si->midiState();
+      for (iEvent i = iel->begin(); i != iel->end(); ++i) {
+            if (i->second.type() == Sysex) {
+                  initLen  = i->second.dataLen();
+                  initData = i->second.data();
+                  break;
+                  }
+            }
+      _mess = (Mess*)((MessSynth*)s)->instantiate(si->name(), initLen, initData);
 
       return (_mess == 0);
       }
@@ -1094,7 +1111,9 @@ bool SynthI::getData(unsigned pos, int ports, unsigned n, float** buffer)
 
       iMPEvent ie = _playEvents.begin();
 
+      MusEGlobal::dspLoadProfiler.begin(&_sourceLoad);
       ie = _sif->getData(mp, &_playEvents, ie, pos, ports, n, buffer);
+      MusEGlobal::dspLoadProfiler.end();
 
       // p4.0.15 We are done with these events. Let us erase them here instead of Audio::processMidi.
       // That way we can simply set the next play event to the beginning.
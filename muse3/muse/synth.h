@@ -105,7 +105,7 @@ class MessSynth : public Synth {
       virtual ~MessSynth() {}
       virtual Type synthType() const { return MESS_SYNTH; }
 
-      virtual void* instantiate(const QString&);
+      virtual void* instantiate(const QString&, int initLen = 0, const unsigned char* initData = 0);
 
       virtual SynthIF* createSIF(SynthI*);
       };
@@ -40,6 +40,7 @@
 #include "globaldefs.h"
 #include "cleftypes.h"
 #include "controlfifo.h"
+#include "dspload.h"
 
 class QPixmap;
 
@@ -429,6 +430,8 @@ class AudioTrack : public Track {
       SndFileR _recFile;
       Fifo fifo;                    // fifo -> _recFile
       bool _processed;
+      DspLoad _trackLoad;           // Time used by the track itself: routing, volume, metering.
+      DspLoad _sourceLoad;          // Time used producing the track's data: wave fifo, synth.
       
    public:
       AudioTrack(TrackType t);
@@ -446,6 +449,9 @@ class AudioTrack : public Track {
       bool prepareRecording();
 
       bool processed() { return _processed; }
+      const DspLoad& trackLoad() const  { return _trackLoad; }
+      const DspLoad& sourceLoad() const { return _sourceLoad; }
+      void resetDspLoadPeaks();
 
       void addController(CtrlList*);
       void removeController(int id);
@@ -35,15 +35,23 @@
 #include "part.h"
 #include "audiodev.h"
 #include "track.h"
+#include "midievent.h"
+#include "gconfig.h"
 
 #include <string.h>
 #include <QAction>
 #include <QString>
 #include <set>
+#include <map>
+#include <vector>
 
 // Enable for debugging:
 //#define _UNDO_DEBUG_
 
+// Approximate allocator and node overhead of std::list and std::map entries.
+#define UNDO_LIST_NODE_OVERHEAD 32
+#define UNDO_MAP_NODE_OVERHEAD  48
+
 namespace MusECore {
 
 // iundo points to last Undo() in Undo-list
@@ -62,7 +70,7 @@ const char* UndoOp::typeName()
             "AddRoute", "DeleteRoute", 
             "AddTrack", "DeleteTrack", 
             "AddPart",  "DeletePart", "MovePart", "ModifyPartLength", "ModifyPartName", "SelectPart",
-            "AddEvent", "DeleteEvent", "ModifyEvent", "SelectEvent",
+            "AddEvent", "DeleteEvent", "ModifyEvent", "SelectEvent", "ModifyEventList",
             "AddAudioCtrlVal", "DeleteAudioCtrlVal", "ModifyAudioCtrlVal", "ModifyAudioCtrlValList",
             "AddTempo", "DeleteTempo", "ModifyTempo", "SetGlobalTempo",
             "AddSig",   "DeleteSig",   "ModifySig",
@@ -119,6 +127,319 @@ void UndoOp::dump()
             }
       }
 
+//---------------------------------------------------------
+//   memoryUsage
+//    Rough estimate. Counts the operation and what only the
+//     undo history keeps alive. Events and parts the song
+//     uses are not counted, which of them those are depends
+//     on whether the operation is done or undone.
+//---------------------------------------------------------
+
+static std::size_t eventMemoryUsage(const Event& e)
+      {
+      if (e.empty())
+            return 0;
+      return sizeof(MidiEventBase) + e.dataLen();
+      }
+
+static std::size_t eventListMemoryUsage(const EventList* el)
+      {
+      if (!el)
+            return 0;
+      std::size_t n = sizeof(EventList);
+      for (ciEvent i = el->begin(); i != el->end(); ++i)
+            n += UNDO_MAP_NODE_OVERHEAD + sizeof(*i) + eventMemoryUsage(i->second);
+      return n;
+      }
+
+// The list only, for lists of events the song uses.
+static std::size_t sharedEventListMemoryUsage(const EventList* el)
+      {
+      if (!el)
+            return 0;
+      return sizeof(EventList) + el->size() * (UNDO_MAP_NODE_OVERHEAD + sizeof(EventList::value_type));
+      }
+
+static std::size_t ctrlListMemoryUsage(const CtrlList* cl)
+      {
+      if (!cl)
+            return 0;
+      return sizeof(CtrlList) + cl->size() * (UNDO_MAP_NODE_OVERHEAD + sizeof(CtrlList::value_type));
+      }
+
+std::size_t UndoOp::memoryUsage(bool reverted) const
+      {
+      std::size_t n = UNDO_LIST_NODE_OVERHEAD + sizeof(UndoOp);
+      switch(type) {
+            case AddEvent:
+                  if (reverted)
+                        n += eventMemoryUsage(nEvent);
+                  break;
+            case DeleteEvent:
+                  if (!reverted)
+                        n += eventMemoryUsage(nEvent);
+                  break;
+            case ModifyEvent:
+                  n += eventMemoryUsage(reverted ? nEvent : oEvent);
+                  break;
+            case ModifyEventList:
+                  if (reverted) {
+                        n += _addEventDelta ? _addEventDelta->memoryUsage() : eventListMemoryUsage(_addEventList);
+                        n += sharedEventListMemoryUsage(_eraseEventList);
+                        }
+                  else {
+                        n += _eraseEventDelta ? _eraseEventDelta->memoryUsage() : eventListMemoryUsage(_eraseEventList);
+                        n += sharedEventListMemoryUsage(_addEventList);
+                        }
+                  break;
+            case ModifyAudioCtrlValList:
+                  // Both lists are copies owned by the operation.
+                  n += ctrlListMemoryUsage(_eraseCtrlList) + ctrlListMemoryUsage(_addCtrlList);
+                  break;
+            case ModifyPartName:
+            case ModifyTrackName:
+                  if (_oldName)
+                        n += sizeof(QString) + _oldName->size() * sizeof(QChar);
+                  if (_newName)
+                        n += sizeof(QString) + _newName->size() * sizeof(QChar);
+                  break;
+            case AddPart:
+            case DeletePart:
+                  // The part is out of the song while an AddPart is undone or a DeletePart done.
+                  if (part && reverted == (type == AddPart))
+                        n += sizeof(MidiPart) + eventListMemoryUsage(&part->events());
+                  break;
+            default:
+                  break;
+            }
+      return n;
+      }
+
+std::size_t Undo::memoryUsage(bool reverted) const
+      {
+      std::size_t& cached = _memoryUsage[reverted ? 1 : 0];
+      if (cached == 0) {
+            std::size_t n = sizeof(Undo);
+            for (ciUndoOp i = begin(); i != end(); ++i)
+                  n += i->memoryUsage(reverted);
+            cached = n;
+            }
+      return cached;
+      }
+
+std::size_t UndoList::memoryUsage() const
+      {
+      std::size_t n = 0;
+      for (std::list<Undo>::const_iterator i = begin(); i != end(); ++i)
+            n += i->memoryUsage(!isUndo);
+      return n;
+      }
+
+//---------------------------------------------------------
+//   EventListDelta
+//    Each packed event is stored as the step to the index
+//     of its counterpart in the base list, a mask of the
+//     fields which differ and, for those, the zigzag coded
+//     difference as a varint. Events moved, transposed or
+//     with changed velocity take a few bytes each.
+//---------------------------------------------------------
+
+enum {
+      DELTA_TICK     = 0x01,
+      DELTA_LEN      = 0x02,
+      DELTA_A        = 0x04,
+      DELTA_B        = 0x08,
+      DELTA_C        = 0x10,
+      DELTA_SELECTED = 0x20
+      };
+
+static void putDelta(QByteArray& data, long long d)
+      {
+      unsigned long long v = (d < 0) ? ((~(unsigned long long)d) << 1) | 1 : ((unsigned long long)d) << 1;
+      while (v >= 0x80) {
+            data.append(char((v & 0x7f) | 0x80));
+            v >>= 7;
+            }
+      data.append(char(v));
+      }
+
+static long long getDelta(const unsigned char*& p)
+      {
+      unsigned long long v = 0;
+      int shift = 0;
+      for (;;) {
+            const unsigned char c = *p++;
+            v |= (unsigned long long)(c & 0x7f) << shift;
+            if (!(c & 0x80))
+                  break;
+            shift += 7;
+            }
+      return (v & 1) ? (long long)~(v >> 1) : (long long)(v >> 1);
+      }
+
+EventListDelta::~EventListDelta()
+      {
+      if (_rest)
+            delete _rest;
+      }
+
+EventListDelta* EventListDelta::encode(const EventList& events, const EventList& base)
+      {
+      std::map<EventID_t, int> index;
+      std::vector<const Event*> bases;
+      bases.reserve(base.size());
+      for (ciEvent i = base.begin(); i != base.end(); ++i) {
+            index.insert(std::pair<EventID_t, int>(i->second.id(), int(bases.size())));
+            bases.push_back(&i->second);
+            }
+
+      EventListDelta* d = new EventListDelta();
+      int prev = 0;
+      for (ciEvent i = events.begin(); i != events.end(); ++i) {
+            const Event& e = i->second;
+            std::map<EventID_t, int>::const_iterator ib = index.find(e.id());
+            // Clones share their sysex data, so the counterpart's can be reused.
+            if (e.type() == Wave || ib == index.end() || bases[ib->second]->type() != e.type()
+               || bases[ib->second]->data() != e.data()) {
+                  if (!d->_rest)
+                        d->_rest = new EventList();
+                  d->_rest->add(e);
+                  continue;
+                  }
+            const Event& b = *bases[ib->second];
+            int mask = e.selected() ? DELTA_SELECTED : 0;
+            if (e.tick() != b.tick())
+                  mask |= DELTA_TICK;
+            if (e.lenTick() != b.lenTick())
+                  mask |= DELTA_LEN;
+            if (e.dataA() != b.dataA())
+                  mask |= DELTA_A;
+            if (e.dataB() != b.dataB())
+                  mask |= DELTA_B;
+            if (e.dataC() != b.dataC())
+                  mask |= DELTA_C;
+            putDelta(d->_data, ib->second - prev);
+            prev = ib->second;
+            d->_data.append(char(mask));
+            if (mask & DELTA_TICK)
+                  putDelta(d->_data, (long long)e.tick() - (long long)b.tick());
+            if (mask & DELTA_LEN)
+                  putDelta(d->_data, (long long)e.lenTick() - (long long)b.lenTick());
+            if (mask & DELTA_A)
+                  putDelta(d->_data, (long long)e.dataA() - b.dataA());
+            if (mask & DELTA_B)
+                  putDelta(d->_data, (long long)e.dataB() - b.dataB());
+            if (mask & DELTA_C)
+                  putDelta(d->_data, (long long)e.dataC() - b.dataC());
+            ++d->_count;
+            }
+      if (d->_count == 0) {
+            delete d;
+            return 0;
+            }
+      d->_data.squeeze();
+      return d;
+      }
+
+EventList* EventListDelta::decode(const EventList& base) const
+      {
+      std::vector<const Event*> bases;
+      bases.reserve(base.size());
+      for (ciEvent i = base.begin(); i != base.end(); ++i)
+            bases.push_back(&i->second);
+
+      EventList* el = _rest ? new EventList(*_rest) : new EventList();
+      const unsigned char* p = (const unsigned char*)_data.constData();
+      int idx = 0;
+      for (int k = 0; k < _count; ++k) {
+            idx += int(getDelta(p));
+            const int mask = *p++;
+            const Event& b = *bases[idx];
+            // Same id as the counterpart, like the clone it was made from.
+            Event e = b.clone();
+            if (mask & DELTA_TICK)
+                  e.setTick(b.tick() + getDelta(p));
+            if (mask & DELTA_LEN)
+                  e.setLenTick(b.lenTick() + getDelta(p));
+            if (mask & DELTA_A)
+                  e.setA(b.dataA() + getDelta(p));
+            if (mask & DELTA_B)
+                  e.setB(b.dataB() + getDelta(p));
+            if (mask & DELTA_C)
+                  e.setC(b.dataC() + getDelta(p));
+            e.setSelected(mask & DELTA_SELECTED);
+            el->add(e);
+            }
+      return el;
+      }
+
+std::size_t EventListDelta::memoryUsage() const
+      {
+      return sizeof(EventListDelta) + _data.capacity() + eventListMemoryUsage(_rest);
+      }
+
+//---------------------------------------------------------
+//   packEventList
+//    The events in the song stay as they are. The others,
+//     those erased while done or added while undone, are
+//     packed against them.
+//---------------------------------------------------------
+
+void UndoOp::packEventList(bool reverted)
+      {
+      if (type != ModifyEventList)
+            return;
+      EventList*& owned = reverted ? _addEventList : _eraseEventList;
+      EventListDelta*& delta = reverted ? _addEventDelta : _eraseEventDelta;
+      const EventList* live = reverted ? _eraseEventList : _addEventList;
+      if (!owned || !live || delta)
+            return;
+      delta = EventListDelta::encode(*owned, *live);
+      if (delta) {
+            delete owned;
+            owned = 0;
+            }
+      }
+
+//---------------------------------------------------------
+//   expandEventList
+//---------------------------------------------------------
+
+void UndoOp::expandEventList()
+      {
+      if (type != ModifyEventList)
+            return;
+      if (_eraseEventDelta) {
+            _eraseEventList = _eraseEventDelta->decode(*_addEventList);
+            delete _eraseEventDelta;
+            _eraseEventDelta = 0;
+            }
+      if (_addEventDelta) {
+            _addEventList = _addEventDelta->decode(*_eraseEventList);
+            delete _addEventDelta;
+            _addEventDelta = 0;
+            }
+      }
+
+//---------------------------------------------------------
+//   trimToSize
+//---------------------------------------------------------
+
+int UndoList::trimToSize(std::size_t maxBytes)
+      {
+      std::size_t total = memoryUsage();
+      int dropped = 0;
+      while (total > maxBytes && size() > 1) {
+            total -= front().memoryUsage(!isUndo);
+            // Let clearDelete free whatever the group owns.
+            UndoList old(isUndo);
+            old.splice(old.end(), *this, begin());
+            old.clearDelete();
+            ++dropped;
+            }
+      return dropped;
+      }
+
 //---------------------------------------------------------
 //    clearDelete
 //---------------------------------------------------------
@@ -165,6 +486,17 @@ void UndoList::clearDelete()
                     delete i->_addCtrlList;
                   break;
                   
+            case UndoOp::ModifyEventList:
+                  if (i->_eraseEventList)
+                    delete i->_eraseEventList;
+                  if (i->_addEventList)
+                    delete i->_addEventList;
+                  if (i->_eraseEventDelta)
+                    delete i->_eraseEventDelta;
+                  if (i->_addEventDelta)
+                    delete i->_addEventDelta;
+                  break;
+                  
             default:
                   break;
           }
@@ -209,6 +541,17 @@ void UndoList::clearDelete()
                     delete i->_addCtrlList;
                   break;
                   
+            case UndoOp::ModifyEventList:
+                  if (i->_eraseEventList)
+                    delete i->_eraseEventList;
+                  if (i->_addEventList)
+                    delete i->_addEventList;
+                  if (i->_eraseEventDelta)
+                    delete i->_eraseEventDelta;
+                  if (i->_addEventDelta)
+                    delete i->_addEventDelta;
+                  break;
+                  
             default:
                   break;
           }
@@ -257,6 +600,14 @@ void Song::endUndo(SongChangedFlags_t flags)
               if (prev_undo->merge_combo(undoList->back()))
                     undoList->pop_back();
         }
+        
+        // Keep the history within the configured memory limit.
+        if(MusEGlobal::config.undoMemoryLimit > 0)
+        {
+          const int dropped = undoList->trimToSize(std::size_t(MusEGlobal::config.undoMemoryLimit) * 1024 * 1024);
+          if(dropped && MusEGlobal::debugMsg)
+            fprintf(stderr, "Song::endUndo: undo memory limit reached, dropped %d oldest undo steps\n", dropped);
+        }
       }
       
       // Even if the current list was empty, or emptied during appending of given operations to the current list, 
@@ -308,6 +659,18 @@ void Song::setUndoRedoText()
     }
     MusEGlobal::redoAction->setText(s);
   }
+  
+  if(MusEGlobal::undoAction && MusEGlobal::redoAction)
+  {
+    const double mb = double(undoList->memoryUsage() + redoList->memoryUsage()) / (1024.0 * 1024.0);
+    QString tip;
+    if(MusEGlobal::config.undoMemoryLimit > 0)
+      tip = tr("Undo history: %1 MB of %2 MB").arg(mb, 0, 'f', 1).arg(MusEGlobal::config.undoMemoryLimit);
+    else
+      tip = tr("Undo history: %1 MB").arg(mb, 0, 'f', 1);
+    MusEGlobal::undoAction->setStatusTip(tip);
+    MusEGlobal::redoAction->setStatusTip(tip);
+  }
 }
 
 void Undo::push_back(const UndoOp& op)
@@ -330,6 +693,7 @@ void Undo::insert(Undo::iterator position, Undo::size_type n, const UndoOp& op)
 void Undo::insert(Undo::iterator position, const UndoOp& op)
 {
   UndoOp n_op = op;
+  memoryUsageChanged();
 
 #ifdef _UNDO_DEBUG_
   switch(n_op.type)
@@ -400,6 +764,9 @@ void Undo::insert(Undo::iterator position, const UndoOp& op)
     case UndoOp::SelectEvent:
       fprintf(stderr, "Undo::insert: SelectEvent\n");
     break;
+    case UndoOp::ModifyEventList:
+      fprintf(stderr, "Undo::insert: ModifyEventList\n");
+    break;
     
     
     case UndoOp::AddAudioCtrlVal:
@@ -1590,6 +1957,23 @@ UndoOp::UndoOp(UndoType type_, const Event& nev, const Event& oev, const Part* p
       _noUndo = noUndo;
       }
 
+UndoOp::UndoOp(UndoType type_, const Part* part_, EventList* eraseEvents, EventList* addEvents, bool doCtrls_, bool doClones_, bool noUndo)
+      {
+      assert(type_==ModifyEventList);
+      assert(part_);
+      assert(eraseEvents || addEvents);
+      
+      type   = type_;
+      part   = part_;
+      _eraseEventList = eraseEvents;
+      _addEventList = addEvents;
+      _eraseEventDelta = 0;
+      _addEventDelta = 0;
+      doCtrls = doCtrls_;
+      doClones = doClones_;
+      _noUndo = noUndo;
+      }
+
 UndoOp::UndoOp(UndoType type_, const Event& nev, const Part* part_, bool a_, bool b_, bool noUndo)
       {
       assert(type_==DeleteEvent || type_==AddEvent || type_==SelectEvent);
@@ -1743,6 +2127,8 @@ void Song::addUndo(UndoOp i)
 
 void Song::revertOperationGroup1(Undo& operations)
       {
+      // What the operations own changes sides, and may be packed differently.
+      operations.memoryUsageChanged();
       for (riUndoOp i = operations.rbegin(); i != operations.rend(); ++i) {
             Track* editable_track = const_cast<Track*>(i->track);
             Track* editable_property_track = const_cast<Track*>(i->_propertyTrack);
@@ -2063,6 +2449,16 @@ void Song::revertOperationGroup1(Undo& operations)
                         changeEventOperation(i->nEvent, i->oEvent, editable_part, i->doCtrls, i->doClones);
                         updateFlags |= SC_EVENT_MODIFIED;
                         break;
+                        
+                  case UndoOp::ModifyEventList:
+#ifdef _UNDO_DEBUG_
+                        fprintf(stderr, "Song::revertOperationGroup1:ModifyEventList ** calling modifyEventListOperation\n");
+#endif                        
+                        i->expandEventList();
+                        modifyEventListOperation(i->_addEventList, i->_eraseEventList, editable_part, i->doCtrls, i->doClones);
+                        i->packEventList(true);
+                        updateFlags |= SC_EVENT_INSERTED | SC_EVENT_REMOVED | SC_EVENT_MODIFIED;
+                        break;
 
                         
                   case UndoOp::AddAudioCtrlVal:
@@ -2236,6 +2632,8 @@ void Song::revertOperationGroup1(Undo& operations)
                         break;
                   }
             }
+      // Journal the operations while their iterators are still valid.
+      _songChanges.add(pendingOperations);
       return;
       }
 
@@ -2246,6 +2644,7 @@ void Song::revertOperationGroup1(Undo& operations)
 
 void Song::revertOperationGroup3(Undo& operations)
       {
+      _eventChanges.add(pendingOperations);
       pendingOperations.executeNonRTStage();
 #ifdef _UNDO_DEBUG_
       fprintf(stderr, "Song::revertOperationGroup3 *** Calling pendingOperations.clear()\n");
@@ -2379,6 +2778,8 @@ void Song::revertOperationGroup3(Undo& operations)
 
 void Song::executeOperationGroup1(Undo& operations)
       {
+      // What the operations own changes sides, and may be packed differently.
+      operations.memoryUsageChanged();
       unsigned song_len = MusEGlobal::song->len();
         
       for (iUndoOp i = operations.begin(); i != operations.end(); ++i) {
@@ -2750,6 +3151,16 @@ void Song::executeOperationGroup1(Undo& operations)
                         changeEventOperation(i->oEvent, i->nEvent, editable_part, i->doCtrls, i->doClones);
                         updateFlags |= SC_EVENT_MODIFIED;
                         break;
+                        
+                  case UndoOp::ModifyEventList:
+#ifdef _UNDO_DEBUG_
+                        fprintf(stderr, "Song::executeOperationGroup1:ModifyEventList ** calling modifyEventListOperation\n");
+#endif                        
+                        i->expandEventList();
+                        modifyEventListOperation(i->_eraseEventList, i->_addEventList, editable_part, i->doCtrls, i->doClones);
+                        i->packEventList(false);
+                        updateFlags |= SC_EVENT_INSERTED | SC_EVENT_REMOVED | SC_EVENT_MODIFIED;
+                        break;
 
                         
                   case UndoOp::AddAudioCtrlVal:
@@ -2932,6 +3343,8 @@ void Song::executeOperationGroup1(Undo& operations)
                         break;
                   }
             }
+      // Journal the operations while their iterators are still valid.
+      _songChanges.add(pendingOperations);
       }
 
 //---------------------------------------------------------
@@ -2941,6 +3354,7 @@ void Song::executeOperationGroup1(Undo& operations)
 
 void Song::executeOperationGroup3(Undo& operations)
       {
+      _eventChanges.add(pendingOperations);
       pendingOperations.executeNonRTStage();
 #ifdef _UNDO_DEBUG_
       fprintf(stderr, "Song::executeOperationGroup3 *** Calling pendingOperations.clear()\n");
@@ -26,6 +26,8 @@
 
 #include <list>
 
+#include <QByteArray>
+
 #include "event.h"
 #include "marker/marker.h"
 #include "route.h"
@@ -45,6 +47,32 @@ class CtrlList;
 struct CtrlVal;
 
 extern std::list<QString> temporaryWavFiles; //!< Used for storing all tmp-files, for cleanup on shutdown
+
+//---------------------------------------------------------
+//   EventListDelta
+//    Compact form of a list of midi events which differ
+//     only a little from the events with the same id in
+//     another (base) list. Each such event is kept as the
+//     fields differing from its counterpart, other events
+//     are kept as they are.
+//---------------------------------------------------------
+
+class EventListDelta {
+      QByteArray _data;   // Per event: base index step, field mask, field deltas.
+      int _count;         // Number of events in _data.
+      EventList* _rest;   // Events without a usable counterpart, or 0.
+
+      EventListDelta() : _count(0), _rest(0) { }
+
+   public:
+      ~EventListDelta();
+      // Returns 0 if none of the events has a counterpart in base.
+      static EventListDelta* encode(const EventList& events, const EventList& base);
+      // Base must hold the same events as the one given to encode().
+      EventList* decode(const EventList& base) const;
+      std::size_t memoryUsage() const;
+      };
+
 //---------------------------------------------------------
 //   UndoOp
 //---------------------------------------------------------
@@ -54,7 +82,7 @@ struct UndoOp {
             AddRoute, DeleteRoute,
             AddTrack, DeleteTrack,
             AddPart,  DeletePart,  MovePart, ModifyPartLength, ModifyPartName, SelectPart,
-            AddEvent, DeleteEvent, ModifyEvent, SelectEvent,
+            AddEvent, DeleteEvent, ModifyEvent, SelectEvent, ModifyEventList,
             AddAudioCtrlVal, DeleteAudioCtrlVal, ModifyAudioCtrlVal, ModifyAudioCtrlValList,
             AddTempo, DeleteTempo, ModifyTempo, SetGlobalTempo, 
             AddSig,   DeleteSig,   ModifySig,
@@ -117,6 +145,13 @@ struct UndoOp {
       QString* _newName;
       Event oEvent;
       Event nEvent;
+      // ModifyEventList: events removed from and added to the part, owned by the operation.
+      // While undone (redo list) the added events may be packed in _addEventDelta, otherwise
+      //  the erased ones in _eraseEventDelta. The list pointer is then 0.
+      EventList* _eraseEventList;
+      EventList* _addEventList;
+      EventListDelta* _eraseEventDelta;
+      EventListDelta* _addEventDelta;
       bool selected;
       bool selected_old;
       bool doCtrls;
@@ -133,6 +168,12 @@ struct UndoOp {
       
       const char* typeName();
       void dump();
+      // Approximate number of bytes held by this operation, not counting data the song uses.
+      // Reverted is true if the operation is undone, ie. in the redo list.
+      std::size_t memoryUsage(bool reverted) const;
+      // ModifyEventList: Packs the events which are not in the song as deltas, and restores them.
+      void packEventList(bool reverted);
+      void expandEventList();
       
       UndoOp();
       // NOTE: In these constructors, if noUndo is set, the operation cannot be undone. It is a 'one time' operation, removed after execution.
@@ -145,6 +186,8 @@ struct UndoOp {
       UndoOp(UndoType type, const Part* part, int old_len_or_pos, int new_len_or_pos, Pos::TType new_time_type = Pos::TICKS, const Track* oTrack = 0, const Track* nTrack = 0, bool noUndo = false);
       UndoOp(UndoType type, const Event& nev, const Event& oev, const Part* part, bool doCtrls, bool doClones, bool noUndo = false);
       UndoOp(UndoType type, const Event& nev, const Part* part, bool, bool, bool noUndo = false);
+      // NOTE: Do not mix ModifyEventList with other event operations on the same part in one operation group.
+      UndoOp(UndoType type, const Part* part, EventList* eraseEvents, EventList* addEvents, bool doCtrls, bool doClones, bool noUndo = false);
       UndoOp(UndoType type, const Event& changedEvent, const QString& changeData, int startframe, int endframe, bool noUndo = false);
       UndoOp(UndoType type, Marker* copyMarker, Marker* realMarker, bool noUndo = false);
       UndoOp(UndoType type, const Track* track, const QString& old_name, const QString& new_name, bool noUndo = false);
@@ -157,12 +200,18 @@ struct UndoOp {
 };
 
 class Undo : public std::list<UndoOp> {
+      // Cached, indexed by reverted. 0 = not known.
+      mutable std::size_t _memoryUsage[2];
+
    public:
-      Undo() : std::list<UndoOp>() { combobreaker=false; }
-      Undo(const Undo& other) : std::list<UndoOp>(other) { this->combobreaker=other.combobreaker; }
-      Undo& operator=(const Undo& other) { std::list<UndoOp>::operator=(other); this->combobreaker=other.combobreaker; return *this;}
+      Undo() : std::list<UndoOp>() { combobreaker=false; memoryUsageChanged(); }
+      Undo(const Undo& other) : std::list<UndoOp>(other) { this->combobreaker=other.combobreaker; _memoryUsage[0]=other._memoryUsage[0]; _memoryUsage[1]=other._memoryUsage[1]; }
+      Undo& operator=(const Undo& other) { std::list<UndoOp>::operator=(other); this->combobreaker=other.combobreaker; _memoryUsage[0]=other._memoryUsage[0]; _memoryUsage[1]=other._memoryUsage[1]; return *this;}
 
       bool empty() const;
+      std::size_t memoryUsage(bool reverted) const;
+      // Must be called when what the operations own changes.
+      void memoryUsageChanged() { _memoryUsage[0] = _memoryUsage[1] = 0; }
       
       
       /** if set, forbid merging (below).
@@ -192,6 +241,10 @@ class UndoList : public std::list<Undo> {
       bool isUndo;
    public:
       void clearDelete();
+      std::size_t memoryUsage() const;
+      // Drops the oldest groups until the list holds at most maxBytes. The newest group is always kept.
+      // Returns the number of groups dropped.
+      int trimToSize(std::size_t maxBytes);
       UndoList(bool _isUndo) : std::list<Undo>() { isUndo=_isUndo; }
 };
 
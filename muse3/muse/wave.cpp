@@ -57,6 +57,7 @@ const int cacheMag = 128;
 
 
 SndFileList SndFile::sndFiles;
+QMutex SndFile::cacheMutex;
 
 //---------------------------------------------------------
 //   SndFile
@@ -154,16 +155,16 @@ void SndFile::update(bool showProgress)
 //  create cache
 //---------------------------------------------------
 
-void SndFile::createCache(const QString& path, bool showProgress, bool bWrite, sf_count_t cstart)
+void SndFile::createCache(SampleVtype* c, sf_count_t size, bool showProgress, sf_count_t cstart)
 {
-   if(cstart >= csize)
+   if(cstart >= size)
       return;
    QProgressDialog* progress = 0;
    if (showProgress) {
       QString label(QWidget::tr("create peakfile for "));
       label += basename();
       progress = new QProgressDialog(label,
-                                     QString::null, 0, csize, 0);
+                                     QString::null, 0, size, 0);
       progress->setMinimumDuration(0);
       progress->show();
    }
@@ -171,38 +172,36 @@ void SndFile::createCache(const QString& path, bool showProgress, bool bWrite, s
    float* fp[channels()];
    for (unsigned k = 0; k < channels(); ++k)
       fp[k] = &data[k][0];
-   int interval = (csize - cstart) / 10;
+   int interval = (size - cstart) / 10;
 
    if(!interval)
       interval = 1;
-   for (int i = cstart; i < csize; i++) {
+   for (int i = cstart; i < size; i++) {
       if (showProgress && ((i % interval) == 0))
          progress->setValue(i);
       seek(i * cacheMag, 0);
       read(channels(), fp, cacheMag);
       for (unsigned ch = 0; ch < channels(); ++ch) {
          float rms = 0.0;
-         cache[ch][i].peak = 0;
+         c[ch][i].peak = 0;
          for (int n = 0; n < cacheMag; n++) {
             float fd = data[ch][n];
             rms += fd * fd;
             int idata = int(fd * 255.0);
             if (idata < 0)
                idata = -idata;
-            if (cache[ch][i].peak < idata)
-               cache[ch][i].peak = idata;
+            if (c[ch][i].peak < idata)
+               c[ch][i].peak = idata;
          }
          // amplify rms value +12dB
          int rmsValue = int((sqrt(rms/cacheMag) * 255.0));
          if (rmsValue > 255)
             rmsValue = 255;
-         cache[ch][i].rms = rmsValue;
+         c[ch][i].rms = rmsValue;
       }
    }
    if (showProgress)
-      progress->setValue(csize);
-   if(bWrite)
-      writeCache(path);
+      progress->setValue(size);
    if (showProgress)
       delete progress;
 
@@ -210,33 +209,45 @@ void SndFile::createCache(const QString& path, bool showProgress, bool bWrite, s
 
 //---------------------------------------------------------
 //   readCache
+//    The new cache is filled before it replaces the current
+//     one, which other threads may be reading meanwhile.
 //---------------------------------------------------------
 
 void SndFile::readCache(const QString& path, bool showProgress)
 {
-   if (cache) {
-      delete[] cache;
-   }
-   if (samples() == 0)
-      return;
-
-   csize = (samples() + cacheMag - 1)/cacheMag;
-   cache = new SampleVtype[channels()];
-   for (unsigned ch = 0; ch < channels(); ++ch)
+   SampleVtype* c = 0;
+   sf_count_t size = 0;
+   bool created = false;
+   if (samples() != 0)
    {
-      cache [ch].resize(csize);
-   }
-
-   FILE* cfile = fopen(path.toLocal8Bit().constData(), "r");
-   if (cfile) {
+      size = (samples() + cacheMag - 1)/cacheMag;
+      c = new SampleVtype[channels()];
       for (unsigned ch = 0; ch < channels(); ++ch)
-         fread(&cache[ch] [0], csize * sizeof(SampleV), 1, cfile);
-      fclose(cfile);
-      return;
+      {
+         c [ch].resize(size);
+      }
+
+      FILE* cfile = fopen(path.toLocal8Bit().constData(), "r");
+      if (cfile) {
+         for (unsigned ch = 0; ch < channels(); ++ch)
+            fread(&c[ch] [0], size * sizeof(SampleV), 1, cfile);
+         fclose(cfile);
+      }
+      else {
+         createCache(c, size, showProgress);
+         created = true;
+      }
    }
 
+   cacheMutex.lock();
+   SampleVtype* old = cache;
+   cache = c;
+   csize = size;
+   cacheMutex.unlock();
+   delete[] old;
 
-   createCache(path, showProgress, true);
+   if (created)
+      writeCache(path);
 }
 
 //---------------------------------------------------------
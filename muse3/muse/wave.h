@@ -29,6 +29,7 @@
 #include <sndfile.h>
 
 #include <QString>
+#include <QMutex>
 
 class QFileInfo;
 
@@ -36,6 +37,8 @@ namespace MusECore {
 
 class Event;
 
+extern const int cacheMag;    // Frames per peak file entry.
+
 class Xml;
 
 //---------------------------------------------------------
@@ -83,9 +86,13 @@ class SndFile {
       int getRefCount() { return refCount; }
 
       static SndFileList sndFiles;
+      // Held while a peak cache is reallocated. Threads other than the gui
+      //  must hold it while reading a peak cache.
+      static QMutex cacheMutex;
       static void applyUndoFile(const Event& original, const QString* tmpfile, unsigned sx, unsigned ex);
 
-      void createCache(const QString& path, bool showProgress, bool bWrite, sf_count_t cstart = 0);
+      // Fills c, which holds size entries per channel, from the sound file.
+      void createCache(SampleVtype* c, sf_count_t size, bool showProgress, sf_count_t cstart = 0);
       void readCache(const QString& path, bool progress);
 
       bool openRead(bool createCache=true, bool showProgress=true);        //!< returns true on error
@@ -555,11 +555,12 @@ void WaveCanvas::draw(QPainter& p, const QRect& r)
       // draw Canvas Items
       //---------------------------------------------------
 
-      iCItem to(items.lower_bound(x2));
+      std::vector<CItem*> visible;
+      itemsIn(r.adjusted(-rmapxDev(2) - 1, -rmapyDev(2) - 1, rmapxDev(2) + 1, rmapyDev(2) + 1), visible);
       
-      for(iCItem i = items.begin(); i != to; ++i)
+      for(std::vector<CItem*>::const_iterator i = visible.begin(); i != visible.end(); ++i)
       { 
-        CItem* ci = i->second;
+        CItem* ci = *i;
         // NOTE Optimization: For each item call this once now, then use cached results later via cachedHasHiddenEvents().
         // Not required for now.
         //ci->part()->hasHiddenEvents();
@@ -606,7 +607,7 @@ void WaveCanvas::draw(QPainter& p, const QRect& r)
       for(i = 0; i != sz; ++i) 
         drawItem(p, list4[i], r);
       
-      to = moving.lower_bound(x2);
+      iCItem to = moving.lower_bound(x2);
       for (iCItem i = moving.begin(); i != to; ++i) 
       {
             drawItem(p, i->second, r);
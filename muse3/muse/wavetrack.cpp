@@ -256,6 +256,8 @@ bool WaveTrack::closeAllParts()
 
 bool WaveTrack::getData(unsigned framePos, int channels, unsigned nframe, float** bp)
       {
+      // Input routes pulled below are charged to their own tracks.
+      DspLoadScope dsp_scope(&MusEGlobal::dspLoadProfiler, &_sourceLoad);
       bool have_data = false;
       if ((MusEGlobal::song->bounceTrack != this) && !noInRoute()) {
             have_data = AudioTrack::getData(framePos, channels, nframe, bp);
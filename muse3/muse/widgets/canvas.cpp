@@ -241,10 +241,12 @@ void Canvas::draw(QPainter& p, const QRect& rect)
             // draw Canvas Items
             //---------------------------------------------------
 
-            iCItem to(items.lower_bound(x2));
-            for(iCItem i = items.begin(); i != to; ++i)
+            // Some items draw a little outside their box.
+            std::vector<CItem*> visible;
+            itemsIn(rect.adjusted(-rmapxDev(2) - 1, -rmapyDev(2) - 1, rmapxDev(2) + 1, rmapyDev(2) + 1), visible);
+            for(std::vector<CItem*>::const_iterator i = visible.begin(); i != visible.end(); ++i)
             { 
-              CItem* ci = i->second;
+              CItem* ci = *i;
               // NOTE Optimization: For each item call this once now, then use cached results later via cachedHasHiddenEvents().
               // Not required for now.
               //ci->part()->hasHiddenEvents();
@@ -275,7 +277,7 @@ void Canvas::draw(QPainter& p, const QRect& rect)
               drawItem(p, list4[i], rect);
             
             // Draw items being moved, a special way in their original location.
-            to = moving.lower_bound(x2);
+            iCItem to = moving.lower_bound(x2);
             for (iCItem i = moving.begin(); i != to; ++i) 
                   drawItem(p, i->second, rect);
 
@@ -330,9 +332,11 @@ void Canvas::draw(QPainter& p, const QRect& rect)
             // draw Canvas Items
             //---------------------------------------------------
             
-            for(iCItem i = items.begin(); i != items.end(); ++i)
+            std::vector<CItem*> visible;
+            itemsIn(new_rect, visible);
+            for(std::vector<CItem*>::const_iterator i = visible.begin(); i != visible.end(); ++i)
             { 
-              CItem* ci = i->second;
+              CItem* ci = *i;
               // NOTE Optimization: For each item call this once now, then use cached results later via cachedHasHiddenEvents().
               // Not required for now.
               //ci->part()->hasHiddenEvents();
@@ -1486,6 +1490,24 @@ void Canvas::viewMouseReleaseEvent(QMouseEvent* event)
       mouseRelease(pos);
 }
 
+//---------------------------------------------------------
+//   itemsIn
+//---------------------------------------------------------
+
+void Canvas::itemsIn(const QRect& r, std::vector<CItem*>& list) const
+      {
+      if (virt()) {
+            items.query(r, list);
+            return;
+            }
+      // Items are drawn around their position with a box in pixels.
+      //  Widen the rectangle by the largest box, in virtual units.
+      const QRect ext = items.extents();
+      const int mx = qMax(qAbs(rmapxDev(ext.left())), qAbs(rmapxDev(ext.right() + 1))) + 1;
+      const int my = qMax(qAbs(rmapyDev(ext.top())), qAbs(rmapyDev(ext.bottom() + 1))) + 1;
+      items.query(r.adjusted(-mx, -my, mx, my), list, true);
+      }
+
 //---------------------------------------------------------
 //   selectLasso
 //---------------------------------------------------------
@@ -1493,25 +1515,27 @@ void Canvas::viewMouseReleaseEvent(QMouseEvent* event)
 void Canvas::selectLasso(bool toggle)
       {
       int n = 0;
+      std::vector<CItem*> list;
+      itemsIn(lasso, list);
       if (virt()) {
-            for (iCItem i = items.begin(); i != items.end(); ++i) {
-                  if (i->second->intersects(lasso)) {
-                        selectItem(i->second, !(toggle && i->second->isSelected()));
+            for (std::vector<CItem*>::const_iterator i = list.begin(); i != list.end(); ++i) {
+                  if ((*i)->intersects(lasso)) {
+                        selectItem(*i, !(toggle && (*i)->isSelected()));
                         ++n;
                         }
                   }
             }
       else {
-            for (iCItem i = items.begin(); i != items.end(); ++i) {
-                  QRect box = i->second->bbox();
+            for (std::vector<CItem*>::const_iterator i = list.begin(); i != list.end(); ++i) {
+                  QRect box = (*i)->bbox();
                   int x = rmapxDev(box.x());
                   int y = rmapyDev(box.y());
                   int w = rmapxDev(box.width());
                   int h = rmapyDev(box.height());
                   QRect r(x, y, w, h);
-                  r.translate(i->second->pos().x(), i->second->pos().y());
+                  r.translate((*i)->pos().x(), (*i)->pos().y());
                   if (r.intersects(lasso)) {
-                        selectItem(i->second, !(toggle && i->second->isSelected()));
+                        selectItem(*i, !(toggle && (*i)->isSelected()));
                         ++n;
                         }
                   }
@@ -1599,21 +1623,23 @@ CItem *Canvas::findCurrentItem(const QPoint &cStart)
    if (virt())
       item = items.find(cStart);
    else {
-      for (ciCItem i = items.begin(); i != items.end(); ++i) {
-         QRect box = i->second->bbox();
+      std::vector<CItem*> list;
+      itemsIn(QRect(cStart, QSize(1, 1)), list);
+      for (std::vector<CItem*>::const_iterator i = list.begin(); i != list.end(); ++i) {
+         QRect box = (*i)->bbox();
          int x = rmapxDev(box.x());
          int y = rmapyDev(box.y());
          int w = rmapxDev(box.width());
          int h = rmapyDev(box.height());
          QRect r(x, y, w, h);
-         r.translate(i->second->pos().x(), i->second->pos().y());
+         r.translate((*i)->pos().x(), (*i)->pos().y());
          if (r.contains(cStart)) {
-            if(i->second->isSelected())
-              return i->second;
+            if((*i)->isSelected())
+              return *i;
             else
             {
               if(!item)
-                item = i->second;
+                item = *i;
             }
          }
       }
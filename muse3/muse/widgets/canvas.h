@@ -205,6 +205,8 @@ class Canvas : public View {
       virtual void endMoveItems(const QPoint&, DragType, int dir, bool rasterize = true) = 0;
 
       virtual void selectLasso(bool toggle);
+      // Items which may lie in the virtual rectangle r, in list order.
+      void itemsIn(const QRect& r, std::vector<CItem*>& list) const;
 
       virtual void itemPressed(const CItem*) {}
       virtual void itemReleased(const CItem*, const QPoint&) {}
@@ -24,14 +24,45 @@
 #include "citem.h"
 #include "undo.h"
 #include "song.h"
+#include "memory.h"
 #include <stdio.h>
+#include <new>
+#include <algorithm>
+#include <math.h>
+#include <limits.h>
 
 namespace MusEGui {
 
+// Largest object the pool handles, see Pool::alloc().
+static const size_t canvasItemPoolMax = 21 * sizeof(unsigned long);
+static Pool canvasItemPool;
+
+//---------------------------------------------------------
+//   operator new
+//   operator delete
+//---------------------------------------------------------
+
+void* CItem::operator new(size_t n)
+      {
+      if (n > canvasItemPoolMax)
+            return ::operator new(n);
+      return canvasItemPool.alloc(n);
+      }
+
+void CItem::operator delete(void* p, size_t n)
+      {
+      if (n > canvasItemPoolMax)
+            ::operator delete(p);
+      else
+            canvasItemPool.free(p, n);
+      }
+
 //---------------------------------------------------------
 //   CItem
 //---------------------------------------------------------
 
+unsigned CItem::_geometrySerial = 0;
+
 CItem::CItem()
       {
       _isMoving = false;
@@ -71,34 +102,199 @@ void CItem::setSelected(bool f)
       }
 
 //---------------------------------------------------------
-//   CItemList
+//   find
+//    Topmost item at pos, a selected one preferred.
 //---------------------------------------------------------
 
 CItem* CItemList::find(const QPoint& pos) const
       {
+      std::vector<CItem*> list;
+      query(QRect(pos, QSize(1, 1)), list);
       CItem* item = 0;
-      for (rciCItem i = rbegin(); i != rend(); ++i) {
-            if (i->second->contains(pos))
+      for (std::vector<CItem*>::const_reverse_iterator i = list.rbegin(); i != list.rend(); ++i) {
+            if ((*i)->contains(pos))
             {
-              if(i->second->isSelected()) 
-                  return i->second;
+              if((*i)->isSelected()) 
+                  return *i;
               
               else
               {
                 if(!item)
-                  item = i->second;    
+                  item = *i;    
               }  
             }      
           }
       return item;
       }
 
+//---------------------------------------------------------
+//   buildIndex
+//    Sort-tile-recursive packing: the entries are cut into
+//     vertical slices by x, each slice sorted by y and cut
+//     into leaves, the nodes above group their neighbours.
+//---------------------------------------------------------
+
+enum { CITEM_INDEX_FANOUT = 16, CITEM_INDEX_MIN_ITEMS = 64 };
+
+bool CItemList::entryLessX(const IndexEntry& a, const IndexEntry& b)
+      {
+      return a.x1 < b.x1;
+      }
+
+bool CItemList::entryLessY(const IndexEntry& a, const IndexEntry& b)
+      {
+      return a.y1 < b.y1;
+      }
+
+void CItemList::buildIndex(bool byPos) const
+      {
+      _indexValid  = true;
+      _indexByPos  = byPos;
+      _indexSerial = CItem::geometrySerial();
+      _entries.clear();
+      _levels.clear();
+      _extents = QRect();
+
+      _entries.reserve(size());
+      int order = 0;
+      for (ciCItem i = begin(); i != end(); ++i, ++order) {
+            CItem* item = i->second;
+            const QRect r = item->bbox().normalized();
+            _extents |= r;
+            IndexEntry e;
+            if (byPos) {
+                  e.x1 = e.x2 = item->pos().x();
+                  e.y1 = e.y2 = item->pos().y();
+                  }
+            else {
+                  // One unit of margin, empty boxes are still hit by their edges.
+                  e.x1 = r.left() - 1;
+                  e.x2 = r.right() + 1;
+                  e.y1 = r.top() - 1;
+                  e.y2 = r.bottom() + 1;
+                  }
+            e.order = order;
+            e.item  = item;
+            _entries.push_back(e);
+            }
+      if (int(_entries.size()) < CITEM_INDEX_MIN_ITEMS)
+            return;
+
+      std::sort(_entries.begin(), _entries.end(), entryLessX);
+      const int n      = _entries.size();
+      const int leaves = (n + CITEM_INDEX_FANOUT - 1) / CITEM_INDEX_FANOUT;
+      const int slice  = int(ceil(sqrt(double(leaves)))) * CITEM_INDEX_FANOUT;
+      for (int s = 0; s < n; s += slice)
+            std::sort(_entries.begin() + s, _entries.begin() + std::min(s + slice, n), entryLessY);
+
+      // Leaves over the entries.
+      _levels.push_back(std::vector<IndexNode>());
+      for (int first = 0; first < n; first += CITEM_INDEX_FANOUT) {
+            IndexNode node;
+            node.first = first;
+            node.last  = std::min(first + CITEM_INDEX_FANOUT, n);
+            node.x1 = node.y1 = INT_MAX;
+            node.x2 = node.y2 = INT_MIN;
+            for (int k = node.first; k < node.last; ++k) {
+                  const IndexEntry& e = _entries[k];
+                  node.x1 = std::min(node.x1, e.x1);
+                  node.y1 = std::min(node.y1, e.y1);
+                  node.x2 = std::max(node.x2, e.x2);
+                  node.y2 = std::max(node.y2, e.y2);
+                  }
+            _levels.back().push_back(node);
+            }
+      // Inner levels up to a single root.
+      while (_levels.back().size() > 1) {
+            const std::vector<IndexNode> below = _levels.back();
+            const int nb = below.size();
+            std::vector<IndexNode> level;
+            for (int first = 0; first < nb; first += CITEM_INDEX_FANOUT) {
+                  IndexNode node;
+                  node.first = first;
+                  node.last  = std::min(first + CITEM_INDEX_FANOUT, nb);
+                  node.x1 = node.y1 = INT_MAX;
+                  node.x2 = node.y2 = INT_MIN;
+                  for (int k = node.first; k < node.last; ++k) {
+                        node.x1 = std::min(node.x1, below[k].x1);
+                        node.y1 = std::min(node.y1, below[k].y1);
+                        node.x2 = std::max(node.x2, below[k].x2);
+                        node.y2 = std::max(node.y2, below[k].y2);
+                        }
+                  level.push_back(node);
+                  }
+            _levels.push_back(level);
+            }
+      }
+
+//---------------------------------------------------------
+//   query
+//---------------------------------------------------------
+
+void CItemList::query(const QRect& rect, std::vector<CItem*>& list, bool byPos) const
+      {
+      if (!_indexValid || _indexByPos != byPos || _indexSerial != CItem::geometrySerial())
+            buildIndex(byPos);
+
+      // Small lists are not worth it, the caller tests all items.
+      if (_levels.empty()) {
+            for (std::vector<IndexEntry>::const_iterator i = _entries.begin(); i != _entries.end(); ++i)
+                  list.push_back(i->item);
+            return;
+            }
+
+      const QRect r = rect.normalized();
+      const int x1 = r.left(), x2 = r.right(), y1 = r.top(), y2 = r.bottom();
+      std::vector<std::pair<int, CItem*> > found;
+
+      // Depth first, (level, node) pairs.
+      std::vector<std::pair<int, int> > stack;
+      const int top = _levels.size() - 1;
+      for (int k = 0; k < int(_levels[top].size()); ++k)
+            stack.push_back(std::pair<int, int>(top, k));
+      while (!stack.empty()) {
+            const int level = stack.back().first;
+            const IndexNode& node = _levels[level][stack.back().second];
+            stack.pop_back();
+            if (node.x1 > x2 || node.x2 < x1 || node.y1 > y2 || node.y2 < y1)
+                  continue;
+            if (level == 0) {
+                  for (int k = node.first; k < node.last; ++k) {
+                        const IndexEntry& e = _entries[k];
+                        if (e.x1 <= x2 && e.x2 >= x1 && e.y1 <= y2 && e.y2 >= y1)
+                              found.push_back(std::pair<int, CItem*>(e.order, e.item));
+                        }
+                  }
+            else {
+                  for (int k = node.first; k < node.last; ++k)
+                        stack.push_back(std::pair<int, int>(level - 1, k));
+                  }
+            }
+
+      // Back into list order, which is also the drawing order.
+      std::sort(found.begin(), found.end());
+      for (std::vector<std::pair<int, CItem*> >::const_iterator i = found.begin(); i != found.end(); ++i)
+            list.push_back(i->second);
+      }
+
+//---------------------------------------------------------
+//   extents
+//---------------------------------------------------------
+
+QRect CItemList::extents() const
+      {
+      if (!_indexValid || _indexSerial != CItem::geometrySerial())
+            buildIndex(_indexByPos);
+      return _extents;
+      }
+
 //---------------------------------------------------------
 //   CItemList
 //---------------------------------------------------------
 
 void CItemList::add(CItem* item)
       {
+      _indexValid = false;
       std::multimap<int, CItem*, std::less<int> >::insert(std::pair<const int, CItem*> (item->bbox().x(), item));
       }
 
@@ -24,6 +24,7 @@
 #define __CITEM_H__
 
 #include <map>
+#include <vector>
 #include <QPoint>
 #include <QRect>
 
@@ -44,6 +45,7 @@ class CItem {
    private:
       MusECore::Event _event;
       MusECore::Part* _part;
+      static unsigned _geometrySerial;   // Bumped by any position or size change.
 
    protected:
       bool _isMoving;
@@ -57,6 +59,12 @@ class CItem {
       // Changed by Tim. p3.3.20
       //CItem(MusECore::Event e, MusECore::Part* p);
       CItem(const MusECore::Event& e, MusECore::Part* p);
+      virtual ~CItem() {}
+
+      // Items are created and deleted in bulk by the canvases,
+      //  they come from a pool. GUI thread only.
+      static void* operator new(size_t);
+      static void operator delete(void*, size_t);
 
       bool isMoving() const        { return _isMoving;  }
       void setMoving(bool f)       { _isMoving = f;     }
@@ -64,21 +72,22 @@ class CItem {
       void setSelected(bool f);
 
       int width() const            { return _bbox.width(); }
-      void setWidth(int l)         { _bbox.setWidth(l); }
-      void setHeight(int l)        { _bbox.setHeight(l); }
+      void setWidth(int l)         { _bbox.setWidth(l); ++_geometrySerial; }
+      void setHeight(int l)        { _bbox.setHeight(l); ++_geometrySerial; }
       void setMp(const QPoint&p)   { moving = p;    }
       const QPoint mp() const      { return moving; }
       int x() const                { return _pos.x(); }
       int y() const                { return _pos.y(); }
-      void setY(int y)             { _bbox.setY(y); }
+      void setY(int y)             { _bbox.setY(y); ++_geometrySerial; }
       QPoint pos() const           { return _pos; }
-      void setPos(const QPoint& p) { _pos = p;    }
+      void setPos(const QPoint& p) { _pos = p; ++_geometrySerial; }
       int height() const           { return _bbox.height(); }
       const QRect& bbox() const    { return _bbox; }
-      void setBBox(const QRect& r) { _bbox = r; }
+      void setBBox(const QRect& r) { _bbox = r; ++_geometrySerial; }
       void move(const QPoint& tl)  {
             _bbox.moveTopLeft(tl);
             _pos = tl;
+            ++_geometrySerial;
             }
       bool contains(const QPoint& p) const  { return _bbox.contains(p); }
       bool intersects(const QRect& r) const { return r.intersects(_bbox); }
@@ -87,6 +96,7 @@ class CItem {
       void setEvent(MusECore::Event& e)     { _event = e;     }
       MusECore::Part* part() const          { return _part; }
       void setPart(MusECore::Part* p)       { _part = p; }
+      static unsigned geometrySerial()      { return _geometrySerial; }
       };
 
 typedef std::multimap<int, CItem*, std::less<int> >::iterator iCItem;
@@ -99,9 +109,40 @@ typedef std::multimap<int, CItem*, std::less<int> >::const_reverse_iterator rciC
 //---------------------------------------------------------
 
 class CItemList: public std::multimap<int, CItem*, std::less<int> > {
+      // Spatial index: a packed R-tree over the item rectangles,
+      //  built on first query after the list or any item changed.
+      struct IndexEntry {
+            int x1, y1, x2, y2;     // inclusive, with a margin
+            int order;              // position in the list
+            CItem* item;
+            };
+      struct IndexNode {
+            int x1, y1, x2, y2;
+            int first, last;        // range of entries or of nodes one level down
+            };
+      mutable std::vector<IndexEntry> _entries;
+      mutable std::vector<std::vector<IndexNode> > _levels;
+      mutable QRect _extents;
+      mutable bool _indexValid;
+      mutable bool _indexByPos;
+      mutable unsigned _indexSerial;
+
+      static bool entryLessX(const IndexEntry&, const IndexEntry&);
+      static bool entryLessY(const IndexEntry&, const IndexEntry&);
+      void buildIndex(bool byPos) const;
+
    public:
+      CItemList() : _indexValid(false), _indexByPos(false), _indexSerial(0) { }
       void add(CItem*);
+      void erase(iterator i)              { _indexValid = false; std::multimap<int, CItem*, std::less<int> >::erase(i); }
+      void erase(iterator a, iterator b)  { _indexValid = false; std::multimap<int, CItem*, std::less<int> >::erase(a, b); }
+      void clear()                        { _indexValid = false; std::multimap<int, CItem*, std::less<int> >::clear(); }
       CItem* find(const QPoint& pos) const;
+      // Candidates in list order: items whose bounding box (byPos false) or
+      //  position (byPos true) may lie in r. Callers still test each item.
+      void query(const QRect& r, std::vector<CItem*>& list, bool byPos = false) const;
+      // Union of the item bounding boxes.
+      QRect extents() const;
       void clearDelete() {
             for (iCItem i = begin(); i != end(); ++i)
                   delete i->second;
@@ -154,7 +154,10 @@ void GlobalSettingsConfig::updateSettings()
             }
 
       autoSaveCheckBox->setChecked(MusEGlobal::config.autoSave);
+      autoSaveIntervalSpinBox->setValue(MusEGlobal::config.autoSaveInterval);
       scrollableSubmenusCheckbox->setChecked(MusEGlobal::config.scrollableSubMenus);
+      compactEventsCheckBox->setChecked(MusEGlobal::config.compactEventEncoding);
+      undoMemoryLimitSpinBox->setValue(MusEGlobal::config.undoMemoryLimit);
       liveWaveUpdateCheckBox->setChecked(MusEGlobal::config.liveWaveUpdate);
       warnIfBadTimingCheckBox->setChecked(MusEGlobal::config.warnIfBadTiming);      
       warnOnFileVersionsCheckBox->setChecked(MusEGlobal::config.warnOnFileVersions);
@@ -340,7 +343,10 @@ void GlobalSettingsConfig::apply()
       MusEGlobal::config.mixer2.geometry.setHeight(mixer2H->value());
 
       MusEGlobal::config.autoSave = autoSaveCheckBox->isChecked();
+      MusEGlobal::config.autoSaveInterval = autoSaveIntervalSpinBox->value();
       MusEGlobal::config.scrollableSubMenus = scrollableSubmenusCheckbox->isChecked();
+      MusEGlobal::config.compactEventEncoding = compactEventsCheckBox->isChecked();
+      MusEGlobal::config.undoMemoryLimit = undoMemoryLimitSpinBox->value();
       MusEGlobal::config.liveWaveUpdate = liveWaveUpdateCheckBox->isChecked();
       MusEGlobal::config.showSplashScreen = showSplash->isChecked();
       MusEGlobal::config.showDidYouKnow   = showDidYouKnow->isChecked();
@@ -26,6 +26,8 @@
 
 #include <cmath>
 
+#include <QApplication>
+#include <QElapsedTimer>
 #include <QMouseEvent>
 #include <QPainter>
 #include <QResizeEvent>
@@ -45,6 +47,86 @@
 
 namespace MusEGui {
 
+//---------------------------------------------------------
+//   MeterScheduler
+//---------------------------------------------------------
+
+MeterScheduler::MeterScheduler(QObject* parent)
+   : QObject(parent)
+      {
+      _next = 0;
+      connect(&_timer, SIGNAL(timeout()), this, SLOT(step()));
+      }
+
+MeterScheduler* MeterScheduler::instance()
+      {
+      static MeterScheduler* scheduler = 0;
+      if(!scheduler)
+        scheduler = new MeterScheduler(qApp);
+      return scheduler;
+      }
+
+void MeterScheduler::add(Meter* m)
+      {
+      if(!m->_scheduled)
+      {
+        m->_scheduled = true;
+        _meters.push_back(m);
+      }
+      if(!_timer.isActive())
+        _timer.start(1000/std::max(30, MusEGlobal::config.guiRefresh));
+      }
+
+void MeterScheduler::remove(Meter* m)
+      {
+      if(!m->_scheduled)
+        return;
+      m->_scheduled = false;
+      std::vector<Meter*>::iterator im = std::find(_meters.begin(), _meters.end(), m);
+      if(im != _meters.end())
+        _meters.erase(im);
+      if(_meters.empty())
+        _timer.stop();
+      }
+
+//---------------------------------------------------------
+//   step
+//    Continue where the last step ran out of time, so
+//     every meter gets its turn.
+//---------------------------------------------------------
+
+void MeterScheduler::step()
+      {
+      const qint64 budget = _timer.interval() / 2;
+      QElapsedTimer elapsed;
+      elapsed.start();
+
+      std::vector<Meter*>::size_type i = _next;
+      for(std::vector<Meter*>::size_type n = _meters.size(); n != 0; --n)
+      {
+        if(i >= _meters.size())
+          i = 0;
+        Meter* m = _meters[i];
+        bool falling = false;
+        if(m->isVisible() && !m->visibleRegion().isEmpty())
+          falling = m->updateTargetMeterValue();
+        else
+          m->settle();
+        if(falling)
+          ++i;
+        else
+        {
+          m->_scheduled = false;
+          _meters.erase(_meters.begin() + i);
+        }
+        if(elapsed.elapsed() >= budget)
+          break;
+      }
+      _next = i;
+      if(_meters.empty())
+        _timer.stop();
+      }
+
 //---------------------------------------------------------
 //   Meter
 //---------------------------------------------------------
@@ -77,6 +159,7 @@ Meter::Meter(QWidget* parent, MeterType type)
       setStyleSheet("font: 9px \"Sans\"; ");
       
       mtype = type;
+      _scheduled  = false;
       _showText   = false;
       overflow    = false;
       cur_yv      = -1;     // Flag as -1 to initialize in paint.
@@ -149,11 +232,14 @@ Meter::Meter(QWidget* parent, MeterType type)
       maskGrad.setColorAt(0.5, mask_center);
       maskGrad.setColorAt(1, mask_edge);
 
-      connect(&fallingTimer, SIGNAL(timeout()), this, SLOT(updateTargetMeterValue()));
-
 //       updateText(targetVal);
       }
 
+Meter::~Meter()
+      {
+      MeterScheduler::instance()->remove(this);
+      }
+
 //---------------------------------------------------------
 //   updateText
 //---------------------------------------------------------
@@ -238,16 +324,30 @@ void Meter::setVal(double v, double max, bool ovl)
       if(ud || (maxVal != max))
       {
          targetMaxVal = max;
-         if(!fallingTimer.isActive())
-         {
-            fallingTimer.start(1000/std::max(30, MusEGlobal::config.guiRefresh));
-         }
+         MeterScheduler::instance()->add(this);
       }
       
 
 }
 
-void Meter::updateTargetMeterValue()
+//---------------------------------------------------------
+//   settle
+//---------------------------------------------------------
+
+void Meter::settle()
+{
+   val = targetVal;
+   targetValStep = 0;
+   if(maxVal != targetMaxVal)
+   {
+     maxVal = targetMaxVal;
+     if(_showText)
+       updateText((mtype == DBMeter) ? (MusECore::fast_log10(maxVal) * 20.0) : maxVal);
+   }
+   cur_yv = -1;  // Force re-initialization.
+}
+
+bool Meter::updateTargetMeterValue()
 {
    double range = maxScale - minScale;
    int fw = frameWidth();
@@ -316,11 +416,7 @@ void Meter::updateTargetMeterValue()
        update(QRect(fw, y1, w, y2 - y1 + 1));
        //repaint(QRect(fw, y1, w, y2 - y1 + 1));
    }
-   if(!ud)
-   {
-      fallingTimer.stop();
-   }
-
+   return ud;
 }
 
 
@@ -29,6 +29,7 @@
 
 #include <QFrame>
 #include <QTimer>
+#include <vector>
 
 class QResizeEvent;
 class QMouseEvent;
@@ -41,6 +42,33 @@ class QFont;
 
 namespace MusEGui {
 
+class Meter;
+
+//---------------------------------------------------------
+//   MeterScheduler
+//    Steps all falling meters from a single timer instead
+//     of one timer per meter. Hidden meters jump to their
+//     target, and a step never takes more than half the
+//     timer interval so the rest of the gui keeps up.
+//---------------------------------------------------------
+
+class MeterScheduler : public QObject {
+    Q_OBJECT
+      QTimer _timer;
+      std::vector<Meter*> _meters;
+      // Where the last step ran out of time.
+      std::vector<Meter*>::size_type _next;
+
+   private slots:
+      void step();
+
+   public:
+      MeterScheduler(QObject* parent = 0);
+      static MeterScheduler* instance();
+      void add(Meter*);
+      void remove(Meter*);
+      };
+
 class Meter : public QFrame {
     Q_OBJECT
    public:
@@ -108,18 +136,24 @@ class Meter : public QFrame {
 
       void drawVU(QPainter& p, const QRect&, const QPainterPath&, int);
 
-      QTimer fallingTimer;
+      // Whether the meter is in the MeterScheduler's list.
+      bool _scheduled;
+      // Go to the target values at once, to be painted when next shown.
+      void settle();
+      friend class MeterScheduler;
 
    public slots:
       void resetPeaks();
       void setVal(double, double, bool);
-      void updateTargetMeterValue();
+      // Returns whether the meter is still falling.
+      bool updateTargetMeterValue();
 
    signals:
       void mousePress();      
 
    public:
       Meter(QWidget* parent, MeterType type = DBMeter);
+      virtual ~Meter();
       void setRange(double min, double max);
 
       bool showText() const { return _showText; }
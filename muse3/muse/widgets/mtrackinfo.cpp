@@ -914,7 +914,7 @@ void MidiTrackInfo::iLautstChanged(int val)
           MusECore::ME_CONTROLLER, MusECore::CTRL_VOLUME, val);
         MusEGlobal::audio->msgPlayMidiEvent(&ev);
       }  
-      MusEGlobal::song->update(SC_MIDI_CONTROLLER);
+      MusEGlobal::song->scheduleUpdate(SC_MIDI_CONTROLLER, track, MusECore::CTRL_VOLUME);
     }
 
 //---------------------------------------------------------
@@ -1009,7 +1009,7 @@ void MidiTrackInfo::iPanChanged(int val)
           MusECore::ME_CONTROLLER, MusECore::CTRL_PANPOT, val);
         MusEGlobal::audio->msgPlayMidiEvent(&ev);
       }  
-      MusEGlobal::song->update(SC_MIDI_CONTROLLER);
+      MusEGlobal::song->scheduleUpdate(SC_MIDI_CONTROLLER, track, MusECore::CTRL_PANPOT);
     }
 
 //---------------------------------------------------------
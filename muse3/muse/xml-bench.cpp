@@ -0,0 +1,501 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  xml-bench.cpp
+//    Tokenize song files with the Xml parser and with the
+//    line based one it replaced, and report the times. The
+//    token checksums tell whether both read the same.
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <QByteArray>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+#include "xml.h"
+
+#ifndef XML_BENCH_DEMOS
+#define XML_BENCH_DEMOS "demos"
+#endif
+
+namespace {
+
+//---------------------------------------------------------
+//   OldXml
+//    The tokenizer of Xml before it read the whole file at
+//     once: 512 byte lines through fgets, tokens built one
+//     character at a time. Only parse() is kept.
+//---------------------------------------------------------
+
+class OldXml {
+      FILE* f;
+      int _line;
+      int _col;
+      QString _s1, _s2, _tag;
+      int level;
+      bool inTag;
+      int c;            // current char
+      char lbuffer[512];
+      const char* bufptr;
+
+      void next();
+      void nextc();
+      void token(int);
+      void stoken();
+      QString strip(const QString& s);
+
+   public:
+      OldXml(FILE*);
+      MusECore::Xml::Token parse();
+      const QString& s1() { return _s1; }
+      const QString& s2() { return _s2; }
+      };
+
+OldXml::OldXml(FILE* _f)
+      {
+      f          = _f;
+      _line      = 0;
+      _col       = 0;
+      level      = 0;
+      inTag      = false;
+      lbuffer[0] = 0;
+      bufptr     = lbuffer;
+      }
+
+void OldXml::next()
+      {
+      if (*bufptr == 0) {
+            if (f == 0 || fgets(lbuffer, 512, f) == 0) {
+                  c = EOF;
+                  return;
+                  }
+            bufptr = lbuffer;
+            }
+      c = *bufptr++;
+      if (c == '\n') {
+            ++_line;
+            _col = -1;
+            }
+      ++_col;
+      }
+
+void OldXml::nextc()
+      {
+      next();
+      while (c == ' ' || c == '\t' || c == '\n')
+            next();
+      }
+
+void OldXml::token(int cc)
+      {
+      QByteArray buffer;
+
+      int i = 0;
+      for (; i < 9999999;) {
+            if (c == ' ' || c == '\t' || c == cc || c == '\n' || c == EOF)
+                  break;
+            buffer[i++] = c;
+            next();
+            }
+      buffer[i] = 0;
+      _s2 = buffer;
+      }
+
+void OldXml::stoken()
+      {
+      QByteArray buffer;
+
+      int i = 0;
+      buffer[i] = c;
+      ++i;
+      next();
+
+      for (;i < 10000000*4-1;) {
+            if (c == '"') {
+                  buffer[i++] = c;
+                  next();
+                  break;
+                  }
+            if (c == '&') {
+                  char entity[6];
+                  int k = 0;
+                  for (; k < 6; ++k) {
+                        next();
+                        if (c == EOF)
+                             break;
+                        else if (c == ';') {
+                              entity[k] = 0;
+                              if (strcmp(entity, "quot") == 0)
+                                    c = '"';
+                              else if (strcmp(entity, "amp") == 0)
+                                    c = '&';
+                              else if (strcmp(entity, "lt") == 0)
+                                    c = '<';
+                              else if (strcmp(entity, "gt") == 0)
+                                    c = '>';
+                              else if (strcmp(entity, "apos") == 0)
+                                    c = '\'';
+                              else
+                                    entity[k] = c;
+                              break;
+                              }
+                        else
+                              entity[k] = c;
+                        }
+                  if (c == EOF || k == 6) {
+                        int n = 0;
+                        buffer[i++] = '&';
+                        for (;(i < 511) && (n < k); ++i, ++n)
+                              buffer[i] = entity[n];
+                        }
+                  else
+                        buffer[i++] = c;
+                  }
+            else if(c != EOF)
+              buffer[i++] = c;
+            if (c == EOF)
+                  break;
+            next();
+            }
+      buffer[i] = 0;
+      _s2 = buffer;
+      }
+
+QString OldXml::strip(const QString& s)
+      {
+      int l = s.length();
+      if (l >= 2 && s[0] == '"')
+            return s.mid(1, l-2);
+      return s;
+      }
+
+MusECore::Xml::Token OldXml::parse()
+      {
+      QByteArray buffer;
+      int idx = 0;
+
+ again:
+      bool endFlag = false;
+      nextc();
+      if (c == EOF)
+            return level == 0 ? MusECore::Xml::End : MusECore::Xml::Error;
+
+      _s1 = QString("");
+      if (inTag) {
+            if (c == '/') {
+                  nextc();
+                  token('>');
+                  if (c != '>')
+                        goto error;
+                  _s1   = _tag;
+                  inTag = false;
+                  --level;
+                  return MusECore::Xml::TagEnd;
+                  }
+            _s2 = QString("");
+            token('=');
+            _s1 = _s2;
+            nextc();      // skip space
+            if (c == '"')
+                  stoken();
+            else
+                  token('>');
+            if (c == '>')
+                  inTag = false;
+            else
+                  --bufptr;
+            _s2 = strip(_s2);
+            return MusECore::Xml::Attribut;
+            }
+      if (c == '<') {
+            next();
+            if (c == '/') {
+                  endFlag = true;
+                  next();
+                  }
+            if (c == '?') {
+                  next();
+                  idx = 0;
+                  for (;;) {
+                        if (c == '?' || c == EOF || c == '>')
+                              break;
+                        buffer[idx++] = c;
+                        next();
+                        }
+                  buffer[idx] = 0;
+                  _s1 = QString(buffer);
+                  if (c == EOF)
+                        goto error;
+                  nextc();
+                  if (c != '>')
+                        goto error;
+                  next();
+                  return MusECore::Xml::Proc;
+                  }
+            else if (c == '!') {    // process comment
+                  bool endc = false;
+                  for(;;) {
+                        next();
+                        if (c == '>' && endc)
+                              break;
+                        endc = c == '-';
+                        if (c == EOF)
+                              goto error;
+                        }
+                  goto again;
+                  }
+            idx = 0;
+            for (;;) {
+                  if (c == '/' || c == ' ' || c == '\t' || c == '>' || c == '\n' || c == EOF)
+                        break;
+                  buffer[idx++] = c;
+                  next();
+                  }
+            buffer[idx] = 0;
+            _s1 = QString(buffer);
+            while (c == ' ' || c == '\t' || c == '\n')
+                  next();
+            if (c == '/') {
+                  nextc();
+                  if (c == '>')
+                        return MusECore::Xml::Flag;
+                  goto error;
+                  }
+            if (c == '?') {
+                  nextc();
+                  if (c == '>')
+                        return MusECore::Xml::Proc;
+                  goto error;
+                  }
+            if (c == '>') {
+                  if (endFlag) {
+                        --level;
+                        return MusECore::Xml::TagEnd;
+                        }
+                  else {
+                        ++level;
+                        return MusECore::Xml::TagStart;
+                        }
+                  }
+            else {
+                  _tag = _s1;
+                  --bufptr;
+                  inTag = true;
+                  ++level;
+                  if (!endFlag)
+                        return MusECore::Xml::TagStart;
+                  goto error;
+                  }
+            }
+      else {
+            if (level == 0)
+                  goto error;
+            idx = 0;
+            for (;;) {
+                  if (c == EOF || c == '<')
+                        break;
+                  if (c == '&') {
+                        next();
+                        if (c == '<') {         // be tolerant with old muse files
+                              buffer[idx++] = '&';
+                              continue;
+                              }
+                        QByteArray name;
+                        int name_idx = 0;
+                        name[name_idx++] = c;
+                        for (; name_idx < 9999999;) {
+                              next();
+                              if (c == ';')
+                                    break;
+                              name[name_idx++] = c;
+                              }
+                        name[name_idx] = 0;
+                        if (strcmp(name, "lt") == 0)
+                              c = '<';
+                        else if (strcmp(name, "gt") == 0)
+                              c = '>';
+                        else if (strcmp(name, "apos") == 0)
+                              c = '\'';
+                        else if (strcmp(name, "quot") == 0)
+                              c = '"';
+                        else if (strcmp(name, "amp") == 0)
+                              c = '&';
+                        else
+                              c = '?';
+                        }
+                  buffer[idx++] = c;
+                  next();
+                  }
+            buffer[idx] = 0;
+            _s1 = QString(buffer);
+            if (c == '<')
+                  --bufptr;
+            return MusECore::Xml::Text;
+            }
+error:
+      fprintf(stderr, "OldXml Parse Error at line %d col %d\n", _line, _col+1);
+      return MusECore::Xml::Error;
+      }
+
+} // anonymous namespace
+
+//---------------------------------------------------------
+//   now
+//---------------------------------------------------------
+
+static double now()
+      {
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return ts.tv_sec + ts.tv_nsec * 1e-9;
+      }
+
+//---------------------------------------------------------
+//   tokenize
+//    Read a song file the way MusE does, up to the end of
+//     the <muse> tag. Returns the time taken, the number of
+//     tokens and a checksum of them, or a negative time if
+//     the file can't be read.
+//---------------------------------------------------------
+
+template <class X> static double tokenize(const QString& path, int* tokens, uint* sum)
+      {
+      FILE* f = fopen(path.toLocal8Bit().constData(), "r");
+      if (!f)
+            return -1.0;
+      double start = now();
+      X xml(f);
+      *tokens = 0;
+      *sum    = 0;
+      for (;;) {
+            MusECore::Xml::Token token = xml.parse();
+            if (token == MusECore::Xml::Error || token == MusECore::Xml::End)
+                  break;
+            ++*tokens;
+            *sum = *sum * 31 + token;
+            *sum = *sum * 31 + qHash(xml.s1());
+            if (token == MusECore::Xml::Attribut)
+                  *sum = *sum * 31 + qHash(xml.s2());
+            if (token == MusECore::Xml::TagEnd && xml.s1() == "muse")
+                  break;
+            }
+      double t = now() - start;
+      fclose(f);
+      return t;
+      }
+
+//---------------------------------------------------------
+//   usage
+//---------------------------------------------------------
+
+static void usage(const char* name)
+      {
+      fprintf(stderr,
+         "usage: %s [-r runs] [file or directory ...]\n"
+         "   tokenize song files with the old and the new Xml parser,\n"
+         "   best of 'runs' (default 20). Directories are searched for\n"
+         "   *.med files, default %s\n",
+         name, XML_BENCH_DEMOS);
+      }
+
+//---------------------------------------------------------
+//   main
+//---------------------------------------------------------
+
+int main(int argc, char* argv[])
+      {
+      int runs = 20;
+      QStringList args;
+      for (int i = 1; i < argc; ++i) {
+            if (!strcmp(argv[i], "-r") && i + 1 < argc)
+                  runs = atoi(argv[++i]);
+            else if (argv[i][0] == '-') {
+                  usage(argv[0]);
+                  return 1;
+                  }
+            else
+                  args.append(QString::fromLocal8Bit(argv[i]));
+            }
+      if (runs <= 0) {
+            usage(argv[0]);
+            return 1;
+            }
+      if (args.isEmpty())
+            args.append(QString(XML_BENCH_DEMOS));
+
+      QStringList files;
+      for (int i = 0; i < args.size(); ++i) {
+            QFileInfo fi(args[i]);
+            if (!fi.isDir()) {
+                  files.append(args[i]);
+                  continue;
+                  }
+            QDir dir(args[i]);
+            QStringList med = dir.entryList(QStringList("*.med"), QDir::Files, QDir::Name);
+            for (int k = 0; k < med.size(); ++k)
+                  files.append(dir.filePath(med[k]));
+            }
+      if (files.isEmpty()) {
+            fprintf(stderr, "xml-bench: no song files found\n");
+            return 1;
+            }
+
+      printf("%-32s %10s %8s %10s %10s %8s  %s\n", "file", "bytes", "tokens", "old ms", "new ms", "speedup", "same");
+      double oldTotal = 0.0, newTotal = 0.0;
+      bool allSame = true;
+      for (int i = 0; i < files.size(); ++i) {
+            const QString& path = files[i];
+            double oldBest = 0.0, newBest = 0.0;
+            int oldTokens = 0, newTokens = 0;
+            uint oldSum = 0, newSum = 0;
+            bool ok = true;
+            for (int r = 0; r < runs && ok; ++r) {
+                  // Alternate, so that neither gets a warmer cache.
+                  double t = tokenize<OldXml>(path, &oldTokens, &oldSum);
+                  ok = t >= 0.0;
+                  if (ok && (r == 0 || t < oldBest))
+                        oldBest = t;
+                  t = tokenize<MusECore::Xml>(path, &newTokens, &newSum);
+                  if (ok && (r == 0 || t < newBest))
+                        newBest = t;
+                  }
+            if (!ok) {
+                  fprintf(stderr, "xml-bench: can't read %s\n", path.toLocal8Bit().constData());
+                  continue;
+                  }
+            const bool same = oldTokens == newTokens && oldSum == newSum;
+            allSame = allSame && same;
+            oldTotal += oldBest;
+            newTotal += newBest;
+            printf("%-32s %10lld %8d %10.3f %10.3f %7.1fx  %s\n",
+               QFileInfo(path).fileName().toLocal8Bit().constData(), (long long)QFileInfo(path).size(),
+               newTokens, oldBest * 1000.0, newBest * 1000.0,
+               newBest > 0.0 ? oldBest / newBest : 0.0, same ? "yes" : "NO");
+            }
+      printf("%-32s %10s %8s %10.3f %10.3f %7.1fx\n", "total", "", "", oldTotal * 1000.0, newTotal * 1000.0,
+         newTotal > 0.0 ? oldTotal / newTotal : 0.0);
+      return allSame ? 0 : 2;
+      }
@@ -24,6 +24,8 @@
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
+#include <sys/stat.h>
 
 #include <QByteArray>
 #include <QString>
@@ -58,8 +60,9 @@ Xml::Xml(FILE* _f)
       level      = 0;
       inTag      = false;
       inComment  = false;
-      lbuffer[0] = 0;
-      bufptr     = lbuffer;
+      _loaded    = false;
+      bufptr     = "";
+      _deferred  = 0;
       _minorVersion = -1;
       _majorVersion = -1;
       }
@@ -72,23 +75,77 @@ Xml::Xml(const char* buf)
       level     = 0;
       inTag     = false;
       inComment = false;
+      _loaded   = true;
       bufptr    = buf;
+      _deferred = 0;
       _minorVersion = -1;
       _majorVersion = -1;
       }
 
+//---------------------------------------------------------
+//   fill
+//    Read the rest of the file in one go, so tokens can be
+//     scanned in place. Compressed songs come through a
+//     pipe, so the size is only a hint.
+//    Returns false if there is nothing more to read.
+//---------------------------------------------------------
+
+bool Xml::fill()
+      {
+      if (_loaded)
+            return false;
+      _loaded = true;
+      if (f == 0)
+            return false;
+
+      int chunk = 256 * 1024;
+      struct stat st;
+      if (fstat(fileno(f), &st) == 0 && S_ISREG(st.st_mode)) {
+            const long pos = ftell(f);
+            if (pos >= 0 && st.st_size > pos && st.st_size - pos < 0x7fff0000)
+                  chunk = st.st_size - pos + 1;   // One more, to see the end in the first read.
+            }
+      int size = 0;
+      for (;;) {
+            _data.resize(size + chunk);
+            const size_t n = fread(_data.data() + size, 1, chunk, f);
+            size += n;
+            if (n < (size_t)chunk)
+                  break;
+            }
+      _data.resize(size);
+      bufptr = _data.constData();
+      return size != 0;
+      }
+
+//---------------------------------------------------------
+//   advance
+//    Skip to e, keeping line and column up to date.
+//---------------------------------------------------------
+
+void Xml::advance(const char* e)
+      {
+      const char* nl = 0;
+      for (const char* p = bufptr; (p = (const char*)memchr(p, '\n', e - p)) != 0; ++p) {
+            ++_line;
+            nl = p;
+            }
+      if (nl)
+            _col = e - nl - 1;
+      else
+            _col += e - bufptr;
+      bufptr = e;
+      }
+
 //---------------------------------------------------------
 //   next
 //---------------------------------------------------------
 
 void Xml::next()
       {
-      if (*bufptr == 0) {
-            if (f == 0 || fgets(lbuffer, 512, f) == 0) {
-                  c = EOF;
-                  return;
-                  }
-            bufptr = lbuffer;
+      if (*bufptr == 0 && !fill()) {
+            c = EOF;
+            return;
             }
       c = *bufptr++;
       if (c == '\n') {
@@ -106,8 +163,30 @@ void Xml::next()
 void Xml::nextc()
       {
       next();
-      while (c == ' ' || c == '\t' || c == '\n')
+      if (c == ' ' || c == '\t' || c == '\n') {
+            advance(bufptr + strspn(bufptr, " \t\n"));
             next();
+            }
+      }
+
+//---------------------------------------------------------
+//   scanToken
+//    Read from the current character up to one of the
+//     stop characters or the end of input. The input is
+//     always in memory, so this is a single strcspn()
+//     instead of a loop over next().
+//---------------------------------------------------------
+
+QString Xml::scanToken(const char* stops)
+      {
+      if (c == EOF || strchr(stops, c))
+            return QString("");
+      const char* s = bufptr - 1;   // The current character.
+      const char* e = bufptr + strcspn(bufptr, stops);
+      QString token = QString::fromUtf8(s, e - s);
+      advance(e);
+      next();
+      return token;
       }
 
 //---------------------------------------------------------
@@ -117,17 +196,8 @@ void Xml::nextc()
 
 void Xml::token(int cc)
       {
-      QByteArray buffer;
-
-      int i = 0;
-      for (; i < 9999999;) {   // Stop at a reasonably large amount 10 million.
-            if (c == ' ' || c == '\t' || c == cc || c == '\n' || c == EOF)
-                  break;
-            buffer[i++] = c;
-            next();
-            }
-      buffer[i] = 0;
-      _s2 = buffer;     // deep copy !?
+      const char stops[] = { ' ', '\t', '\n', char(cc), 0 };
+      _s2 = scanToken(stops);
       }
 
 //---------------------------------------------------------
@@ -138,61 +208,58 @@ void Xml::token(int cc)
 void Xml::stoken()
       {
       QByteArray buffer;
-      
-      int i = 0;
-      buffer[i] = c;
-      ++i;
-      next();
+      buffer.append(char(c));      // The opening quote.
 
-      for (;i < 10000000*4-1;) {  // Stop at a reasonably large amount 10 million.
+      for (;;) {
+            // Copy plain characters in one go.
+            const char* e = bufptr + strcspn(bufptr, "\"&");
+            buffer.append(bufptr, e - bufptr);
+            advance(e);
+            next();
+            if (c == EOF)
+                  break;
             if (c == '"') {
-                  buffer[i++] = c;
+                  buffer.append('"');
                   next();
                   break;
                   }
-            if (c == '&') {
-                  char entity[6];
-                  int k = 0;
-                  for (; k < 6; ++k) {
-                        next();
-                        if (c == EOF)
-                             break;
-                        else if (c == ';') {
-                              entity[k] = 0;
-                              if (strcmp(entity, "quot") == 0)
-                                    c = '"';
-                              else if (strcmp(entity, "amp") == 0)
-                                    c = '&';
-                              else if (strcmp(entity, "lt") == 0)
-                                    c = '<';
-                              else if (strcmp(entity, "gt") == 0)
-                                    c = '>';
-                              else if (strcmp(entity, "apos") == 0)
-                                    c = '\'';
-                              else
-                                    entity[k] = c;
-                              break;
-                              }
+
+            // c == '&'
+            char entity[6];
+            int k = 0;
+            for (; k < 6; ++k) {
+                  next();
+                  if (c == EOF)
+                       break;
+                  else if (c == ';') {
+                        entity[k] = 0;
+                        if (strcmp(entity, "quot") == 0)
+                              c = '"';
+                        else if (strcmp(entity, "amp") == 0)
+                              c = '&';
+                        else if (strcmp(entity, "lt") == 0)
+                              c = '<';
+                        else if (strcmp(entity, "gt") == 0)
+                              c = '>';
+                        else if (strcmp(entity, "apos") == 0)
+                              c = '\'';
                         else
                               entity[k] = c;
-                        }
-                  if (c == EOF || k == 6) {
-                        // dump entity
-                        int n = 0;
-                        buffer[i++] = '&';
-                        for (;(i < 511) && (n < k); ++i, ++n)
-                              buffer[i] = entity[n];
+                        break;
                         }
                   else
-                        buffer[i++] = c;
+                        entity[k] = c;
+                  }
+            if (c == EOF || k == 6) {
+                  // dump entity
+                  buffer.append('&');
+                  buffer.append(entity, k);
                   }
-            else if(c != EOF)
-              buffer[i++] = c;
+            else
+                  buffer.append(char(c));
             if (c == EOF)
                   break;
-            next();
             }
-      buffer[i] = 0;
       _s2 = buffer;
       }
 
@@ -215,9 +282,6 @@ QString Xml::strip(const QString& s)
 
 Xml::Token Xml::parse()
       {
-      QByteArray buffer;
-      int idx = 0;
-
  again:
       bool endFlag = false;
       nextc();
@@ -270,20 +334,7 @@ Xml::Token Xml::parse()
                   }
             if (c == '?') {
                   next();
-                  idx = 0;
-                  for (;;) {
-                        if (c == '?' || c == EOF || c == '>')
-                              break;
-                        
-                        buffer[idx++] = c;
-                        
-                        // TODO: check overflow
-                        next();
-                        }
-                  
-                  buffer[idx] = 0;
-                  
-                  _s1 = QString(buffer);
+                  _s1 = scanToken("?>");
                   if (c == EOF) {
                         fprintf(stderr, "XML: unexpected EOF\n");
                         goto error;
@@ -310,20 +361,7 @@ Xml::Token Xml::parse()
                         }
                   goto again;
                   }
-            idx = 0;
-            for (;;) {
-                  if (c == '/' || c == ' ' || c == '\t' || c == '>' || c == '\n' || c == EOF)
-                        break;
-                  // TODO: check overflow
-                  
-                  buffer[idx++] = c;
-                  
-                  next();
-                  }
-            
-            buffer[idx] = 0;
-            
-            _s1 = QString(buffer);
+            _s1 = scanToken("/ \t>\n");
             // skip white space:
             while (c == ' ' || c == '\t' || c == '\n')
                   next();
@@ -371,55 +409,51 @@ Xml::Token Xml::parse()
                   fprintf(stderr, "XML: level = 0\n");
                   goto error;
                   }
-            idx = 0;
+            QByteArray text;
             for (;;) {
                   if (c == EOF || c == '<')
                         break;
                   if (c == '&') {
                         next();
                         if (c == '<') {         // be tolerant with old muse files
-                              buffer[idx++] = '&';
-                              
+                              text.append('&');
                               continue;
                               }
                               
                         QByteArray name;
-                        int name_idx = 0;
-                        
-                        name[name_idx++] = c;
-                        
-                        for (; name_idx < 9999999;) {   // Stop at a reasonably large amount 10 million.
-                              next();
-                              if (c == ';')
+                        for (;;) {
+                              if (c == ';' || c == EOF)
                                     break;
-                              
-                              name[name_idx++] = c;
+                              name.append(char(c));
+                              next();
                               }
-                              
-                        name[name_idx] = 0;
                         
-                        if (strcmp(name, "lt") == 0)
+                        if (name == "lt")
                               c = '<';
-                        else if (strcmp(name, "gt") == 0)
+                        else if (name == "gt")
                               c = '>';
-                        else if (strcmp(name, "apos") == 0)
+                        else if (name == "apos")
                               c = '\'';
-                        else if (strcmp(name, "quot") == 0)
+                        else if (name == "quot")
                               c = '"';
-                        else if (strcmp(name, "amp") == 0)
+                        else if (name == "amp")
                               c = '&';
                         else
                               c = '?';
+                        text.append(char(c));
+                        next();
+                        continue;
                         }
 
-                  buffer[idx++] = c;
-                  
+                  // Copy plain characters in one go.
+                  const char* s = bufptr - 1;   // The current character.
+                  const char* e = bufptr + strcspn(bufptr, "<&");
+                  text.append(s, e - s);
+                  advance(e);
                   next();
                   }
                   
-            buffer[idx] = 0;
-            
-            _s1 = QString(buffer);
+            _s1 = text;
 
             if (c == '<')
                   --bufptr;
@@ -772,8 +806,9 @@ void Xml::dump(QString &dump)
       fpos_t pos;
       fgetpos(f, &pos);
       rewind(f);
-      while(fgets(lbuffer, 512, f) != 0)
-          dump.append(lbuffer);
+      char buf[512];
+      while(fgets(buf, 512, f) != 0)
+          dump.append(buf);
        fsetpos(f, &pos);
       }
 
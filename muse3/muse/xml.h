@@ -27,6 +27,7 @@
 #include <stdio.h>
 
 #include <QString>
+#include <QByteArray>
 
 class QColor;
 class QRect;
@@ -34,6 +35,8 @@ class QWidget;
 
 namespace MusECore {
 
+class DeferredEvents;
+
 //---------------------------------------------------------
 //   Xml
 //    very simple XML-like parser
@@ -59,9 +62,14 @@ class Xml {
       int _majorVersion;                      // Currently loaded songfile major version
 
       int c;            // current char
-      char lbuffer[512];
+      QByteArray _data; // Whole input when reading from a file.
+      bool _loaded;
       const char* bufptr;
+      DeferredEvents* _deferred;
 
+      bool fill();
+      void advance(const char* e);
+      QString scanToken(const char* stops);
       void next();
       void nextc();
       void token(int);
@@ -96,6 +104,11 @@ class Xml {
       const QString& s2() { return _s2; }
       void dump(QString &dump);
 
+      // While set, midi part events are collected here instead of written.
+      void setDeferredEvents(DeferredEvents* d) { _deferred = d; }
+      DeferredEvents* deferredEvents() const    { return _deferred; }
+      long tell() const                         { return f ? ftell(f) : -1; }
+
       void header();
       void put(const char* format, ...);
       void put(int level, const char* format, ...);
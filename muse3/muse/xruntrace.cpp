@@ -0,0 +1,248 @@
+//=============================================================================
+//  MusE
+//  Linux Music Editor
+//
+//  xruntrace.cpp
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//=============================================================================
+
+#include <stdio.h>
+
+#include <QString>
+#include <QByteArray>
+
+#include "xruntrace.h"
+#include "song.h"
+#include "track.h"
+
+namespace MusEGlobal {
+MusECore::XrunTrace xrunTrace;
+}
+
+namespace MusECore {
+
+//---------------------------------------------------------
+//   XrunTrace
+//---------------------------------------------------------
+
+XrunTrace::XrunTrace()
+      {
+      _widx          = 0;
+      _count         = 0;
+      _cycle         = 0;
+      _cur           = 0;
+      _lastXruns     = 0;
+      _postCycles    = 0;
+      _frozen        = 0;
+      _freezeRequest = 0;
+      _rearmRequest  = 0;
+      _capturedXruns = 0;
+      }
+
+//---------------------------------------------------------
+//   freeze
+//    Stop writing. Make sure all records are visible
+//     to the gui before it sees the flag.
+//---------------------------------------------------------
+
+void XrunTrace::freeze()
+      {
+      _cur = 0;
+      __sync_synchronize();
+      _frozen = 1;
+      }
+
+//---------------------------------------------------------
+//   beginCycle
+//---------------------------------------------------------
+
+void XrunTrace::beginCycle(unsigned frames, unsigned framePos, long xruns)
+      {
+      ++_cycle;
+      const bool xrun = xruns > _lastXruns;   // The gui may reset the counter.
+      _lastXruns = xruns;
+
+      if(_rearmRequest) {
+            _rearmRequest  = 0;
+            _freezeRequest = 0;
+            _postCycles    = 0;   // Don't carry an xrun over, or freeze right away.
+            _frozen        = 0;
+            }
+      if(_frozen) {
+            _cur = 0;
+            return;
+            }
+      if(_freezeRequest) {
+            _freezeRequest = 0;
+            freeze();
+            return;
+            }
+
+      // Keep recording for a while after the xrun, then freeze.
+      if(xrun && _postCycles == 0)
+            _postCycles = XRUN_TRACE_POST_CYCLES;
+
+      CycleTraceRecord* r = &_ring[_widx];
+      r->cycle       = _cycle;
+      r->frames      = frames;
+      r->framePos    = framePos;
+      r->xrun        = xrun;
+      r->start       = DspLoadProfiler::now();
+      r->msgEnd      = r->start;
+      r->midiEnd     = r->start;
+      r->prepEnd     = r->start;
+      r->outputs     = 0;
+      r->end         = r->start;
+      r->pluginTime  = 0.0;
+      r->synthTime   = 0.0;
+      r->prefetchMin = -1;
+      _cur = r;
+      }
+
+//---------------------------------------------------------
+//   markOutput
+//---------------------------------------------------------
+
+void XrunTrace::markOutput()
+      {
+      if(!_cur)
+            return;
+      const double t = DspLoadProfiler::now();
+      if(_cur->outputs < XRUN_TRACE_OUTPUTS)
+            _cur->outputEnd[_cur->outputs++] = t;
+      else
+            _cur->outputEnd[XRUN_TRACE_OUTPUTS - 1] = t;
+      }
+
+//---------------------------------------------------------
+//   endCycle
+//---------------------------------------------------------
+
+void XrunTrace::endCycle(double pluginTime, double synthTime, int prefetchMin)
+      {
+      if(!_cur)
+            return;
+      _cur->end         = DspLoadProfiler::now();
+      _cur->pluginTime  = pluginTime;
+      _cur->synthTime   = synthTime;
+      _cur->prefetchMin = prefetchMin;
+      _cur = 0;
+
+      _widx = (_widx + 1) % XRUN_TRACE_CYCLES;
+      if(_count < XRUN_TRACE_CYCLES)
+            ++_count;
+
+      if(_postCycles > 0 && --_postCycles == 0) {
+            ++_capturedXruns;
+            freeze();
+            }
+      }
+
+//---------------------------------------------------------
+//   jsonString
+//---------------------------------------------------------
+
+static QByteArray jsonString(const QString& s)
+      {
+      QByteArray in = s.toUtf8();
+      QByteArray out;
+      for(int i = 0; i < in.size(); ++i) {
+            const char c = in.at(i);
+            if(c == '"' || c == '\\')
+                  out.append('\\');
+            if((unsigned char)c < 0x20)
+                  continue;
+            out.append(c);
+            }
+      return out;
+      }
+
+//---------------------------------------------------------
+//   writeSpan
+//---------------------------------------------------------
+
+static void writeSpan(FILE* f, bool* first, const char* name, int tid, double base, double from, double to, unsigned cycle)
+      {
+      if(to < from)
+            to = from;
+      fprintf(f, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"cycle\":%u}}",
+         *first ? "" : ",", name, tid, (from - base) * 1000000.0, (to - from) * 1000000.0, cycle);
+      *first = false;
+      }
+
+//---------------------------------------------------------
+//   write
+//    Write the ring as Chrome trace event JSON, which can
+//     be loaded into chrome://tracing or Perfetto.
+//    Returns true on error.
+//---------------------------------------------------------
+
+bool XrunTrace::write(const QString& path) const
+      {
+      FILE* f = fopen(path.toLocal8Bit().constData(), "w");
+      if(!f)
+            return true;
+
+      // Output names as they are now. Good enough, outputs rarely change around an xrun.
+      QByteArray outNames[XRUN_TRACE_OUTPUTS];
+      OutputList* ol = MusEGlobal::song->outputs();
+      int oi = 0;
+      for(ciAudioOutput i = ol->begin(); i != ol->end() && oi < XRUN_TRACE_OUTPUTS; ++i, ++oi)
+            outNames[oi] = jsonString((*i)->name());
+      if(oi == XRUN_TRACE_OUTPUTS && (int)ol->size() > XRUN_TRACE_OUTPUTS)
+            outNames[XRUN_TRACE_OUTPUTS - 1] += " (and further outputs)";
+
+      const unsigned first_idx = (_widx + XRUN_TRACE_CYCLES - _count) % XRUN_TRACE_CYCLES;
+      const double base = _count ? _ring[first_idx].start : 0.0;
+
+      fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+      fprintf(f, "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Audio cycles\"}}");
+      fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"Cycle phases\"}}");
+      bool first = false;
+
+      for(unsigned n = 0; n < _count; ++n) {
+            const CycleTraceRecord& r = _ring[(first_idx + n) % XRUN_TRACE_CYCLES];
+
+            writeSpan(f, &first, "cycle", 1, base, r.start, r.end, r.cycle);
+            writeSpan(f, &first, "messages", 2, base, r.start, r.msgEnd, r.cycle);
+            writeSpan(f, &first, "midi", 2, base, r.msgEnd, r.midiEnd, r.cycle);
+            writeSpan(f, &first, "prepare and aux", 2, base, r.midiEnd, r.prepEnd, r.cycle);
+            double t = r.prepEnd;
+            for(int o = 0; o < r.outputs; ++o) {
+                  QByteArray name = "output ";
+                  name += outNames[o].isEmpty() ? QByteArray::number(o) : outNames[o];
+                  writeSpan(f, &first, name.constData(), 2, base, t, r.outputEnd[o], r.cycle);
+                  t = r.outputEnd[o];
+                  }
+            writeSpan(f, &first, "unconnected tracks and write", 2, base, t, r.end, r.cycle);
+
+            fprintf(f, ",\n{\"name\":\"load\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"plugins us\":%.3f,\"synths us\":%.3f}}",
+               (r.start - base) * 1000000.0, r.pluginTime * 1000000.0, r.synthTime * 1000000.0);
+            if(r.prefetchMin >= 0)
+                  fprintf(f, ",\n{\"name\":\"prefetch fifo\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"lowest fill\":%d}}",
+                     (r.start - base) * 1000000.0, r.prefetchMin);
+            if(r.xrun)
+                  fprintf(f, ",\n{\"name\":\"xrun\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"args\":{\"frame\":%u}}",
+                     (r.start - base) * 1000000.0, r.framePos);
+            }
+
+      fprintf(f, "\n]}\n");
+      const bool err = ferror(f);
+      fclose(f);
+      return err;
+      }
+
+} // namespace MusECore
@@ -0,0 +1,109 @@
+//=============================================================================
+//  MusE
+//  Linux Music Editor
+//
+//  xruntrace.h
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//=============================================================================
+
+#ifndef __XRUNTRACE_H__
+#define __XRUNTRACE_H__
+
+#include "dspload.h"
+
+#define XRUN_TRACE_CYCLES       512   // Cycles kept in the ring.
+#define XRUN_TRACE_POST_CYCLES  32    // Cycles still recorded after an xrun before freezing.
+#define XRUN_TRACE_OUTPUTS      8     // Individually timed audio outputs. The rest are lumped into the last.
+
+class QString;
+
+namespace MusECore {
+
+//---------------------------------------------------------
+//   CycleTraceRecord
+//    Timestamps of one Audio::process cycle, in seconds
+//     of the monotonic clock.
+//---------------------------------------------------------
+
+struct CycleTraceRecord {
+      unsigned cycle;
+      unsigned frames;
+      unsigned framePos;
+      bool xrun;                // An xrun was reported since the previous cycle started.
+      double start;
+      double msgEnd;            // Gui message processed.
+      double midiEnd;           // Midi events collected.
+      double prepEnd;           // Tracks pre-processed, aux tracks done.
+      int outputs;
+      double outputEnd[XRUN_TRACE_OUTPUTS];   // Graph pulled for each audio output.
+      double end;               // Outputs written.
+      double pluginTime;        // Total time in rack plugins.
+      double synthTime;         // Total time in synths.
+      int prefetchMin;          // Lowest prefetch fifo fill among wave tracks, -1 if none.
+      };
+
+//---------------------------------------------------------
+//   XrunTrace
+//    Lock-free ring of per-cycle timing records, written by
+//     the audio thread only. When an xrun is seen a few more
+//     cycles are recorded, then the ring freezes until the
+//     gui has saved it, so the cycles leading up to the
+//     dropout survive for later inspection.
+//---------------------------------------------------------
+
+class XrunTrace {
+      CycleTraceRecord _ring[XRUN_TRACE_CYCLES];
+      unsigned _widx;           // Next slot to write.
+      unsigned _count;          // Valid records, up to XRUN_TRACE_CYCLES.
+      unsigned _cycle;
+      CycleTraceRecord* _cur;   // Record being filled, or 0 if not recording.
+      long _lastXruns;
+      int _postCycles;          // Cycles left before freezing, or 0 if no xrun pending.
+      volatile int _frozen;
+      volatile int _freezeRequest;
+      volatile int _rearmRequest;
+      volatile unsigned _capturedXruns;
+
+      void freeze();
+
+   public:
+      XrunTrace();
+
+      // Audio thread:
+      void beginCycle(unsigned frames, unsigned framePos, long xruns);
+      void markMsg()     { if(_cur) _cur->msgEnd  = DspLoadProfiler::now(); }
+      void markMidi()    { if(_cur) _cur->midiEnd = DspLoadProfiler::now(); }
+      void markPrep()    { if(_cur) _cur->prepEnd = DspLoadProfiler::now(); }
+      void markOutput();
+      bool recording() const { return _cur != 0; }
+      void endCycle(double pluginTime, double synthTime, int prefetchMin);
+
+      // Gui thread:
+      bool frozen() const              { return _frozen; }
+      unsigned capturedXruns() const   { return _capturedXruns; }
+      void requestFreeze()             { _freezeRequest = 1; }
+      void rearm()                     { _rearmRequest = 1; }
+      bool write(const QString& path) const;   // Chrome trace event JSON. Returns true on error.
+      };
+
+} // namespace MusECore
+
+namespace MusEGlobal {
+extern MusECore::XrunTrace xrunTrace;
+}
+
+#endif
+
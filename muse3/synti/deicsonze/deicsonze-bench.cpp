@@ -0,0 +1,176 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//
+//  deicsonze-bench.cpp
+//    Render a fixed midi workload with DeicsOnze and
+//    report how long process() took. The output checksum
+//    tells whether a change to the renderer kept the
+//    sound the same.
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include <QApplication>
+
+#include "libsynti/mess.h"
+#include "muse/midictrl.h"
+#include "mpevent.h"
+#include "globals.h"
+#include "config.h"
+#include "deicsonzepreset.h"
+
+static const int SAMPLE_RATE  = 48000;
+static const int SEGMENT_SIZE = 256;
+static const int BEAT_BLOCKS  = 24;     // blocks between two chords
+static const int NOTE_BLOCKS  = 18;     // blocks a chord is held
+static const int CHANNELS     = 16;
+static const int VOICES       = 8;
+
+//---------------------------------------------------------
+//   now
+//---------------------------------------------------------
+
+static double now()
+      {
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return ts.tv_sec + ts.tv_nsec * 1e-9;
+      }
+
+//---------------------------------------------------------
+//   send
+//---------------------------------------------------------
+
+static void send(Mess* synth, int channel, int type, int a, int b)
+      {
+      MusECore::MidiPlayEvent ev(0, 0, channel, type, a, b);
+      synth->processEvent(ev);
+      }
+
+//---------------------------------------------------------
+//   chordPitch
+//    The pitches of a channel's chord on a beat. They only
+//    depend on both, so every run plays the same notes.
+//---------------------------------------------------------
+
+static int chordPitch(int channel, int beat, int note)
+      {
+      static const int steps[3] = { 0, 4, 7 };
+      return 36 + (channel * 5 + beat * 7) % 36 + steps[note];
+      }
+
+//---------------------------------------------------------
+//   usage
+//---------------------------------------------------------
+
+static void usage(const char* name)
+      {
+      fprintf(stderr,
+         "usage: %s [-s sharedir] [-b blocks] [qt options]\n"
+         "   render %d channels of chords with DeicsOnze,\n"
+         "   %d frames per block at %d Hz (default 2000 blocks)\n",
+         name, CHANNELS, SEGMENT_SIZE, SAMPLE_RATE);
+      }
+
+//---------------------------------------------------------
+//   main
+//---------------------------------------------------------
+
+int main(int argc, char* argv[])
+      {
+      // The synth builds its gui, which needs an application.
+      // Pass -platform offscreen to run without a display.
+      QApplication app(argc, argv);
+
+      int blocks = 2000;
+      MusEGlobal::museGlobalShare = QString(SHAREDIR);
+      for (int i = 1; i < argc; ++i) {
+            if (!strcmp(argv[i], "-s") && i + 1 < argc)
+                  MusEGlobal::museGlobalShare = QString(argv[++i]);
+            else if (!strcmp(argv[i], "-b") && i + 1 < argc)
+                  blocks = atoi(argv[++i]);
+            else {
+                  usage(argv[0]);
+                  return 1;
+                  }
+            }
+      if (blocks <= 0) {
+            usage(argv[0]);
+            return 1;
+            }
+
+      const MESS* descr = mess_descriptor();
+      Mess* synth = descr->instantiate(SAMPLE_RATE, 0, 0, "deicsonze-bench");
+      if (!synth) {
+            fprintf(stderr, "deicsonze-bench: can't instantiate %s\n", descr->name);
+            return 1;
+            }
+      // The synth seeds rand() with the time, the lfo's
+      // sample and hold wave must be the same on every run.
+      srand(1);
+
+      for (int c = 0; c < CHANNELS; ++c) {
+            send(synth, c, MusECore::ME_CONTROLLER, CTRL_CHANNELENABLE, 1);
+            send(synth, c, MusECore::ME_CONTROLLER, CTRL_NBRVOICES, VOICES);
+            send(synth, c, MusECore::ME_CONTROLLER, MusECore::CTRL_PROGRAM, c);
+            }
+
+      float left[SEGMENT_SIZE];
+      float right[SEGMENT_SIZE];
+      float* buffer[2] = { left, right };
+      double checksum = 0.0;
+      double busy = 0.0;
+      unsigned pos = 0;
+
+      for (int b = 0; b < blocks; ++b) {
+            int beat = b / BEAT_BLOCKS;
+            int phase = b % BEAT_BLOCKS;
+            if (phase == 0 || phase == NOTE_BLOCKS) {
+                  for (int c = 0; c < CHANNELS; ++c)
+                        for (int n = 0; n < 3; ++n)
+                              send(synth, c, MusECore::ME_NOTEON,
+                                 chordPitch(c, beat, n), phase ? 0 : 64 + c * 4);
+                  }
+            memset(left, 0, sizeof(left));
+            memset(right, 0, sizeof(right));
+
+            double start = now();
+            synth->process(pos, buffer, 0, SEGMENT_SIZE);
+            busy += now() - start;
+
+            for (int i = 0; i < SEGMENT_SIZE; ++i)
+                  checksum += fabs(left[i]) + fabs(right[i]);
+            pos += SEGMENT_SIZE;
+            // let the gui drain the events the synth sent it
+            app.processEvents();
+            }
+
+      double rendered = double(blocks) * SEGMENT_SIZE / SAMPLE_RATE;
+      printf("rendered   %.2f s of audio in %d blocks\n", rendered, blocks);
+      printf("process    %.3f s, %.2f us per block\n", busy, busy * 1e6 / blocks);
+      printf("realtime   x%.1f\n", busy > 0.0 ? rendered / busy : 0.0);
+      printf("checksum   %.6f\n", checksum);
+
+      delete synth;
+      return 0;
+      }
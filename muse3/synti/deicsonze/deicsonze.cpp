@@ -1934,62 +1934,83 @@ inline double coefAttack(unsigned char attack) {
 }
 
 //---------------------------------------------------------
-// env2RAmp
-//  return the amplitude ratio with respect to an envelope and an
-//   envelope state, making evoluate the envelope
-//  sr is the sample rate and st the sine_table
+// envelopeBlock
+//  write the next steps amplitude ratios of an operator
+//  envelope to env, making evoluate the envelope the same
+//  way as one call per sample would. Each envelope state
+//  is run by its own loop until the state changes, and
+//  once the envelope is off the rest of env is zero.
+//  return the number of steps until the envelope went off
+//   (that step included), 0 if it was off already, steps
+//   if it is still on
+//  sr is the sample rate and wt the sine_table
 //---------------------------------------------------------
-inline double env2AmpR(double sr, float* wt, Eg eg, OpVoice* p_opVoice) {
-  switch(p_opVoice->envState) {
-  case ATTACK:
-    p_opVoice->envIndex+=p_opVoice->envInct;
-    if (p_opVoice->envIndex<(RESOLUTION/4)) {
-      p_opVoice->envLevel=wt[(int)p_opVoice->envIndex];
-    }
-    else {
-      p_opVoice->envState=DECAY;
-      p_opVoice->envLevel=1.0;
-      p_opVoice->coefVLevel=envD1R2coef(eg.d1r, sr);
-    }
-    return p_opVoice->envLevel;
-    break;
-  case DECAY:
-    if (p_opVoice->envLevel>((double)eg.d1l/(double)MAXD1L)+COEFERRDECSUS) {
-      p_opVoice->envLevel*=p_opVoice->coefVLevel;
-    }
-    else {
-      p_opVoice->envState=SUSTAIN;
-      p_opVoice->envLevel=((double)eg.d1l/(double)MAXD1L);
-      p_opVoice->coefVLevel=envD1R2coef(eg.d2r, sr);//probably the same
-    }
-    return p_opVoice->envLevel;
-    break;
-  case SUSTAIN:
-    if (p_opVoice->envLevel>COEFERRSUSREL) {
-      p_opVoice->envLevel*=p_opVoice->coefVLevel;
-    }
-    else {
-      p_opVoice->envState=OFF;
-      p_opVoice->envLevel=0.0;
+static int envelopeBlock(double* env, int steps, double sr, const float* wt,
+			 const Eg& eg, OpVoice* p_opVoice) {
+  int s = 0;
+  double level = p_opVoice->envLevel;
+  double coef = p_opVoice->coefVLevel;
+  while(s < steps && p_opVoice->envState != OFF) {
+    switch(p_opVoice->envState) {
+    case ATTACK: {
+      double index = p_opVoice->envIndex;
+      double inct = p_opVoice->envInct;
+      for(; s < steps; s++) {
+	index += inct;
+	if(index < (RESOLUTION/4)) level = wt[(int)index];
+	else {
+	  p_opVoice->envState = DECAY;
+	  level = 1.0;
+	  coef = envD1R2coef(eg.d1r, sr);
+	  env[s++] = level;
+	  break;
+	}
+	env[s] = level;
+      }
+      p_opVoice->envIndex = index;
+      break;
     }
-    return p_opVoice->envLevel;
-    break;
-  case RELEASE:
-    if (p_opVoice->envLevel > COEFERRSUSREL) {
-	  p_opVoice->envLevel*=p_opVoice->coefVLevel;
+    case DECAY: {
+      double sustain = (double)eg.d1l/(double)MAXD1L;
+      double threshold = sustain + COEFERRDECSUS;
+      for(; s < steps; s++) {
+	if(level > threshold) level *= coef;
+	else {
+	  p_opVoice->envState = SUSTAIN;
+	  level = sustain;
+	  coef = envD1R2coef(eg.d2r, sr);//probably the same
+	  env[s++] = level;
+	  break;
+	}
+	env[s] = level;
+      }
+      break;
     }
-    else {
-      p_opVoice->envState=OFF;
-      p_opVoice->envLevel=0.0;
+    case SUSTAIN:
+    case RELEASE:
+      for(; s < steps; s++) {
+	if(level > COEFERRSUSREL) level *= coef;
+	else {
+	  p_opVoice->envState = OFF;
+	  level = 0.0;
+	  env[s++] = level;
+	  break;
+	}
+	env[s] = level;
+      }
+      break;
+    default:
+      printf("Error case envelopeState");
+      p_opVoice->envState = OFF;
+      break;
     }
-    return p_opVoice->envLevel;
-    break;
-  case OFF: return 0.0;
-    break;
-  default: printf("Error case envelopeState");
-    break;
   }
-  return p_opVoice->envLevel;
+  p_opVoice->envLevel = level;
+  p_opVoice->coefVLevel = coef;
+  if(p_opVoice->envState != OFF) return steps;
+  int on = s;
+  for(; s < steps; s++) env[s] = 0.0;
+  return on;
 }
 
 //---------------------------------------------------------
@@ -4092,9 +4113,156 @@ void DeicsOnze::processMessages()
   }
 }
 
+//---------------------------------------------------------
+// renderVoice
+//  add the next steps computed samples of a voice to out,
+//  until the voice goes off. lfoAmp and inctCoef hold the
+//  channel lfo amplitude and increment coefficient for
+//  each step. The algorithm is a template parameter so that
+//  each one gets its own loop without any switch in it.
+//  The operator envelopes are computed for the whole block
+//  first: the ones deciding when the voice goes off tell
+//  how many steps are rendered, the others are computed
+//  for those steps only
+//---------------------------------------------------------
+template <Algorithm algorithm>
+static void renderVoice(float* out, int steps, Channel* p_c, Voice* p_v,
+			Preset* p, float* const* wt, const float* lfoAmp,
+			const float* inctCoef, double sr) {
+  if(steps <= 0) return;
+  const float* w0 = wt[p->oscWave[0]];
+  const float* w1 = wt[p->oscWave[1]];
+  const float* w2 = wt[p->oscWave[2]];
+  const float* w3 = wt[p->oscWave[3]];
+  float sampleOp[NBROP];
+  float ampOp[NBROP];
+  float sample;
+  double env[NBROP][RENDERBLOCKSIZE];
+  //the voice is on while one of its gate operators is
+  bool gate[NBROP];
+  for(int k=0; k<NBROP; k++)
+    gate[k] = (k==0 || algorithm==EIGHTH || (algorithm==FIFTH && k==2));
+  int live = 1;
+  for(int k=0; k<NBROP; k++)
+    if(gate[k]) {
+      int on = envelopeBlock(env[k], steps, sr, wt[W2], p->eg[k], &p_v->op[k]);
+      if(on > live) live = on;
+    }
+  for(int k=0; k<NBROP; k++)
+    if(!gate[k])
+      envelopeBlock(env[k], live, sr, wt[W2], p->eg[k], &p_v->op[k]);
+  for(int s = 0; s < live; s++) {
+    //portamento
+    portamentoUpdate(p_c, p_v);
+    //pitch envelope
+    pitchEnvelopeUpdate(p_v, &p->pitchEg, sr);
+    //per op
+    for(int k=0; k<NBROP; k++) {
+      //compute the next index on the wavetable,
+      //without taking account of the feedback and FM modulation
+      p_v->op[k].index=plusMod(p_v->op[k].index, p_v->op[k].inct
+			       * inctCoef[s] * p_v->pitchEnvCoefInct);
+      ampOp[k]=p_v->op[k].amp*COEFLEVEL
+	*(p->sensitivity.ampOn[k]?lfoAmp[s]:1.0)
+	*env[k][s];
+    }
+    sampleOp[3]=ampOp[3]
+      *w3[(int)plusMod(p_v->op[3].index,
+		       (float)RESOLUTION*p_v->sampleFeedback)];
+    switch(algorithm) {
+    case FIRST :
+      sampleOp[2]=ampOp[2]
+	*w2[(int)plusMod(p_v->op[2].index, (float)RESOLUTION*sampleOp[3])];
+      sampleOp[1]=ampOp[1]
+	*w1[(int)plusMod(p_v->op[1].index, (float)RESOLUTION*sampleOp[2])];
+      sampleOp[0]=ampOp[0]
+	*w0[(int)plusMod(p_v->op[0].index, (float)RESOLUTION*sampleOp[1])];
+      sample=sampleOp[0];///COEFLEVEL;
+      break;
+    case SECOND :
+      sampleOp[2]=ampOp[2]*w2[(int)p_v->op[2].index];
+      sampleOp[1]=ampOp[1]
+	*w1[(int)plusMod(p_v->op[1].index,
+			 (float)RESOLUTION*(sampleOp[2]+sampleOp[3])/2.0)];
+      sampleOp[0]=ampOp[0]
+	*w0[(int)plusMod(p_v->op[0].index, (float)RESOLUTION*sampleOp[1])];
+      sample=sampleOp[0];///COEFLEVEL;
+      break;
+    case THIRD :
+      sampleOp[2]=ampOp[2]*w2[(int)p_v->op[2].index];
+      sampleOp[1]=ampOp[1]
+	*w1[(int)plusMod(p_v->op[1].index, (float)RESOLUTION*sampleOp[2])];
+      sampleOp[0]=ampOp[0]
+	*w0[(int)plusMod(p_v->op[0].index,
+			 (float)RESOLUTION*(sampleOp[3]+sampleOp[1])/2.0)];
+      sample=sampleOp[0];///COEFLEVEL;
+      break;
+    case FOURTH :
+      sampleOp[2]=ampOp[2]
+	*w2[(int)plusMod(p_v->op[2].index, (float)RESOLUTION*sampleOp[3])];
+      sampleOp[1]=ampOp[1]*w1[(int)p_v->op[1].index];
+      sampleOp[0]=ampOp[0]
+	*w0[(int)plusMod(p_v->op[0].index,
+			 (float)RESOLUTION*(sampleOp[1]+sampleOp[2])/2.0)];
+      sample=sampleOp[0];///COEFLEVEL;
+      break;
+    case FIFTH :
+      sampleOp[2]=ampOp[2]
+	*w2[(int)plusMod(p_v->op[2].index, (float)RESOLUTION*sampleOp[3])];
+      sampleOp[1]=ampOp[1]*w1[(int)p_v->op[1].index];
+      sampleOp[0]=ampOp[0]
+	*w0[(int)plusMod(p_v->op[0].index, (float)RESOLUTION*sampleOp[1])];
+      sample=(sampleOp[0]+sampleOp[2])/2.0;///COEFLEVEL;
+      break;
+    case SIXTH :
+      sampleOp[2]=ampOp[2]
+	*w2[(int)plusMod(p_v->op[2].index, (float)RESOLUTION*sampleOp[3])];
+      sampleOp[1]=ampOp[1]
+	*w1[(int)plusMod(p_v->op[1].index, (float)RESOLUTION*sampleOp[3])];
+      sampleOp[0]=ampOp[0]
+	*w0[(int)plusMod(p_v->op[0].index, (float)RESOLUTION*sampleOp[3])];
+      sample=(sampleOp[0]+sampleOp[1]+sampleOp[2])/3.0;
+      break;
+    case SEVENTH :
+      sampleOp[2]=ampOp[2]
+	*w2[(int)plusMod(p_v->op[2].index, (float)RESOLUTION*sampleOp[3])];
+      sampleOp[1]=ampOp[1]*w1[(int)p_v->op[1].index];
+      sampleOp[0]=ampOp[0]*w0[(int)p_v->op[0].index];
+      sample=(sampleOp[0]+sampleOp[1]+sampleOp[2])/3.0;
+      break;
+    case EIGHTH :
+      sampleOp[2]=ampOp[2]*w2[(int)p_v->op[2].index];
+      sampleOp[1]=ampOp[1]*w1[(int)p_v->op[1].index];
+      sampleOp[0]=ampOp[0]*w0[(int)p_v->op[0].index];
+      sample=(sampleOp[0]+sampleOp[1]+sampleOp[2]+sampleOp[3])/4.0;
+      break;
+    }
+    p_v->volume=ampOp[0]+ampOp[1]+ampOp[2]+ampOp[3];
+    p_v->sampleFeedback=sampleOp[3]*p_c->feedbackAmp;
+    out[s] += sample;
+  }
+  p_v->isOn = false;
+  for(int k=0; k<NBROP; k++)
+    if(gate[k] && p_v->op[k].envState!=OFF) p_v->isOn = true;
+}
+
+typedef void (*VoiceRenderer)(float*, int, Channel*, Voice*, Preset*,
+			      float* const*, const float*, const float*, double);
+
+//indexed by Algorithm
+static const VoiceRenderer voiceRenderers[] = {
+  renderVoice<FIRST>, renderVoice<SECOND>, renderVoice<THIRD>,
+  renderVoice<FOURTH>, renderVoice<FIFTH>, renderVoice<SIXTH>,
+  renderVoice<SEVENTH>, renderVoice<EIGHTH>
+};
+
 //---------------------------------------------------------
 //   write
 //    synthesize n samples into buffer+offset
+//    by blocks of at most RENDERBLOCKSIZE computed samples:
+//    the channel lfos first, then each voice for the whole
+//    block. Samples skipped by the quality repeat the last
+//    computed one
 //---------------------------------------------------------
 void DeicsOnze::process(unsigned pos, float** buffer, int offset, int n) {
   /*
@@ -4115,319 +4283,112 @@ void DeicsOnze::process(unsigned pos, float** buffer, int offset, int n) {
   float* leftOutput = buffer[0] + offset;
   float* rightOutput = buffer[1] + offset; 
 
-  float sample[MAXNBRVOICES];
-  float tempLeftOutput;
-  float tempRightOutput;
-  float tempChannelOutput;
+  float* wt[NBRWAVES];
+  for(int w = 0; w < NBRWAVES; w++) wt[w] = waveTable[w];
+
+  int stepPos[RENDERBLOCKSIZE]; //output sample of each computed sample
+  float lfoAmp[RENDERBLOCKSIZE];
+  float inctCoef[RENDERBLOCKSIZE];
+  float channelOutput[RENDERBLOCKSIZE];
+  float left[RENDERBLOCKSIZE];
+  float right[RENDERBLOCKSIZE];
+  float chorusLeft[RENDERBLOCKSIZE];
+  float chorusRight[RENDERBLOCKSIZE];
+  float reverbLeft[RENDERBLOCKSIZE];
+  float reverbRight[RENDERBLOCKSIZE];
+  float delayLeft[RENDERBLOCKSIZE];
+  float delayRight[RENDERBLOCKSIZE];
   float tempChannelLeftOutput;
   float tempChannelRightOutput;
-  float tempIncChannel; //for optimization
-  float sampleOp[NBROP];
-  for(int i = 0; i < NBROP; i++) sampleOp[i] = 0.0;
-  float ampOp[NBROP];
-  for(int i = 0; i < n; i++) {
-    if(_global.qualityCounter == 0) {
-      tempLeftOutput = 0.0;
-      tempRightOutput = 0.0;
-      _global.lastInputLeftChorusSample = 0.0;
-      _global.lastInputRightChorusSample = 0.0;
-      _global.lastInputLeftReverbSample = 0.0;
-      _global.lastInputRightReverbSample = 0.0;
-      _global.lastInputLeftDelaySample = 0.0;
-      _global.lastInputRightDelaySample = 0.0;
-      //per channel
-      for(int c = 0; c < NBRCHANNELS; c++) {
-	tempChannelOutput = 0.0;
-	if(_global.channel[c].isEnable) {
-	  //lfo, trick : we use the first quater of the wave W2
-	  lfoUpdate(_preset[c], &_global.channel[c], waveTable[W2]);
-	  
-	  //optimization
-	  tempIncChannel =
-	    _global.channel[c].lfoCoefInct * _global.channel[c].pitchBendCoef;
-	  
-	  //per voice
-	  for(int j=0; j<_global.channel[c].nbrVoices; j++) {
-	    if (_global.channel[c].voices[j].isOn) {
-	      //portamento
-	      portamentoUpdate(&_global.channel[c],
-			       &_global.channel[c].voices[j]);
-	      //pitch envelope
-	      pitchEnvelopeUpdate(&_global.channel[c].voices[j],
-				  &_preset[c]->pitchEg, _global.deiSampleRate);
-	      //per op
-	      for(int k=0; k<NBROP; k++) {
-		//compute the next index on the wavetable,
-		//without taking account of the feedback and FM modulation
-		_global.channel[c].voices[j].op[k].index=
-		  plusMod(_global.channel[c].voices[j].op[k].index,
-			  _global.channel[c].voices[j].op[k].inct
-			  * tempIncChannel
-			  * _global.channel[c].voices[j].pitchEnvCoefInct);
-		
-		ampOp[k]=_global.channel[c].voices[j].op[k].amp*COEFLEVEL
-		  *(_preset[c]->sensitivity.ampOn[k]?
-		    _global.channel[c].lfoAmp:1.0)
-		  *env2AmpR(_global.deiSampleRate, waveTable[W2],
-			    _preset[c]->eg[k],
-			    &_global.channel[c].voices[j].op[k]);
-	      }
-	      switch(_preset[c]->algorithm) {
-	      case FIRST :
-		sampleOp[3]=ampOp[3]
-		  *waveTable[_preset[c]->oscWave[3]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[3].index,
-				(float)RESOLUTION
-				*_global.channel[c].voices[j].sampleFeedback)];
-		sampleOp[2]=ampOp[2]
-		  *waveTable[_preset[c]->oscWave[2]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[2].index,
-				(float)RESOLUTION*sampleOp[3])];
-		sampleOp[1]=ampOp[1]
-		  *waveTable[_preset[c]->oscWave[1]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[1].index,
-				(float)RESOLUTION*sampleOp[2])];
-		sampleOp[0]=ampOp[0]
-		  *waveTable[_preset[c]->oscWave[0]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[0].index,
-				(float)RESOLUTION*sampleOp[1])];
-		
-		sample[j]=sampleOp[0];///COEFLEVEL;
-		
-		_global.channel[c].voices[j].isOn =
-		  (_global.channel[c].voices[j].op[0].envState!=OFF);
-		break;
-	      case SECOND :
-		sampleOp[3]=ampOp[3]
-		  *waveTable[_preset[c]->oscWave[3]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[3].index,
-				(float)RESOLUTION
-				*_global.channel[c].voices[j].sampleFeedback)];
-		sampleOp[2]=ampOp[2]
-		  *waveTable[_preset[c]->oscWave[2]]
-		  [(int)_global.channel[c].voices[j].op[2].index];
-		sampleOp[1]=ampOp[1]
-		  *waveTable[_preset[c]->oscWave[1]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[1].index,
-				(float)RESOLUTION
-				*(sampleOp[2]+sampleOp[3])/2.0)];
-		sampleOp[0]=ampOp[0]
-		  *waveTable[_preset[c]->oscWave[0]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[0].index,
-				(float)RESOLUTION
-				*sampleOp[1])];
-		
-		sample[j]=sampleOp[0];///COEFLEVEL;
-		
-		_global.channel[c].voices[j].isOn =
-		  (_global.channel[c].voices[j].op[0].envState!=OFF);
-		break;
-	      case THIRD :
-		sampleOp[3]=ampOp[3]
-		  *waveTable[_preset[c]->oscWave[3]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[3].index,
-				(float)RESOLUTION
-				*_global.channel[c].voices[j].sampleFeedback)];
-		sampleOp[2]=ampOp[2]
-		  *waveTable[_preset[c]->oscWave[2]]
-		  [(int)_global.channel[c].voices[j].op[2].index];
-		sampleOp[1]=ampOp[1]
-		  *waveTable[_preset[c]->oscWave[1]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[1].index,
-				(float)RESOLUTION*sampleOp[2])];
-		sampleOp[0]=ampOp[0]
-		  *waveTable[_preset[c]->oscWave[0]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[0].index,
-				(float)RESOLUTION
-				*(sampleOp[3]+sampleOp[1])/2.0)];
-		
-		sample[j]=sampleOp[0];///COEFLEVEL;
-		
-		_global.channel[c].voices[j].isOn = 
-		  (_global.channel[c].voices[j].op[0].envState!=OFF);
-		break;
-	      case FOURTH :
-		sampleOp[3]=ampOp[3]
-		  *waveTable[_preset[c]->oscWave[3]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[3].index,
-				(float)RESOLUTION
-				*_global.channel[c].voices[j].sampleFeedback)];
-		sampleOp[2]=ampOp[2]
-		  *waveTable[_preset[c]->oscWave[2]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[2].index,
-				(float)RESOLUTION
-				*sampleOp[3])];
-		sampleOp[1]=ampOp[1]
-		  *waveTable[_preset[c]->oscWave[1]]
-		  [(int)_global.channel[c].voices[j].op[1].index];
-		sampleOp[0]=ampOp[0]
-		  *waveTable[_preset[c]->oscWave[0]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[0].index,
-				(float)RESOLUTION
-				*(sampleOp[1]+sampleOp[2])/2.0)];
-		
-		sample[j]=sampleOp[0];///COEFLEVEL;
-		
-		_global.channel[c].voices[j].isOn =
-		  (_global.channel[c].voices[j].op[0].envState!=OFF);
-		break;
-	      case FIFTH :
-		sampleOp[3]=ampOp[3]
-		  *waveTable[_preset[c]->oscWave[3]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[3].index,
-				(float)RESOLUTION
-				*_global.channel[c].voices[j].sampleFeedback)];
-		sampleOp[2]=ampOp[2]
-		  *waveTable[_preset[c]->oscWave[2]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[2].index,
-				(float)RESOLUTION*sampleOp[3])];
-		sampleOp[1]=ampOp[1]
-		  *waveTable[_preset[c]->oscWave[1]]
-		  [(int)_global.channel[c].voices[j].op[1].index];
-		sampleOp[0]=ampOp[0]
-		  *waveTable[_preset[c]->oscWave[0]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[0].index,
-				(float)RESOLUTION*sampleOp[1])];
-		
-		sample[j]=(sampleOp[0]+sampleOp[2])/2.0;///COEFLEVEL;
-		
-		_global.channel[c].voices[j].isOn = 
-		  (_global.channel[c].voices[j].op[0].envState!=OFF
-		   ||_global.channel[c].voices[j].op[2].envState!=OFF);
-		break;
-	      case SIXTH :
-		sampleOp[3]=ampOp[3]
-		  *waveTable[_preset[c]->oscWave[3]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[3].index,
-				(float)RESOLUTION
-				*_global.channel[c].voices[j].sampleFeedback)];
-		sampleOp[2]=ampOp[2]
-		  *waveTable[_preset[c]->oscWave[2]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[2].index,
-				(float)RESOLUTION*sampleOp[3])];
-		sampleOp[1]=ampOp[1]
-		  *waveTable[_preset[c]->oscWave[1]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[1].index,
-				(float)RESOLUTION*sampleOp[3])];
-		sampleOp[0]=ampOp[0]
-		  *waveTable[_preset[c]->oscWave[0]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[0].index,
-				(float)RESOLUTION*sampleOp[3])];
-		
-		sample[j]=(sampleOp[0]+sampleOp[1]+sampleOp[2])/3.0;
-		
-		_global.channel[c].voices[j].isOn = 
-		  (_global.channel[c].voices[j].op[0].envState!=OFF);
-		break;
-	      case SEVENTH :
-		sampleOp[3]=ampOp[3]
-		  *waveTable[_preset[c]->oscWave[3]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[3].index,
-				(float)RESOLUTION
-				*_global.channel[c].voices[j].sampleFeedback)];
-		sampleOp[2]=ampOp[2]
-		  *waveTable[_preset[c]->oscWave[2]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[2].index,
-				(float)RESOLUTION*sampleOp[3])];
-		sampleOp[1]=ampOp[1]
-		  *waveTable[_preset[c]->oscWave[1]]
-		  [(int)_global.channel[c].voices[j].op[1].index];
-		sampleOp[0]=ampOp[0]*waveTable[_preset[c]->oscWave[0]]
-		  [(int)_global.channel[c].voices[j].op[0].index];
-		
-		sample[j]=(sampleOp[0]+sampleOp[1]+sampleOp[2])/3.0;
-		
-		_global.channel[c].voices[j].isOn =
-		  (_global.channel[c].voices[j].op[0].envState!=OFF);
-		break;		
-	      case EIGHTH :
-		sampleOp[3]=ampOp[3]
-		  *waveTable[_preset[c]->oscWave[3]]
-		  [(int)plusMod(_global.channel[c].voices[j].op[3].index,
-				(float)RESOLUTION
-				*_global.channel[c].voices[j].sampleFeedback)];
-		sampleOp[2]=ampOp[2]
-		  *waveTable[_preset[c]->oscWave[2]]
-		  [(int)_global.channel[c].voices[j].op[2].index];
-		sampleOp[1]=ampOp[1]
-		  *waveTable[_preset[c]->oscWave[1]]
-		  [(int)_global.channel[c].voices[j].op[1].index];
-		sampleOp[0]=ampOp[0]
-		  *waveTable[_preset[c]->oscWave[0]]
-		  [(int)_global.channel[c].voices[j].op[0].index];
-		
-		sample[j]=
-		  (sampleOp[0]+sampleOp[1]+sampleOp[2]+sampleOp[3])
-		  /4.0;
-		
-		_global.channel[c].voices[j].isOn =
-		  (_global.channel[c].voices[j].op[0].envState!=OFF
-		   || _global.channel[c].voices[j].op[1].envState!=OFF
-		   || _global.channel[c].voices[j].op[2].envState!=OFF
-		   || _global.channel[c].voices[j].op[3].envState!=OFF);
-		break;
-	      default : printf("Error : No algorithm");
-		break;
-	      }
-	      
-	      _global.channel[c].voices[j].volume=
-		ampOp[0]+ampOp[1]+ampOp[2]+ampOp[3];
-	      
-	      _global.channel[c].voices[j].sampleFeedback =
-		sampleOp[3]*_global.channel[c].feedbackAmp;
-	      
-	      tempChannelOutput += sample[j];
-	    }
-	  }
-	  //printf("left out = %f, temp out = %f, left amp = %f\n",
-	  //tempLeftOutput, tempChannelOutput, _global.channel[c].ampLeft);
- 
-	  tempChannelLeftOutput = tempChannelOutput*_global.channel[c].ampLeft;
-	  tempChannelRightOutput=tempChannelOutput*_global.channel[c].ampRight;
-	  
-	  if(_global.isChorusActivated) {
-	    _global.lastInputLeftChorusSample += tempChannelLeftOutput *
-	      _global.channel[c].chorusAmount;
-	    _global.lastInputRightChorusSample += tempChannelRightOutput *
-	      _global.channel[c].chorusAmount;
-	  }
-	  if(_global.isReverbActivated) {
-	    _global.lastInputLeftReverbSample += tempChannelLeftOutput *
-	      _global.channel[c].reverbAmount;
-	    _global.lastInputRightReverbSample += tempChannelRightOutput *
-	      _global.channel[c].reverbAmount;
-	  }
-	  if(_global.isDelayActivated) {
-	    _global.lastInputLeftDelaySample += tempChannelLeftOutput *
-	      _global.channel[c].delayAmount;
-	    _global.lastInputRightDelaySample += tempChannelRightOutput *
-	      _global.channel[c].delayAmount;
-	  }
-	  tempLeftOutput += tempChannelLeftOutput;
-	  tempRightOutput += tempChannelRightOutput;
+
+  for(int i = 0; i < n; ) {
+    //find which output samples of the block are computed
+    int steps = 0;
+    int end = i;
+    for(; end < n; end++) {
+      if(_global.qualityCounter == 0) {
+	if(steps == RENDERBLOCKSIZE) break;
+	stepPos[steps++] = end;
+      }
+      _global.qualityCounter++;
+      _global.qualityCounter %= _global.qualityCounterTop;
+    }
+    
+    for(int s = 0; s < steps; s++) {
+      left[s] = right[s] = 0.0;
+      chorusLeft[s] = chorusRight[s] = 0.0;
+      reverbLeft[s] = reverbRight[s] = 0.0;
+      delayLeft[s] = delayRight[s] = 0.0;
+    }
+    //per channel
+    for(int c = 0; c < NBRCHANNELS && steps; c++) {
+      Channel* p_c = &_global.channel[c];
+      if(!p_c->isEnable) continue;
+      for(int s = 0; s < steps; s++) {
+	//lfo, trick : we use the first quater of the wave W2
+	lfoUpdate(_preset[c], p_c, waveTable[W2]);
+	lfoAmp[s] = p_c->lfoAmp;
+	inctCoef[s] = p_c->lfoCoefInct * p_c->pitchBendCoef;
+	channelOutput[s] = 0.0;
+      }
+      //per voice
+      if((unsigned)_preset[c]->algorithm <= EIGHTH) {
+	VoiceRenderer render = voiceRenderers[_preset[c]->algorithm];
+	for(int j=0; j<p_c->nbrVoices; j++)
+	  if(p_c->voices[j].isOn)
+	    render(channelOutput, steps, p_c, &p_c->voices[j], _preset[c], wt,
+		   lfoAmp, inctCoef, _global.deiSampleRate);
+      }
+      else printf("Error : No algorithm\n");
+      
+      for(int s = 0; s < steps; s++) {
+	tempChannelLeftOutput = channelOutput[s]*p_c->ampLeft;
+	tempChannelRightOutput = channelOutput[s]*p_c->ampRight;
+	if(_global.isChorusActivated) {
+	  chorusLeft[s] += tempChannelLeftOutput * p_c->chorusAmount;
+	  chorusRight[s] += tempChannelRightOutput * p_c->chorusAmount;
 	}
+	if(_global.isReverbActivated) {
+	  reverbLeft[s] += tempChannelLeftOutput * p_c->reverbAmount;
+	  reverbRight[s] += tempChannelRightOutput * p_c->reverbAmount;
+	}
+	if(_global.isDelayActivated) {
+	  delayLeft[s] += tempChannelLeftOutput * p_c->delayAmount;
+	  delayRight[s] += tempChannelRightOutput * p_c->delayAmount;
+	}
+	left[s] += tempChannelLeftOutput;
+	right[s] += tempChannelRightOutput;
       }
-      _global.lastLeftSample = tempLeftOutput * _global.masterVolume;
-      _global.lastRightSample = tempRightOutput * _global.masterVolume;
     }
-    leftOutput[i] += _global.lastLeftSample;
-    rightOutput[i] += _global.lastRightSample;
-	  
-    if(_global.isChorusActivated) {
-      tempInputChorus[0][i] = _global.lastInputLeftChorusSample;
-      tempInputChorus[1][i] = _global.lastInputRightChorusSample;
+
+    for(int s = 0; i < end; i++) {
+      if(s < steps && stepPos[s] == i) {
+	_global.lastLeftSample = left[s] * _global.masterVolume;
+	_global.lastRightSample = right[s] * _global.masterVolume;
+	_global.lastInputLeftChorusSample = chorusLeft[s];
+	_global.lastInputRightChorusSample = chorusRight[s];
+	_global.lastInputLeftReverbSample = reverbLeft[s];
+	_global.lastInputRightReverbSample = reverbRight[s];
+	_global.lastInputLeftDelaySample = delayLeft[s];
+	_global.lastInputRightDelaySample = delayRight[s];
+	s++;
+      }
+      leftOutput[i] += _global.lastLeftSample;
+      rightOutput[i] += _global.lastRightSample;
+      
+      if(_global.isChorusActivated) {
+	tempInputChorus[0][i] = _global.lastInputLeftChorusSample;
+	tempInputChorus[1][i] = _global.lastInputRightChorusSample;
+      }
+      if(_global.isReverbActivated) {
+	tempInputReverb[0][i] = _global.lastInputLeftReverbSample;
+	tempInputReverb[1][i] = _global.lastInputRightReverbSample;
+      }    
+      if(_global.isDelayActivated) {
+	tempInputDelay[0][i] = _global.lastInputLeftDelaySample;
+	tempInputDelay[1][i] = _global.lastInputRightDelaySample;
+      }    
     }
-    if(_global.isReverbActivated) {
-      tempInputReverb[0][i] = _global.lastInputLeftReverbSample;
-      tempInputReverb[1][i] = _global.lastInputRightReverbSample;
-    }    
-    if(_global.isDelayActivated) {
-      tempInputDelay[0][i] = _global.lastInputLeftDelaySample;
-      tempInputDelay[1][i] = _global.lastInputRightDelaySample;
-    }    
-    
-    _global.qualityCounter++;
-    _global.qualityCounter %= _global.qualityCounterTop;
   }
   //apply Filter
   if(_global.filter) _dryFilter->process(leftOutput, rightOutput, n);
@@ -4510,7 +4471,8 @@ extern "C" {
 	"DeicsOnze FM DX11/TX81Z emulator",
 	"0.5.5",      // version string
 	MESS_MAJOR_VERSION, MESS_MINOR_VERSION,
-	instantiate
+	instantiate,
+	0,          // instantiateWithInitData
     };
     // We must compile with -fvisibility=hidden to avoid namespace
     // conflicts with global variables.
@@ -97,6 +97,7 @@
 #define NBRBANKPRESETS 32
 #define MAXNBRVOICES 64
 #define NBRCHANNELS 16
+#define RENDERBLOCKSIZE 64 //computed samples rendered per voice at a time
 
 #define SYSEX_INIT_DATA 1
 #define SYSEX_INIT_DATA_VERSION 1
@@ -76,6 +76,7 @@ extern "C" {
             "0.1",      // fluid version string
             MESS_MAJOR_VERSION, MESS_MINOR_VERSION,
             instantiate,
+            0,          // instantiateWithInitData
             };
       // We must compile with -fvisibility=hidden to avoid namespace
       // conflicts with global variables.
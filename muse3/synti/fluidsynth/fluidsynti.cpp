@@ -31,6 +31,7 @@
 
 #include <list>
 #include <iostream>
+#include <stdlib.h>
 
 #include <QFileInfo>
 #include <QFileDialog>
@@ -89,17 +90,35 @@ QString *projPathPtr;
 //
 // Fluidsynth
 //
-FluidSynth::FluidSynth(int sr, pthread_mutex_t *_Globalsfloader_mutex) : Mess(2)
+//    cpuCores  number of threads fluidsynth renders voices with
+//    groups    number of extra stereo outputs the midi channels
+//              are spread across, 0 for the stereo mix only
+//    dynamicSamples  load samples on first use of a preset
+//
+FluidSynth::FluidSynth(int sr, pthread_mutex_t *_Globalsfloader_mutex, int cpuCores, int groups, bool dynamicSamples)
+   : Mess(2 + 2 * groups)
       {
       gui = 0;
+      audioGroups = groups;
+      this->cpuCores = cpuCores;
+      this->dynamicSamples = dynamicSamples;
       setSampleRate(sr);
       fluid_settings_t* s = new_fluid_settings();
       fluid_settings_setnum(s, (char*) "synth.sample-rate", float(sampleRate()));
+      fluid_settings_setint(s, (char*) "synth.cpu-cores", cpuCores);
+      if (audioGroups) {
+            fluid_settings_setint(s, (char*) "synth.audio-channels", audioGroups);
+            fluid_settings_setint(s, (char*) "synth.audio-groups", audioGroups);
+            fluid_settings_setint(s, (char*) "synth.effects-channels", 2);
+            }
+      // Only load the samples of presets actually selected on a channel
+      fluid_settings_setint(s, (char*) "synth.dynamic-sample-loading", dynamicSamples);
       fluidsynth = new_fluid_synth(s);
       if (!fluidsynth) {
             printf("Error while creating fluidsynth!\n");
             return;
             }
+      SoundFontCache::installLoader(fluidsynth, s);
 
       //Set up channels:
       for (int i=0; i<FS_MAX_NR_OF_CHANNELS; i++) {
@@ -130,6 +149,8 @@ FluidSynth::~FluidSynth()
       }
         
       int err = delete_fluid_synth (fluidsynth);
+      for (std::list<FluidSoundFont>::iterator it =stack.begin(); it !=stack.end(); it++)
+        SoundFontCache::release(it->mapping);
       if(gui)
         delete gui;
 
@@ -242,12 +263,59 @@ void FluidSynth::process(unsigned /*pos*/, float** ports, int offset, int len)
             }
       */
 
+      if (audioGroups) {
+            processGroups(ports, offset, len);
+            return;
+            }
       if (fluid_synth_write_float(fluidsynth, len, ports[0], offset, 1, ports[1], offset, 1)) {
             M_ERROR("Error writing from synth!");
             return;
             }
       }
 
+//---------------------------------------------------------
+//   processGroups
+//    Render each audio group dry into its own output pair.
+//    The send effects only exist as separate buffers, so the
+//    main pair is the sum of all groups plus reverb and chorus.
+//---------------------------------------------------------
+
+void FluidSynth::processGroups(float** ports, int offset, int len)
+      {
+      float* fxLeft[2]  = { fxBuffer[0], fxBuffer[2] };
+      float* fxRight[2] = { fxBuffer[1], fxBuffer[3] };
+
+      for (int done = 0; done < len; ) {
+            int n = len - done;
+            if (n > FS_FX_BUFSIZE)
+                  n = FS_FX_BUFSIZE;
+            int pos = offset + done;
+            for (int g = 0; g < audioGroups; ++g) {
+                  groupLeft[g]  = ports[2 + 2 * g] + pos;
+                  groupRight[g] = ports[3 + 2 * g] + pos;
+                  }
+            if (fluid_synth_nwrite_float(fluidsynth, n, groupLeft, groupRight, fxLeft, fxRight)) {
+                  M_ERROR("Error writing from synth!");
+                  return;
+                  }
+            float* l = ports[0] + pos;
+            float* r = ports[1] + pos;
+            for (int i = 0; i < n; ++i) {
+                  l[i] = fxBuffer[0][i] + fxBuffer[2][i];
+                  r[i] = fxBuffer[1][i] + fxBuffer[3][i];
+                  }
+            for (int g = 0; g < audioGroups; ++g) {
+                  const float* gl = groupLeft[g];
+                  const float* gr = groupRight[g];
+                  for (int i = 0; i < n; ++i) {
+                        l[i] += gl[i];
+                        r[i] += gr[i];
+                        }
+                  }
+            done += n;
+            }
+      }
+
 //---------------------------------------------------------
 //   getInitData
 // Prepare data that will restore the synth's state on load
@@ -272,6 +340,9 @@ void FluidSynth::getInitData(int* n, const unsigned char** data)
       // which is mapped to internal id after all fonts are loaded.
       //
       // reverb + chorus on/off (2 bytes)
+      //
+      // audio groups + cpu cores (2 bytes), always last so that
+      // instantiate can find them without parsing the rest.
       if (FS_DEBUG)
             printf("FluidSynth::getInitData()\n");
 
@@ -287,11 +358,13 @@ void FluidSynth::getInitData(int* n, const unsigned char** data)
                 }
             len+=fileLen + 2;
             }
-      //Add length for lastdir and channels:
-      len+=strlen(lastdir.c_str())+1;
+      //Add length for the channel section marker and channels:
+      len+=1;
       len+=(FS_MAX_NR_OF_CHANNELS*4); // 4 bytes: ext+int id + bankno + drumchannel status
       // + reverb
       len+=2;
+      // + audio groups and cores
+      len+=2;
 
       if (FS_DEBUG)
             printf("Total length of init sysex: %d\n", len);
@@ -354,6 +427,10 @@ void FluidSynth::getInitData(int* n, const unsigned char** data)
       //Reverb:
       *chptr = rev_on; chptr++;
       *chptr = cho_on; chptr++;
+
+      //Fixed for the instance's lifetime, see instantiateWithInitData:
+      *chptr = audioGroups; chptr++;
+      *chptr = cpuCores > 255 ? 255 : cpuCores; chptr++;
       if (FS_DEBUG) {
             for (int i=0; i<len; i++)
                   printf("%c ", initBuffer[i]);
@@ -468,6 +545,9 @@ void FluidSynth::parseInitData(int n, const byte* d)
       setController(0, FS_REVERB_ON, *chptr); chptr++;
       setController(0, FS_CHORUS_ON, *chptr); chptr++;
 
+      // Ver 0.5 and later end with the audio groups and cpu cores.
+      // They can't change now, the instance was created with them.
+
       if (FS_DEBUG)
             printf("--- END PARSE INIT DATA ---\n");
       //Load the shit:
@@ -661,9 +741,14 @@ static void* fontLoadThread(void* t)
 
       //Let only one loadThread have access to the fluidsynth-object at the time
       pthread_mutex_lock(sfloader_mutex);
+      //With dynamic sample loading, samples are read from the file later on.
+      //Keep it mapped for as long as the font stays loaded then. Otherwise
+      //the whole font is read now, and the mapping only lives while loading.
+      SoundFontMapping* mapping = fptr->dynamicSamples ? SoundFontCache::acquire(h->file_name) : 0;
       int rv = fluid_synth_sfload(fptr->fluidsynth, sf_pathstr, 1);
 
       if (rv ==-1) {
+            SoundFontCache::release(mapping);
             fptr->sendError(fluid_synth_error(fptr->fluidsynth));
             if (FS_DEBUG)
                   std::cerr << DEBUG_ARGS << "error loading soundfont: " << fluid_synth_error(fptr->fluidsynth) << std::endl;
@@ -682,6 +767,7 @@ static void* fontLoadThread(void* t)
       font.file_name = h->file_name;
 
       font.intid = rv;
+      font.mapping = mapping;
       if (h->id == FS_UNSPECIFIED_ID) {
             font.extid = fptr->getNextAvailableExternalId();
             if (FS_DEBUG)
@@ -1399,6 +1485,7 @@ bool FluidSynth::popSoundfont (int ext_id)
                //Remove it from soundfont stack
                for (std::list<FluidSoundFont>::iterator it =stack.begin(); it !=stack.end(); it++) {
                      if (it->intid == int_id) {
+                           SoundFontCache::release(it->mapping);
                            stack.erase(it);
                            break;
                            }
@@ -1428,7 +1515,32 @@ static  pthread_mutex_t globalMutex;
 static bool mutexEnabled = false;
 
 
-static Mess* instantiate(int sr, QWidget*, QString* projectPathPtr, const char* name)
+//---------------------------------------------------------
+//   envSetting
+//    MUSE_FLUIDSYNTH_CPU_CORES, MUSE_FLUIDSYNTH_AUDIO_GROUPS and
+//    MUSE_FLUIDSYNTH_DYNAMIC_SAMPLES configure new instances. The
+//    output count is fixed for the lifetime of an instance, so it
+//    can't be a controller.
+//---------------------------------------------------------
+
+static int envSetting(const char* var, int def, int min, int max)
+      {
+      const char* p = getenv(var);
+      if (!p || !*p)
+            return def;
+      int val = atoi(p);
+      if (val < min)
+            val = min;
+      if (val > max)
+            val = max;
+      return val;
+      }
+
+//---------------------------------------------------------
+//   createSynth
+//---------------------------------------------------------
+
+static Mess* createSynth(int sr, QString* projectPathPtr, const char* name, int cores, int groups)
       {
       printf("fluidsynth sampleRate %d\n", sr);
       projPathPtr=projectPathPtr;
@@ -1438,7 +1550,11 @@ static Mess* instantiate(int sr, QWidget*, QString* projectPathPtr, const char*
           mutexEnabled = true;
           }
 
-      FluidSynth* synth = new FluidSynth(sr, &globalMutex);
+      // Off by default: fluidsynth would load samples from whichever
+      // thread selects a preset, which is the audio thread.
+      bool dynamicSamples = envSetting("MUSE_FLUIDSYNTH_DYNAMIC_SAMPLES", 0, 0, 1);
+
+      FluidSynth* synth = new FluidSynth(sr, &globalMutex, cores, groups, dynamicSamples);
       if (synth->init(name)) {
             delete synth;
             synth = 0;
@@ -1446,6 +1562,41 @@ static Mess* instantiate(int sr, QWidget*, QString* projectPathPtr, const char*
       return synth;
       }
 
+//---------------------------------------------------------
+//   instantiate
+//    A new instance renders with one thread unless the user
+//    asks for more.
+//---------------------------------------------------------
+
+static Mess* instantiate(int sr, QWidget*, QString* projectPathPtr, const char* name)
+      {
+      int cores  = envSetting("MUSE_FLUIDSYNTH_CPU_CORES", 1, 1, 255);
+      int groups = envSetting("MUSE_FLUIDSYNTH_AUDIO_GROUPS", 0, 0, FS_MAX_NR_OF_CHANNELS);
+      return createSynth(sr, projectPathPtr, name, cores, groups);
+      }
+
+//---------------------------------------------------------
+//   instantiateWithInitData
+//    A restored instance gets the outputs it was saved with,
+//    so that routes from its extra outputs stay valid.
+//    MUSE_FLUIDSYNTH_CPU_CORES still overrides the cores.
+//---------------------------------------------------------
+
+static Mess* instantiateWithInitData(int sr, QWidget* parent, QString* projectPathPtr, const char* name,
+   int n, const unsigned char* d)
+      {
+      // Header plus version 0.5 or later, see getInitData
+      if (n < FS_INIT_DATA_HEADER_SIZE + 2 || d[0] != MUSE_SYNTH_SYSEX_MFG_ID || d[1] != FLUIDSYNTH_UNIQUE_ID
+         || d[2] != FS_INIT_DATA || (d[3] == 0 && d[4] < 5))
+            return instantiate(sr, parent, projectPathPtr, name);
+
+      int groups = d[n - 2];
+      if (groups > FS_MAX_NR_OF_CHANNELS)
+            groups = FS_MAX_NR_OF_CHANNELS;
+      int cores = envSetting("MUSE_FLUIDSYNTH_CPU_CORES", d[n - 1] ? d[n - 1] : 1, 1, 255);
+      return createSynth(sr, projectPathPtr, name, cores, groups);
+      }
+
 extern "C"
       {
       static MESS descriptor = {
@@ -1454,6 +1605,7 @@ extern "C"
             "0.1",      //Version string
             MESS_MAJOR_VERSION, MESS_MINOR_VERSION,
             instantiate,
+            instantiateWithInitData,
             };
       // We must compile with -fvisibility=hidden to avoid namespace
       // conflicts with global variables.
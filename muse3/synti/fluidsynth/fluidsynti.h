@@ -43,8 +43,10 @@
 #include "muse/mpevent.h"   
 #include "muse/midictrl.h"
 #include "common_defs.h"
+#include "sfcache.h"
 
 #define FS_DEBUG_DATA 0 //Turn on/off debug print of midi data sent to fluidsynth
+#define FS_FX_BUFSIZE  256 //Frames rendered per chunk when audio groups are in use
 
 typedef unsigned char byte;
 
@@ -53,6 +55,8 @@ struct FluidSoundFont
       QString file_name;
       QString name;
       byte extid, intid;
+      SoundFontMapping* mapping; // reference held while the font is loaded, with dynamic sample loading
+      FluidSoundFont() : mapping(0) {}
       };
 
 struct FluidCtrl {
@@ -125,8 +129,17 @@ class FluidSynth : public Mess {
       bool rev_on, cho_on;
       int cho_num, cho_type;
 
+      // Separate outputs: midi channel n goes to stereo pair 1 + n % audioGroups,
+      // pair 0 carries the full mix including reverb and chorus.
+      int audioGroups;
+      int cpuCores;
+      float* groupLeft[FS_MAX_NR_OF_CHANNELS];
+      float* groupRight[FS_MAX_NR_OF_CHANNELS];
+      float fxBuffer[4][FS_FX_BUFSIZE]; // reverb l/r, chorus l/r
+      void processGroups(float**, int, int);
+
 public:
-      FluidSynth(int sr, pthread_mutex_t *_Globalsfloader_mutex);
+      FluidSynth(int sr, pthread_mutex_t *_Globalsfloader_mutex, int cpuCores = 1, int groups = 0, bool dynamicSamples = false);
       virtual ~FluidSynth();
       bool init(const char*);
       // This is only a kludge required to support old songs' midistates. Do not use in any new synth.
@@ -162,6 +175,7 @@ public:
       FluidSynthGui* gui;
       pthread_mutex_t *_sfloader_mutex;
       int currentlyLoadedFonts; //To know whether or not to run the init-parameters
+      bool dynamicSamples;      //Samples are loaded on first use of a preset
       std::list<FluidSoundFont> stack;
       int nrOfSoundfonts;
 
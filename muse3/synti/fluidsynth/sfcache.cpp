@@ -0,0 +1,199 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//  $Id: ./synti/fluidsynth/sfcache.cpp $
+//
+//  Copyright (C) 1999-2011 by Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#include <list>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QString>
+
+#include "sfcache.h"
+
+#if FS_HAVE_SFLOADER_CALLBACKS
+
+struct SoundFontMapping {
+      QByteArray path;        // as passed to fluid_synth_sfload
+      QDateTime mtime;
+      qint64 size;
+      QFile file;
+      const char* data;
+      int refs;
+      };
+
+// handle given to fluidsynth for each open()
+struct MappedFile {
+      SoundFontMapping* mapping;
+      qint64 pos;
+      };
+
+static pthread_mutex_t cacheMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::list<SoundFontMapping*> mappings;   // newest last
+
+//---------------------------------------------------------
+//   acquire
+//---------------------------------------------------------
+
+SoundFontMapping* SoundFontCache::acquire(const QString& path)
+      {
+      QFileInfo fi(path);
+      if (!fi.isFile())
+            return 0;
+      QByteArray p = path.toLocal8Bit();
+      QDateTime mtime = fi.lastModified();
+      qint64 size = fi.size();
+
+      pthread_mutex_lock(&cacheMutex);
+      for (std::list<SoundFontMapping*>::iterator i = mappings.begin(); i != mappings.end(); ++i) {
+            SoundFontMapping* m = *i;
+            if (m->path == p && m->mtime == mtime && m->size == size) {
+                  ++m->refs;
+                  pthread_mutex_unlock(&cacheMutex);
+                  return m;
+                  }
+            }
+
+      SoundFontMapping* m = new SoundFontMapping;
+      m->path  = p;
+      m->mtime = mtime;
+      m->size  = size;
+      m->refs  = 1;
+      m->data  = 0;
+      m->file.setFileName(path);
+      if (size > 0 && m->file.open(QIODevice::ReadOnly))
+            m->data = (const char*)m->file.map(0, size);
+      if (!m->data) {
+            pthread_mutex_unlock(&cacheMutex);
+            fprintf(stderr, "SoundFontCache: can't map %s\n", p.constData());
+            delete m;
+            return 0;
+            }
+      // No read ahead of the whole file: fluidsynth reads the parts it
+      // needs, and with dynamic sample loading only the samples in use.
+      mappings.push_back(m);
+      pthread_mutex_unlock(&cacheMutex);
+      return m;
+      }
+
+//---------------------------------------------------------
+//   release
+//---------------------------------------------------------
+
+void SoundFontCache::release(SoundFontMapping* m)
+      {
+      if (!m)
+            return;
+      pthread_mutex_lock(&cacheMutex);
+      if (--m->refs) {
+            pthread_mutex_unlock(&cacheMutex);
+            return;
+            }
+      mappings.remove(m);
+      pthread_mutex_unlock(&cacheMutex);
+      m->file.unmap((uchar*)m->data);
+      m->file.close();
+      delete m;
+      }
+
+//---------------------------------------------------------
+//   soundfont file callbacks
+//    open() only reuses a mapping if the file's mtime and
+//    size still match. A mapping of a file that was since
+//    truncated or rewritten could fault (SIGBUS) on reads.
+//---------------------------------------------------------
+
+static void* cacheOpen(const char* filename)
+      {
+      SoundFontMapping* m = SoundFontCache::acquire(QString::fromLocal8Bit(filename));
+      if (!m)
+            return 0;   // let the next loader try
+      MappedFile* f = new MappedFile;
+      f->mapping = m;
+      f->pos     = 0;
+      return f;
+      }
+
+static int cacheRead(void* buf, fluid_long_long_t count, void* handle)
+      {
+      MappedFile* f = (MappedFile*)handle;
+      if (count < 0 || f->pos + count > f->mapping->size)
+            return FLUID_FAILED;
+      memcpy(buf, f->mapping->data + f->pos, count);
+      f->pos += count;
+      return FLUID_OK;
+      }
+
+static int cacheSeek(void* handle, fluid_long_long_t offset, int origin)
+      {
+      MappedFile* f = (MappedFile*)handle;
+      qint64 pos;
+      switch (origin) {
+            case SEEK_SET: pos = offset; break;
+            case SEEK_CUR: pos = f->pos + offset; break;
+            case SEEK_END: pos = f->mapping->size + offset; break;
+            default:       return FLUID_FAILED;
+            }
+      if (pos < 0 || pos > f->mapping->size)
+            return FLUID_FAILED;
+      f->pos = pos;
+      return FLUID_OK;
+      }
+
+static fluid_long_long_t cacheTell(void* handle)
+      {
+      return ((MappedFile*)handle)->pos;
+      }
+
+static int cacheClose(void* handle)
+      {
+      MappedFile* f = (MappedFile*)handle;
+      SoundFontCache::release(f->mapping);
+      delete f;
+      return FLUID_OK;
+      }
+
+//---------------------------------------------------------
+//   installLoader
+//---------------------------------------------------------
+
+void SoundFontCache::installLoader(fluid_synth_t* synth, fluid_settings_t* settings)
+      {
+      fluid_sfloader_t* loader = new_fluid_defsfloader(settings);
+      if (!loader)
+            return;
+      fluid_sfloader_set_callbacks(loader, cacheOpen, cacheRead, cacheSeek, cacheTell, cacheClose);
+      // Added in front of the default loader, which stays as fallback.
+      fluid_synth_add_sfloader(synth, loader);
+      }
+
+#else
+
+SoundFontMapping* SoundFontCache::acquire(const QString&) { return 0; }
+void SoundFontCache::release(SoundFontMapping*) {}
+void SoundFontCache::installLoader(fluid_synth_t*, fluid_settings_t*) {}
+
+#endif
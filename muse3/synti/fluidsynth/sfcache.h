@@ -0,0 +1,64 @@
+//=========================================================
+//  MusE
+//  Linux Music Editor
+//  $Id: ./synti/fluidsynth/sfcache.h $
+//
+//  Copyright (C) 1999-2011 by Werner Schweer and others
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; version 2 of
+//  the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//
+//=========================================================
+
+#ifndef __MUSE_FLUIDSYNTH_SFCACHE_H__
+#define __MUSE_FLUIDSYNTH_SFCACHE_H__
+
+#include <fluidsynth.h>
+
+class QString;
+
+// Custom soundfont file callbacks appeared with fluidsynth 2.0, but until 2.2
+//  they took int and long offsets. The fluid_long_long_t ones are used here.
+#if defined(FLUIDSYNTH_VERSION_MAJOR) && \
+    (FLUIDSYNTH_VERSION_MAJOR > 2 || (FLUIDSYNTH_VERSION_MAJOR == 2 && FLUIDSYNTH_VERSION_MINOR >= 2))
+#define FS_HAVE_SFLOADER_CALLBACKS 1
+#else
+#define FS_HAVE_SFLOADER_CALLBACKS 0
+#endif
+
+struct SoundFontMapping;
+
+//---------------------------------------------------------
+//   SoundFontCache
+//    Process wide, shared by all fluidsynth instances.
+//    Each soundfont file (keyed by path, mtime and size) is
+//    memory mapped once, and the fluidsynth soundfont
+//    loader of every instance reads from that mapping.
+//    A mapping lives as long as it is referenced, so with
+//    dynamic sample loading a loaded font holds one to read
+//    its samples from later.
+//---------------------------------------------------------
+
+class SoundFontCache {
+   public:
+      // Returns a referenced mapping, or 0 if the file can't be mapped.
+      static SoundFontMapping* acquire(const QString& path);
+      static void release(SoundFontMapping*);
+
+      // Installs the cache backed loader. Must be called before
+      // the first soundfont is loaded into the synth.
+      static void installLoader(fluid_synth_t*, fluid_settings_t*);
+      };
+
+#endif
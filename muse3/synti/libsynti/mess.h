@@ -24,7 +24,7 @@
 #define __MESS_H__
 
 #define MESS_MAJOR_VERSION 1
-#define MESS_MINOR_VERSION 1
+#define MESS_MINOR_VERSION 2
 
 #include <QString>
 #include "mpevent.h"
@@ -120,6 +120,12 @@ struct MESS {
       const char* version;
       int majorMessVersion, minorMessVersion;
       Mess* (*instantiate)(int sr, QWidget* parent, QString* projectPathPtr, const char* name);
+      // Since minor version 2, may be 0. Used instead of instantiate when a saved
+      //  instance is restored, with the data getInitData() gave. The data is still
+      //  sent as usual afterwards. Lets a synth set up what can't change during
+      //  its lifetime, like the number of channels, the way it was saved.
+      Mess* (*instantiateWithInitData)(int sr, QWidget* parent, QString* projectPathPtr, const char* name,
+                                       int initLen, const unsigned char* initData);
       };
 
 extern "C" {
@@ -27,6 +27,7 @@
 
 #include <cmath>
 #include <stdio.h>
+#include <algorithm>
 
 #include "muse/midi.h"
 //#include "libsynti/mpevent.h"
@@ -170,6 +171,68 @@ static inline float table_pos (float* table, unsigned long freq_256, unsigned *a
       return table[*accum >> 8];
       }
 
+//---------------------------------------------------------
+//   harmonic
+//    add n samples of one harmonic to out
+//---------------------------------------------------------
+
+static void harmonic(double* out, int n, float* table, unsigned long freq_256, unsigned* accum, double harm)
+      {
+      if (harm == 0.0) {
+            // silent drawbar, only keep the phase going
+            *accum = (*accum + (unsigned long long)freq_256 * n) % (RESOLUTION * 256);
+            return;
+            }
+      unsigned acc = *accum;
+      for (int i = 0; i < n; ++i)
+            out[i] += table_pos(table, freq_256, &acc) * harm;
+      *accum = acc;
+      }
+
+//---------------------------------------------------------
+//   envelope
+//    run an attack - decay - sustain - release envelope
+//    for n samples one segment at a time, storing the
+//    attenuation of each sample in a. Returns the number
+//    of samples before the envelope went off
+//---------------------------------------------------------
+
+static int envelope(int* state, Envelope* attack, Envelope* decay, Envelope* release, int sustain, int* a, int n)
+      {
+      int on = n;
+      int i  = 0;
+      while (i < n) {
+            switch(*state) {
+                  case ATTACK:
+                        i += attack->steps(a + i, n - i);
+                        if (i < n)
+                              *state = DECAY;
+                        break;
+                  case DECAY:
+                        i += decay->steps(a + i, n - i);
+                        if (i < n)
+                              *state = SUSTAIN;
+                        break;
+                  case SUSTAIN:
+                        for (; i < n; ++i)
+                              a[i] = sustain;
+                        break;
+                  case RELEASE:
+                        i += release->steps(a + i, n - i);
+                        if (i < n)
+                              *state = OFF;
+                        break;
+                  default:
+                        if (i < on)
+                              on = i;
+                        for (; i < n; ++i)
+                              a[i] = MAX_ATTENUATION;
+                        break;
+                  }
+            }
+      return on;
+      }
+
 //---------------------------------------------------------
 //   init
 //---------------------------------------------------------
@@ -250,6 +313,8 @@ void Organ::process(unsigned /*pos*/, float** ports, int offset, int sampleCount
       */
       
       float* buffer = *ports + offset;
+      int a1[RENDER_BLOCK], a2[RENDER_BLOCK];
+      double lo[RENDER_BLOCK], hi[RENDER_BLOCK];
       for (int i = 0; i < VOICES; ++i) {
             Voice* v = &voices[i];
             if (!v->isOn)
@@ -258,18 +323,15 @@ void Organ::process(unsigned /*pos*/, float** ports, int offset, int sampleCount
             vol *= volume;
 
             unsigned freq_256 = freq256[v->pitch];
-            unsigned* harm0_accum = &(v->harm0_accum);
-            unsigned* harm1_accum = &(v->harm1_accum);
-            unsigned* harm2_accum = &(v->harm2_accum);
-            unsigned* harm3_accum = &(v->harm3_accum);
-            unsigned* harm4_accum = &(v->harm4_accum);
-            unsigned* harm5_accum = &(v->harm5_accum);
 
             unsigned long freq_256_harm2, freq_256_harm3;
             unsigned long freq_256_harm4, freq_256_harm5;
 
             float* reed_table  = reed  ? g_pulse_table    : sine_table;
             float* flute_table = flute ? g_triangle_table : sine_table;
+            float* harm2_table;
+            float* harm3_table;
+            float* harm4_table;
 
             unsigned freq_256_harm0 = freq_256 / 2;
             unsigned freq_256_harm1 = freq_256;
@@ -279,120 +341,40 @@ void Organ::process(unsigned /*pos*/, float** ports, int offset, int sampleCount
                   freq_256_harm3 = freq_256_harm2 * 2;
                   freq_256_harm4 = freq_256_harm3 * 2;
                   freq_256_harm5 = freq_256_harm4 * 2;
-                  for (int i = 0; i < sampleCount; i++) {
-                        int a1=0, a2=0;	//prevent compiler warning: unitialized usage of vars a1 & a2
-                        switch(v->state1) {
-                              case ATTACK:
-                                    if (v->envL1.step(&a1))
-                                          break;
-                                    v->state1 = DECAY;
-                              case DECAY:
-                                    if (v->envL2.step(&a1))
-                                          break;
-                                    v->state1 = SUSTAIN;
-                              case SUSTAIN:
-                                    a1 = sustain0;
-                                    break;
-                              case RELEASE:
-                                    if (v->envL3.step(&a1))
-                                          break;
-                                    v->state1 = OFF;
-                                    a1 = MAX_ATTENUATION;
-                                    break;
-                              }
-                        switch(v->state2) {
-                              case ATTACK:
-                                    if (v->envH1.step(&a2))
-                                          break;
-                                    v->state2 = DECAY;
-                              case DECAY:
-                                    if (v->envH2.step(&a2))
-                                          break;
-                                    v->state2 = SUSTAIN;
-                              case SUSTAIN:
-                                    a2 = sustain1;
-                                    break;
-                              case RELEASE:
-                                    if (v->envH3.step(&a2))
-                                          break;
-                                    v->state2 = OFF;
-                                    a1 = MAX_ATTENUATION;
-                                    break;
-                              }
-                        if (v->state1 == OFF && v->state2 == OFF) {
-                              v->isOn = false;
-                              break;
-                              }
-                        buffer[i] +=
-                            (table_pos (sine_table, freq_256_harm0, harm0_accum) * harm0
-                           + table_pos (sine_table, freq_256_harm1, harm1_accum) * harm1
-                           + table_pos (reed_table, freq_256_harm2, harm2_accum) * harm2)
-                              * cb2amp(a1) * vol
-                           + (table_pos (sine_table,  freq_256_harm3, harm3_accum) * harm3
-                           +  table_pos (flute_table, freq_256_harm4, harm4_accum) * harm4
-                           +  table_pos (flute_table, freq_256_harm5, harm5_accum) * harm5)
-                             * cb2amp(a2) * vol;
-                        }
+                  harm2_table = reed_table;
+                  harm3_table = sine_table;
+                  harm4_table = flute_table;
                   }
             else {
                   freq_256_harm2 = freq_256 * 3 / 2;
                   freq_256_harm3 = freq_256 * 2;
                   freq_256_harm4 = freq_256 * 3;
                   freq_256_harm5 = freq_256_harm3 * 2;
-                  for (int i = 0; i < sampleCount; i++) {
-                        int a1=0, a2=0;//prevent compiler warning: unitialized usage of vars a1 & a2
-                        switch(v->state1) {
-                              case ATTACK:
-                                    if (v->envL1.step(&a1))
-                                          break;
-                                    v->state1 = DECAY;
-                              case DECAY:
-                                    if (v->envL2.step(&a1))
-                                          break;
-                                    v->state1 = SUSTAIN;
-                              case SUSTAIN:
-                                    a1 = sustain0;
-                                    break;
-                              case RELEASE:
-                                    if (v->envL3.step(&a1))
-                                          break;
-                                    v->state1 = OFF;
-                                    a1 = MAX_ATTENUATION;
-                                    break;
-                              }
-                        switch(v->state2) {
-                              case ATTACK:
-                                    if (v->envH1.step(&a2))
-                                          break;
-                                    v->state2 = DECAY;
-                              case DECAY:
-                                    if (v->envH2.step(&a2))
-                                          break;
-                                    v->state2 = SUSTAIN;
-                              case SUSTAIN:
-                                    a2 = sustain1;
-                                    break;
-                              case RELEASE:
-                                    if (v->envH3.step(&a2))
-                                          break;
-                                    v->state2 = OFF;
-                                    a1 = MAX_ATTENUATION;
-                                    break;
-                              }
-                        if (v->state1 == OFF && v->state2 == OFF) {
-                              v->isOn = false;
-                              break;
-                              }
-                        buffer[i] +=
-                           (table_pos (sine_table, freq_256_harm0, harm0_accum) * harm0
-                           + table_pos (sine_table, freq_256_harm1, harm1_accum) * harm1
-                           + table_pos (sine_table, freq_256_harm2, harm2_accum) * harm2)
-                              * cb2amp(a1) * vol
-                           + (table_pos (reed_table, freq_256_harm3, harm3_accum) * harm3
-                           + table_pos (sine_table, freq_256_harm4,  harm4_accum) * harm4
-                           + table_pos (flute_table, freq_256_harm5, harm5_accum) * harm5)
-                             * cb2amp(a2) * vol;
+                  harm2_table = sine_table;
+                  harm3_table = reed_table;
+                  harm4_table = sine_table;
+                  }
+
+            // Envelopes first, then each harmonic over the whole block.
+            for (int pos = 0; pos < sampleCount && v->isOn; pos += RENDER_BLOCK) {
+                  int n = std::min(RENDER_BLOCK, sampleCount - pos);
+                  int on = std::max(
+                     envelope(&v->state1, &v->envL1, &v->envL2, &v->envL3, sustain0, a1, n),
+                     envelope(&v->state2, &v->envH1, &v->envH2, &v->envH3, sustain1, a2, n));
+                  if (on < n) {
+                        v->isOn = false;
+                        n = on;
                         }
+                  std::fill(lo, lo + n, 0.0);
+                  std::fill(hi, hi + n, 0.0);
+                  harmonic(lo, n, sine_table,  freq_256_harm0, &v->harm0_accum, harm0);
+                  harmonic(lo, n, sine_table,  freq_256_harm1, &v->harm1_accum, harm1);
+                  harmonic(lo, n, harm2_table, freq_256_harm2, &v->harm2_accum, harm2);
+                  harmonic(hi, n, harm3_table, freq_256_harm3, &v->harm3_accum, harm3);
+                  harmonic(hi, n, harm4_table, freq_256_harm4, &v->harm4_accum, harm4);
+                  harmonic(hi, n, flute_table, freq_256_harm5, &v->harm5_accum, harm5);
+                  for (int k = 0; k < n; ++k)
+                        buffer[pos + k] += lo[k] * cb2amp(a1[k]) * vol + hi[k] * cb2amp(a2[k]) * vol;
                   }
             }
       }
@@ -763,6 +745,7 @@ extern "C" {
             "0.1",      // version string
             MESS_MAJOR_VERSION, MESS_MINOR_VERSION,
             instantiate,
+            0,          // instantiateWithInitData
             };
       // We must compile with -fvisibility=hidden to avoid namespace
       // conflicts with global variables.
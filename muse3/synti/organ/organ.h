@@ -34,6 +34,7 @@
 
 #define RESOLUTION   (16384*2)
 #define VOICES          128    // max polyphony
+#define RENDER_BLOCK    64     // samples per envelope block
 #define INIT_DATA_CMD   1
 
 class OrganGui;
@@ -87,6 +88,21 @@ struct Envelope {
             --ticks;
             return true;
             }
+
+      // step up to n times, returns how often. Less than n on envelope end
+      int steps(int* a, int n) {
+            int i = 0;
+            for (; i < n && ticks; ++i) {
+                  a[i] = y;
+                  error += delta;
+                  while (error > 0) {
+                        y += yinc;
+                        error -= schritt;
+                        }
+                  --ticks;
+                  }
+            return i;
+            }
       };
 
 static const int HARM0      =  0 + MusECore::CTRL_RPN14_OFFSET;
@@ -240,7 +240,8 @@ extern "C" {
             "S1 MusE Demo Software Synthesizer",
             "0.2",      // version string
             MESS_MAJOR_VERSION, MESS_MINOR_VERSION,
-            instantiate
+            instantiate,
+            0,          // instantiateWithInitData
             };
       // We must compile with -fvisibility=hidden to avoid namespace
       // conflicts with global variables.
@@ -33,6 +33,11 @@
 
 #include <samplerate.h>
 #include <QFileDialog>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <unistd.h>
+#include <utime.h>
 
 const char* SimpleSynth::synth_state_descr[] =
 {
@@ -149,7 +154,6 @@ SimpleSynth::SimpleSynth(int sr)
    //initialize
    for (int i=0; i<SS_NR_OF_CHANNELS; i++) {
       channels[i].sample = 0;
-      channels[i].originalSample = 0;
       channels[i].playoffset = 0;
       channels[i].noteoff_ignore = true /* false */; //ignore note-offs by default (good for drum editors with fixed note lengths)
       channels[i].volume = (double) (100.0/SS_CHANNEL_VOLUME_QUOT );
@@ -164,6 +168,8 @@ SimpleSynth::SimpleSynth(int sr)
       for (int j=0; j<SS_NR_OF_SENDEFFECTS; j++) {
          channels[i].sendfxlevel[j] = 0.0;
       }      
+      loadRequests[i] = 0;
+      loadsDone[i] = 0;
    }
 
    //Process buffer:
@@ -256,6 +262,8 @@ SimpleSynth::SimpleSynth(int sr)
    }
 
    pthread_mutex_init(&SS_LoaderMutex, NULL);
+   diskThreadRun = false;
+   loaderThreadRun = false;
    SS_TRACE_OUT
 }
 
@@ -266,19 +274,28 @@ SimpleSynth::~SimpleSynth()
 {
    SS_TRACE_IN
 
+   // The loader thread reports loaded samples to the gui
+   if (loaderThreadRun) {
+      loaderThreadRun = false;
+      pthread_join(loaderThread, 0);
+   }
+
    if(gui){
       SimpleSynthGui *tmpGui = gui;
       gui = 0;
       delete tmpGui;  // p4.0.27
    }
 
+   if (diskThreadRun) {
+      diskThreadRun = false;
+      pthread_join(diskThread, 0);
+   }
+
    // Cleanup channels and samples:
    SS_DBG("Cleaning up sample data");
    for (int i=0; i<SS_NR_OF_CHANNELS; i++) {
-      if (channels[i].sample) {
-         delete[] channels[i].sample->data;
-         delete channels[i].sample;
-      }
+      if (channels[i].sample)
+         deleteSample(channels[i].sample);
    }
    simplesynth_ptr = NULL;
 
@@ -370,6 +387,14 @@ bool SimpleSynth::playNote(int /*channel*/, int pitch, int velo)
          if (channels[ch].sample) {
             //Turn on the white stuff:
             channels[ch].playoffset = 0;
+            SS_Stream* stream = channels[ch].sample->stream;
+            if (stream && stream->readPos) {
+               // Have the disk thread read the tail from its start again,
+               // while the head plays from memory
+               stream->readPos = 0;
+               __sync_synchronize();
+               stream->restarts++;
+            }
             SWITCH_CHAN_STATE(ch , SS_SAMPLE_PLAYING);
             channels[ch].cur_velo = (double) velo / 127.0;
             channels[ch].gain_factor = channels[ch].cur_velo * channels[ch].volume;
@@ -477,11 +502,10 @@ bool SimpleSynth::setController(int channel, int id, int val)
          channels[ch].pitchInt = val;
          printf("SS_CHANNEL_CTRL_PITCH %d\n", channels[channel].pitchInt);
 
+         // May come from the audio thread, so only ask the loader thread
+         // for a reload. A sweep of values ends up as one or two reloads.
          if (channels[ch].sample != 0)
-         {
-            std::string bkStr = channels[ch].sample->filename;
-            resample(channels[ch].originalSample,channels[ch].sample,rangeToPitch(channels[ch].pitchInt));
-         }
+            __sync_fetch_and_add(&loadRequests[ch], 1);
          break;
 
       case SS_CHANNEL_CTRL_NOFF:
@@ -817,6 +841,28 @@ void SimpleSynth::processMessages()
    }
 }
 
+/*!
+    \fn readStream(SS_Sample* smp, long offset, float* out)
+    \brief Get the sample frame at offset past the head of a streamed sample into out,
+     silence if the disk thread hasn't read it yet
+ */
+static inline void readStream(SS_Sample* smp, long offset, float* out)
+{
+   SS_Stream* s = smp->stream;
+   const long frame = offset / smp->channels;
+   out[0] = out[1] = 0.0;
+   if (s->gen != s->restarts || frame >= s->writePos)
+      return;
+   __sync_synchronize();
+   const float* f = s->ring + (frame % SS_STREAM_RING_FRAMES) * smp->channels + offset % smp->channels;
+   out[0] = f[0];
+   if (smp->channels == 2)
+      out[1] = f[1];
+   // The disk thread may reuse the slot from now on
+   __sync_synchronize();
+   s->readPos = frame + 1;
+}
+
 //---------------------------------------------------------
 //   process
 /*!
@@ -853,7 +899,8 @@ void SimpleSynth::process(unsigned /*pos*/, float** out, int offset, int len)
       //Temporary mix-doubles
       double out1, out2;
       //double ltemp, rtemp;
-      float* data;
+      const float* data;
+      float streamFrame[2];
       // Velocity factor:
       double gain_factor;
 
@@ -887,27 +934,33 @@ void SimpleSynth::process(unsigned /*pos*/, float** out, int offset, int len)
             memset(processBuffer[0], 0, SS_PROCESS_BUFFER_SIZE * sizeof(double));
             memset(processBuffer[1], 0, SS_PROCESS_BUFFER_SIZE * sizeof(double));
 
+            SS_Sample* smp = channels[ch].sample;
+            const long headSamples = smp->stream ? smp->stream->headFrames * smp->channels : smp->samples;
             for (int i=0; i<len; i++) {
                // Current channel sample data:
-               data = channels[ch].sample->data;
+               data = smp->data + channels[ch].playoffset;
+               if (channels[ch].playoffset >= headSamples) {
+                  readStream(smp, channels[ch].playoffset - headSamples, streamFrame);
+                  data = streamFrame;
+               }
                gain_factor = channels[ch].gain_factor;
                // Current velocity factor:
 
-               if (channels[ch].sample->channels == 2) {
+               if (smp->channels == 2) {
                   //
                   // Stereo sample:
                   //
                   // Add from sample:
-                  out1 = (double) (data[channels[ch].playoffset] * gain_factor * channels[ch].balanceFactorL);
-                  out2 = (double) (data[channels[ch].playoffset + 1] * gain_factor * channels[ch].balanceFactorR);
+                  out1 = (double) (data[0] * gain_factor * channels[ch].balanceFactorL);
+                  out2 = (double) (data[1] * gain_factor * channels[ch].balanceFactorR);
                   channels[ch].playoffset += 2;
                }
                else {
                   //
                   // Mono sample:
                   //
-                  out1 = (double) (data[channels[ch].playoffset] * gain_factor * channels[ch].balanceFactorL);
-                  out2 = (double) (data[channels[ch].playoffset] * gain_factor * channels[ch].balanceFactorR);
+                  out1 = (double) (data[0] * gain_factor * channels[ch].balanceFactorL);
+                  out2 = (double) (data[0] * gain_factor * channels[ch].balanceFactorR);
                   channels[ch].playoffset++;
                }
 
@@ -1024,6 +1077,16 @@ bool SimpleSynth::init(const char* name)
    for(int i = 0; i < SS_NR_OF_CHANNELS; i++){
       guiUpdateNoff(i, channels[i].noteoff_ignore); //update nOff gui checkbox (on by default now)
    }
+   diskThreadRun = true;
+   if (pthread_create(&diskThread, 0, ::streamThread, (void*) this)) {
+      perror("creating disk thread failed:");
+      diskThreadRun = false;
+   }
+   loaderThreadRun = true;
+   if (pthread_create(&loaderThread, 0, ::sampleLoaderThread, (void*) this)) {
+      perror("creating loader thread failed:");
+      loaderThreadRun = false;
+   }
    SWITCH_SYNTH_STATE(SS_RUNNING);
    SS_TRACE_OUT
          return true;
@@ -1461,19 +1524,14 @@ void SimpleSynth::parseInitData(const unsigned char* data)
 bool SimpleSynth::loadSample(int chno, const char* filename)
 {
    SS_TRACE_IN
-         SS_Channel* ch = &channels[chno];
-
-   // Thread stuff:
-   SS_SampleLoader* loader = new SS_SampleLoader;
-   loader->channel = ch;
-   loader->ch_no   = chno;
+   std::string path;
    if (SS_DEBUG) {
       printf("Loader filename is: %s\n", filename);
    }
 
    if (QFile::exists(filename))
    {
-      loader->filename = std::string(filename);
+      path = std::string(filename);
    }
    else
    {
@@ -1481,7 +1539,7 @@ bool SimpleSynth::loadSample(int chno, const char* filename)
       //MusEGlobal::museProject
       QFileInfo fi(filename);
       if (QFile::exists(fi.fileName()))
-         loader->filename = QDir::currentPath().toStdString() + "/" + fi.fileName().toStdString();
+         path = QDir::currentPath().toStdString() + "/" + fi.fileName().toStdString();
       else {
 
          // TODO: Strings should be translated, this does
@@ -1492,23 +1550,26 @@ bool SimpleSynth::loadSample(int chno, const char* filename)
                                                         QString("Can't find sample: %1 - Choose sample").arg(filename),
                                                         filename,
                                                         QString("Samples *.wav *.ogg *.flac (*.wav *.WAV *.ogg *.flac);;All files (*)"));
-         loader->filename = newName.toStdString();
+         path = newName.toStdString();
       }
    }
+   SS_TRACE_OUT
+   return startLoader(chno, path);
+}
 
-
-   pthread_t sampleThread;
-   pthread_attr_t* attributes = (pthread_attr_t*) malloc(sizeof(pthread_attr_t));
-   pthread_attr_init(attributes);
-   pthread_attr_setdetachstate(attributes, PTHREAD_CREATE_DETACHED);
-   if (pthread_create(&sampleThread, attributes, ::loadSampleThread, (void*) loader)) {
-      perror("creating thread failed:");
-      pthread_attr_destroy(attributes);
-      delete loader;
+/*!
+    \fn SimpleSynth::startLoader(int chno, const std::string& filename)
+    \brief Have the loader thread load a sample, whose file is known to exist
+ */
+bool SimpleSynth::startLoader(int chno, const std::string& filename)
+{
+   SS_TRACE_IN
+   if (!loaderThreadRun)
       return false;
-   }
-
-   pthread_attr_destroy(attributes);
+   pthread_mutex_lock(&SS_LoaderMutex);
+   loadFile[chno] = filename;
+   pthread_mutex_unlock(&SS_LoaderMutex);
+   __sync_fetch_and_add(&loadRequests[chno], 1);
    SS_TRACE_OUT
          return true;
 }
@@ -1525,6 +1586,15 @@ void resample(SS_Sample *origSample, SS_Sample* newSample, double pitch)
 
    // Allocate mem for the new one
    float* newData = new float[newSample->frames * newSample->channels];
+
+   // Same rate and no pitching: nothing to convert
+   if (srcratio == 1.0) {
+      memcpy(newData, origSample->data, sizeof(float) * newSample->samples);
+      float *oldData = newSample->data;
+      newSample->data = newData;
+      delete[] oldData;
+      return;
+   }
    memset(newData, 0, sizeof(float)* newSample->frames * newSample->channels);
 
    // libsamplerate & co (secret rabbits in the code!)
@@ -1551,48 +1621,173 @@ void resample(SS_Sample *origSample, SS_Sample* newSample, double pitch)
    float *oldData = newSample->data;
    newSample->data = newData;
    if (oldData) {
-      delete oldData;
+      delete[] oldData;
    }
 }
 
 /*!
-    \fn loadSampleThread(void* p)
-    \brief Since process needs to respond withing a certain time, loading of samples need to be done in a separate thread
+    \fn resampleCachePath(const std::string& filename, int pitchInt)
+    \brief Where the sample resampled to the current rate and pitch is cached on disk, empty if it can't be
  */
-static void* loadSampleThread(void* p)
+static QString resampleCachePath(const std::string& filename, int pitchInt)
 {
-   SS_TRACE_IN
-         pthread_mutex_lock(&SS_LoaderMutex);
+   QFileInfo fi(QString::fromStdString(filename));
+   QString dir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+   if (!fi.exists() || dir.isEmpty())
+      return QString();
+   dir += "/MusE/simpledrums";
+   if (!QDir().mkpath(dir))
+      return QString();
+
+   // Any change to the file gives a new name, stale entries are simply never read again
+   QCryptographicHash hash(QCryptographicHash::Sha1);
+   hash.addData(fi.absoluteFilePath().toUtf8());
+   hash.addData(QByteArray::number(fi.lastModified().toMSecsSinceEpoch()));
+   hash.addData(QByteArray::number(fi.size()));
+   hash.addData(QByteArray::number(SS_samplerate));
+   hash.addData(QByteArray::number(pitchInt));
+   return dir + "/" + QString(hash.result().toHex()) + ".wav";
+}
 
-   // Crit section:
-   SS_State prevState = synth_state;
-   SWITCH_SYNTH_STATE(SS_LOADING_SAMPLE);
-   SS_SampleLoader* loader = (SS_SampleLoader*) p;
-   SS_Channel* ch = loader->channel;
-   int ch_no      = loader->ch_no;
+/*!
+    \fn readSample(SNDFILE* sf, const SF_INFO& sfi, SS_Sample* smp)
+    \brief Read sf, whose data is at the synth rate, into smp. Samples longer than
+     SS_STREAM_HEAD_FRAMES only get their head read, smp keeps sf to stream the
+     rest from. Otherwise sf is closed.
+ */
+static bool readSample(SNDFILE* sf, const SF_INFO& sfi, SS_Sample* smp)
+{
+   const bool stream = sfi.frames > SS_STREAM_HEAD_FRAMES;
+   const long frames = stream ? SS_STREAM_HEAD_FRAMES : sfi.frames;
+   float* data = new float[frames * sfi.channels];
+   if (sf_readf_float(sf, data, frames) != frames) {
+      delete[] data;
+      sf_close(sf);
+      return false;
+   }
+   smp->channels = sfi.channels;
+   smp->frames = sfi.frames;
+   smp->samples = sfi.frames * sfi.channels;
+   smp->samplerate = SS_samplerate;
+   delete[] smp->data;
+   smp->data = data;
+   if (!stream) {
+      sf_close(sf);
+      return true;
+   }
+   SS_Stream* s = new SS_Stream;
+   s->sf = sf;
+   s->headFrames = frames;
+   s->ring = new float[SS_STREAM_RING_FRAMES * sfi.channels];
+   s->readPos = 0;
+   s->writePos = 0;
+   s->restarts = 0;
+   s->gen = -1;   // Have the disk thread fill the ring right away
+   smp->stream = s;
+   return true;
+}
+
+/*!
+    \fn deleteSample(SS_Sample* smp)
+ */
+static void deleteSample(SS_Sample* smp)
+{
+   if (smp->stream) {
+      sf_close(smp->stream->sf);
+      delete[] smp->stream->ring;
+      delete smp->stream;
+   }
+   delete[] smp->data;
+   delete smp;
+}
+
+/*!
+    \fn readCachedSample(const QString& path, SS_Sample* smp)
+    \brief Read a resampled sample from the cache into smp, whose channels must be set
+ */
+static bool readCachedSample(const QString& path, SS_Sample* smp)
+{
+   const QByteArray p = path.toLocal8Bit();
+   SF_INFO sfi;
+   sfi.format = 0;
+   SNDFILE* sf = sf_open(p.constData(), SFM_READ, &sfi);
+   if (sf == 0)
+      return false;
+   if (sfi.channels != smp->channels || sfi.samplerate != SS_samplerate) {
+      sf_close(sf);
+      return false;
+   }
+   // The modification time orders the cache for removal, see pruneResampleCache
+   utime(p.constData(), 0);
+   return readSample(sf, sfi, smp);
+}
+
+/*!
+    \fn writeCachedSample(const QString& path, const SS_Sample* smp)
+    \brief Store a resampled sample in the cache. Written under a temporary name
+     and renamed, so a parallel loader never reads half a file
+ */
+static bool writeCachedSample(const QString& path, const SS_Sample* smp)
+{
+   if (smp->samples * (long long) sizeof(float) > SS_RESAMPLE_CACHE_MAX_BYTES)
+      return false;
+   const QString tmpPath = path + QString(".%1.tmp").arg((qulonglong) pthread_self());
+   SF_INFO sfi;
+   sfi.samplerate = smp->samplerate;
+   sfi.channels = smp->channels;
+   sfi.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+   SNDFILE* sf = sf_open(tmpPath.toLocal8Bit().constData(), SFM_WRITE, &sfi);
+   if (sf == 0)
+      return false;
+   const bool ok = sf_writef_float(sf, smp->data, smp->frames) == smp->frames;
+   sf_close(sf);
+   if (!ok || !QFile::rename(tmpPath, path)) {
+      QFile::remove(tmpPath);
+      return false;
+   }
+   return true;
+}
 
-   if (ch->sample) {
-      delete[] ch->sample->data;
-      delete ch->sample;
+/*!
+    \fn pruneResampleCache(const QString& keep)
+    \brief Remove the least recently used files from the cache until it is no bigger
+     than SS_RESAMPLE_CACHE_MAX_BYTES. keep, the file just written, stays. Removing
+     a file another sample streams from is fine, the open file lives on.
+ */
+static void pruneResampleCache(const QString& keep)
+{
+   QFileInfo keepInfo(keep);
+   QDir dir(keepInfo.absolutePath());
+   // Oldest first
+   QFileInfoList files = dir.entryInfoList(QStringList("*.wav"), QDir::Files, QDir::Time | QDir::Reversed);
+   long long total = 0;
+   for (int i = 0; i < files.size(); i++)
+      total += files[i].size();
+   for (int i = 0; i < files.size() && total > SS_RESAMPLE_CACHE_MAX_BYTES; i++) {
+      if (files[i].fileName() == keepInfo.fileName())
+         continue;
+      if (QFile::remove(files[i].absoluteFilePath()))
+         total -= files[i].size();
    }
+}
 
+/*!
+    \fn readSampleFile(const std::string& filename, int pitchInt)
+    \brief Read a sample and resample it for the pitch, return 0 if that fails
+ */
+static SS_Sample* readSampleFile(const std::string& filename, int pitchInt)
+{
+   SS_TRACE_IN
    SNDFILE* sf;
-   const char* filename = loader->filename.c_str();
    SF_INFO sfi;
 
    if (SS_DEBUG)
-      printf("loadSampleThread: filename = %s\n", filename);
+      printf("readSampleFile: filename = %s\n", filename.c_str());
 
-   sf = sf_open(filename, SFM_READ, &sfi);
+   sf = sf_open(filename.c_str(), SFM_READ, &sfi);
    if (sf == 0) {
-      fprintf(stderr,"Error opening file: %s\n", filename);
-      SWITCH_SYNTH_STATE(prevState);
-      simplesynth_ptr->guiSendSampleLoaded(false, loader->ch_no, filename);
-      delete ch->sample; ch->sample = 0;
-      delete loader;
-      pthread_mutex_unlock(&SS_LoaderMutex);
-      SS_TRACE_OUT
-            pthread_exit(0);
+      fprintf(stderr,"Error opening file: %s\n", filename.c_str());
+      return 0;
    }
 
    //Print some info:
@@ -1603,63 +1798,187 @@ static void* loadSampleThread(void* p)
       printf("Samplerate: \t%d\n", sfi.samplerate);
    }
 
-   //
-   // Allocate and read the thingie
-   //
-
-   //      // If current samplerate is the same as MusE's and no pitching is needed:
-   //      if (SS_samplerate == sfi.samplerate && (ch->pitch -1.0) < 0.001) {
-   //            smp->data = new float[sfi.channels * sfi.frames];
-   //            sf_count_t n = sf_readf_float(sf, smp->data, sfi.frames);
-   //            smp->frames = sfi.frames;
-   //            smp->samples = (n * sfi.channels);
-   //            smp->channels = sfi.channels;
-   //            if (SS_DEBUG) {
-   //                  printf("%ld frames read\n", (long) n);
-   //                  }
-   //            }
-   //      else  // otherwise, resample:
-   {
-      ch->sample = new SS_Sample;
-      SS_Sample* smp = ch->sample;
-      //smp->data = 0; // reset the data so we won't accidentally delete unallocated data
-      ch->originalSample = new SS_Sample;
-      SS_Sample* origSmp = ch->originalSample;
-
-      smp->channels = sfi.channels;
-      origSmp->channels = sfi.channels;
-
-      // Read to original sample storage:
-      float *origSample = new float[sfi.frames * sfi.channels];
-      int frames_read = sf_readf_float(sf, origSample, sfi.frames);
-      if (frames_read != sfi.frames) {
-         fprintf(stderr,"Error reading sample %s\n", filename);
-         simplesynth_ptr->guiSendSampleLoaded(false, loader->ch_no, filename);
+   SS_Sample* smp = new SS_Sample;
+   smp->channels = sfi.channels;
+   smp->filename = filename;
+
+   const double pitch = rangeToPitch(pitchInt);
+   bool ok;
+   if (sfi.samplerate == SS_samplerate && pitch == 1.0) {
+      // Nothing to convert, a long sample streams from its own file
+      ok = readSample(sf, sfi, smp);
+   }
+   else {
+      // Resampling with the best quality is slow, so its result is cached
+      // on disk. A long sample streams from the cached file.
+      const QString cachePath = resampleCachePath(filename, pitchInt);
+      ok = !cachePath.isEmpty() && readCachedSample(cachePath, smp);
+      if (ok)
+         sf_close(sf);
+      else {
+         // The original is only held while resampling
+         SS_Sample origSmp;
+         origSmp.channels = sfi.channels;
+         origSmp.frames = sfi.frames;
+         origSmp.samplerate = sfi.samplerate;
+         origSmp.data = new float[sfi.frames * sfi.channels];
+         ok = sf_readf_float(sf, origSmp.data, sfi.frames) == sfi.frames;
+         //Just close the dam thing
          sf_close(sf);
-         SWITCH_SYNTH_STATE(prevState);
-         delete ch->sample; ch->sample = 0;
-         delete loader;
+         if (ok) {
+            resample(&origSmp, smp, pitch);
+            if (!cachePath.isEmpty() && writeCachedSample(cachePath, smp)) {
+               pruneResampleCache(cachePath);
+               // Keep only the head in memory if it is long enough to stream
+               if (smp->frames > SS_STREAM_HEAD_FRAMES)
+                  readCachedSample(cachePath, smp);
+            }
+         }
+         delete[] origSmp.data;
+      }
+   }
+   if (!ok) {
+      fprintf(stderr,"Error reading sample %s\n", filename.c_str());
+      deleteSample(smp);
+      smp = 0;
+   }
+   SS_TRACE_OUT
+   return smp;
+}
+
+/*!
+    \fn SimpleSynth::serviceLoads()
+    \brief Load the sample of each channel with a pending request, return whether there was any
+ */
+bool SimpleSynth::serviceLoads()
+{
+   bool busy = false;
+   for (int ch_no = 0; ch_no < SS_NR_OF_CHANNELS; ch_no++) {
+      SS_Channel* ch = &channels[ch_no];
+      const int req = loadRequests[ch_no];
+      if (req == loadsDone[ch_no])
+         continue;
+      busy = true;
+
+      // The file of the latest load request, or else the current one for a new pitch.
+      // A file whose load was dropped is kept until it is installed.
+      pthread_mutex_lock(&SS_LoaderMutex);
+      if (!loadFile[ch_no].empty()) {
+         loaderFile[ch_no] = loadFile[ch_no];
+         loadFile[ch_no].clear();
+      }
+      else if (loaderFile[ch_no].empty() && ch->sample)
+         loaderFile[ch_no] = ch->sample->filename;
+      const int pitchInt = ch->pitchInt;
+      pthread_mutex_unlock(&SS_LoaderMutex);
+      if (loaderFile[ch_no].empty()) {
+         // Cleared meanwhile, nothing to reload
+         loadsDone[ch_no] = req;
+         continue;
+      }
+
+      // Reading and resampling run unlocked
+      SS_Sample* smp = readSampleFile(loaderFile[ch_no], pitchInt);
+
+      pthread_mutex_lock(&SS_LoaderMutex);
+      if (ch->pitchInt != pitchInt || !loadFile[ch_no].empty()) {
+         // Outdated. The request stays pending, so the next round
+         // loads the current file and pitch.
          pthread_mutex_unlock(&SS_LoaderMutex);
-         pthread_exit(0);
-         SS_TRACE_OUT
+         if (smp)
+            deleteSample(smp);
+         continue;
       }
+      // Crit section:
+      SS_State prevState = synth_state;
+      SWITCH_SYNTH_STATE(SS_LOADING_SAMPLE);
+      ch->state = SS_CHANNEL_INACTIVE;
+      ch->playoffset = 0;
+      if (ch->sample)
+         deleteSample(ch->sample);
+      ch->sample = smp;
+      SWITCH_SYNTH_STATE(prevState);
+      guiSendSampleLoaded(smp != 0, ch_no, loaderFile[ch_no].c_str());
+      pthread_mutex_unlock(&SS_LoaderMutex);
+      loadsDone[ch_no] = req;
+      loaderFile[ch_no].clear();
+   }
+   return busy;
+}
+
+/*!
+    \fn sampleLoaderThread(void* p)
+    \brief Since process needs to respond withing a certain time, loading of samples need to be done in a separate thread
+ */
+static void* sampleLoaderThread(void* p)
+{
+   SimpleSynth* synth = (SimpleSynth*) p;
+   while (synth->loading()) {
+      if (!synth->serviceLoads())
+         usleep(SS_LOADER_POLL_USECS);
+   }
+   return 0;
+}
 
-      origSmp->channels = sfi.channels;
-      origSmp->frames = sfi.frames;
-      origSmp->samplerate = sfi.samplerate;
-      origSmp->data = origSample;
+/*!
+    \fn SimpleSynth::serviceStreams()
+    \brief Read ahead for the streamed samples, return whether there was anything to read
+ */
+bool SimpleSynth::serviceStreams()
+{
+   bool busy = false;
+   for (int ch = 0; ch < SS_NR_OF_CHANNELS; ch++) {
+      // The lock keeps the sample from being replaced or cleared meanwhile
+      pthread_mutex_lock(&SS_LoaderMutex);
+      SS_Sample* smp = channels[ch].sample;
+      SS_Stream* s = smp ? smp->stream : 0;
+      if (s) {
+         const int restarts = s->restarts;
+         __sync_synchronize();
+         if (s->gen != restarts) {
+            sf_seek(s->sf, s->headFrames, SEEK_SET);
+            s->writePos = 0;
+            __sync_synchronize();
+            s->gen = restarts;
+         }
+         const long pos = s->writePos;
+         long n = SS_STREAM_RING_FRAMES - (pos - s->readPos);
+         if (n > SS_STREAM_READ_FRAMES)
+            n = SS_STREAM_READ_FRAMES;
+         if (n > smp->frames - s->headFrames - pos)
+            n = smp->frames - s->headFrames - pos;
+         // Up to the end of the ring, the next read wraps
+         if (n > SS_STREAM_RING_FRAMES - pos % SS_STREAM_RING_FRAMES)
+            n = SS_STREAM_RING_FRAMES - pos % SS_STREAM_RING_FRAMES;
+         if (n > 0) {
+            float* buf = s->ring + (pos % SS_STREAM_RING_FRAMES) * smp->channels;
+            sf_count_t got = sf_readf_float(s->sf, buf, n);
+            if (got < 0)
+               got = 0;
+            if (got < n)
+               memset(buf + got * smp->channels, 0, (n - got) * smp->channels * sizeof(float));
+            __sync_synchronize();
+            s->writePos = pos + n;
+            busy = true;
+         }
+      }
+      pthread_mutex_unlock(&SS_LoaderMutex);
+   }
+   return busy;
+}
 
-      resample(origSmp, smp, rangeToPitch(ch->pitchInt));
+/*!
+    \fn streamThread(void* p)
+    \brief Disk thread of a synth, keeps the rings of its streamed samples filled
+ */
+static void* streamThread(void* p)
+{
+   SimpleSynth* synth = (SimpleSynth*) p;
+   while (synth->streaming()) {
+      if (!synth->serviceStreams())
+         usleep(SS_STREAM_POLL_USECS);
    }
-   //Just close the dam thing
-   sf_close(sf);
-   SWITCH_SYNTH_STATE(prevState);
-   ch->sample->filename = loader->filename;
-   simplesynth_ptr->guiSendSampleLoaded(true, ch_no, filename);
-   delete loader;
-   pthread_mutex_unlock(&SS_LoaderMutex);
-   SS_TRACE_OUT
-         pthread_exit(0);
+   return 0;
 }
 
 
@@ -1871,6 +2190,7 @@ static MESS descriptor = {
    "0.1.1",      //Version string
    MESS_MAJOR_VERSION, MESS_MINOR_VERSION,
    instantiate,
+   0,          // instantiateWithInitData
 };
 // We must compile with -fvisibility=hidden to avoid namespace
 // conflicts with global variables.
@@ -2094,14 +2414,11 @@ void SimpleSynth::clearSample(int ch)
       SS_State prevstate = synth_state;
       SWITCH_CHAN_STATE(ch, SS_CHANNEL_INACTIVE);
       SWITCH_SYNTH_STATE(SS_CLEARING_SAMPLE);
-      if (channels[ch].sample->data) {
-         delete[] channels[ch].sample->data;
-         channels[ch].sample->data = 0;
-      }
-      if (channels[ch].sample) {
-         delete channels[ch].sample;
-         channels[ch].sample = 0;
-      }
+      // The disk thread may be reading the sample's stream
+      pthread_mutex_lock(&SS_LoaderMutex);
+      deleteSample(channels[ch].sample);
+      channels[ch].sample = 0;
+      pthread_mutex_unlock(&SS_LoaderMutex);
       SWITCH_SYNTH_STATE(prevstate);
       guiNotifySampleCleared(ch);
       if (SS_DEBUG) {
@@ -41,6 +41,13 @@
 #define SS_PROCESS_BUFFER_SIZE 4096 //TODO: Add initialization method for nr of frames in each process from MusE - if nr of frames > than this, this will fail
 #define SS_SENDFX_BUFFER_SIZE  SS_PROCESS_BUFFER_SIZE
 
+#define SS_STREAM_HEAD_FRAMES  131072 // Longer samples keep only this many frames in memory, the rest is streamed from disk
+#define SS_STREAM_RING_FRAMES  65536  // Frames the disk thread reads ahead of a streamed sample
+#define SS_STREAM_READ_FRAMES  8192   // Frames the disk thread reads at a time
+#define SS_STREAM_POLL_USECS   5000   // Disk thread sleep when no stream needs data
+#define SS_LOADER_POLL_USECS   10000  // Loader thread sleep when no channel needs a sample
+#define SS_RESAMPLE_CACHE_MAX_BYTES (512LL * 1024 * 1024) // Least recently used resampled files are removed above this
+
 enum SS_ChannelState
 {
    SS_CHANNEL_INACTIVE=0,
@@ -72,10 +79,28 @@ struct SS_SendFx
    int            nrofparameters;
 };
 
+//
+// The part of a long sample that isn't held in memory. The disk thread
+// fills ring from sf, process() reads it. Positions count frames after
+// the head. process() bumps restarts when the sample starts over, the
+// disk thread then seeks back and sets gen to it.
+//
+struct SS_Stream
+{
+   SNDFILE*      sf;
+   long          headFrames;
+   float*        ring;
+   volatile long readPos;
+   volatile long writePos;
+   volatile int  restarts;
+   volatile int  gen;
+};
+
 struct SS_Sample
 {
-   SS_Sample() { data = 0; }
-   float*      data;
+   SS_Sample() { data = 0; stream = 0; }
+   float*      data;       // All of the sample, or only its head if streamed
+   SS_Stream*  stream;
    int         samplerate;
    //int         bits;
    std::string filename;
@@ -96,7 +121,6 @@ struct SS_Channel
    SS_ChannelState state;
    const char*     name;
    SS_Sample*      sample;
-   SS_Sample*      originalSample;
    int             playoffset;
    bool            noteoff_ignore;
 
@@ -126,13 +150,6 @@ struct SS_Controller
    int min, max;
 };
 
-struct SS_SampleLoader
-{
-   SS_Channel*  channel;
-   std::string  filename;
-   int          ch_no;
-};
-
 double rangeToPitch(int value);
 //int pitchToRange(double pitch);
 
@@ -165,6 +182,10 @@ public:
    bool init(const char* name);
    void guiSendSampleLoaded(bool success, int ch, const char* filename);
    void guiSendError(const char* errorstring);
+   bool streaming() const { return diskThreadRun; }
+   bool serviceStreams();
+   bool loading() const { return loaderThreadRun; }
+   bool serviceLoads();
 
    static const char* synth_state_descr[];
    static const char* channel_state_descr[];
@@ -180,6 +201,7 @@ private:
    SS_Controller controllers[SS_NR_OF_CONTROLLERS];
    bool setController(int channel, int id, int val, bool fromGui);
    bool loadSample(int ch_no, const char* filename);
+   bool startLoader(int ch_no, const std::string& filename);
    void parseInitData(const unsigned char* data);
    void updateVolume(int ch, int in_volume_ctrlval);
    void updatePitch(int ch, int inpitch_ctrlval);
@@ -208,10 +230,25 @@ private:
    float* sendFxLineOut[SS_NR_OF_SENDEFFECTS][2]; //stereo output (fed into LADSPA inputs),sent from the individual channels -> LADSPA fx
    float* sendFxReturn[SS_NR_OF_SENDEFFECTS][2];  //stereo inputs, from LADSPA plugins, sent from LADSPA -> SS and added to the mix
    double* processBuffer[2];
+
+   pthread_t diskThread;
+   volatile bool diskThreadRun;
+
+   // Sample (re)loads. Requests of a channel are coalesced, the loader
+   // thread only loads the latest file and pitch asked for.
+   volatile int loadRequests[SS_NR_OF_CHANNELS]; // Bumped by each request
+   int loadsDone[SS_NR_OF_CHANNELS];             // Loader thread only
+   std::string loadFile[SS_NR_OF_CHANNELS];      // File to switch to, under SS_LoaderMutex
+   std::string loaderFile[SS_NR_OF_CHANNELS];    // Loader thread only, file being loaded
+   pthread_t loaderThread;
+   volatile bool loaderThreadRun;
 };
 
 void resample(SS_Sample *origSmp, SS_Sample* newSample, double pitch);
-static void* loadSampleThread(void*);
+static SS_Sample* readSampleFile(const std::string& filename, int pitchInt);
+static void* sampleLoaderThread(void*);
+static void* streamThread(void*);
+static void deleteSample(SS_Sample*);
 static pthread_mutex_t SS_LoaderMutex;
 static SS_State synth_state;
 static SimpleSynth* simplesynth_ptr;